@@ -0,0 +1,127 @@
+//=============================================================================
+// bench.cpp
+//
+//    The timing harness for the kernel microbenchmarks.
+//
+// notes:
+// o  Each repetition runs enough iterations of the kernel to last at least
+//    "min_seconds", calibrated during the warmup, so that the clock
+//    resolution does not matter even for the smallest kernels.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+#include "bench.h"
+#include "../src/profile.h"
+
+namespace{
+   volatile double g_sink = 0.0;
+}
+
+//-----------------------------------------------------------------------------
+void Consume( double x )
+{
+   g_sink = g_sink + x;
+}
+
+//-----------------------------------------------------------------------------
+BenchResult Measure(
+   const std::string& kernel,
+   int size,
+   double flops,
+   double bytes,
+   const BenchConfig& config,
+   const std::function<void(long long iterations)>& op )
+{
+   // Calibrate the number of iterations per repetition.
+   long long iterations = 1;
+   for (;;) {
+      double start = WallSeconds();
+      op(iterations);
+      double elapsed = WallSeconds() - start;
+
+      if (elapsed >= config.min_seconds || iterations >= (1LL << 40)) break;
+      if (elapsed <= 0) {
+         iterations *= 10;
+      }
+      else {
+         double scale = 1.2 * config.min_seconds / elapsed;
+         iterations = static_cast<long long>( iterations * std::min(std::max(scale, 1.5), 100.0) ) + 1;
+      }
+   }
+
+   for (int w = 0; w < config.warmup; ++w)
+      op(iterations);
+
+   // The timed repetitions.
+   std::vector<double> ns( config.reps );
+   for (int r = 0; r < config.reps; ++r) {
+      double start = WallSeconds();
+      op(iterations);
+      ns[r] = (WallSeconds() - start) * 1e9 / iterations;
+   }
+
+   BenchResult result;
+   result.kernel     = kernel;
+   result.size       = size;
+   result.reps       = config.reps;
+   result.iterations = iterations;
+
+   double sum = 0.0;
+   for (double t : ns) sum += t;
+   result.ns_mean = sum / ns.size();
+
+   double ss = 0.0;
+   for (double t : ns) ss += (t - result.ns_mean)*(t - result.ns_mean);
+   result.ns_stddev = (ns.size() > 1) ? sqrt( ss/(ns.size()-1) ) : 0.0;
+
+   std::sort( ns.begin(), ns.end() );
+   result.ns_min    = ns.front();
+   result.ns_median = (ns.size() % 2 == 1) ? ns[ns.size()/2] : 0.5*(ns[ns.size()/2-1] + ns[ns.size()/2]);
+
+   result.gflops = flops / result.ns_median;     // flop/ns == GFLOP/s
+   result.gbytes = bytes / result.ns_median;     // byte/ns == GB/s
+
+   return result;
+}
+
+//-----------------------------------------------------------------------------
+void WriteCsv( std::ostream& out, const std::vector<BenchResult>& results )
+{
+   out << "kernel,size,reps,iterations,ns_median,ns_mean,ns_stddev,ns_min,gflops,gbytes" << std::endl;
+   out << std::setprecision(6);
+
+   for (const auto& r : results) {
+      out << r.kernel << ',' << r.size << ',' << r.reps << ',' << r.iterations << ','
+          << r.ns_median << ',' << r.ns_mean << ',' << r.ns_stddev << ',' << r.ns_min << ','
+          << r.gflops << ',' << r.gbytes << std::endl;
+   }
+}
+
+//-----------------------------------------------------------------------------
+void WriteJson( std::ostream& out, const std::vector<BenchResult>& results )
+{
+   out << std::setprecision(6);
+   out << "[\n";
+
+   for (size_t i = 0; i < results.size(); ++i) {
+      const BenchResult& r = results[i];
+      out << "   { \"kernel\": \"" << r.kernel << "\", \"size\": " << r.size
+          << ", \"reps\": " << r.reps << ", \"iterations\": " << r.iterations
+          << ", \"ns_median\": " << r.ns_median << ", \"ns_mean\": " << r.ns_mean
+          << ", \"ns_stddev\": " << r.ns_stddev << ", \"ns_min\": " << r.ns_min
+          << ", \"gflops\": " << r.gflops << ", \"gbytes\": " << r.gbytes << " }"
+          << (i+1 < results.size() ? "," : "") << "\n";
+   }
+
+   out << "]\n";
+}
@@ -0,0 +1,72 @@
+//=============================================================================
+// bench.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+struct BenchConfig {
+   int    warmup;                // untimed repetitions
+   int    reps;                  // timed repetitions
+   double min_seconds;           // minimum duration of one repetition
+};
+
+//-----------------------------------------------------------------------------
+// The statistics are per operation, over the timed repetitions. The rates
+// are computed from the median; they are zero when not meaningful.
+//-----------------------------------------------------------------------------
+struct BenchResult {
+   std::string kernel;
+   int         size;
+   int         reps;
+   long long   iterations;       // operations per repetition
+   double      ns_median;
+   double      ns_mean;
+   double      ns_stddev;
+   double      ns_min;
+   double      gflops;           // GFLOP/s
+   double      gbytes;           // GB/s
+};
+
+//-----------------------------------------------------------------------------
+// Measure
+//
+//    Time "op(iterations)", which must perform "iterations" operations of
+//    the kernel. Each operation does "flops" floating point operations and
+//    moves "bytes" bytes.
+//-----------------------------------------------------------------------------
+BenchResult Measure(
+   const std::string& kernel,
+   int size,
+   double flops,
+   double bytes,
+   const BenchConfig& config,
+   const std::function<void(long long iterations)>& op
+);
+
+// Keep a result alive, so the compiler cannot discard the computation.
+void Consume( double x );
+
+void WriteCsv( std::ostream& out, const std::vector<BenchResult>& results );
+void WriteJson( std::ostream& out, const std::vector<BenchResult>& results );
+
+//-----------------------------------------------------------------------------
+void BenchLinearAlgebra( const BenchConfig& config, std::vector<BenchResult>& results );
+void BenchSpecialFunctions( const BenchConfig& config, std::vector<BenchResult>& results );
+
+
+//=============================================================================
+#endif  // BENCH_H
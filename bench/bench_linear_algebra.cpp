@@ -0,0 +1,334 @@
+//=============================================================================
+// bench_linear_algebra.cpp
+//
+//    Microbenchmarks for the dot products, the Cholesky routines, the
+//    matrix products, Slice, and the H-matrix.
+//
+// notes:
+// o  The symmetric positive definite test matrices are exponential
+//    covariance matrices on random points, like those built by the engine.
+//
+// o  The flop counts are the conventional leading-order counts. The byte
+//    counts are the minimum traffic: each operand read once, each result
+//    written once.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "../src/batched_cholesky-inl.h"
+#include "../src/fixed_cholesky-inl.h"
+#include "../src/hmatrix.h"
+#include "../src/linear_systems.h"
+#include "../src/matrix.h"
+#include "../src/sum_product-inl.h"
+
+namespace{
+   //--------------------------------------------------------------------------
+   // n random points in the unit square, and the exponential covariance
+   // between two of them, with a small nugget on the diagonal.
+   //--------------------------------------------------------------------------
+   void RandomPoints( int n, std::vector<double>& x, std::vector<double>& y )
+   {
+      std::mt19937 generator( n );
+      std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+      x.resize(n);
+      y.resize(n);
+      for (int i = 0; i < n; ++i) {
+         x[i] = uniform(generator);
+         y[i] = uniform(generator);
+      }
+   }
+
+   double Covariance( const std::vector<double>& x, const std::vector<double>& y, int i, int j )
+   {
+      double h = hypot( x[i]-x[j], y[i]-y[j] );
+      return (i == j) ? 1.0 : 0.9*exp(-3.0*h/0.5);
+   }
+
+   //--------------------------------------------------------------------------
+   // An n x n exponential covariance matrix on random points.
+   //--------------------------------------------------------------------------
+   Matrix CovarianceMatrix( int n )
+   {
+      std::vector<double> x, y;
+      RandomPoints(n, x, y);
+
+      Matrix A(n, n);
+      for (int i = 0; i < n; ++i)
+         for (int j = 0; j < n; ++j)
+            A(i,j) = Covariance(x, y, i, j);
+      return A;
+   }
+
+   //--------------------------------------------------------------------------
+   Matrix RandomMatrix( int nrows, int ncols )
+   {
+      std::mt19937 generator( nrows*ncols );
+      std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+
+      Matrix A(nrows, ncols);
+      for (double* p = A.begin(); p != A.end(); ++p)
+         *p = uniform(generator);
+      return A;
+   }
+
+   //--------------------------------------------------------------------------
+   void BenchSumProduct( const BenchConfig& config, std::vector<BenchResult>& results )
+   {
+      const int STRIDE = 4;
+      const int sizes[] = {16, 256, 4096, 65536};
+
+      for (int n : sizes) {
+         Matrix x = RandomMatrix( n*STRIDE, 1 );
+         Matrix y = RandomMatrix( n*STRIDE, 1 );
+         const double* px = x.Base();
+         const double* py = y.Base();
+
+         results.push_back( Measure("SumProduct", n, 2.0*n, 16.0*n, config,
+            [=](long long iterations){
+               double s = 0.0;
+               for (long long i = 0; i < iterations; ++i) s += SumProduct(n, px, py);
+               Consume(s);
+            }) );
+
+         results.push_back( Measure("SumProduct_strided", n, 2.0*n, 16.0*n, config,
+            [=](long long iterations){
+               double s = 0.0;
+               for (long long i = 0; i < iterations; ++i) s += SumProduct(n, px, STRIDE, py, STRIDE);
+               Consume(s);
+            }) );
+
+         results.push_back( Measure("SumProduct_mixed", n, 2.0*n, 16.0*n, config,
+            [=](long long iterations){
+               double s = 0.0;
+               for (long long i = 0; i < iterations; ++i) s += SumProduct(n, px, py, STRIDE);
+               Consume(s);
+            }) );
+
+         results.push_back( Measure("SumProduct_self", n, 2.0*n, 8.0*n, config,
+            [=](long long iterations){
+               double s = 0.0;
+               for (long long i = 0; i < iterations; ++i) s += SumProduct(n, px);
+               Consume(s);
+            }) );
+
+         results.push_back( Measure("SumProduct_self_strided", n, 2.0*n, 8.0*n, config,
+            [=](long long iterations){
+               double s = 0.0;
+               for (long long i = 0; i < iterations; ++i) s += SumProduct(n, px, STRIDE);
+               Consume(s);
+            }) );
+      }
+   }
+
+   //--------------------------------------------------------------------------
+   void BenchCholesky( const BenchConfig& config, std::vector<BenchResult>& results )
+   {
+      const int sizes[] = {16, 64, 256, 512};
+
+      for (int n : sizes) {
+         const Matrix A = CovarianceMatrix(n);
+         const Matrix b = RandomMatrix(n, 1);
+         Matrix L(n, n);
+         Matrix x(n, 1);
+         Matrix Ainv(n, n);
+         CholeskyDecomposition(A, L);
+
+         const double nn = static_cast<double>(n)*n;
+
+         results.push_back( Measure("CholeskyDecomposition", n, n*nn/3.0, 8.0*nn, config,
+            [&](long long iterations){
+               for (long long i = 0; i < iterations; ++i) CholeskyDecomposition(A, L);
+               Consume( L(n-1,n-1) );
+            }) );
+
+         FloatMatrix Af(n, n, FloatMatrix::UNINITIALIZED);
+         std::copy( A.begin(), A.end(), Af.begin() );
+         FloatMatrix Lf(n, n);
+
+         results.push_back( Measure("CholeskyDecomposition_float", n, n*nn/3.0, 4.0*nn, config,
+            [&](long long iterations){
+               for (long long i = 0; i < iterations; ++i) CholeskyDecomposition(Af, Lf);
+               Consume( Lf(n-1,n-1) );
+            }) );
+
+         results.push_back( Measure("CholeskySolve", n, 2.0*nn, 4.0*nn + 16.0*n, config,
+            [&](long long iterations){
+               for (long long i = 0; i < iterations; ++i) CholeskySolve(L, b, x);
+               Consume( x(n-1,0) );
+            }) );
+
+         results.push_back( Measure("CholeskyInverse", n, n*nn, 8.0*nn + 8.0*nn, config,
+            [&](long long iterations){
+               for (long long i = 0; i < iterations; ++i) CholeskyInverse(L, Ainv);
+               Consume( Ainv(n-1,n-1) );
+            }) );
+      }
+   }
+
+   //--------------------------------------------------------------------------
+   // The fixed-size and batched kernels of order N against the general
+   // routine on the same raw storage. Every timing includes copying in the
+   // lower triangle; the batched one is for BATCH_LANES systems.
+   //--------------------------------------------------------------------------
+   template <int N>
+   void BenchFixedCholesky( const BenchConfig& config, std::vector<BenchResult>& results )
+   {
+      const int LD = FixedStride<N>();
+      const Matrix A = CovarianceMatrix(N);
+      std::vector<double> work(N*LD);
+
+      const double nn = static_cast<double>(N)*N;
+
+      results.push_back( Measure("CholeskyDecomposition_raw", N, N*nn/3.0, 8.0*nn, config,
+         [&](long long iterations){
+            for (long long i = 0; i < iterations; ++i) {
+               for (int r = 0; r < N; ++r)
+                  std::copy( A.Base(r,0), A.Base(r,0) + r+1, &work[r*N] );
+               CholeskyDecomposition(N, work.data(), N);
+            }
+            Consume( work[N*N-1] );
+         }) );
+
+      results.push_back( Measure("FixedCholesky", N, N*nn/3.0, 8.0*nn, config,
+         [&](long long iterations){
+            for (long long i = 0; i < iterations; ++i) {
+               for (int r = 0; r < N; ++r)
+                  std::copy( A.Base(r,0), A.Base(r,0) + r+1, &work[r*LD] );
+               FixedCholesky<N>(work.data());
+            }
+            Consume( work[(N-1)*LD + N-1] );
+         }) );
+
+      std::vector<double> batch(BATCH_LANES*N*N);
+      bool ok[BATCH_LANES];
+
+      results.push_back( Measure("BatchedCholesky", N, BATCH_LANES*N*nn/3.0, BATCH_LANES*8.0*nn, config,
+         [&](long long iterations){
+            for (long long i = 0; i < iterations; ++i) {
+               for (int r = 0; r < N; ++r) {
+                  const double* Ar = A.Base(r,0);
+                  double* Br = &batch[r*N*BATCH_LANES];
+                  for (int c = 0; c <= r; ++c)
+                     for (int l = 0; l < BATCH_LANES; ++l)
+                        Br[c*BATCH_LANES + l] = Ar[c];
+               }
+               BatchedCholesky(N, batch.data(), ok);
+            }
+            Consume( batch[BATCH_LANES*N*N - 1] );
+         }) );
+   }
+
+   //--------------------------------------------------------------------------
+   void BenchMultiply( const BenchConfig& config, std::vector<BenchResult>& results )
+   {
+      const int sizes[] = {16, 64, 256};
+
+      for (int n : sizes) {
+         const Matrix A = RandomMatrix(n, n);
+         const Matrix B = RandomMatrix(n, n);
+         Matrix C(n, n);
+
+         const double nn = static_cast<double>(n)*n;
+
+         results.push_back( Measure("Multiply_MM", n, 2.0*n*nn, 24.0*nn, config,
+            [&](long long iterations){
+               for (long long i = 0; i < iterations; ++i) Multiply_MM(A, B, C);
+               Consume( C(n-1,n-1) );
+            }) );
+
+         results.push_back( Measure("Multiply_MtM", n, 2.0*n*nn, 24.0*nn, config,
+            [&](long long iterations){
+               for (long long i = 0; i < iterations; ++i) Multiply_MtM(A, B, C);
+               Consume( C(n-1,n-1) );
+            }) );
+      }
+   }
+
+   //--------------------------------------------------------------------------
+   // Slice an n x n matrix down to the (n-1) x (n-1) matrix that drops one
+   // interior row and column, as the engine does for every observation.
+   //--------------------------------------------------------------------------
+   void BenchSlice( const BenchConfig& config, std::vector<BenchResult>& results )
+   {
+      const int sizes[] = {16, 64, 256, 1024};
+
+      for (int n : sizes) {
+         const Matrix A = RandomMatrix(n, n);
+         std::vector<int> flag(n, 1);
+         flag[n/2] = 0;
+         Matrix C(n-1, n-1);
+
+         const double m = n-1;
+
+         results.push_back( Measure("Slice", n, 0.0, 16.0*m*m, config,
+            [&](long long iterations){
+               for (long long i = 0; i < iterations; ++i) Slice(A, flag, flag, C);
+               Consume( C(0,0) );
+            }) );
+      }
+   }
+
+   //--------------------------------------------------------------------------
+   // The H-matrix of an n x n covariance matrix, compressed to 1e-8. Factor
+   // replaces the leaves, so each factorization includes the compression.
+   //--------------------------------------------------------------------------
+   void BenchHMatrix( const BenchConfig& config, std::vector<BenchResult>& results )
+   {
+      const int sizes[] = {1024, 4096};
+
+      for (int n : sizes) {
+         std::vector<double> x, y;
+         RandomPoints(n, x, y);
+         auto entry = [&](int i, int j) { return Covariance(x, y, i, j); };
+
+         HMatrix H;
+         results.push_back( Measure("HMatrixFactor", n, 0.0, 0.0, config,
+            [&](long long iterations){
+               for (long long i = 0; i < iterations; ++i) {
+                  H.Compress(x, y, entry, 1e-8, 1);
+                  H.Factor();
+               }
+               Consume( static_cast<double>(H.Storage()) );
+            }) );
+
+         const std::vector<double> b(n, 1.0);
+         std::vector<double> v(n);
+
+         results.push_back( Measure("HMatrixSolve", n, 0.0, 8.0*H.Storage(), config,
+            [&](long long iterations){
+               for (long long i = 0; i < iterations; ++i) {
+                  v = b;
+                  H.Solve(v.data());
+               }
+               Consume( v[n-1] );
+            }) );
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+void BenchLinearAlgebra( const BenchConfig& config, std::vector<BenchResult>& results )
+{
+   BenchSumProduct( config, results );
+   BenchCholesky( config, results );
+   BenchFixedCholesky<16>( config, results );
+   BenchFixedCholesky<32>( config, results );
+   BenchFixedCholesky<64>( config, results );
+   BenchMultiply( config, results );
+   BenchSlice( config, results );
+   BenchHMatrix( config, results );
+}
@@ -0,0 +1,212 @@
+//=============================================================================
+// bench_main.cpp
+//
+//    The driver for the benchmarks.
+//
+//    bench_Webinan [kernel options]
+//       Time the linear-algebra and special-function kernels.
+//
+//    bench_Webinan --scaling [scaling options]
+//       Run the engine end-to-end on synthetic data over grids of N,
+//       radius, and thread count.
+//
+//    bench_Webinan --generate <file> [data options]
+//       Write a synthetic data set in the Webinan input format.
+//
+// notes:
+// o  The results are always written to standard output as CSV. The --csv
+//    and --json options also write them to files, so that runs on different
+//    machines, or before and after a change, can be compared.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "bench_scaling.h"
+#include "synthetic.h"
+#include "../src/write_results.h"
+
+namespace{
+   //--------------------------------------------------------------------------
+   void BenchUsage()
+   {
+      std::cerr <<
+         "Usage: bench_Webinan [--quick] [--reps <n>] [--warmup <n>] [--csv <file>] [--json <file>]\n"
+         "       bench_Webinan --scaling [--sizes <n,...>] [--radii <r,...>] [--threads <t,...>]\n"
+         "                     [--alpha <a>] [--max-seconds <s>] [--max-memory <GB>] [data options]\n"
+         "                     [--csv <file>] [--json <file>]\n"
+         "       bench_Webinan --generate <file> [--n <n>] [data options]\n"
+         "data options: [--layout uniform|clustered|duplicates] [--outliers <n>] [--seed <s>]\n";
+   }
+
+   //--------------------------------------------------------------------------
+   // Parse a comma-separated list of numbers.
+   //--------------------------------------------------------------------------
+   template <typename T>
+   bool ParseList( const char* text, std::vector<T>& values )
+   {
+      values.clear();
+      std::stringstream in( text );
+      std::string item;
+
+      while (std::getline(in, item, ',')) {
+         std::stringstream field( item );
+         T value;
+         if (!(field >> value)) return false;
+         values.push_back( value );
+      }
+      return !values.empty();
+   }
+
+   //--------------------------------------------------------------------------
+   template <typename Writer>
+   bool WriteFile( const std::string& filename, Writer writer )
+   {
+      if (filename.empty()) return true;
+
+      std::ofstream out( filename );
+      writer( out );
+      if (!out) {
+         std::cerr << "ERROR: could not write " << filename << "." << std::endl;
+         return false;
+      }
+      return true;
+   }
+}
+
+//-----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+   BenchConfig config;
+   config.warmup      = 2;
+   config.reps        = 10;
+   config.min_seconds = 0.01;
+
+   ScalingConfig scaling;
+
+   bool run_scaling = false;
+   std::string generatename;
+   std::string csvname;
+   std::string jsonname;
+
+   for (int i = 1; i < argc; ++i) {
+      bool valid = true;
+
+      if ( strcmp(argv[i], "--quick") == 0 ) {
+         config.warmup = 1;
+         config.reps = 3;
+         config.min_seconds = 0.001;
+      }
+      else if ( strcmp(argv[i], "--reps") == 0 && i+1 < argc ) {
+         config.reps = atoi( argv[++i] );
+      }
+      else if ( strcmp(argv[i], "--warmup") == 0 && i+1 < argc ) {
+         config.warmup = atoi( argv[++i] );
+      }
+      else if ( strcmp(argv[i], "--csv") == 0 && i+1 < argc ) {
+         csvname = argv[++i];
+      }
+      else if ( strcmp(argv[i], "--json") == 0 && i+1 < argc ) {
+         jsonname = argv[++i];
+      }
+      else if ( strcmp(argv[i], "--scaling") == 0 ) {
+         run_scaling = true;
+      }
+      else if ( strcmp(argv[i], "--generate") == 0 && i+1 < argc ) {
+         generatename = argv[++i];
+      }
+      else if ( strcmp(argv[i], "--sizes") == 0 && i+1 < argc ) {
+         valid = ParseList( argv[++i], scaling.sizes );
+      }
+      else if ( strcmp(argv[i], "--radii") == 0 && i+1 < argc ) {
+         valid = ParseList( argv[++i], scaling.radii );
+      }
+      else if ( strcmp(argv[i], "--threads") == 0 && i+1 < argc ) {
+         valid = ParseList( argv[++i], scaling.threads );
+      }
+      else if ( strcmp(argv[i], "--alpha") == 0 && i+1 < argc ) {
+         scaling.alpha = atof( argv[++i] );
+      }
+      else if ( strcmp(argv[i], "--max-seconds") == 0 && i+1 < argc ) {
+         scaling.max_seconds = atof( argv[++i] );
+      }
+      else if ( strcmp(argv[i], "--max-memory") == 0 && i+1 < argc ) {
+         scaling.max_memory = 1.0e9 * atof( argv[++i] );
+      }
+      else if ( strcmp(argv[i], "--n") == 0 && i+1 < argc ) {
+         scaling.spec.n = atoi( argv[++i] );
+         valid = scaling.spec.n > 0;
+      }
+      else if ( strcmp(argv[i], "--layout") == 0 && i+1 < argc ) {
+         valid = ParseLayout( argv[++i], scaling.spec.layout );
+      }
+      else if ( strcmp(argv[i], "--outliers") == 0 && i+1 < argc ) {
+         scaling.spec.noutliers = atoi( argv[++i] );
+      }
+      else if ( strcmp(argv[i], "--seed") == 0 && i+1 < argc ) {
+         scaling.spec.seed = static_cast<unsigned>( atol( argv[++i] ) );
+      }
+      else {
+         valid = false;
+      }
+
+      if (!valid) {
+         std::cerr << "ERROR: option " << argv[i] << " is not valid." << std::endl;
+         BenchUsage();
+         return 1;
+      }
+   }
+
+   if (config.reps < 1 || config.warmup < 0) {
+      std::cerr << "ERROR: --reps must be positive and --warmup must be non-negative." << std::endl;
+      return 1;
+   }
+
+   // Generate a synthetic data set.
+   if (!generatename.empty()) {
+      try {
+         WriteSynthetic( generatename, GenerateSynthetic(scaling.spec) );
+      }
+      catch (InvalidOutputFile& e) {
+         std::cerr << "ERROR: " << e.what() << std::endl;
+         return 4;
+      }
+      std::cout << scaling.spec.n << " " << LayoutName(scaling.spec.layout) << " data records written to "
+                << generatename << "." << std::endl;
+      return 0;
+   }
+
+   // The end-to-end scaling runs.
+   if (run_scaling) {
+      std::vector<ScalingResult> results;
+      RunScaling( scaling, results );
+
+      WriteScalingCsv( std::cout, results );
+      if (!WriteFile( csvname, [&](std::ostream& out){ WriteScalingCsv(out, results); } )) return 4;
+      if (!WriteFile( jsonname, [&](std::ostream& out){ WriteScalingJson(out, results); } )) return 4;
+      return 0;
+   }
+
+   // The kernel microbenchmarks.
+   std::vector<BenchResult> results;
+   BenchLinearAlgebra( config, results );
+   BenchSpecialFunctions( config, results );
+
+   WriteCsv( std::cout, results );
+   if (!WriteFile( csvname, [&](std::ostream& out){ WriteCsv(out, results); } )) return 4;
+   if (!WriteFile( jsonname, [&](std::ostream& out){ WriteJson(out, results); } )) return 4;
+   return 0;
+}
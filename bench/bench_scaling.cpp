@@ -0,0 +1,204 @@
+//=============================================================================
+// bench_scaling.cpp
+//
+//    End-to-end scaling runs of the engine on synthetic data.
+//
+// notes:
+// o  For each N a single synthetic data set is generated and assembled, and
+//    then the engine is run for every (radius, threads) combination on the
+//    identical data.
+//
+// o  The dense engine costs about O(N^4), so the large sizes of the default
+//    grid are out of reach. A case is skipped when the runtime predicted
+//    from the two previous sizes of the same combination exceeds
+//    "max_seconds", or when the dense D and C matrices would exceed
+//    "max_memory" bytes. Skipped cases are still reported.
+//
+// o  The peak resident set size is reset before each N where the operating
+//    system allows it (Linux), otherwise it is the process high-water mark.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+#include "bench_scaling.h"
+#include "../src/engine.h"
+#include "../src/matrix.h"
+#include "../src/profile.h"
+
+namespace{
+   // The exponent assumed until two sizes of a combination have completed.
+   const double DEFAULT_EXPONENT = 4.0;
+
+   //--------------------------------------------------------------------------
+   void ResetPeakResident()
+   {
+#ifdef __linux__
+      std::ofstream clear( "/proc/self/clear_refs" );
+      clear << "5";
+#endif
+   }
+
+   //--------------------------------------------------------------------------
+   // Predict the runtime at size n from the completed sizes of a combination.
+   //--------------------------------------------------------------------------
+   double Predict( const std::vector<std::pair<int,double>>& history, int n )
+   {
+      if (history.empty()) return 0.0;
+
+      const std::pair<int,double>& last = history.back();
+      double exponent = DEFAULT_EXPONENT;
+
+      if (history.size() > 1) {
+         const std::pair<int,double>& prev = history[history.size()-2];
+         if (prev.second > 0 && last.second > 0 && last.first > prev.first)
+            exponent = log(last.second/prev.second) / log(double(last.first)/prev.first);
+         exponent = std::max( exponent, 1.0 );
+      }
+      return last.second * pow( double(n)/last.first, exponent );
+   }
+}
+
+//-----------------------------------------------------------------------------
+ScalingConfig::ScalingConfig()
+:  spec(),
+   sizes( {1000, 2000, 5000, 10000, 20000, 50000, 100000} ),
+   radii( {0.0, 50.0} ),
+   threads( {1, 0} ),
+   alpha( 0.001 ),
+   max_seconds( 600.0 ),
+   max_memory( 8.0e9 )
+{
+}
+
+//-----------------------------------------------------------------------------
+void RunScaling( const ScalingConfig& config, std::vector<ScalingResult>& results )
+{
+   std::map<std::pair<double,int>, std::vector<std::pair<int,double>>> history;
+
+   for (int n : config.sizes) {
+      // Decide which combinations are worth running at this size.
+      const bool fits = 2.0 * sizeof(double) * double(n) * n <= config.max_memory;
+
+      std::vector<std::pair<double,int>> cases;
+      for (double radius : config.radii) {
+         for (int nthreads : config.threads) {
+            std::pair<double,int> key(radius, nthreads);
+            if (fits && Predict(history[key], n) <= config.max_seconds)
+               cases.push_back(key);
+            else {
+               ScalingResult skipped = ScalingResult();
+               skipped.layout  = LayoutName( config.spec.layout );
+               skipped.n       = n;
+               skipped.radius  = radius;
+               skipped.threads = (nthreads < 1) ? DefaultThreadCount() : nthreads;
+               skipped.status  = "skipped";
+               skipped.planted = std::min( config.spec.noutliers, n );
+               skipped.recall  = NAN;
+               results.push_back( skipped );
+            }
+         }
+      }
+      if (cases.empty()) continue;
+
+      // Generate and assemble the data once for all of the combinations.
+      ResetPeakResident();
+
+      SyntheticSpec spec = config.spec;
+      spec.n = n;
+      SyntheticData data = GenerateSynthetic( spec );
+
+      double start = WallSeconds();
+      Matrix D, C;
+      {
+         Assembly assembly( spec.nugget, spec.sill, spec.range );
+         for (const DataRecord& rec : data.obs)
+            assembly.Append( rec );
+         assembly.Finalize( D, C, 0 );
+      }
+      const double assembly_seconds = WallSeconds() - start;
+
+      std::vector<char> planted( n, 0 );
+      for (int k : data.outliers) planted[k] = 1;
+
+      for (const auto& key : cases) {
+         ScalingResult result = ScalingResult();
+         result.layout  = LayoutName( spec.layout );
+         result.n       = n;
+         result.radius  = key.first;
+         result.threads = (key.second < 1) ? DefaultThreadCount() : key.second;
+         result.status  = "ok";
+         result.assembly_seconds = assembly_seconds;
+         result.planted = data.outliers.size();
+
+         EngineOptions options;
+         options.nthreads = result.threads;
+
+         start = WallSeconds();
+         Engine( spec.sill, key.first, data.obs, D, C,
+            [&](int k, const Boomerang& b) {
+               if (b.pvalue < config.alpha) {
+                  ++result.flagged;
+                  if (planted[k]) ++result.detected;
+               }
+            },
+            options );
+         result.engine_seconds = WallSeconds() - start;
+
+         result.recall = (result.planted > 0) ? double(result.detected)/result.planted : NAN;
+         result.peak_rss_bytes = PeakResidentBytes();
+
+         history[key].push_back( std::make_pair(n, result.engine_seconds) );
+         results.push_back( result );
+
+         std::cerr << "scaling: " << result.layout << " N = " << n << ", radius = " << result.radius
+                   << ", threads = " << result.threads << ": " << result.engine_seconds << " s, recall = "
+                   << result.recall << std::endl;
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+void WriteScalingCsv( std::ostream& out, const std::vector<ScalingResult>& results )
+{
+   out << "layout,n,radius,threads,status,assembly_seconds,engine_seconds,peak_rss_bytes,planted,flagged,detected,recall" << std::endl;
+   out << std::setprecision(6);
+
+   for (const auto& r : results) {
+      out << r.layout << ',' << r.n << ',' << r.radius << ',' << r.threads << ',' << r.status << ','
+          << r.assembly_seconds << ',' << r.engine_seconds << ',' << r.peak_rss_bytes << ','
+          << r.planted << ',' << r.flagged << ',' << r.detected << ',' << r.recall << std::endl;
+   }
+}
+
+//-----------------------------------------------------------------------------
+void WriteScalingJson( std::ostream& out, const std::vector<ScalingResult>& results )
+{
+   out << std::setprecision(6);
+   out << "[\n";
+
+   for (size_t i = 0; i < results.size(); ++i) {
+      const ScalingResult& r = results[i];
+      out << "   { \"layout\": \"" << r.layout << "\", \"n\": " << r.n << ", \"radius\": " << r.radius
+          << ", \"threads\": " << r.threads << ", \"status\": \"" << r.status << "\""
+          << ", \"assembly_seconds\": " << r.assembly_seconds << ", \"engine_seconds\": " << r.engine_seconds
+          << ", \"peak_rss_bytes\": " << r.peak_rss_bytes << ", \"planted\": " << r.planted
+          << ", \"flagged\": " << r.flagged << ", \"detected\": " << r.detected
+          << ", \"recall\": ";
+      if (std::isnan(r.recall)) out << "null"; else out << r.recall;
+      out << " }" << (i+1 < results.size() ? "," : "") << "\n";
+   }
+
+   out << "]\n";
+}
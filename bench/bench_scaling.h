@@ -0,0 +1,58 @@
+//=============================================================================
+// bench_scaling.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef BENCH_SCALING_H
+#define BENCH_SCALING_H
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "synthetic.h"
+
+//-----------------------------------------------------------------------------
+struct ScalingConfig {
+   SyntheticSpec       spec;             // spec.n is taken from "sizes"
+   std::vector<int>    sizes;
+   std::vector<double> radii;
+   std::vector<int>    threads;          // < 1 for the default thread count
+   double              alpha;            // flag observations with pvalue < alpha
+   double              max_seconds;      // skip cases predicted to run longer
+   double              max_memory;       // skip sizes needing more bytes for D and C
+
+   ScalingConfig();
+};
+
+//-----------------------------------------------------------------------------
+struct ScalingResult {
+   std::string layout;
+   int         n;
+   double      radius;
+   int         threads;
+   std::string status;                   // "ok" or "skipped"
+   double      assembly_seconds;
+   double      engine_seconds;
+   std::size_t peak_rss_bytes;
+   int         planted;                  // planted outliers
+   int         flagged;                  // observations with pvalue < alpha
+   int         detected;                 // planted outliers flagged
+   double      recall;                   // detected / planted
+};
+
+void RunScaling( const ScalingConfig& config, std::vector<ScalingResult>& results );
+
+void WriteScalingCsv( std::ostream& out, const std::vector<ScalingResult>& results );
+void WriteScalingJson( std::ostream& out, const std::vector<ScalingResult>& results );
+
+
+//=============================================================================
+#endif  // BENCH_SCALING_H
@@ -0,0 +1,79 @@
+//=============================================================================
+// bench_special_functions.cpp
+//
+//    Microbenchmarks for GaussianCDF and GaussianCDFInv, scalar and batched.
+//
+// notes:
+// o  The "size" is the number of arguments evaluated per operation. The
+//    arguments cover the tails as well as the center, since the p-values of
+//    the outliers come from the tails.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "../src/special_functions.h"
+
+//-----------------------------------------------------------------------------
+void BenchSpecialFunctions( const BenchConfig& config, std::vector<BenchResult>& results )
+{
+   const int sizes[] = {1, 1024};
+
+   for (int n : sizes) {
+      std::mt19937 generator( n );
+      std::uniform_real_distribution<double> z_uniform(-8.0, 8.0);
+      std::uniform_real_distribution<double> p_uniform(1e-12, 1.0-1e-12);
+
+      std::vector<double> z(n), p(n);
+      for (int i = 0; i < n; ++i) {
+         z[i] = z_uniform(generator);
+         p[i] = p_uniform(generator);
+      }
+
+      results.push_back( Measure("GaussianCDF", n, 0.0, 16.0*n, config,
+         [&](long long iterations){
+            double s = 0.0;
+            for (long long i = 0; i < iterations; ++i)
+               for (int j = 0; j < n; ++j) s += GaussianCDF( z[j] );
+            Consume(s);
+         }) );
+
+      results.push_back( Measure("GaussianCDF_batched", n, 0.0, 16.0*n, config,
+         [&](long long iterations){
+            std::vector<double> out(n);
+            double s = 0.0;
+            for (long long i = 0; i < iterations; ++i) {
+               GaussianCDF( n, z.data(), out.data() );
+               s += out[0];
+            }
+            Consume(s);
+         }) );
+
+      results.push_back( Measure("GaussianCDFInv", n, 0.0, 16.0*n, config,
+         [&](long long iterations){
+            double s = 0.0;
+            for (long long i = 0; i < iterations; ++i)
+               for (int j = 0; j < n; ++j) s += GaussianCDFInv( p[j] );
+            Consume(s);
+         }) );
+
+      results.push_back( Measure("GaussianCDFInv_batched", n, 0.0, 16.0*n, config,
+         [&](long long iterations){
+            std::vector<double> out(n);
+            double s = 0.0;
+            for (long long i = 0; i < iterations; ++i) {
+               GaussianCDFInv( n, p.data(), out.data() );
+               s += out[0];
+            }
+            Consume(s);
+         }) );
+   }
+}
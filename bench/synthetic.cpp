@@ -0,0 +1,187 @@
+//=============================================================================
+// synthetic.cpp
+//
+//    Reproducible synthetic data sets with known outliers.
+//
+// notes:
+// o  The correlated field is simulated with random Fourier features, so
+//    that data sets of 10^5 points cost O(N*K) rather than an O(N^3)
+//    Cholesky factorization. The exponential covariance exp(-r/a) in two
+//    dimensions has the bivariate Cauchy spectral density, so the
+//    frequencies are drawn as w = g/(a|e|) with g ~ N(0,I) and e ~ N(0,1).
+//    With K = 1000 features the covariance is exact in expectation, and the
+//    sample covariance has a relative error of about sqrt(2/K).
+//
+// o  z = mean + sqrt(sill-nugget)*field + sqrt(nugget)*noise, matching the
+//    covariance (sill-nugget)*exp(-3h/range) used by the engine.
+//
+// o  The planted outliers are shifted by +/- shift*sqrt(sill), with random
+//    signs.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <random>
+#include <sstream>
+
+#include "synthetic.h"
+#include "../src/numerical_constants.h"
+#include "../src/write_results.h"
+
+namespace{
+   // Manifest constants.
+   const int NUMBER_OF_FEATURES = 1000;
+   const int POINTS_PER_CLUSTER = 50;
+   const double DUPLICATE_FRACTION = 0.1;
+
+   const char* LAYOUT_NAMES[] = { "uniform", "clustered", "duplicates" };
+}
+
+//-----------------------------------------------------------------------------
+const char* LayoutName( SyntheticLayout layout )
+{
+   return LAYOUT_NAMES[layout];
+}
+
+//-----------------------------------------------------------------------------
+bool ParseLayout( const std::string& name, SyntheticLayout& layout )
+{
+   for (int i = 0; i < 3; ++i) {
+      if (name == LAYOUT_NAMES[i]) {
+         layout = static_cast<SyntheticLayout>(i);
+         return true;
+      }
+   }
+   return false;
+}
+
+//-----------------------------------------------------------------------------
+SyntheticSpec::SyntheticSpec()
+:  n( 1000 ),
+   layout( LAYOUT_UNIFORM ),
+   extent( 1000.0 ),
+   nugget( 2.0 ),
+   sill( 16.0 ),
+   range( 250.0 ),
+   mean( 100.0 ),
+   noutliers( 10 ),
+   shift( 6.0 ),
+   seed( 1 )
+{
+}
+
+//-----------------------------------------------------------------------------
+SyntheticData GenerateSynthetic( const SyntheticSpec& spec )
+{
+   std::mt19937 generator( spec.seed );
+   std::uniform_real_distribution<double> uniform(0.0, 1.0);
+   std::normal_distribution<double> normal(0.0, 1.0);
+
+   const int N = spec.n;
+   SyntheticData data;
+   data.obs.resize(N);
+
+   // The locations.
+   switch (spec.layout) {
+      case LAYOUT_UNIFORM:
+      case LAYOUT_DUPLICATES: {
+         for (int i = 0; i < N; ++i) {
+            data.obs[i].x = spec.extent * uniform(generator);
+            data.obs[i].y = spec.extent * uniform(generator);
+         }
+         if (spec.layout == LAYOUT_DUPLICATES) {
+            for (int i = 1; i < N; ++i) {
+               if (uniform(generator) < DUPLICATE_FRACTION) {
+                  int j = static_cast<int>( i * uniform(generator) );
+                  data.obs[i].x = data.obs[j].x;
+                  data.obs[i].y = data.obs[j].y;
+               }
+            }
+         }
+         break;
+      }
+      case LAYOUT_CLUSTERED: {
+         const double spread = spec.extent / 50.0;
+         double cx = 0, cy = 0;
+         for (int i = 0; i < N; ++i) {
+            if (i % POINTS_PER_CLUSTER == 0) {
+               cx = spec.extent * uniform(generator);
+               cy = spec.extent * uniform(generator);
+            }
+            data.obs[i].x = cx + spread*normal(generator);
+            data.obs[i].y = cy + spread*normal(generator);
+         }
+         break;
+      }
+   }
+
+   // The correlated field.
+   const double a = spec.range / 3.0;
+   std::vector<double> wx(NUMBER_OF_FEATURES), wy(NUMBER_OF_FEATURES), phase(NUMBER_OF_FEATURES);
+   for (int f = 0; f < NUMBER_OF_FEATURES; ++f) {
+      double e = std::max( fabs(normal(generator)), std::numeric_limits<double>::min() );
+      wx[f] = normal(generator) / (a*e);
+      wy[f] = normal(generator) / (a*e);
+      phase[f] = TWO_PI * uniform(generator);
+   }
+
+   const double amplitude = sqrt( 2.0*(spec.sill - spec.nugget) / NUMBER_OF_FEATURES );
+   const double noise = sqrt( spec.nugget );
+
+   for (int i = 0; i < N; ++i) {
+      double s = 0.0;
+      for (int f = 0; f < NUMBER_OF_FEATURES; ++f)
+         s += cos( wx[f]*data.obs[i].x + wy[f]*data.obs[i].y + phase[f] );
+
+      data.obs[i].z = spec.mean + amplitude*s + noise*normal(generator);
+
+      std::ostringstream id;
+      id << 'S' << i;
+      data.obs[i].id = id.str();
+   }
+
+   // The planted outliers.
+   std::vector<int> index(N);
+   for (int i = 0; i < N; ++i) index[i] = i;
+   std::shuffle( index.begin(), index.end(), generator );
+
+   const int noutliers = std::min( spec.noutliers, N );
+   data.outliers.assign( index.begin(), index.begin() + noutliers );
+   std::sort( data.outliers.begin(), data.outliers.end() );
+
+   for (int k : data.outliers) {
+      double sign = (uniform(generator) < 0.5) ? -1.0 : 1.0;
+      data.obs[k].z += sign * spec.shift * sqrt(spec.sill);
+   }
+
+   return data;
+}
+
+//-----------------------------------------------------------------------------
+void WriteSynthetic( const std::string& filename, const SyntheticData& data )
+{
+   std::ofstream outfile( filename );
+   outfile << std::setprecision( std::numeric_limits<double>::digits10 + 1 );
+
+   for (const DataRecord& rec : data.obs)
+      outfile << rec.id << ',' << rec.x << ',' << rec.y << ',' << rec.z << '\n';
+
+   std::ofstream outliers( filename + ".outliers" );
+   for (int k : data.outliers)
+      outliers << data.obs[k].id << '\n';
+
+   outfile.close();
+   outliers.close();
+   if (outfile.fail() || outliers.fail())
+      throw InvalidOutputFile( "could not write " + filename + "." );
+}
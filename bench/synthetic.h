@@ -0,0 +1,59 @@
+//=============================================================================
+// synthetic.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef SYNTHETIC_H
+#define SYNTHETIC_H
+
+#include <string>
+#include <vector>
+
+#include "../src/read_data.h"
+
+//-----------------------------------------------------------------------------
+enum SyntheticLayout {
+   LAYOUT_UNIFORM,               // uniform on the square
+   LAYOUT_CLUSTERED,             // Gaussian clusters about uniform centers
+   LAYOUT_DUPLICATES             // uniform, with some locations repeated
+};
+
+const char* LayoutName( SyntheticLayout layout );
+bool ParseLayout( const std::string& name, SyntheticLayout& layout );
+
+//-----------------------------------------------------------------------------
+struct SyntheticSpec {
+   int             n;            // number of observations
+   SyntheticLayout layout;
+   double          extent;       // side of the square [0,extent]^2
+   double          nugget;       // exponential variogram parameters
+   double          sill;
+   double          range;
+   double          mean;         // mean of z
+   int             noutliers;    // number of planted outliers
+   double          shift;        // outlier shift, in units of sqrt(sill)
+   unsigned        seed;
+
+   SyntheticSpec();
+};
+
+struct SyntheticData {
+   std::vector<DataRecord> obs;
+   std::vector<int>        outliers;   // indices of the planted outliers, ascending
+};
+
+SyntheticData GenerateSynthetic( const SyntheticSpec& spec );
+
+// Write the observations in the Webinan input format, and the ids of the
+// planted outliers one per line to "<filename>.outliers".
+void WriteSynthetic( const std::string& filename, const SyntheticData& data );
+
+
+//=============================================================================
+#endif  // SYNTHETIC_H
@@ -0,0 +1,199 @@
+//=============================================================================
+// arena.cpp
+//
+//    Memory resources for the numerical storage.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+#include "arena.h"
+
+namespace{
+   // Manifest constants.
+   const std::size_t MINIMUM_CHUNK = 4096;
+
+   //--------------------------------------------------------------------------
+   // Round n up to a multiple of the alignment.
+   //--------------------------------------------------------------------------
+   inline std::size_t RoundUp( std::size_t n )
+   {
+      return (n + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+   }
+
+   //--------------------------------------------------------------------------
+   // Aligned heap allocation. The block returned by operator new is stored
+   // just in front of the aligned block, so that it can be released.
+   //--------------------------------------------------------------------------
+   void* AlignedNew( std::size_t bytes )
+   {
+      char* raw = static_cast<char*>( ::operator new( bytes + ARENA_ALIGNMENT + sizeof(void*) ) );
+
+      std::uintptr_t address = reinterpret_cast<std::uintptr_t>( raw + sizeof(void*) );
+      address = (address + ARENA_ALIGNMENT - 1) & ~static_cast<std::uintptr_t>(ARENA_ALIGNMENT - 1);
+
+      char* p = reinterpret_cast<char*>( address );
+      reinterpret_cast<void**>(p)[-1] = raw;
+      return p;
+   }
+
+   //--------------------------------------------------------------------------
+   void AlignedDelete( void* p )
+   {
+      if (p != nullptr)
+         ::operator delete( static_cast<void**>(p)[-1] );
+   }
+
+   //--------------------------------------------------------------------------
+   // HeapResource
+   //
+   //    Each block is individually allocated from, and returned to, the heap.
+   //--------------------------------------------------------------------------
+   class HeapResource : public MemoryResource
+   {
+   public:
+      void* Allocate( std::size_t bytes ) override
+      {
+         return AlignedNew( bytes );
+      }
+
+      void Deallocate( void* p, std::size_t ) override
+      {
+         AlignedDelete( p );
+      }
+   };
+}
+
+//=============================================================================
+// MemoryResource
+//=============================================================================
+MemoryResource::~MemoryResource()
+{
+}
+
+//-----------------------------------------------------------------------------
+// The resource used by any Matrix that is not given one explicitly.
+//-----------------------------------------------------------------------------
+MemoryResource* DefaultResource()
+{
+   static HeapResource resource;
+   return &resource;
+}
+
+//=============================================================================
+// Arena
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+// Constructor. The initial chunk, if any, is reserved immediately, so that an
+// Arena sized for its largest working set never touches the heap again.
+//-----------------------------------------------------------------------------
+Arena::Arena( std::size_t bytes )
+:  m_Chunks(),
+   m_Chunk( nullptr ),
+   m_Size( 0 ),
+   m_Offset( 0 ),
+   m_Used( 0 ),
+   m_Retired( 0 )
+{
+   if (bytes > 0) {
+      m_Size  = RoundUp( bytes );
+      m_Chunk = static_cast<char*>( AlignedNew( m_Size ) );
+   }
+}
+
+//-----------------------------------------------------------------------------
+Arena::~Arena()
+{
+   for (char* chunk : m_Chunks)
+      AlignedDelete( chunk );
+   AlignedDelete( m_Chunk );
+}
+
+//-----------------------------------------------------------------------------
+// Bump-pointer allocation.
+//-----------------------------------------------------------------------------
+void* Arena::Allocate( std::size_t bytes )
+{
+   bytes = RoundUp( std::max<std::size_t>( bytes, 1 ) );
+
+   if (m_Offset + bytes > m_Size)
+      Grow( bytes );
+
+   char* p = m_Chunk + m_Offset;
+   m_Offset += bytes;
+   m_Used   += bytes;
+   return p;
+}
+
+//-----------------------------------------------------------------------------
+// Individual blocks are never released; see Reset.
+//-----------------------------------------------------------------------------
+void Arena::Deallocate( void*, std::size_t )
+{
+}
+
+//-----------------------------------------------------------------------------
+// Release every block handed out since the last Reset. If the Arena had to
+// grow, the chunks are coalesced into a single chunk large enough for the
+// whole of the last cycle, so that the next cycle runs without growing.
+//-----------------------------------------------------------------------------
+void Arena::Reset()
+{
+   if (!m_Chunks.empty()) {
+      const std::size_t size = m_Size + m_Retired;
+
+      for (char* chunk : m_Chunks)
+         AlignedDelete( chunk );
+      m_Chunks.clear();
+      m_Retired = 0;
+
+      AlignedDelete( m_Chunk );
+      m_Chunk = nullptr;
+      m_Size  = 0;
+
+      m_Chunk = static_cast<char*>( AlignedNew( size ) );
+      m_Size  = size;
+   }
+
+   m_Offset = 0;
+   m_Used   = 0;
+}
+
+//-----------------------------------------------------------------------------
+std::size_t Arena::Used() const
+{
+   return m_Used;
+}
+
+//-----------------------------------------------------------------------------
+std::size_t Arena::Capacity() const
+{
+   return m_Size + m_Retired;
+}
+
+//-----------------------------------------------------------------------------
+// Retire the current chunk and start a new one, at least twice as large.
+//-----------------------------------------------------------------------------
+void Arena::Grow( std::size_t bytes )
+{
+   const std::size_t size = std::max( std::max( 2*m_Size, bytes ), MINIMUM_CHUNK );
+   char* chunk = static_cast<char*>( AlignedNew( size ) );
+
+   if (m_Chunk != nullptr) {
+      m_Chunks.push_back( m_Chunk );
+      m_Retired += m_Size;
+   }
+
+   m_Chunk  = chunk;
+   m_Size   = size;
+   m_Offset = 0;
+}
@@ -0,0 +1,90 @@
+//=============================================================================
+// arena.h
+//
+//    Memory resources for the numerical storage.  A MemoryResource hands out
+//    blocks aligned to ARENA_ALIGNMENT bytes, so that every row base of a
+//    Matrix, and every scratch vector, starts on a cache line and is suitable
+//    for aligned SIMD loads.
+//
+//    Two resources are provided:
+//
+//       DefaultResource()  a thread-safe heap resource; each block is
+//                          individually allocated and released.
+//
+//       Arena              a bump-pointer resource owned by one thread.
+//                          Deallocate is a no-op; all of the blocks are
+//                          released at once by Reset().
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Alignment, in bytes, of every block handed out by a MemoryResource.
+//-----------------------------------------------------------------------------
+const std::size_t ARENA_ALIGNMENT = 64;
+
+//=============================================================================
+// MemoryResource
+//=============================================================================
+class MemoryResource
+{
+public:
+   virtual ~MemoryResource();
+
+   virtual void* Allocate( std::size_t bytes ) = 0;
+   virtual void  Deallocate( void* p, std::size_t bytes ) = 0;
+};
+
+//-----------------------------------------------------------------------------
+MemoryResource* DefaultResource();
+
+//=============================================================================
+// Arena
+//=============================================================================
+class Arena : public MemoryResource
+{
+public:
+   explicit Arena( std::size_t bytes = 0 );
+   ~Arena();
+
+   void* Allocate( std::size_t bytes ) override;
+   void  Deallocate( void* p, std::size_t bytes ) override;
+
+   template <typename T>
+   T* Allocate( std::size_t n )
+   {
+      return static_cast<T*>( Allocate( sizeof(T)*n ) );
+   }
+
+   void Reset();                                      // release every block
+
+   std::size_t Used() const;                          // bytes handed out
+   std::size_t Capacity() const;                      // bytes reserved
+
+private:
+   Arena( const Arena& );                             // not copyable
+   Arena& operator=( const Arena& );
+
+   void Grow( std::size_t bytes );
+
+   std::vector<char*> m_Chunks;                       // retired chunks
+   char*       m_Chunk;                               // current chunk
+   std::size_t m_Size;                                // size of the chunk
+   std::size_t m_Offset;                              // next free byte
+   std::size_t m_Used;                                // bytes handed out
+   std::size_t m_Retired;                             // bytes in m_Chunks
+};
+
+//=============================================================================
+#endif  // ARENA_H
@@ -0,0 +1,129 @@
+//=============================================================================
+// batched_cholesky-inl.h
+//
+//    Cholesky factorization and solution of BATCH_LANES independent small
+//    symmetric positive definite systems of the same order, in lockstep.
+//
+//    The systems are interleaved: entry (i,j) of system [l] is stored at
+//    A[(i*n + j)*BATCH_LANES + l], and entry [i] of a vector at
+//    x[i*BATCH_LANES + l]. Every step is then the same operation applied to
+//    BATCH_LANES adjacent values, so the loops vectorize across the systems,
+//    rather than within one, and the serial dependence of each dot product
+//    is shared by all of the lanes.
+//
+//    Systems of different orders are batched by padding each to the common
+//    order n with identity rows and zero right-hand sides.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef BATCHED_CHOLESKY_INL_H
+#define BATCHED_CHOLESKY_INL_H
+
+#include <math.h>
+
+//-----------------------------------------------------------------------------
+// The number of systems in a batch.
+//-----------------------------------------------------------------------------
+const int BATCH_LANES = 4;
+
+//-----------------------------------------------------------------------------
+// BatchedCholesky
+//
+//    On entrance the lower triangles of A hold those of the BATCH_LANES
+//    interleaved n x n matrices; on exit they hold the factors L. The upper
+//    triangles are neither accessed nor modified.
+//
+//    ok[l] is set to what CholeskyDecomposition would have returned for
+//    system [l]. A failed lane is carried on with a unit pivot, so that the
+//    other lanes are unaffected and nothing overflows, but its factor is
+//    meaningless.
+//-----------------------------------------------------------------------------
+inline void BatchedCholesky( int n, double* A, bool* ok )
+{
+   const int W = BATCH_LANES;
+   const double MIN_DIVISOR = 1e-12;
+
+   for (int l = 0; l < W; ++l)
+      ok[l] = true;
+
+   for (int j = 0; j < n; ++j) {
+      double* Aj = A + j*n*W;
+
+      double s[W];
+      for (int l = 0; l < W; ++l)
+         s[l] = Aj[j*W + l];
+      for (int k = 0; k < j; ++k)
+         for (int l = 0; l < W; ++l)
+            s[l] -= Aj[k*W + l] * Aj[k*W + l];
+
+      double r[W];
+      for (int l = 0; l < W; ++l) {
+         if (!(s[l] >= MIN_DIVISOR)) {
+            ok[l] = false;
+            s[l] = 1.0;
+         }
+         Aj[j*W + l] = sqrt( s[l] );
+         r[l] = 1.0 / Aj[j*W + l];
+      }
+
+      for (int i = j+1; i < n; ++i) {
+         double* Ai = A + i*n*W;
+
+         double t[W];
+         for (int l = 0; l < W; ++l)
+            t[l] = Ai[j*W + l];
+         for (int k = 0; k < j; ++k)
+            for (int l = 0; l < W; ++l)
+               t[l] -= Ai[k*W + l] * Aj[k*W + l];
+
+         for (int l = 0; l < W; ++l)
+            Ai[j*W + l] = t[l] * r[l];
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+// BatchedSolve
+//
+//    Solve LL' x = b for each of the BATCH_LANES interleaved systems, where
+//    L is from BatchedCholesky. On entrance x holds the b's; on exit, the
+//    solutions.
+//-----------------------------------------------------------------------------
+inline void BatchedSolve( int n, const double* L, double* x )
+{
+   const int W = BATCH_LANES;
+
+   // Solve L y = b, by rows.
+   for (int i = 0; i < n; ++i) {
+      const double* Li = L + i*n*W;
+
+      double t[W];
+      for (int l = 0; l < W; ++l)
+         t[l] = x[i*W + l];
+      for (int k = 0; k < i; ++k)
+         for (int l = 0; l < W; ++l)
+            t[l] -= Li[k*W + l] * x[k*W + l];
+
+      for (int l = 0; l < W; ++l)
+         x[i*W + l] = t[l] / Li[i*W + l];
+   }
+
+   // Solve L' x = y, by the rows of L, which are the columns of L'.
+   for (int j = n-1; j >= 0; --j) {
+      const double* Lj = L + j*n*W;
+
+      for (int l = 0; l < W; ++l)
+         x[j*W + l] /= Lj[j*W + l];
+      for (int i = 0; i < j; ++i)
+         for (int l = 0; l < W; ++l)
+            x[i*W + l] -= Lj[i*W + l] * x[j*W + l];
+   }
+}
+
+#endif  // BATCHED_CHOLESKY_INL_H
@@ -0,0 +1,306 @@
+//=============================================================================
+// checkpoint.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+
+#ifdef _WIN32
+   #include <fcntl.h>
+   #include <io.h>
+#else
+   #include <fcntl.h>
+   #include <unistd.h>
+#endif
+
+#include "checkpoint.h"
+
+namespace{
+   // Manifest constants.
+   const char MAGIC[8] = { 'W', 'B', 'N', 'C', 'K', 'P', 'T', '2' };
+   const int  RECORD_SIZE = 4*4 + 5*8;  // bytes per record
+   const int  BATCH = 256;              // records that wake the writer early
+   const std::chrono::seconds FLUSH_INTERVAL( 1 );
+
+   const unsigned long long FNV_OFFSET = 14695981039346656037ULL;
+   const unsigned long long FNV_PRIME  = 1099511628211ULL;
+
+   void Hash( unsigned long long& h, const void* data, std::size_t size )
+   {
+      const unsigned char* p = static_cast<const unsigned char*>(data);
+      for (std::size_t i = 0; i < size; ++i) {
+         h ^= p[i];
+         h *= FNV_PRIME;
+      }
+   }
+
+   void Encode( const CheckpointEntry& entry, unsigned char* p )
+   {
+      const std::int32_t fields[4] = { entry.k, entry.status, entry.result.cnt, entry.iterations };
+      const double values[5] = { entry.result.zhat, entry.result.kstd, entry.result.zeta, entry.result.pvalue, entry.residual };
+      memcpy( p, fields, sizeof(fields) );
+      memcpy( p + sizeof(fields), values, sizeof(values) );
+   }
+
+   CheckpointEntry Decode( const unsigned char* p )
+   {
+      std::int32_t fields[4];
+      double values[5];
+      memcpy( fields, p, sizeof(fields) );
+      memcpy( values, p + sizeof(fields), sizeof(values) );
+
+      CheckpointEntry entry;
+      entry.k      = fields[0];
+      entry.status = fields[1];
+      entry.result = { values[0], values[1], values[2], values[3], fields[2] };
+      entry.iterations = fields[3];
+      entry.residual   = values[4];
+      return entry;
+   }
+
+   //--------------------------------------------------------------------------
+   // A second descriptor of the file, through which what has been flushed
+   // to it is forced to the disk; the C++ streams offer no way to do so.
+   //--------------------------------------------------------------------------
+   int OpenDescriptor( const std::string& filename )
+   {
+   #ifdef _WIN32
+      return _open( filename.c_str(), _O_WRONLY | _O_BINARY );
+   #else
+      return open( filename.c_str(), O_WRONLY );
+   #endif
+   }
+
+   bool SyncDescriptor( int fd )
+   {
+   #ifdef _WIN32
+      return _commit( fd ) == 0;
+   #else
+      return fsync( fd ) == 0;
+   #endif
+   }
+
+   void CloseDescriptor( int fd )
+   {
+   #ifdef _WIN32
+      _close( fd );
+   #else
+      close( fd );
+   #endif
+   }
+}
+
+//-----------------------------------------------------------------------------
+unsigned long long HashObservations( const std::vector<DataRecord>& obs )
+{
+   unsigned long long h = FNV_OFFSET;
+
+   const std::uint64_t n = obs.size();
+   Hash( h, &n, sizeof(n) );
+   for (const auto& rec : obs) {
+      const std::uint64_t length = rec.id.size();
+      Hash( h, &length, sizeof(length) );
+      Hash( h, rec.id.data(), rec.id.size() );
+      Hash( h, &rec.x, sizeof(rec.x) );
+      Hash( h, &rec.y, sizeof(rec.y) );
+      Hash( h, &rec.z, sizeof(rec.z) );
+   }
+   return h;
+}
+
+//=============================================================================
+// Checkpoint
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+Checkpoint::Checkpoint( const std::string& filename, unsigned long long hash, const std::string& parameters, int n )
+:  m_filename( filename ),
+   m_hash( hash ),
+   m_parameters( parameters ),
+   m_n( n ),
+   m_file(),
+   m_descriptor( -1 ),
+   m_valid( 0 ),
+   m_writer(),
+   m_mutex(),
+   m_ready(),
+   m_pending(),
+   m_closing( false ),
+   m_failed( false )
+{
+}
+
+//-----------------------------------------------------------------------------
+Checkpoint::~Checkpoint()
+{
+   Stop();
+   if ( m_descriptor >= 0 ) CloseDescriptor( m_descriptor );
+}
+
+//-----------------------------------------------------------------------------
+// Load
+//-----------------------------------------------------------------------------
+bool Checkpoint::Load( std::vector<CheckpointEntry>& entries )
+{
+   entries.clear();
+   m_valid = 0;
+
+   std::ifstream file( m_filename, std::ios::binary );
+   if ( !file ) return false;
+
+   char magic[sizeof(MAGIC)];
+   unsigned long long hash = 0;
+   std::uint32_t length = 0;
+   file.read( magic, sizeof(magic) );
+   file.read( reinterpret_cast<char*>(&hash), sizeof(hash) );
+   file.read( reinterpret_cast<char*>(&length), sizeof(length) );
+
+   std::string parameters;
+   if ( file ) {
+      parameters.resize( length );
+      file.read( &parameters[0], length );
+   }
+
+   std::stringstream message;
+   message << "<" << m_filename << "> ";
+   if ( !file || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ) {
+      message << "is not a checkpoint file.";
+      throw InvalidCheckpointFile(message.str());
+   }
+   if ( hash != m_hash ) {
+      message << "is a checkpoint of different input data.";
+      throw InvalidCheckpointFile(message.str());
+   }
+   if ( parameters != m_parameters ) {
+      message << "is a checkpoint of a run with different parameters: " << parameters;
+      throw InvalidCheckpointFile(message.str());
+   }
+   m_valid = sizeof(MAGIC) + sizeof(hash) + sizeof(length) + length;
+
+   unsigned char record[RECORD_SIZE];
+   while ( file.read(reinterpret_cast<char*>(record), RECORD_SIZE) ) {
+      const CheckpointEntry entry = Decode( record );
+      if ( entry.k < 0 || entry.k >= m_n ) {
+         message << "is corrupt at byte " << m_valid << ".";
+         throw InvalidCheckpointFile(message.str());
+      }
+      entries.push_back( entry );
+      m_valid += RECORD_SIZE;
+   }
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+// Open
+//
+//    Appends after the records loaded, over any partial record, or else
+//    starts a new file.
+//-----------------------------------------------------------------------------
+void Checkpoint::Open()
+{
+   if ( m_valid > 0 ) {
+      m_file.open( m_filename, std::ios::in | std::ios::out | std::ios::binary );
+      m_file.seekp( m_valid );
+   }
+   else {
+      const std::uint32_t length = m_parameters.size();
+      m_file.open( m_filename, std::ios::out | std::ios::trunc | std::ios::binary );
+      m_file.write( MAGIC, sizeof(MAGIC) );
+      m_file.write( reinterpret_cast<const char*>(&m_hash), sizeof(m_hash) );
+      m_file.write( reinterpret_cast<const char*>(&length), sizeof(length) );
+      m_file.write( m_parameters.data(), length );
+      m_file.flush();
+   }
+
+   m_descriptor = OpenDescriptor( m_filename );
+   if ( m_file.fail() || m_descriptor < 0 || !SyncDescriptor(m_descriptor) ) {
+      std::stringstream message;
+      message << "Could not open <" << m_filename << "> for output.";
+      throw InvalidCheckpointFile(message.str());
+   }
+
+   m_closing = false;
+   m_failed  = false;
+   m_writer  = std::thread( &Checkpoint::Run, this );
+}
+
+//-----------------------------------------------------------------------------
+void Checkpoint::Append( int k, int status, const Boomerang& result, int iterations, double residual )
+{
+   std::lock_guard<std::mutex> lock(m_mutex);
+   m_pending.push_back( CheckpointEntry{ k, status, result, iterations, residual } );
+   if ( static_cast<int>(m_pending.size()) == BATCH ) m_ready.notify_one();
+}
+
+//-----------------------------------------------------------------------------
+void Checkpoint::Close()
+{
+   Stop();
+   if ( m_file.is_open() ) m_file.close();
+   if ( m_descriptor >= 0 ) {
+      CloseDescriptor( m_descriptor );
+      m_descriptor = -1;
+   }
+
+   if ( m_failed ) {
+      std::stringstream message;
+      message << "Writing to <" << m_filename << "> failed.";
+      throw InvalidCheckpointFile(message.str());
+   }
+}
+
+//-----------------------------------------------------------------------------
+void Checkpoint::Stop()
+{
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_closing = true;
+   }
+   m_ready.notify_one();
+   if ( m_writer.joinable() ) m_writer.join();
+}
+
+//-----------------------------------------------------------------------------
+// Run
+//
+//    The writer thread: every BATCH records, or every FLUSH_INTERVAL, write
+//    what has accumulated in one piece, flush it to the file, and sync the
+//    file to the disk.
+//-----------------------------------------------------------------------------
+void Checkpoint::Run()
+{
+   std::vector<CheckpointEntry> batch;
+   std::vector<unsigned char> bytes;
+   bool synced = true;
+
+   std::unique_lock<std::mutex> lock(m_mutex);
+   for (;;) {
+      m_ready.wait_for( lock, FLUSH_INTERVAL, [this]{ return m_closing || static_cast<int>(m_pending.size()) >= BATCH; } );
+      batch.swap( m_pending );
+      const bool closing = m_closing;
+      lock.unlock();
+
+      if ( !batch.empty() ) {
+         bytes.resize( batch.size() * RECORD_SIZE );
+         for (std::size_t i = 0; i < batch.size(); ++i)
+            Encode( batch[i], &bytes[i*RECORD_SIZE] );
+         m_file.write( reinterpret_cast<const char*>(bytes.data()), bytes.size() );
+         m_file.flush();
+         synced = !m_file.fail() && SyncDescriptor( m_descriptor );
+         batch.clear();
+      }
+
+      lock.lock();
+      if ( m_file.fail() || !synced ) m_failed = true;
+      if ( closing && m_pending.empty() ) break;
+   }
+}
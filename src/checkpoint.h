@@ -0,0 +1,124 @@
+//=============================================================================
+// checkpoint.h
+//
+//    An append-only binary record of the completed observations of a run,
+//    from which an interrupted run can resume.
+//
+//    The file is a header, identifying the run, followed by fixed-size
+//    records, one per completed observation, in the order of completion:
+//
+//       header:  "WBNCKPT2"              8 bytes
+//                hash of the input       8 bytes
+//                parameter length        4 bytes
+//                parameters              text
+//
+//       record:  observation index       4 bytes
+//                status                  4 bytes
+//                count                   4 bytes
+//                iterations              4 bytes
+//                zhat, kstd, zeta, p     4 x 8 bytes
+//                residual                8 bytes
+//
+//    The iterations and residual are those of an iterative solution, or 0
+//    and NaN.
+//
+//    in the byte order of the machine. A record cut short by a crash is
+//    ignored, and overwritten by the next one appended. Every batch written
+//    is also synchronized to the disk, so a checkpoint survives a crash of
+//    the machine, and not only of the program.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cmath>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "engine.h"
+#include "read_data.h"
+
+//-----------------------------------------------------------------------------
+class InvalidCheckpointFile : public std::runtime_error {
+   public :
+      InvalidCheckpointFile( const std::string& message ) : std::runtime_error(message) {
+      }
+};
+
+//-----------------------------------------------------------------------------
+struct CheckpointEntry {
+   int       k;                         // observation index
+   int       status;                    // as the caller defines it
+   Boomerang result;
+   int       iterations;                // of an iterative solution, or 0
+   double    residual;                  // of an iterative solution, or NaN
+};
+
+//-----------------------------------------------------------------------------
+// A 64-bit FNV-1a hash of the observations: their number, and every
+// identifier and coordinate, bit for bit.
+//-----------------------------------------------------------------------------
+unsigned long long HashObservations( const std::vector<DataRecord>& obs );
+
+//-----------------------------------------------------------------------------
+// Checkpoint
+//
+//    Load reads the entries of an existing checkpoint of the same run. Open
+//    then starts a background thread that appends the entries handed to
+//    Append, in batches, after those loaded, or to a new file if nothing was
+//    loaded. Close writes whatever is left. The calling thread never waits
+//    on the disk, only on a brief lock.
+//-----------------------------------------------------------------------------
+class Checkpoint {
+   public :
+      // A run of "n" observations with the given hash and parameters, which
+      // a checkpoint must match to be loaded.
+      Checkpoint( const std::string& filename, unsigned long long hash, const std::string& parameters, int n );
+      ~Checkpoint();
+
+      // Returns false if there is no such file. Throws InvalidCheckpointFile
+      // if it is not a checkpoint of this run.
+      bool Load( std::vector<CheckpointEntry>& entries );
+
+      void Open();
+      void Append( int k, int status, const Boomerang& result, int iterations = 0, double residual = NAN );
+      void Close();
+
+      Checkpoint( const Checkpoint& ) = delete;
+      Checkpoint& operator=( const Checkpoint& ) = delete;
+
+   private :
+      void Run();
+      void Stop();
+
+      std::string                  m_filename;
+      unsigned long long           m_hash;
+      std::string                  m_parameters;
+      int                          m_n;
+
+      std::fstream                 m_file;
+      int                          m_descriptor;  // of the same file, to sync it
+      long long                    m_valid;     // bytes of whole records loaded
+      std::thread                  m_writer;
+      std::mutex                   m_mutex;
+      std::condition_variable      m_ready;
+      std::vector<CheckpointEntry> m_pending;
+      bool                         m_closing;
+      bool                         m_failed;
+};
+
+
+//=============================================================================
+#endif  // CHECKPOINT_H
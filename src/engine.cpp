@@ -12,134 +12,3137 @@
 // version:
 //    26 June 2017
 //=============================================================================
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
 #include <iomanip>
 #include <math.h>
-#include <numeric>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
 
+#include "arena.h"
+#include "batched_cholesky-inl.h"
 #include "engine.h"
+#include "fast_exp-inl.h"
+#include "fixed_cholesky-inl.h"
+#include "hmatrix.h"
 #include "matrix.h"
 #include "linear_systems.h"
+#include "locations.h"
+#include "matrix_free.h"
+#include "nystrom.h"
+#include "profile.h"
+#include "sparse_cholesky.h"
 #include "special_functions.h"
+#include "sum_product-inl.h"
+#include "trace.h"
+#include "vecchia.h"
+
+namespace{
+   // Manifest constants.
+   const int MINIMUM_COUNT = 10;
+   const int ASSEMBLY_TILE = 64;
+   const int MAX_REFINEMENT_SOLVES = 10;
+   const int MIXED_AUDIT_STRIDE    = 32;
+   const int MAX_CG_ITERATIONS     = 1000;
+   const int ITERATIVE_BATCH       = 16;
+   const double AUDIT_TOLERANCE    = 1e-10;
+   const int NYSTROM_AUDIT         = 16;     // default audit sample
+   const int NYSTROM_AUDIT_POINTS  = 10000;  // largest N with all of it
+   const double MEMORY_FRACTION    = 0.75;   // of that available, for the workers
+
+   //--------------------------------------------------------------------------
+   // Workspace
+   //
+   //    The scratch storage of one worker thread. The arena is reserved once
+   //    for the largest possible active set, M = N-1, and reset for every
+   //    observation, so that the steady-state loop does no heap allocation,
+   //    each scratch vector is packed for the actual M, and every one starts
+   //    on a cache line. The mixed-precision statistics are merged when the
+   //    worker finishes.
+   //
+   //    In a batched run the arena instead holds one batch of interleaved
+   //    systems of at most FIXED_MAX unknowns, and there is an active set for
+   //    each lane.
+   //
+   //    In a local run the caller keeps the active set, and the covariance
+   //    matrix of just that set, which is factored in place; the arena then
+   //    holds no double-precision copy of it.
+   //--------------------------------------------------------------------------
+   struct Workspace {
+      std::vector<int> active;         // indices of the active observations
+      Arena            arena;          // see Evaluate, EvaluateBatch
+      PrecisionReport  report;         // mixed-precision statistics
+
+      Workspace( int N, Precision precision, bool batched, bool local = false )
+      :  active( local ? 0 : batched ? BATCH_LANES*N : N ),
+         arena( Footprint(N, precision, batched, local) ),
+         report()
+      {
+      }
+
+      static std::size_t Footprint( int N, Precision precision, bool batched, bool local = false )
+      {
+         if (batched) {
+            const std::size_t F = std::min( N, FIXED_MAX );
+            return sizeof(double)*(BATCH_LANES*(F*F + 2*F) + 5*F) + 16*ARENA_ALIGNMENT;
+         }
+
+         const std::size_t NN = static_cast<std::size_t>(N)*N;
+         std::size_t bytes = sizeof(double)*((local ? 0 : NN) + 5*N);
+         if (precision == PRECISION_MIXED)
+            bytes += sizeof(float)*(NN + 2*N) + sizeof(double)*5*N;
+         return bytes + 16*ARENA_ALIGNMENT;
+      }
+   };
+
+   //--------------------------------------------------------------------------
+   // SolveDouble
+   //
+   //    Solve A u = b and A v = 1, where A is the covariance matrix of the M
+   //    active observations, in double precision. Only the lower triangle of
+   //    A is needed. Returns false if A is not numerically positive definite.
+   //--------------------------------------------------------------------------
+   bool SolveDouble(
+      int M,
+      const Matrix& C,
+      const int* active,
+      const double* b,
+      double* u,
+      double* v,
+      Arena& arena )
+   {
+      double* A = arena.Allocate<double>( static_cast<std::size_t>(M)*M );
+      {
+         ScopedTimer timer( PHASE_SLICE );
+         for (int r = 0; r < M; ++r) {
+            const double* Cr = C.Base(active[r], 0);
+            double* Ar = A + r*M;
+            for (int c = 0; c <= r; ++c)
+               Ar[c] = Cr[active[c]];
+         }
+      }
+
+      if (!CholeskyDecomposition(M, A, M))
+         return false;
+
+      for (int r = 0; r < M; ++r) {
+         u[r] = b[r];
+         v[r] = 1.0;
+      }
+      CholeskySolve(M, A, M, u);
+      CholeskySolve(M, A, M, v);
+      return true;
+   }
+
+   //--------------------------------------------------------------------------
+   // SolveInPlace
+   //
+   //    As SolveDouble, for the caller's own covariance matrix of just the
+   //    active observations, in its first M rows and columns. Its lower
+   //    triangle is overwritten by the Cholesky factor, rather than copied.
+   //--------------------------------------------------------------------------
+   bool SolveInPlace(
+      int M,
+      Matrix& C,
+      const double* b,
+      double* u,
+      double* v )
+   {
+      const int LD = C.nCols();
+      if (!CholeskyDecomposition(M, C.Base(), LD))
+         return false;
+
+      for (int r = 0; r < M; ++r) {
+         u[r] = b[r];
+         v[r] = 1.0;
+      }
+      CholeskySolve(M, C.Base(), LD, u);
+      CholeskySolve(M, C.Base(), LD, v);
+      return true;
+   }
+
+   //--------------------------------------------------------------------------
+   // SolveFixed
+   //
+   //    Solve the same two systems as SolveDouble, for M <= N, with the
+   //    fixed-size kernels of order N and stack storage. The system is padded
+   //    to order N with identity rows and zero right-hand sides; the padded
+   //    block is decoupled from the active one, so the first M entries of the
+   //    solutions are unchanged and the rest are zero.
+   //--------------------------------------------------------------------------
+   template <int N>
+   bool SolveFixed(
+      int M,
+      const Matrix& C,
+      const int* active,
+      const double* b,
+      double* u,
+      double* v )
+   {
+      const int LD = FixedStride<N>();
+      alignas(ARENA_ALIGNMENT) double A[N*(N + FIXED_BLOCK)];
+      alignas(ARENA_ALIGNMENT) double x[N];
+      alignas(ARENA_ALIGNMENT) double y[N];
+      {
+         ScopedTimer timer( PHASE_SLICE );
+         for (int r = 0; r < M; ++r) {
+            const double* Cr = C.Base(active[r], 0);
+            double* Ar = A + r*LD;
+            for (int c = 0; c <= r; ++c)
+               Ar[c] = Cr[active[c]];
+            x[r] = b[r];
+            y[r] = 1.0;
+         }
+         for (int r = M; r < N; ++r) {
+            double* Ar = A + r*LD;
+            for (int c = 0; c < r; ++c)
+               Ar[c] = 0.0;
+            Ar[r] = 1.0;
+            x[r] = 0.0;
+            y[r] = 0.0;
+         }
+      }
+
+      {
+         ScopedTimer timer( PHASE_FACTORIZATION );
+         if (!FixedCholesky<N>(A))
+            return false;
+      }
+      {
+         ScopedTimer timer( PHASE_SOLVE );
+         FixedSolve<N>(A, x);
+         FixedSolve<N>(A, y);
+      }
+
+      for (int r = 0; r < M; ++r) {
+         u[r] = x[r];
+         v[r] = y[r];
+      }
+      return true;
+   }
+
+   //--------------------------------------------------------------------------
+   // Dispatch a system of order M <= FIXED_MAX to the smallest fixed-size
+   // kernel that holds it.
+   //--------------------------------------------------------------------------
+   bool SolveSmall(
+      int M,
+      const Matrix& C,
+      const int* active,
+      const double* b,
+      double* u,
+      double* v )
+   {
+      assert(0 < M && M <= FIXED_MAX);
+
+      switch ((M + FIXED_STEP - 1) / FIXED_STEP) {
+         case 1:  return SolveFixed< 8>(M, C, active, b, u, v);
+         case 2:  return SolveFixed<16>(M, C, active, b, u, v);
+         case 3:  return SolveFixed<24>(M, C, active, b, u, v);
+         case 4:  return SolveFixed<32>(M, C, active, b, u, v);
+         case 5:  return SolveFixed<40>(M, C, active, b, u, v);
+         case 6:  return SolveFixed<48>(M, C, active, b, u, v);
+         case 7:  return SolveFixed<56>(M, C, active, b, u, v);
+         default: return SolveFixed<64>(M, C, active, b, u, v);
+      }
+   }
+
+   //--------------------------------------------------------------------------
+   // SolveMixed
+   //
+   //    Solve the same two systems as SolveDouble, with A assembled and
+   //    factored in float32, and double-precision accuracy recovered by
+   //    iterative refinement: each correction is solved with the float32
+   //    factor, against a residual computed in double precision from the
+   //    double covariances in C.
+   //
+   //    Returns the number of float32 solves per system, or 0 if the float32
+   //    factorization failed or the refinement did not converge within
+   //    MAX_REFINEMENT_SOLVES; the caller then falls back to SolveDouble.
+   //
+   //    The stopping test is that of LAPACK's dsposv: the normwise residual
+   //    ||r|| <= sqrt(M) eps ||A|| ||x||, in the infinity norm.
+   //--------------------------------------------------------------------------
+   int SolveMixed(
+      int M,
+      const Matrix& C,
+      const int* active,
+      const double* b,
+      double* u,
+      double* v,
+      Arena& arena )
+   {
+      float* A = arena.Allocate<float>( static_cast<std::size_t>(M)*M );
+      {
+         ScopedTimer timer( PHASE_SLICE );
+         for (int r = 0; r < M; ++r) {
+            const double* Cr = C.Base(active[r], 0);
+            float* Ar = A + r*M;
+            for (int c = 0; c <= r; ++c)
+               Ar[c] = static_cast<float>( Cr[active[c]] );
+         }
+      }
+
+      if (!CholeskyDecomposition(M, A, M))
+         return 0;
+
+      float*  du = arena.Allocate<float>( M );    // float32 corrections
+      float*  dv = arena.Allocate<float>( M );
+      double* ru = arena.Allocate<double>( M );   // double residuals
+      double* rv = arena.Allocate<double>( M );
+
+      for (int r = 0; r < M; ++r) {
+         u[r]  = 0.0;
+         v[r]  = 0.0;
+         ru[r] = b[r];
+         rv[r] = 1.0;
+      }
+
+      const double tolerance = sqrt( static_cast<double>(M) ) * DBL_EPSILON;
+
+      for (int solves = 1; solves <= MAX_REFINEMENT_SOLVES; ++solves) {
+         for (int r = 0; r < M; ++r) {
+            du[r] = static_cast<float>( ru[r] );
+            dv[r] = static_cast<float>( rv[r] );
+         }
+         CholeskySolve(M, A, M, du);
+         CholeskySolve(M, A, M, dv);
+
+         for (int r = 0; r < M; ++r) {
+            u[r] += du[r];
+            v[r] += dv[r];
+         }
+
+         // The residuals, and the norms for the stopping test.
+         ScopedTimer timer( PHASE_SOLVE );
+
+         double Anorm = 0.0, unorm = 0.0, vnorm = 0.0, runorm = 0.0, rvnorm = 0.0;
+         for (int r = 0; r < M; ++r) {
+            const double* Cr = C.Base(active[r], 0);
+            double su = b[r], sv = 1.0, sa = 0.0;
+            for (int c = 0; c < M; ++c) {
+               const double a = Cr[active[c]];
+               su -= a*u[c];
+               sv -= a*v[c];
+               sa += fabs(a);
+            }
+            ru[r] = su;
+            rv[r] = sv;
+
+            Anorm  = std::max( Anorm, sa );
+            unorm  = std::max( unorm, fabs(u[r]) );
+            vnorm  = std::max( vnorm, fabs(v[r]) );
+            runorm = std::max( runorm, fabs(su) );
+            rvnorm = std::max( rvnorm, fabs(sv) );
+         }
+
+         if (runorm <= tolerance*Anorm*unorm && rvnorm <= tolerance*Anorm*vnorm)
+            return solves;
+      }
+      return 0;
+   }
+
+   //--------------------------------------------------------------------------
+   // Combine
+   //
+   //    Form the Ordinary Kriging weights w from u = A^{-1} b and v = A^{-1} 1,
+   //    and fill in the estimate, its standard deviation, and zeta.
+   //--------------------------------------------------------------------------
+   void Combine(
+      int M,
+      double sill,
+      double zk,
+      const double* b,
+      const double* z,
+      const double* u,
+      const double* v,
+      double* w,
+      Boomerang& result )
+   {
+      double sum_u = 0.0, sum_v = 0.0;
+      for (int r = 0; r < M; ++r) {
+         sum_u += u[r];
+         sum_v += v[r];
+      }
+      double lambda = ( sum_u - 1 ) / sum_v;
+
+      for (int r = 0; r < M; ++r)
+         w[r] = u[r] - lambda*v[r];
+
+      double zhat = SumProduct(M, w, z);
+      double kstd = sqrt( sill - SumProduct(M, b, w) - lambda );
+
+      result.zhat = zhat;
+      result.kstd = kstd;
+      result.zeta = (zk-zhat) / kstd;
+   }
+
+   //--------------------------------------------------------------------------
+   // Combine
+   //
+   //    As above, from the inner products alone, for the engines that never
+   //    form u and v: sum_u = 1'u, sum_v = 1'v, zu = z'u, zv = z'v, bu = b'u,
+   //    and bv = b'v. With w = u - lambda*v, zhat = zu - lambda*zv and
+   //    b'w = bu - lambda*bv.
+   //--------------------------------------------------------------------------
+   void Combine(
+      double sill,
+      double zk,
+      double sum_u,
+      double sum_v,
+      double zu,
+      double zv,
+      double bu,
+      double bv,
+      Boomerang& result )
+   {
+      const double lambda = ( sum_u - 1 ) / sum_v;
+      const double zhat = zu - lambda*zv;
+      const double kstd = sqrt( sill - (bu - lambda*bv) - lambda );
+
+      result.zhat = zhat;
+      result.kstd = kstd;
+      result.zeta = (zk - zhat) / kstd;
+   }
+
+   //--------------------------------------------------------------------------
+   // Audit
+   //
+   //    Re-solve an observation of a mixed-precision run in double precision,
+   //    and record the differences in the report. If "own" is not null, C is
+   //    factored in place; see Krige.
+   //--------------------------------------------------------------------------
+   void Audit(
+      int M,
+      double sill,
+      double zk,
+      const Matrix& C,
+      Matrix* own,
+      const int* active,
+      const double* b,
+      const double* z,
+      const Boomerang& result,
+      Arena& arena,
+      PrecisionReport& report )
+   {
+      double* u = arena.Allocate<double>( M );
+      double* v = arena.Allocate<double>( M );
+      double* w = arena.Allocate<double>( M );
+
+      const bool solved = own ? SolveInPlace(M, *own, b, u, v) : SolveDouble(M, C, active, b, u, v, arena);
+      if (!solved)
+         return;
+
+      Boomerang reference = result;
+      Combine(M, sill, zk, b, z, u, v, w, reference);
+
+      ++report.audited;
+      report.max_zhat_error = std::max( report.max_zhat_error, fabs(result.zhat - reference.zhat) / fabs(reference.zhat) );
+      report.max_kstd_error = std::max( report.max_kstd_error, fabs(result.kstd - reference.kstd) / reference.kstd );
+      report.max_zeta_error = std::max( report.max_zeta_error, fabs(result.zeta - reference.zeta) );
+   }
+
+   //--------------------------------------------------------------------------
+   // Merge the mixed-precision statistics of one worker into the total.
+   //--------------------------------------------------------------------------
+   void Merge( PrecisionReport& total, const PrecisionReport& part )
+   {
+      total.systems   += part.systems;
+      total.fallbacks += part.fallbacks;
+      total.solves    += part.solves;
+      total.audited   += part.audited;
+
+      total.max_solves     = std::max( total.max_solves,     part.max_solves );
+      total.max_zhat_error = std::max( total.max_zhat_error, part.max_zhat_error );
+      total.max_kstd_error = std::max( total.max_kstd_error, part.max_kstd_error );
+      total.max_zeta_error = std::max( total.max_zeta_error, part.max_zeta_error );
+   }
+
+   //--------------------------------------------------------------------------
+   // ActiveSet
+   //
+   //    Fill "active" with the indices of the active observations for the
+   //    location of observation [k], i.e. those outside of the buffer radius,
+   //    and return their number, M. If "neighbors" > 0, only that many of
+   //    them, those nearest to [k], are kept, ties going to the lower index,
+   //    in their original order.
+   //--------------------------------------------------------------------------
+   int ActiveSet( int k, double radius, int neighbors, const Matrix& D, int* active )
+   {
+      const int N = D.nCols();
+      const double* Dk = D.Base(k, 0);
+
+      int M = 0;
+      for (int j = 0; j < N; ++j) {
+         if (Dk[j] >= radius && j != k)
+            active[M++] = j;
+      }
+
+      if (neighbors > 0 && M > neighbors) {
+         auto nearer = [Dk](int i, int j) {
+            return Dk[i] < Dk[j] || (!(Dk[j] < Dk[i]) && i < j);
+         };
+         std::nth_element(active, active + neighbors, active + M, nearer);
+         std::sort(active, active + neighbors);
+         M = neighbors;
+      }
+      return M;
+   }
+
+   //--------------------------------------------------------------------------
+   // The result of an observation without a solution.
+   //--------------------------------------------------------------------------
+   Boomerang Unsolved( int M )
+   {
+      Boomerang result;
+      result.zhat   = NAN;
+      result.kstd   = NAN;
+      result.zeta   = NAN;
+      result.pvalue = NAN;                      // see PValues
+      result.cnt    = M;
+      return result;
+   }
+
+   //--------------------------------------------------------------------------
+   // Krige
+   //
+   //    The kriging of observation [k], of value zk, once its M active
+   //    observations are known: their rows of C are active[], and that of
+   //    observation [k] is "row"; their indices in obs are data[]. In
+   //    Evaluate the rows and the indices are the same; in EvaluateLocal, C
+   //    holds only these rows. A hypothetical observation has k = -1.
+   //
+   //    If "own" is not null, it is C itself, the caller's scratch copy of
+   //    just these rows, in order; the double-precision factorization, the
+   //    last use of C, then overwrites its lower triangle.
+   //
+   //    If "fixed", as with a neighbor count, a system of at most FIXED_MAX
+   //    unknowns is solved with the fixed-size kernels; otherwise, as with
+   //    all of the active data, it is solved as a larger one would be.
+   //--------------------------------------------------------------------------
+   Boomerang Krige(
+      int k,
+      double zk,
+      int M,
+      const int* active,
+      const int* data,
+      int row,
+      double sill,
+      const std::vector<DataRecord>& obs,
+      const Matrix& C,
+      Matrix* own,
+      bool fixed,
+      Precision precision,
+      Workspace& ws )
+   {
+      Boomerang result = Unsolved(M);
+      if( M < MINIMUM_COUNT )
+         return result;
+
+      // Carve the scratch storage for this observation out of the arena:
+      // b holds the covariances with observation [k]; z the active observed
+      // values; u = A^{-1} b; v = A^{-1} 1; and w the kriging weights.
+      ws.arena.Reset();
+      double* b = ws.arena.Allocate<double>( M );
+      double* z = ws.arena.Allocate<double>( M );
+      double* u = ws.arena.Allocate<double>( M );
+      double* v = ws.arena.Allocate<double>( M );
+      double* w = ws.arena.Allocate<double>( M );
+      {
+         ScopedTimer timer( PHASE_SLICE );
+         for (int r = 0; r < M; ++r) {
+            b[r] = C(active[r], row);
+            z[r] = obs[data[r]].z;
+         }
+      }
+
+      // Solve the Ordinary Kriging system for the location of observation [k]
+      // using only the active data.
+      const bool small = fixed && M <= FIXED_MAX;
+      bool solved = false;
+      if (small) {
+         solved = SolveSmall(M, C, active, b, u, v);
+      }
+      else if (precision == PRECISION_MIXED) {
+         const int solves = SolveMixed(M, C, active, b, u, v, ws.arena);
+
+         ++ws.report.systems;
+         ws.report.solves += solves;
+         ws.report.max_solves = std::max( ws.report.max_solves, solves );
+
+         solved = solves > 0;
+         if (!solved) {
+            ++ws.report.fallbacks;
+            solved = own ? SolveInPlace(M, *own, b, u, v) : SolveDouble(M, C, active, b, u, v, ws.arena);
+         }
+      }
+      else {
+         solved = own ? SolveInPlace(M, *own, b, u, v) : SolveDouble(M, C, active, b, u, v, ws.arena);
+      }
+
+      if (solved) {
+         Combine(M, sill, zk, b, z, u, v, w, result);
+
+         if (precision == PRECISION_MIXED && !small && k % MIXED_AUDIT_STRIDE == 0)
+            Audit(M, sill, zk, C, own, active, b, z, result, ws.arena, ws.report);
+      }
+      return result;
+   }
+
+   //--------------------------------------------------------------------------
+   // Evaluate
+   //
+   //    Compute the boomerang statistic for the single observation [k]. The
+   //    p-value is left to PValues.
+   //
+   //    If "neighbors" > 0, only that many of the active observations, those
+   //    nearest to observation [k], are used, and systems of at most
+   //    FIXED_MAX unknowns are then solved in double precision, with the
+   //    fixed-size kernels; at that size float32 saves nothing.
+   //--------------------------------------------------------------------------
+   Boomerang Evaluate(
+      int k,
+      double sill,
+      double radius,
+      int neighbors,
+      const std::vector<DataRecord>& obs,
+      const Matrix& D,
+      const Matrix& C,
+      Precision precision,
+      Workspace& ws )
+   {
+      TraceSpan span( "observation" );
+      span.Arg( "k", k );
+
+      // Determine the active subset of the observations for the location of
+      // observation [k].
+      const int M = ActiveSet(k, radius, neighbors, D, ws.active.data());
+      span.Arg( "M", M );
+
+      return Krige(k, obs[k].z, M, ws.active.data(), ws.active.data(), k, sill, obs, C, nullptr, neighbors > 0, precision, ws);
+   }
+
+   //--------------------------------------------------------------------------
+   // EvaluateBatch
+   //
+   //    Compute the boomerang statistics for the "count" <= BATCH_LANES
+   //    observations ks[0], ..., ks[count-1], whose active sets are limited to
+   //    "neighbors" <= FIXED_MAX. Their kriging systems are padded with
+   //    identity rows to the largest order in the batch, interleaved, and
+   //    factored and solved together by BatchedCholesky and BatchedSolve.
+   //    Lanes without a system are left as identities.
+   //--------------------------------------------------------------------------
+   void EvaluateBatch(
+      const int* ks,
+      int count,
+      double sill,
+      double radius,
+      int neighbors,
+      const std::vector<DataRecord>& obs,
+      const Matrix& D,
+      const Matrix& C,
+      Workspace& ws,
+      Boomerang* results )
+   {
+      const int N = obs.size();
+      const int W = BATCH_LANES;
+
+      TraceSpan span( "batch" );
+      span.Arg( "k", ks[0] );
+
+      // The active set of each lane; M[l] = 0 where there is no system.
+      int M[W];
+      int n = 0;
+      for (int l = 0; l < W; ++l) {
+         M[l] = 0;
+         if (l < count) {
+            M[l] = ActiveSet(ks[l], radius, neighbors, D, &ws.active[l*N]);
+            results[l] = Unsolved( M[l] );
+            if (M[l] < MINIMUM_COUNT) M[l] = 0;
+         }
+         n = std::max( n, M[l] );
+      }
+      span.Arg( "M", n );
+
+      if (n == 0)
+         return;
+
+      // Gather the interleaved systems: x holds the b's, and y the 1's.
+      ws.arena.Reset();
+      double* A = ws.arena.Allocate<double>( W*n*n );
+      double* x = ws.arena.Allocate<double>( W*n );
+      double* y = ws.arena.Allocate<double>( W*n );
+      {
+         ScopedTimer timer( PHASE_SLICE );
+         for (int l = 0; l < W; ++l) {
+            const int* active = &ws.active[l*N];
+
+            for (int r = 0; r < M[l]; ++r) {
+               const double* Cr = C.Base(active[r], 0);
+               double* Ar = A + r*n*W + l;
+               for (int c = 0; c <= r; ++c)
+                  Ar[c*W] = Cr[active[c]];
+               x[r*W + l] = Cr[ks[l]];
+               y[r*W + l] = 1.0;
+            }
+            for (int r = M[l]; r < n; ++r) {
+               double* Ar = A + r*n*W + l;
+               for (int c = 0; c < r; ++c)
+                  Ar[c*W] = 0.0;
+               Ar[r*W] = 1.0;
+               x[r*W + l] = 0.0;
+               y[r*W + l] = 0.0;
+            }
+         }
+      }
+
+      bool ok[W];
+      {
+         ScopedTimer timer( PHASE_FACTORIZATION );
+         BatchedCholesky(n, A, ok);
+      }
+      {
+         ScopedTimer timer( PHASE_SOLVE );
+         BatchedSolve(n, A, x);
+         BatchedSolve(n, A, y);
+      }
+
+      // Unpack each lane, and combine as in Evaluate.
+      double* b = ws.arena.Allocate<double>( n );
+      double* z = ws.arena.Allocate<double>( n );
+      double* u = ws.arena.Allocate<double>( n );
+      double* v = ws.arena.Allocate<double>( n );
+      double* w = ws.arena.Allocate<double>( n );
+
+      for (int l = 0; l < W; ++l) {
+         if (M[l] == 0 || !ok[l])
+            continue;
+
+         const int* active = &ws.active[l*N];
+         for (int r = 0; r < M[l]; ++r) {
+            b[r] = C(active[r], ks[l]);
+            z[r] = obs[active[r]].z;
+            u[r] = x[r*W + l];
+            v[r] = y[r*W + l];
+         }
+         Combine(M[l], sill, obs[ks[l]].z, b, z, u, v, w, results[l]);
+      }
+   }
+
+   //--------------------------------------------------------------------------
+   // LocalWorkspace
+   //
+   //    The scratch storage of one worker thread of the local engine: that of
+   //    Evaluate, for active sets of at most M observations, and the
+   //    covariance matrix of an active set and its observation, filled in
+   //    afresh for each one and factored in place.
+   //--------------------------------------------------------------------------
+   struct LocalWorkspace {
+      Workspace        base;
+      std::vector<int> points;         // the active observations, then [k]
+      std::vector<int> rows;           // 0, 1, ..., M
+      std::vector<int> found;          // of the nearest-neighbor search
+      Matrix           C;
+
+      LocalWorkspace( int M, Precision precision )
+      :  base( M, precision, false, true ),
+         points( M+1 ),
+         rows( M+1 ),
+         found(),
+         C( M+1, M+1, Matrix::UNINITIALIZED )
+      {
+         for (int r = 0; r <= M; ++r)
+            rows[r] = r;
+      }
+
+      static std::size_t Footprint( int M, Precision precision )
+      {
+         const std::size_t M1 = M + 1;
+         return Workspace::Footprint(M, precision, false, true) + sizeof(double)*M1*M1 + 3*sizeof(int)*M1;
+      }
+   };
+
+   //--------------------------------------------------------------------------
+   // LocalActiveSet
+   //
+   //    The same active set as ActiveSet, for observation [k] at (x,y), into
+   //    ws.points, found without D: by a scan of the distances from (x,y), or,
+   //    if "neighbors" > 0, by a nearest-neighbor search of the k-d tree. A
+   //    hypothetical observation has k = -1.
+   //--------------------------------------------------------------------------
+   int LocalActiveSet(
+      int k,
+      double x,
+      double y,
+      double radius,
+      int neighbors,
+      const Locations& L,
+      LocalWorkspace& ws )
+   {
+      const int N = L.nRows();
+      int* active = ws.points.data();
+
+      auto outside = [k, x, y, radius, &L](int j) {
+         return j != k && L.Distance(j, x, y) >= radius;
+      };
+
+      if (neighbors > 0) {
+         L.Index().Nearest(x, y, neighbors, outside, ws.found);
+         std::sort(ws.found.begin(), ws.found.end());
+         std::copy(ws.found.begin(), ws.found.end(), active);
+         return ws.found.size();
+      }
+
+      int M = 0;
+      for (int j = 0; j < N; ++j) {
+         if (outside(j))
+            active[M++] = j;
+      }
+      return M;
+   }
+
+   //--------------------------------------------------------------------------
+   // EvaluateLocal
+   //
+   //    Compute the boomerang statistic for the single observation [k], as
+   //    Evaluate does, from the covariances of its active set and itself
+   //    alone. The p-value is left to PValues.
+   //--------------------------------------------------------------------------
+   Boomerang EvaluateLocal(
+      int k,
+      double sill,
+      double radius,
+      int neighbors,
+      const std::vector<DataRecord>& obs,
+      const Locations& L,
+      Precision precision,
+      LocalWorkspace& ws )
+   {
+      TraceSpan span( "observation" );
+      span.Arg( "k", k );
+
+      const int M = LocalActiveSet(k, obs[k].x, obs[k].y, radius, neighbors, L, ws);
+      span.Arg( "M", M );
+
+      if (M < MINIMUM_COUNT)
+         return Unsolved(M);
+
+      // Observation [k] is the last row.
+      ws.points[M] = k;
+      {
+         ScopedTimer timer( PHASE_ASSEMBLY );
+         L.Covariances(ws.points.data(), M+1, ws.C);
+      }
+      return Krige(k, obs[k].z, M, ws.rows.data(), ws.points.data(), M, sill, obs, ws.C, &ws.C, neighbors > 0, precision, ws.base);
+   }
+
+   //--------------------------------------------------------------------------
+   // PValues
+   //
+   //    Fill in the p-values, P(Z <= -|zeta|), of "n" results with a single
+   //    batched call, using "x" and "p" as scratch. The tail is computed
+   //    directly rather than as 1 - GaussianCDF(zeta), so small p-values keep
+   //    their relative accuracy.
+   //--------------------------------------------------------------------------
+   void PValues( int n, Boomerang* results, double* x, double* p )
+   {
+      ScopedTimer timer( PHASE_PVALUE );
+
+      for (int i = 0; i < n; ++i)
+         x[i] = -fabs( results[i].zeta );
+
+      GaussianCDF( n, x, p );
+
+      for (int i = 0; i < n; ++i)
+         results[i].pvalue = p[i];
+   }
+
+   //--------------------------------------------------------------------------
+   // EvaluateHypothetical
+   //
+   //    As EvaluateLocal, for a hypothetical observation of value z at (x,y),
+   //    in the last row of the covariance matrix, and with its p-value.
+   //--------------------------------------------------------------------------
+   Boomerang EvaluateHypothetical(
+      double x,
+      double y,
+      double z,
+      double sill,
+      double radius,
+      int neighbors,
+      const std::vector<DataRecord>& obs,
+      const Locations& L,
+      Precision precision,
+      LocalWorkspace& ws )
+   {
+      const int M = LocalActiveSet(-1, x, y, radius, neighbors, L, ws);
+      if (M < MINIMUM_COUNT)
+         return Unsolved(M);
+
+      L.Covariances(ws.points.data(), M, ws.C);
+      for (int r = 0; r < M; ++r) {
+         ws.C(r, M) = L.Covariance(ws.points[r], x, y);
+         ws.C(M, r) = ws.C(r, M);
+      }
+      ws.C(M, M) = sill;
+
+      Boomerang result = Krige(-1, z, M, ws.rows.data(), ws.points.data(), M, sill, obs, ws.C, &ws.C, neighbors > 0, precision, ws.base);
+
+      double scratch[2];
+      PValues(1, &result, &scratch[0], &scratch[1]);
+      return result;
+   }
+
+   //--------------------------------------------------------------------------
+   // Wendland
+   //
+   //    The Wendland taper phi(t) = (1-t)^4 (4t+1) for 0 <= t < 1, and 0 for
+   //    t >= 1. It is positive definite in two and three dimensions, so the
+   //    product of a covariance and the taper is again a covariance.
+   //--------------------------------------------------------------------------
+   inline double Wendland( double t )
+   {
+      if (t >= 1.0) return 0.0;
+      const double s = (1.0 - t)*(1.0 - t);
+      return s*s*(4.0*t + 1.0);
+   }
+
+   //--------------------------------------------------------------------------
+   // TaperedSystem
+   //
+   //    The factor of the whole tapered covariance matrix C, P C P' = LL',
+   //    shared by the worker threads, with the half solves y1 = L^{-1} P 1 and
+   //    yz = L^{-1} P z of the two dense right-hand sides, and the inner
+   //    products 1' C^{-1} 1 and 1' C^{-1} z.
+   //--------------------------------------------------------------------------
+   struct TaperedSystem {
+      SparseCholesky      factor;
+      std::vector<double> y1, yz;
+      double              q11, q1z;
+
+      TaperedSystem()
+      :  factor(), y1(), yz(), q11( 0.0 ), q1z( 0.0 )
+      {
+      }
+   };
+
+   //--------------------------------------------------------------------------
+   // TaperedWorkspace
+   //
+   //    The scratch storage of one worker thread of a tapered run. The half
+   //    solves are stored compactly, over only the positions reached from
+   //    the observation, so they grow with the largest excluded set and path
+   //    to the root seen, not with N.
+   //--------------------------------------------------------------------------
+   struct TaperedWorkspace {
+      std::vector<int>    excluded;     // observation [k] and its near data
+      std::vector<char>   flag;         // 1 for each excluded observation
+      std::vector<double> Y;            // the compact half solves
+      SparseWorkspace     sparse;       // and their scratch storage
+      std::vector<double> G;            // the capacitance matrix
+      std::vector<double> H, T;         // its right-hand sides and solutions
+
+      explicit TaperedWorkspace( int N )
+      :  excluded(), flag( N, 0 ), Y(), sparse(), G(), H(), T()
+      {
+      }
+   };
+
+   //--------------------------------------------------------------------------
+   // ExcludedSet
+   //
+   //    Fill "excluded" with observation [k] and the observations within the
+   //    buffer radius of it. Since radius < taper, all of them are in row [k]
+   //    of the tapered covariance matrix C.
+   //--------------------------------------------------------------------------
+   void ExcludedSet(
+      int k,
+      double radius,
+      const std::vector<DataRecord>& obs,
+      const SparseMatrix& C,
+      std::vector<int>& excluded )
+   {
+      const int* Cp = C.RowStart();
+      const int* Cj = C.Columns();
+
+      excluded.clear();
+      for (int p = Cp[k]; p < Cp[k+1]; ++p) {
+         const int j = Cj[p];
+         if (j == k || hypot(obs[k].x - obs[j].x, obs[k].y - obs[j].y) < radius)
+            excluded.push_back(j);
+      }
+   }
+
+   //--------------------------------------------------------------------------
+   // EvaluateTapered
+   //
+   //    Compute the boomerang statistic for the single observation [k] from
+   //    the factor of the whole tapered covariance matrix C, rather than by
+   //    factoring the active system A = C_SS.
+   //
+   //    Combine needs only inner products r1' A^{-1} r2, for r1 and r2 among
+   //    b, 1, and z. Let E be the excluded set and G = C^{-1}. Then
+   //
+   //       A^{-1} = [G - G_:E (G_EE)^{-1} G_E:]_SS,
+   //
+   //    and the bracketed matrix is zero on the rows and columns of E, so the
+   //    entries of r1 and r2 on E do not matter. With y = L^{-1} P r, and F
+   //    the half solves of the unit vectors of E,
+   //
+   //       r1' A^{-1} r2 = y1'y2 - (F'y1)' (F'F)^{-1} (F'y2).
+   //
+   //    The unit vectors and b, which lie within row [k], have sparse half
+   //    solves, on the paths from row [k] to the root of the elimination
+   //    tree, and the half solves of 1 and z are shared; so the cost of an
+   //    observation is that of those paths, not of the whole factor.
+   //--------------------------------------------------------------------------
+   Boomerang EvaluateTapered(
+      int k,
+      double sill,
+      double radius,
+      const std::vector<DataRecord>& obs,
+      const SparseMatrix& C,
+      const TaperedSystem* system,
+      TaperedWorkspace& ws )
+   {
+      const int N = obs.size();
+
+      TraceSpan span( "observation" );
+      span.Arg( "k", k );
+
+      ExcludedSet(k, radius, obs, C, ws.excluded);
+      const int ne = ws.excluded.size();
+      const int M  = N - ne;
+      span.Arg( "M", M );
+
+      Boomerang result = Unsolved(M);
+      if (M < MINIMUM_COUNT || system == nullptr)
+         return result;
+
+      const SparseCholesky& L = system->factor;
+      const int*    Cp = C.RowStart();
+      const int*    Cj = C.Columns();
+      const double* Cx = C.Values();
+
+      // The right-hand sides: b, and the unit vectors of E, stored compactly
+      // over the positions reached from row [k].
+      const int nrhs = 1 + ne;
+      const std::size_t nc = L.Reach( Cj + Cp[k], Cp[k+1] - Cp[k], ws.sparse );
+      ws.Y.assign( nrhs*nc, 0.0 );
+      double* Y = ws.Y.data();
+      {
+         ScopedTimer timer( PHASE_SLICE );
+         for (int e : ws.excluded)
+            ws.flag[e] = 1;
+         for (int p = Cp[k]; p < Cp[k+1]; ++p)
+            if (!ws.flag[Cj[p]]) Y[L.Slot(Cj[p], ws.sparse)] = Cx[p];
+         for (int a = 0; a < ne; ++a)
+            Y[(1+a)*nc + L.Slot(ws.excluded[a], ws.sparse)] = 1.0;
+         for (int e : ws.excluded)
+            ws.flag[e] = 0;
+      }
+
+      L.HalfSolve( nrhs, Y, ws.sparse );
+
+      // The inner products, over the positions reached; H holds F'y for
+      // y1, yz, and yb, in turn.
+      const double* y1 = system->y1.data();
+      const double* yz = system->yz.data();
+      double qbb = 0.0, qb1 = 0.0, qbz = 0.0;
+      ws.G.assign( static_cast<std::size_t>(ne)*ne, 0.0 );
+      ws.H.assign( 3*ne, 0.0 );
+      for (std::size_t t = 0; t < nc; ++t) {
+         const int    j  = ws.sparse.columns[t];
+         const double yb = Y[t];
+         qbb += yb * yb;
+         qb1 += yb * y1[j];
+         qbz += yb * yz[j];
+
+         for (int a = 0; a < ne; ++a) {
+            const double ya = Y[(1+a)*nc + t];
+            ws.H[a]      += ya * y1[j];
+            ws.H[ne+a]   += ya * yz[j];
+            ws.H[2*ne+a] += ya * yb;
+            for (int c = 0; c <= a; ++c)
+               ws.G[a*ne + c] += ya * Y[(1+c)*nc + t];
+         }
+      }
+
+      for (int a = 0; a < ne; ++a)
+         for (int c = 0; c < a; ++c)
+            ws.G[c*ne + a] = ws.G[a*ne + c];
+
+      // Remove the excluded data through the capacitance matrix F'F = G_EE.
+      if (!CholeskyDecomposition(ne, ws.G.data(), ne))
+         return result;
+
+      ws.T = ws.H;
+      for (int r = 0; r < 3; ++r)
+         CholeskySolve(ne, ws.G.data(), ne, ws.T.data() + r*ne);
+
+      const double* H1 = ws.H.data();
+      const double* Hz = H1 + ne;
+      const double* Hb = Hz + ne;
+      const double* T1 = ws.T.data();
+      const double* Tb = T1 + 2*ne;
+
+      const double sum_v = system->q11 - SumProduct(ne, H1, T1);     // 1' A^{-1} 1
+      const double sum_u = qb1 - SumProduct(ne, H1, Tb);             // 1' A^{-1} b
+      const double zu    = qbz - SumProduct(ne, Hz, Tb);             // z' A^{-1} b
+      const double zv    = system->q1z - SumProduct(ne, Hz, T1);     // z' A^{-1} 1
+      const double bu    = qbb - SumProduct(ne, Hb, Tb);             // b' A^{-1} b
+      const double bv    = qb1 - SumProduct(ne, Hb, T1);             // b' A^{-1} 1
+
+      Combine(sill, obs[k].z, sum_u, sum_v, zu, zv, bu, bv, result);
+      return result;
+   }
+
+   //--------------------------------------------------------------------------
+   // InverseSystem
+   //
+   //    For the engines that evaluate every observation from G, the whole of
+   //    C^{-1} or an approximation of it, shared by the worker threads: the
+   //    products g1 = G 1 and gz = G z, and the inner products 1'G 1 and
+   //    1'G z. g1 is empty if G could not be formed.
+   //--------------------------------------------------------------------------
+   struct InverseSystem {
+      std::vector<double> g1, gz;
+      double              q11, q1z;
+
+      InverseSystem()
+      :  g1(), gz(), q11( 0.0 ), q1z( 0.0 )
+      {
+      }
+   };
+
+   //--------------------------------------------------------------------------
+   // InverseWorkspace
+   //
+   //    The scratch storage of one worker thread of such an engine.
+   //--------------------------------------------------------------------------
+   struct InverseWorkspace {
+      std::vector<int>    excluded;     // observation [k] and its near data
+      std::vector<double> G;            // the block G_EE
+      std::vector<double> t, T1;        // G_EE^{-1} e_k and G_EE^{-1} g1_E
+      std::vector<double> g1, gz;       // g1_E and gz_E
+      VecchiaWorkspace    vecchia;      // for the blocks of the Vecchia Q
+
+      InverseWorkspace()
+      :  excluded(), G(), t(), T1(), g1(), gz(), vecchia()
+      {
+      }
+   };
+
+   //--------------------------------------------------------------------------
+   // CombineInverse
+   //
+   //    Compute the boomerang statistic for the single observation [k] from
+   //    G = C^{-1}. On entrance ws.excluded holds the excluded set E, which
+   //    includes [k], and ws.G the block G_EE.
+   //
+   //    As in EvaluateTapered,
+   //
+   //       r1' A^{-1} r2 = r1' [G - G_:E (G_EE)^{-1} G_E:] r2.
+   //
+   //    Here b is column [k] of C, less its entries on E, which do not
+   //    matter, and G C(:,k) = e_k. So with t = (G_EE)^{-1} e_k, every
+   //    quantity of Combine needs only the small block G_EE and the shared
+   //    g1 and gz on E:
+   //
+   //       b' A^{-1} b = sill - t_k        1' A^{-1} b = 1 - g1_E' t
+   //       z' A^{-1} b = z_k - gz_E' t     1' A^{-1} 1 = 1'g1 - g1_E' (G_EE)^{-1} g1_E
+   //
+   //    and z' A^{-1} 1 likewise.
+   //--------------------------------------------------------------------------
+   Boomerang CombineInverse(
+      int k,
+      double sill,
+      const std::vector<DataRecord>& obs,
+      const InverseSystem& system,
+      InverseWorkspace& ws )
+   {
+      const int N  = obs.size();
+      const int ne = ws.excluded.size();
+
+      Boomerang result = Unsolved(N - ne);
+      if (!CholeskyDecomposition(ne, ws.G.data(), ne))
+         return result;
+
+      ws.t.assign( ne, 0.0 );
+      ws.g1.resize( ne );
+      ws.gz.resize( ne );
+      int ak = 0;
+      for (int a = 0; a < ne; ++a) {
+         const int j = ws.excluded[a];
+         if (j == k) ak = a;
+         ws.g1[a] = system.g1[j];
+         ws.gz[a] = system.gz[j];
+      }
+      ws.t[ak] = 1.0;
+      ws.T1 = ws.g1;
+      CholeskySolve(ne, ws.G.data(), ne, ws.t.data());
+      CholeskySolve(ne, ws.G.data(), ne, ws.T1.data());
+
+      const double sum_u = 1.0 - SumProduct(ne, ws.g1.data(), ws.t.data());
+      const double zu    = obs[k].z - SumProduct(ne, ws.gz.data(), ws.t.data());
+      const double sum_v = system.q11 - SumProduct(ne, ws.g1.data(), ws.T1.data());
+      const double zv    = system.q1z - SumProduct(ne, ws.gz.data(), ws.T1.data());
+
+      const double bu    = sill - ws.t[ak];
+      const double bv    = sum_u;
+
+      Combine(sill, obs[k].z, sum_u, sum_v, zu, zv, bu, bv, result);
+      return result;
+   }
+
+   //--------------------------------------------------------------------------
+   // Prepare
+   //
+   //    Fill in the shared products of "system", given the product Gv = G v.
+   //--------------------------------------------------------------------------
+   void Prepare(
+      const std::vector<DataRecord>& obs,
+      const std::function<void(const double* v, double* Gv)>& multiply,
+      InverseSystem& system )
+   {
+      const int N = obs.size();
+
+      std::vector<double> ones(N, 1.0), z(N);
+      for (int k = 0; k < N; ++k)
+         z[k] = obs[k].z;
+
+      system.g1.resize(N);
+      system.gz.resize(N);
+      multiply( ones.data(), system.g1.data() );
+      multiply( z.data(), system.gz.data() );
+
+      system.q11 = SumProduct(N, ones.data(), system.g1.data());
+      system.q1z = SumProduct(N, z.data(), system.g1.data());
+   }
+
+   //--------------------------------------------------------------------------
+   // Add observation [k] to the excluded set found by a spatial search, for a
+   // radius of zero.
+   //--------------------------------------------------------------------------
+   void IncludeSelf( int k, std::vector<int>& excluded )
+   {
+      if (std::find(excluded.begin(), excluded.end(), k) == excluded.end())
+         excluded.push_back(k);
+   }
+
+   //--------------------------------------------------------------------------
+   // EvaluateHierarchical
+   //
+   //    Compute the boomerang statistic for the single observation [k] from
+   //    the factor of the whole H-matrix C; see CombineInverse. The entries of
+   //    G_EE come from the stored Woodbury terms of the clusters containing
+   //    them, in O(r log N) each.
+   //--------------------------------------------------------------------------
+   Boomerang EvaluateHierarchical(
+      int k,
+      double sill,
+      double radius,
+      const std::vector<DataRecord>& obs,
+      const HMatrix& C,
+      const InverseSystem& system,
+      InverseWorkspace& ws )
+   {
+      const int N = obs.size();
+
+      TraceSpan span( "observation" );
+      span.Arg( "k", k );
+
+      {
+         ScopedTimer timer( PHASE_SLICE );
+         C.Within( obs[k].x, obs[k].y, radius, ws.excluded );
+         IncludeSelf( k, ws.excluded );
+      }
+      const int ne = ws.excluded.size();
+      const int M  = N - ne;
+      span.Arg( "M", M );
+
+      if (M < MINIMUM_COUNT || system.g1.empty())
+         return Unsolved(M);
+
+      ws.G.resize( static_cast<std::size_t>(ne)*ne );
+      C.InverseBlock( ne, ws.excluded.data(), ws.G.data() );
+      return CombineInverse( k, sill, obs, system, ws );
+   }
+
+   //--------------------------------------------------------------------------
+   // EvaluateVecchia
+   //
+   //    Compute the boomerang statistic for the single observation [k] from
+   //    the Vecchia precision Q, in place of C^{-1}; see CombineInverse. The
+   //    block Q_EE is accumulated from the rows of the sparse factor U that
+   //    touch E, so the cost does not depend on N.
+   //--------------------------------------------------------------------------
+   Boomerang EvaluateVecchia(
+      int k,
+      double sill,
+      double radius,
+      const std::vector<DataRecord>& obs,
+      const Vecchia& V,
+      const InverseSystem& system,
+      InverseWorkspace& ws )
+   {
+      const int N = obs.size();
+
+      TraceSpan span( "observation" );
+      span.Arg( "k", k );
+
+      ScopedTimer timer( PHASE_SLICE );
+      V.Index().Within( obs[k].x, obs[k].y, radius, ws.excluded );
+      IncludeSelf( k, ws.excluded );
+
+      const int ne = ws.excluded.size();
+      const int M  = N - ne;
+      span.Arg( "M", M );
+
+      if (M < MINIMUM_COUNT || system.g1.empty())
+         return Unsolved(M);
+
+      ws.G.resize( static_cast<std::size_t>(ne)*ne );
+      V.PrecisionBlock( ne, ws.excluded.data(), ws.G.data(), ws.vecchia );
+      return CombineInverse( k, sill, obs, system, ws );
+   }
+
+   //--------------------------------------------------------------------------
+   // NystromSystem
+   //
+   //    For the Nystrom engine, the terms of the Woodbury identity over all
+   //    of the observations, shared by the worker threads: the r x r matrix
+   //    S = I + U' D^{-1} U, the r-vectors w1 = U' D^{-1} 1 and wz =
+   //    U' D^{-1} z, and the sums 1' D^{-1} 1 and 1' D^{-1} z. S is empty if
+   //    the approximation could not be built.
+   //--------------------------------------------------------------------------
+   struct NystromSystem {
+      std::vector<double> S;
+      std::vector<double> w1, wz;
+      double              d11, d1z;
+
+      NystromSystem()
+      :  S(), w1(), wz(), d11( 0.0 ), d1z( 0.0 )
+      {
+      }
+   };
+
+   //--------------------------------------------------------------------------
+   // NystromWorkspace
+   //
+   //    The scratch storage of one worker thread of a Nystrom run.
+   //--------------------------------------------------------------------------
+   struct NystromWorkspace {
+      std::vector<int>    excluded;     // observation [k] and its near data
+      std::vector<double> T;            // S less the terms of E, then its factor
+      std::vector<double> a1, az, ab;   // U_A' D_A^{-1} times 1, z, and b
+      std::vector<double> t1, tb;       // T^{-1} a1 and T^{-1} ab
+
+      NystromWorkspace()
+      :  excluded(), T(), a1(), az(), ab(), t1(), tb()
+      {
+      }
+   };
+
+   //--------------------------------------------------------------------------
+   // EvaluateNystrom
+   //
+   //    Compute the boomerang statistic for the single observation [k] with
+   //    the Nystrom approximation C ~ U U' + D. On the active set A, by the
+   //    Woodbury identity,
+   //
+   //       r1' A^{-1} r2 = r1' D_A^{-1} r2 - (U_A' D_A^{-1} r1)' T^{-1} (U_A' D_A^{-1} r2),
+   //
+   //    with T = I + U_A' D_A^{-1} U_A: the shared S, less the |E| terms of
+   //    the excluded set. The covariances b = U_A u_k with u_k = U(k,:), so
+   //    that U_A' D_A^{-1} b = (T - I) u_k and b' D_A^{-1} r = u_k' U_A'
+   //    D_A^{-1} r. The cost is O(|E| r^2 + r^3), whatever N.
+   //--------------------------------------------------------------------------
+   Boomerang EvaluateNystrom(
+      int k,
+      double sill,
+      double radius,
+      const std::vector<DataRecord>& obs,
+      const Nystrom& V,
+      const NystromSystem& system,
+      NystromWorkspace& ws )
+   {
+      const int N = obs.size();
+      const int r = V.Rank();
+
+      TraceSpan span( "observation" );
+      span.Arg( "k", k );
+
+      {
+         ScopedTimer timer( PHASE_SLICE );
+         V.Index().Within( obs[k].x, obs[k].y, radius, ws.excluded );
+         IncludeSelf( k, ws.excluded );
+      }
+      const int M = N - ws.excluded.size();
+      span.Arg( "M", M );
+
+      Boomerang result = Unsolved(M);
+      if (M < MINIMUM_COUNT || system.S.empty())
+         return result;
+
+      // Remove the excluded set from the lower triangle of S, and from the
+      // sums.
+      const double* uk = V.Row(k);
+      double d11 = system.d11;
+      double d1z = system.d1z;
+      {
+         ScopedTimer timer( PHASE_FACTORIZATION );
+         ws.T  = system.S;
+         ws.a1 = system.w1;
+         ws.az = system.wz;
+         for (int j : ws.excluded) {
+            const double* u = V.Row(j);
+            const double  w = 1.0 / V.Diagonal(j);
+            for (int a = 0; a < r; ++a) {
+               const double wu = w * u[a];
+               ws.a1[a] -= wu;
+               ws.az[a] -= wu * obs[j].z;
+               double* Ta = &ws.T[static_cast<std::size_t>(a)*r];
+               for (int c = 0; c <= a; ++c)
+                  Ta[c] -= wu * u[c];
+            }
+            d11 -= w;
+            d1z -= w * obs[j].z;
+         }
+
+         ws.ab.resize(r);
+         for (int a = 0; a < r; ++a) {
+            double sum = -uk[a];
+            for (int c = 0; c < r; ++c)
+               sum += ws.T[static_cast<std::size_t>(std::max(a, c))*r + std::min(a, c)] * uk[c];
+            ws.ab[a] = sum;
+         }
+
+         if (!CholeskyDecomposition(r, ws.T.data(), r))
+            return result;
+      }
+
+      const double b1 = SumProduct(r, uk, ws.a1.data());
+      const double bz = SumProduct(r, uk, ws.az.data());
+      const double bb = SumProduct(r, uk, ws.ab.data());
+
+      ScopedTimer timer( PHASE_SOLVE );
+      ws.t1 = ws.a1;
+      ws.tb = ws.ab;
+      CholeskySolve(r, ws.T.data(), r, ws.t1.data());
+      CholeskySolve(r, ws.T.data(), r, ws.tb.data());
+
+      const double sum_u = b1  - SumProduct(r, ws.ab.data(), ws.t1.data());
+      const double zu    = bz  - SumProduct(r, ws.az.data(), ws.tb.data());
+      const double bu    = bb  - SumProduct(r, ws.ab.data(), ws.tb.data());
+      const double sum_v = d11 - SumProduct(r, ws.a1.data(), ws.t1.data());
+      const double zv    = d1z - SumProduct(r, ws.az.data(), ws.t1.data());
+      const double bv    = sum_u;
+
+      Combine(sill, obs[k].z, sum_u, sum_v, zu, zv, bu, bv, result);
+      return result;
+   }
+
+   //--------------------------------------------------------------------------
+   // IterativeWorkspace
+   //
+   //    The scratch storage of one worker thread of a matrix-free run, for a
+   //    batch of ITERATIVE_BATCH observations. For lane [l] of the batch,
+   //    right-hand sides 2l and 2l+1 are b and 1, and the solutions are
+   //    u = A^{-1} b and v = A^{-1} 1. Each v is the initial guess for the
+   //    next observation in its lane; the active sets mostly agree.
+   //--------------------------------------------------------------------------
+   struct IterativeWorkspace {
+      std::vector<int>              excluded;    // observation [k] and its near data
+      std::vector<Exclusion>        sets;        // of each lane
+      std::vector<const Exclusion*> rhs_sets;    // of each right-hand side
+      std::vector<double>           B, X;        // the right-hand sides and solutions
+      std::vector<int>              iterations;  // of each right-hand side
+      std::vector<double>           residual;    // of each right-hand side
+      OperatorWorkspace             op;          // for the operator
+      IterativeReport               report;      // convergence statistics
+
+      IterativeWorkspace()
+      :  excluded(), sets(ITERATIVE_BATCH), rhs_sets(), B(), X(),
+         iterations(2*ITERATIVE_BATCH), residual(2*ITERATIVE_BATCH), op(), report()
+      {
+      }
+   };
+
+   //--------------------------------------------------------------------------
+   void Merge( IterativeReport& total, const IterativeReport& part )
+   {
+      total.systems     += part.systems;
+      total.unconverged += part.unconverged;
+      total.iterations  += part.iterations;
+
+      total.max_iterations = std::max( total.max_iterations, part.max_iterations );
+      total.max_residual   = std::max( total.max_residual,   part.max_residual );
+
+      total.outcomes.insert( total.outcomes.end(), part.outcomes.begin(), part.outcomes.end() );
+   }
+
+   //--------------------------------------------------------------------------
+   // EvaluateIterative
+   //
+   //    Compute the boomerang statistics for the "count" <= ITERATIVE_BATCH
+   //    observations ks[0], ..., ks[count-1] with the matrix-free operator C.
+   //    The two systems A u = b and A v = 1 of every observation are solved
+   //    together by preconditioned conjugate gradients, to a relative
+   //    residual of "tolerance", and combined as in Combine. The outcome of
+   //    each observation solved is handed to "announce", if it is set.
+   //--------------------------------------------------------------------------
+   void EvaluateIterative(
+      const int* ks,
+      int count,
+      double sill,
+      double radius,
+      const std::vector<DataRecord>& obs,
+      const CovarianceOperator& C,
+      double tolerance,
+      const OutcomeCallback& announce,
+      IterativeWorkspace& ws,
+      Boomerang* results )
+   {
+      const int N = obs.size();
+
+      TraceSpan span( "batch" );
+      span.Arg( "k", ks[0] );
+      span.Arg( "count", count );
+
+      // The lanes with a system to solve.
+      int lanes = 0;
+      std::vector<int> lane(count, -1);
+      std::vector<int> M(count);
+
+      ws.B.resize( 2*ITERATIVE_BATCH*N );
+      ws.X.resize( 2*ITERATIVE_BATCH*N, 0.0 );
+      ws.rhs_sets.resize( 2*ITERATIVE_BATCH );
+
+      for (int l = 0; l < count; ++l) {
+         const int k = ks[l];
+         {
+            ScopedTimer timer( PHASE_SLICE );
+            C.Index().Within( obs[k].x, obs[k].y, radius, ws.excluded );
+            IncludeSelf( k, ws.excluded );
+         }
+         M[l] = N - ws.excluded.size();
+         results[l] = Unsolved(M[l]);
+         if (M[l] < MINIMUM_COUNT || C.nRows() != N) continue;
+
+         const int r = 2*lanes;
+         {
+            ScopedTimer timer( PHASE_FACTORIZATION );
+            C.Exclude( ws.excluded, ws.sets[lanes] );
+         }
+         ws.rhs_sets[r] = ws.rhs_sets[r+1] = &ws.sets[lanes];
+
+         double* B = &ws.B[static_cast<std::size_t>(r)*N];
+         C.Column( k, B );
+         std::fill( B + N, B + 2*N, 1.0 );
+         std::fill( &ws.X[static_cast<std::size_t>(r)*N], &ws.X[static_cast<std::size_t>(r+1)*N], 0.0 );
+
+         lane[l] = lanes++;
+      }
+      if (lanes == 0) return;
+
+      {
+         ScopedTimer timer( PHASE_SOLVE );
+         C.Solve( 2*lanes, ws.rhs_sets.data(), ws.B.data(), ws.X.data(), tolerance, MAX_CG_ITERATIONS,
+                  ws.op, ws.iterations.data(), ws.residual.data() );
+      }
+
+      for (int l = 0; l < count; ++l) {
+         if (lane[l] < 0) continue;
+
+         const int r = 2*lane[l];
+         const int iterations = std::max( ws.iterations[r], ws.iterations[r+1] );
+         const double residual = std::max( ws.residual[r], ws.residual[r+1] );
+
+         ws.report.systems    += 1;
+         ws.report.iterations += iterations;
+         ws.report.max_iterations = std::max( ws.report.max_iterations, iterations );
+         ws.report.max_residual   = std::max( ws.report.max_residual, residual );
+
+         const IterativeOutcome outcome = { ks[l], iterations, residual };
+         ws.report.outcomes.push_back( outcome );
+         if (announce) announce( outcome );
+
+         double* v = &ws.X[static_cast<std::size_t>(r+1)*N];
+         if (!(residual <= tolerance)) {
+            ws.report.unconverged += 1;
+            std::fill( v, v + N, 0.0 );
+            continue;
+         }
+
+         // The entries of u and v in E are zero.
+         const double* b = &ws.B[static_cast<std::size_t>(r)*N];
+         const double* u = &ws.X[static_cast<std::size_t>(r)*N];
+
+         double sum_u = 0.0, zu = 0.0, bu = 0.0;
+         double sum_v = 0.0, zv = 0.0, bv = 0.0;
+         for (int j = 0; j < N; ++j) {
+            sum_u += u[j];
+            zu    += obs[j].z * u[j];
+            bu    += b[j] * u[j];
+            sum_v += v[j];
+            zv    += obs[j].z * v[j];
+            bv    += b[j] * v[j];
+         }
+
+         Combine(sill, obs[ks[l]].z, sum_u, sum_v, zu, zv, bu, bv, results[l]);
+      }
+
+      // A zero-length span for each observation carries its iteration count.
+      if (TracingEnabled()) {
+         for (int l = 0; l < count; ++l) {
+            TraceSpan observation( "observation" );
+            observation.Arg( "k", ks[l] );
+            observation.Arg( "M", M[l] );
+            observation.Arg( "iterations", lane[l] < 0 ? 0 : std::max(ws.iterations[2*lane[l]], ws.iterations[2*lane[l]+1]) );
+         }
+      }
+   }
+
+   //--------------------------------------------------------------------------
+   // Worker
+   //
+   //    The part of an engine run owned by one worker thread: its scratch
+   //    storage, and the evaluation of "count" observations at a time.
+   //--------------------------------------------------------------------------
+   class Worker {
+      public :
+         virtual ~Worker() {}
+
+         // Evaluate observations ks[0], ..., ks[count-1].
+         virtual void Run( const int* ks, int count, Boomerang* results ) = 0;
+
+         // Called once, under the engine lock, after the last observation.
+         virtual void Finish() {}
+   };
+
+   typedef std::function<std::unique_ptr<Worker>()> WorkerFactory;
+
+   //--------------------------------------------------------------------------
+   // DenseWorker
+   //--------------------------------------------------------------------------
+   class DenseWorker : public Worker {
+      public :
+         DenseWorker(
+            double sill,
+            double radius,
+            const std::vector<DataRecord>& obs,
+            const Matrix& D,
+            const Matrix& C,
+            const EngineOptions& options,
+            bool batched,
+            PrecisionReport& report )
+         :  m_sill( sill ),
+            m_radius( radius ),
+            m_obs( obs ),
+            m_D( D ),
+            m_C( C ),
+            m_options( options ),
+            m_batched( batched ),
+            m_report( report ),
+            m_ws( obs.size(), options.precision, batched )
+         {
+         }
+
+         void Run( const int* ks, int count, Boomerang* results ) override
+         {
+            if (m_batched) {
+               EvaluateBatch(ks, count, m_sill, m_radius, m_options.neighbors, m_obs, m_D, m_C, m_ws, results);
+            }
+            else {
+               for (int l = 0; l < count; ++l)
+                  results[l] = Evaluate(ks[l], m_sill, m_radius, m_options.neighbors, m_obs, m_D, m_C, m_options.precision, m_ws);
+            }
+         }
+
+         void Finish() override
+         {
+            Merge( m_report, m_ws.report );
+         }
+
+      private :
+         double m_sill;
+         double m_radius;
+         const std::vector<DataRecord>& m_obs;
+         const Matrix& m_D;
+         const Matrix& m_C;
+         const EngineOptions& m_options;
+         bool m_batched;
+         PrecisionReport& m_report;
+         Workspace m_ws;
+   };
+
+   //--------------------------------------------------------------------------
+   // LocalWorker
+   //--------------------------------------------------------------------------
+   class LocalWorker : public Worker {
+      public :
+         LocalWorker(
+            double sill,
+            double radius,
+            const std::vector<DataRecord>& obs,
+            const Locations& L,
+            const EngineOptions& options,
+            int M,
+            PrecisionReport& report )
+         :  m_sill( sill ),
+            m_radius( radius ),
+            m_obs( obs ),
+            m_L( L ),
+            m_options( options ),
+            m_report( report ),
+            m_ws( M, options.precision )
+         {
+         }
+
+         void Run( const int* ks, int count, Boomerang* results ) override
+         {
+            for (int l = 0; l < count; ++l)
+               results[l] = EvaluateLocal(ks[l], m_sill, m_radius, m_options.neighbors, m_obs, m_L, m_options.precision, m_ws);
+         }
+
+         void Finish() override
+         {
+            Merge( m_report, m_ws.base.report );
+         }
+
+      private :
+         double m_sill;
+         double m_radius;
+         const std::vector<DataRecord>& m_obs;
+         const Locations& m_L;
+         const EngineOptions& m_options;
+         PrecisionReport& m_report;
+         LocalWorkspace m_ws;
+   };
+
+   //--------------------------------------------------------------------------
+   // TaperedWorker
+   //--------------------------------------------------------------------------
+   class TaperedWorker : public Worker {
+      public :
+         TaperedWorker(
+            double sill,
+            double radius,
+            const std::vector<DataRecord>& obs,
+            const SparseMatrix& C,
+            const TaperedSystem* system )
+         :  m_sill( sill ),
+            m_radius( radius ),
+            m_obs( obs ),
+            m_C( C ),
+            m_system( system ),
+            m_ws( obs.size() )
+         {
+         }
+
+         TaperedWorker( const TaperedWorker& ) = delete;
+         TaperedWorker& operator=( const TaperedWorker& ) = delete;
+
+         void Run( const int* ks, int count, Boomerang* results ) override
+         {
+            for (int l = 0; l < count; ++l)
+               results[l] = EvaluateTapered(ks[l], m_sill, m_radius, m_obs, m_C, m_system, m_ws);
+         }
+
+      private :
+         double m_sill;
+         double m_radius;
+         const std::vector<DataRecord>& m_obs;
+         const SparseMatrix& m_C;
+         const TaperedSystem* m_system;
+         TaperedWorkspace m_ws;
+   };
+
+   //--------------------------------------------------------------------------
+   // IterativeWorker
+   //--------------------------------------------------------------------------
+   class IterativeWorker : public Worker {
+      public :
+         IterativeWorker(
+            double sill,
+            double radius,
+            const std::vector<DataRecord>& obs,
+            const CovarianceOperator& C,
+            double tolerance,
+            const OutcomeCallback& announce,
+            IterativeReport& report )
+         :  m_sill( sill ),
+            m_radius( radius ),
+            m_obs( obs ),
+            m_C( C ),
+            m_tolerance( tolerance ),
+            m_announce( announce ),
+            m_report( report ),
+            m_ws()
+         {
+         }
+
+         void Run( const int* ks, int count, Boomerang* results ) override
+         {
+            EvaluateIterative(ks, count, m_sill, m_radius, m_obs, m_C, m_tolerance, m_announce, m_ws, results);
+         }
+
+         void Finish() override
+         {
+            Merge( m_report, m_ws.report );
+         }
+
+      private :
+         double m_sill;
+         double m_radius;
+         const std::vector<DataRecord>& m_obs;
+         const CovarianceOperator& m_C;
+         double m_tolerance;
+         const OutcomeCallback& m_announce;
+         IterativeReport& m_report;
+         IterativeWorkspace m_ws;
+   };
+
+   //--------------------------------------------------------------------------
+   // InverseWorker
+   //
+   //    The worker of the engines that evaluate every observation from G; see
+   //    InverseSystem.
+   //--------------------------------------------------------------------------
+   class InverseWorker : public Worker {
+      public :
+         typedef std::function<Boomerang(int k, InverseWorkspace& ws)> Evaluator;
+
+         explicit InverseWorker( const Evaluator& evaluate )
+         :  m_evaluate( evaluate ),
+            m_ws()
+         {
+         }
+
+         void Run( const int* ks, int count, Boomerang* results ) override
+         {
+            for (int l = 0; l < count; ++l)
+               results[l] = m_evaluate(ks[l], m_ws);
+         }
+
+      private :
+         Evaluator m_evaluate;
+         InverseWorkspace m_ws;
+   };
+
+   //--------------------------------------------------------------------------
+   // NystromWorker
+   //--------------------------------------------------------------------------
+   class NystromWorker : public Worker {
+      public :
+         NystromWorker(
+            double sill,
+            double radius,
+            const std::vector<DataRecord>& obs,
+            const Nystrom& V,
+            const NystromSystem& system )
+         :  m_sill( sill ),
+            m_radius( radius ),
+            m_obs( obs ),
+            m_V( V ),
+            m_system( system ),
+            m_ws()
+         {
+         }
+
+         void Run( const int* ks, int count, Boomerang* results ) override
+         {
+            for (int l = 0; l < count; ++l)
+               results[l] = EvaluateNystrom(ks[l], m_sill, m_radius, m_obs, m_V, m_system, m_ws);
+         }
+
+      private :
+         double m_sill;
+         double m_radius;
+         const std::vector<DataRecord>& m_obs;
+         const Nystrom& m_V;
+         const NystromSystem& m_system;
+         NystromWorkspace m_ws;
+   };
+
+   //--------------------------------------------------------------------------
+   // Targets
+   //
+   //    The observations to evaluate: options.targets, or all N.
+   //--------------------------------------------------------------------------
+   std::vector<int> Targets( int N, const EngineOptions& options )
+   {
+      if (!options.targets.empty())
+         return options.targets;
+
+      std::vector<int> ks(N);
+      for (int k = 0; k < N; ++k)
+         ks[k] = k;
+      return ks;
+   }
+
+   //--------------------------------------------------------------------------
+   // Whether an engine needs the expected active-set sizes: for the progress
+   // reports, or for the order of evaluation.
+   //--------------------------------------------------------------------------
+   bool WantExpected( const EngineOptions& options )
+   {
+      return options.progress || options.priority == PRIORITY_CHEAPEST;
+   }
+
+   //--------------------------------------------------------------------------
+   // Stopped
+   //
+   //    Whether the deadline has passed or the run has been cancelled.
+   //--------------------------------------------------------------------------
+   bool Stopped( const EngineOptions& options )
+   {
+      if (options.cancel && options.cancel->load())
+         return true;
+      return options.deadline > 0 && WallSeconds() >= options.deadline;
+   }
+
+   //--------------------------------------------------------------------------
+   // ThreadCount
+   //
+   //    The number of worker threads: options.nthreads, or the default, but
+   //    no more than fit in MEMORY_FRACTION of the memory available with
+   //    "footprint" bytes of scratch storage apiece; at least one.
+   //--------------------------------------------------------------------------
+   int ThreadCount( const EngineOptions& options, std::size_t footprint )
+   {
+      int nthreads = (options.nthreads < 1) ? DefaultThreadCount() : options.nthreads;
+
+      const std::size_t available = AvailableBytes();
+      if (footprint > 0 && available > 0) {
+         const std::size_t fit = static_cast<std::size_t>( MEMORY_FRACTION*available ) / footprint;
+         nthreads = static_cast<int>( std::max<std::size_t>( 1, std::min<std::size_t>(nthreads, fit) ) );
+      }
+      return nthreads;
+   }
+
+   //--------------------------------------------------------------------------
+   // Schedule
+   //
+   //    The observations "targets" are put in the order of options.priority,
+   //    and distributed across the worker threads, "step" at a time, each
+   //    thread with its own Worker from "factory", whose scratch storage takes
+   //    "footprint" bytes; see ThreadCount. There are never more threads
+   //    than steps, since an idle one would hold its storage for nothing.
+   //    The completed results are collected in a reorder buffer with room
+   //    for every target, and handed to the sink in that order as soon as
+   //    each prefix is complete.
+   //    expected[k] is the expected active-set size of observation [k].
+   //
+   //    Each worker checks for a stop before it takes the next step, so the
+   //    observations started are always a prefix of the order, and every one
+   //    of them is finished.
+   //--------------------------------------------------------------------------
+   void Schedule(
+      const std::vector<int>& targets,
+      int step,
+      const std::vector<int>& expected,
+      const WorkerFactory& factory,
+      std::size_t footprint,
+      const ResultSink& sink,
+      const EngineOptions& options )
+   {
+      const int n = targets.size();
+      const int nthreads = std::max( 1, std::min(ThreadCount(options, footprint), (n + step - 1) / step) );
+
+      // An unknown score counts as the most suspicious.
+      std::vector<int> ks( targets );
+      if (options.priority == PRIORITY_CHEAPEST) {
+         std::stable_sort( ks.begin(), ks.end(), [&](int a, int b) { return expected[a] < expected[b]; } );
+      }
+      else if (options.priority == PRIORITY_SCORE) {
+         assert( options.score.size() == expected.size() );
+         auto key = [&](int k) { return std::isnan(options.score[k]) ? -HUGE_VAL : options.score[k]; };
+         std::stable_sort( ks.begin(), ks.end(), [&](int a, int b) { return key(a) < key(b); } );
+      }
+
+      std::vector<int> cost(n);
+      for (int i = 0; i < n; ++i)
+         cost[i] = expected[ks[i]];
+      Progress progress( cost, options.progress_interval, options.progress );
+
+      // The reorder buffer holds every result, so that no allocation is
+      // needed as the results complete.
+      std::atomic<int> next(0);
+      std::mutex mutex;
+      std::condition_variable ready;
+      std::vector<Boomerang> results(n);
+      std::vector<char> done(n, 0);
+      std::vector<double> x(n), p(n);     // scratch for PValues
+      std::exception_ptr failure;
+      int exited = 0;
+
+      auto publish = [&](int i, const Boomerang& result) {
+         progress.Complete(i, result.cnt);
+
+         std::lock_guard<std::mutex> lock(mutex);
+         results[i] = result;
+         done[i] = 1;
+         ready.notify_one();
+      };
+
+      auto worker = [&]() {
+         SetTraceThreadName( "worker" );
+         try {
+            std::unique_ptr<Worker> state = factory();
+            std::vector<Boomerang> batch(step);
+
+            while (!Stopped(options)) {
+               const int i0 = next.fetch_add(step);
+               if (i0 >= n) break;
+
+               const int count = std::min( step, n - i0 );
+               state->Run(&ks[i0], count, batch.data());
+               for (int l = 0; l < count; ++l)
+                  publish(i0 + l, batch[l]);
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            state->Finish();
+         }
+         catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!failure) failure = std::current_exception();
+            next = n;
+         }
+
+         std::lock_guard<std::mutex> lock(mutex);
+         ++exited;
+         ready.notify_one();
+      };
+
+      std::vector<std::thread> workers;
+      for (int t = 0; t < nthreads; ++t)
+         workers.push_back( std::thread(worker) );
+
+      // Hand the results to the sink in order, taking each completed prefix
+      // as a block so that its p-values are computed together, until the
+      // workers have stopped short of the next one.
+      try {
+         for (int i = 0, m = 0; i < n; i += m) {
+            {
+               std::unique_lock<std::mutex> lock(mutex);
+               ready.wait( lock, [&]{ return failure || done[i] || exited == nthreads; } );
+               if (failure || !done[i]) break;
+
+               for (m = 1; i+m < n && done[i+m]; ++m);
+            }
+
+            PValues( m, &results[i], x.data(), p.data() );
+            for (int j = i; j < i+m; ++j)
+               sink(ks[j], results[j]);
+         }
+      }
+      catch (...) {
+         next = n;
+         for (auto& t : workers) t.join();
+         throw;
+      }
+
+      for (auto& t : workers) t.join();
+      if (failure) std::rethrow_exception(failure);
+   }
+}
+
+//=============================================================================
+// Assembly
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+Assembly::Assembly( double nugget, double sill, double range )
+:  m_nugget( nugget ),
+   m_sill( sill ),
+   m_range( range ),
+   m_x(),
+   m_y()
+{
+}
+
+//-----------------------------------------------------------------------------
+// Append one observation: only its location is kept. The covariances are not
+// computed here, row by row on the thread consuming the records, but all at
+// once by Finalize on the worker threads: reading the data is O(N) and takes
+// a fraction of a percent of the O(N^2) fill (0.7 ms against 90 ms for 2000
+// observations), so overlapping the two would hide almost nothing while
+// serializing the fill on one thread and keeping a copy of the triangles.
+//-----------------------------------------------------------------------------
+void Assembly::Append( const DataRecord& rec )
+{
+   m_x.push_back( rec.x );
+   m_y.push_back( rec.y );
+}
+
+//-----------------------------------------------------------------------------
+// Fill the full symmetric matrices. The lower triangle is cut into square
+// tiles, and the tile rows are handed out to the threads, longest first.
+// Within a tile each row segment is computed with contiguous, branch-free
+// loops, and then copied into the mirror-image tile of the upper triangle
+// while both are still in cache. Every element is written, so the matrices
+// are not zero-filled first, and the pages are first touched by the workers.
+//-----------------------------------------------------------------------------
+void Assembly::Finalize( Matrix& D, Matrix& C, int nthreads )
+{
+   const int N = Size();
+
+   D.Resize( N, N, Matrix::UNINITIALIZED );
+   C.Resize( N, N, Matrix::UNINITIALIZED );
+
+   const int nblocks = (N + ASSEMBLY_TILE - 1) / ASSEMBLY_TILE;
+   if (nthreads < 1) nthreads = DefaultThreadCount();
+   nthreads = std::max( 1, std::min(nthreads, nblocks) );
+
+   const double* x = m_x.data();
+   const double* y = m_y.data();
+   const double scale  = m_sill - m_nugget;
+   const double factor = -3.0 / m_range;
+   const double sill   = m_sill;
+
+   double* Dbase = D.Base();
+   double* Cbase = C.Base();
+
+   std::atomic<int> next(0);
+
+   auto worker = [&]() {
+      ScopedTimer timer( PHASE_ASSEMBLY );
+
+      for (int block = next++; block < nblocks; block = next++) {
+         const int bi = nblocks - 1 - block;
+         const int i0 = bi * ASSEMBLY_TILE;
+         const int i1 = std::min( i0 + ASSEMBLY_TILE, N );
+
+         for (int j0 = 0; j0 <= i0; j0 += ASSEMBLY_TILE) {
+            for (int i = i0; i < i1; ++i) {
+               const int j1 = std::min( j0 + ASSEMBLY_TILE, i );
+               const double xi = x[i];
+               const double yi = y[i];
+               double* d = Dbase + static_cast<std::size_t>(i)*N;
+               double* c = Cbase + static_cast<std::size_t>(i)*N;
+
+               for (int j = j0; j < j1; ++j) {
+                  const double dx = xi - x[j];
+                  const double dy = yi - y[j];
+                  const double h  = sqrt( dx*dx + dy*dy );
+                  d[j] = h;
+                  c[j] = scale * FastExp( factor*h );
+               }
+               for (int j = j0; j < j1; ++j) {
+                  Dbase[static_cast<std::size_t>(j)*N + i] = d[j];
+                  Cbase[static_cast<std::size_t>(j)*N + i] = c[j];
+               }
+            }
+         }
+
+         for (int i = i0; i < i1; ++i) {
+            Dbase[static_cast<std::size_t>(i)*N + i] = 0.0;
+            Cbase[static_cast<std::size_t>(i)*N + i] = sill;
+         }
+      }
+   };
+
+   std::vector<std::thread> workers;
+   for (int t = 1; t < nthreads; ++t)
+      workers.push_back( std::thread(worker) );
+   worker();
+   for (auto& t : workers) t.join();
+
+   m_x.clear();
+   m_y.clear();
+}
+
+//-----------------------------------------------------------------------------
+// Finalize
+//
+//    The tapered version: C(i,j) is the covariance times Wendland(h/taper),
+//    and only the entries with h < taper are stored. The locations are binned
+//    on a grid of cells "taper" on a side, so that the neighbors of each are
+//    found in its own cell and the eight around it, and the memory and the
+//    work are proportional to the number of entries. The rows are counted,
+//    and then filled, in blocks on "nthreads" threads.
+//-----------------------------------------------------------------------------
+void Assembly::Finalize( double taper, SparseMatrix& C, int nthreads )
+{
+   assert(taper > 0);
+
+   const int N = Size();
+   const double* x = m_x.data();
+   const double* y = m_y.data();
+   const double scale  = m_sill - m_nugget;
+   const double factor = -3.0 / m_range;
+   const double sill   = m_sill;
+
+   // Bin the locations, sorted by cell.
+   double xmin = 0.0, ymin = 0.0, ymax = 0.0;
+   if (N > 0) {
+      xmin = *std::min_element( m_x.begin(), m_x.end() );
+      ymin = *std::min_element( m_y.begin(), m_y.end() );
+      ymax = *std::max_element( m_y.begin(), m_y.end() );
+   }
+   const long long ny = static_cast<long long>( (ymax - ymin) / taper ) + 1;
+
+   std::vector<long long> cell(N);
+   std::vector<int> sorted(N);
+   for (int i = 0; i < N; ++i) {
+      const long long cx = static_cast<long long>( (x[i] - xmin) / taper );
+      const long long cy = static_cast<long long>( (y[i] - ymin) / taper );
+      cell[i] = cx*ny + cy;
+      sorted[i] = i;
+   }
+   std::sort( sorted.begin(), sorted.end(), [&cell](int i, int j){ return cell[i] < cell[j]; } );
+
+   std::vector<long long> keys(N);
+   for (int i = 0; i < N; ++i)
+      keys[i] = cell[sorted[i]];
+
+   // Visit the neighbors of location [i]: every [j] with h < taper,
+   // including [i] itself.
+   auto neighbors = [&](int i, const std::function<void(int j, double h)>& visit) {
+      const long long cy = cell[i] % ny;
+      for (long long dx = -1; dx <= 1; ++dx) {
+         for (long long dy = -1; dy <= 1; ++dy) {
+            if (cy + dy < 0 || cy + dy >= ny) continue;
+
+            const long long key = cell[i] + dx*ny + dy;
+            auto range = std::equal_range( keys.begin(), keys.end(), key );
+            for (auto it = range.first; it != range.second; ++it) {
+               const int j = sorted[it - keys.begin()];
+               const double h = hypot( x[i] - x[j], y[i] - y[j] );
+               if (h < taper) visit(j, h);
+            }
+         }
+      }
+   };
+
+   const int nblocks = (N + ASSEMBLY_TILE - 1) / ASSEMBLY_TILE;
+   if (nthreads < 1) nthreads = DefaultThreadCount();
+   nthreads = std::max( 1, std::min(nthreads, nblocks) );
+
+   auto parallel = [&](const std::function<void(int i)>& row) {
+      std::atomic<int> next(0);
+      auto worker = [&]() {
+         ScopedTimer timer( PHASE_ASSEMBLY );
+         for (int block = next++; block < nblocks; block = next++) {
+            const int i1 = std::min( (block+1)*ASSEMBLY_TILE, N );
+            for (int i = block*ASSEMBLY_TILE; i < i1; ++i)
+               row(i);
+         }
+      };
+
+      std::vector<std::thread> workers;
+      for (int t = 1; t < nthreads; ++t)
+         workers.push_back( std::thread(worker) );
+      worker();
+      for (auto& t : workers) t.join();
+   };
+
+   // Count the entries of each row, then fill them in column order.
+   std::vector<int> start(N+1, 0);
+   parallel( [&](int i) {
+      int count = 0;
+      neighbors(i, [&count](int, double) { ++count; });
+      start[i+1] = count;
+   });
+   for (int i = 0; i < N; ++i)
+      start[i+1] += start[i];
+
+   std::vector<int> columns( start[N] );
+   std::vector<double> values( start[N] );
+   parallel( [&](int i) {
+      int* cols = columns.data() + start[i];
+      int count = 0;
+      neighbors(i, [&](int j, double) { cols[count++] = j; });
+      std::sort( cols, cols + count );
+
+      for (int p = 0; p < count; ++p) {
+         const int j = cols[p];
+         const double h = hypot( x[i] - x[j], y[i] - y[j] );
+         values[start[i] + p] = (i == j) ? sill : scale * FastExp( factor*h ) * Wendland( h/taper );
+      }
+   });
+
+   C = SparseMatrix( std::move(start), std::move(columns), std::move(values) );
+
+   m_x.clear();
+   m_y.clear();
+}
+
+//-----------------------------------------------------------------------------
+// Finalize
+//
+//    The hierarchical version: C is compressed to an H-matrix, to the
+//    relative tolerance, and neither matrix is formed; the separation
+//    distances are computed as the entries are.
+//-----------------------------------------------------------------------------
+void Assembly::Finalize( double tolerance, HMatrix& C, int nthreads )
+{
+   const double* x = m_x.data();
+   const double* y = m_y.data();
+   const double scale  = m_sill - m_nugget;
+   const double factor = -3.0 / m_range;
+   const double sill   = m_sill;
+
+   if (nthreads < 1) nthreads = DefaultThreadCount();
+
+   C.Compress( m_x, m_y,
+      [=](int i, int j) {
+         return (i == j) ? sill : scale * FastExp( factor*hypot(x[i] - x[j], y[i] - y[j]) );
+      },
+      tolerance, nthreads );
+
+   m_x.clear();
+   m_y.clear();
+}
+
+//-----------------------------------------------------------------------------
+// Finalize
+//
+//    The Vecchia version: neither matrix is formed. The approximation V, with
+//    "conditioning" neighbors per observation, reads the covariances it
+//    needs as it builds each row, on "nthreads" threads.
+//-----------------------------------------------------------------------------
+void Assembly::Finalize( int conditioning, Vecchia& V, int nthreads )
+{
+   const double* x = m_x.data();
+   const double* y = m_y.data();
+   const double scale  = m_sill - m_nugget;
+   const double factor = -3.0 / m_range;
+   const double sill   = m_sill;
+
+   if (nthreads < 1) nthreads = DefaultThreadCount();
+
+   V.Build( m_x, m_y,
+      [=](int i, int j) {
+         return (i == j) ? sill : scale * FastExp( factor*hypot(x[i] - x[j], y[i] - y[j]) );
+      },
+      conditioning, nthreads );
+
+   m_x.clear();
+   m_y.clear();
+}
+
+//-----------------------------------------------------------------------------
+// Finalize
+//
+//    The Nystrom version: neither matrix is formed. The approximation V, of
+//    the given "rank", computes the covariances it needs as it builds each
+//    row of its factor, on "nthreads" threads.
+//-----------------------------------------------------------------------------
+void Assembly::Finalize( int rank, Nystrom& V, int nthreads )
+{
+   if (nthreads < 1) nthreads = DefaultThreadCount();
+
+   V.Build( m_x, m_y, m_nugget, m_sill, m_range, rank, nthreads );
+
+   m_x.clear();
+   m_y.clear();
+}
+
+//-----------------------------------------------------------------------------
+// Finalize
+//
+//    The matrix-free version: neither matrix is formed. The operator C keeps
+//    the locations and the factors of the blocks of its preconditioner, which
+//    are computed on "nthreads" threads.
+//-----------------------------------------------------------------------------
+void Assembly::Finalize( CovarianceOperator& C, int nthreads )
+{
+   if (nthreads < 1) nthreads = DefaultThreadCount();
+
+   C.Build( m_x, m_y, m_nugget, m_sill, m_range, nthreads );
+
+   m_x.clear();
+   m_y.clear();
+}
+
+//-----------------------------------------------------------------------------
+// Finalize
+//
+//    The local version: no matrix is formed. L keeps the indexed locations,
+//    from which each kriging system is filled in as it is needed.
+//-----------------------------------------------------------------------------
+void Assembly::Finalize( Locations& L )
+{
+   L.Build( m_x, m_y, m_nugget, m_sill, m_range );
+
+   m_x.clear();
+   m_y.clear();
+}
+
+//-----------------------------------------------------------------------------
+int Assembly::Size() const
+{
+   return m_x.size();
+}
+
+//=============================================================================
+// EngineOptions
+//=============================================================================
+EngineOptions::EngineOptions()
+:  nthreads( 0 ),
+   progress_interval( 30.0 ),
+   progress(),
+   precision( PRECISION_DOUBLE ),
+   precision_report(),
+   neighbors( 0 ),
+   taper( 0.0 ),
+   hmatrix( 0.0 ),
+   hmatrix_report(),
+   vecchia( 0 ),
+   nystrom( 0 ),
+   nystrom_audit( -1 ),
+   nystrom_report(),
+   iterative( 0.0 ),
+   iterative_report(),
+   iterative_outcome(),
+   screen( 0.0 ),
+   targets(),
+   priority( PRIORITY_INDEX ),
+   score(),
+   deadline( 0.0 ),
+   cancel( nullptr )
+{
+}
+
+//=============================================================================
+// PrecisionReport
+//=============================================================================
+PrecisionReport::PrecisionReport()
+:  systems( 0 ),
+   fallbacks( 0 ),
+   solves( 0 ),
+   max_solves( 0 ),
+   audited( 0 ),
+   max_zhat_error( 0.0 ),
+   max_kstd_error( 0.0 ),
+   max_zeta_error( 0.0 )
+{
+}
+
+//-----------------------------------------------------------------------------
+// FormatPrecision
+//
+//    e.g. "mixed precision: 5000 systems, 2.00 float32 solves per system
+//          (max 3), 0 double fallbacks; versus double on 157 audited
+//          systems: max relative error zhat 3.1e-16, kstd 2.2e-15; max
+//          zeta error 4.4e-15"  (on one line)
+//-----------------------------------------------------------------------------
+std::string FormatPrecision( const PrecisionReport& report )
+{
+   std::ostringstream out;
+
+   out << "mixed precision: " << report.systems << " systems, ";
+   out << std::fixed << std::setprecision(2) << static_cast<double>(report.solves) / std::max(report.systems, 1);
+   out << " float32 solves per system (max " << report.max_solves << "), ";
+   out << report.fallbacks << " double fallbacks; ";
+   out << "versus double on " << report.audited << " audited systems: ";
+   out << std::scientific << std::setprecision(1);
+   out << "max relative error zhat " << report.max_zhat_error << ", kstd " << report.max_kstd_error;
+   out << "; max zeta error " << report.max_zeta_error;
+
+   return out.str();
+}
+
+//-----------------------------------------------------------------------------
+IterativeReport::IterativeReport()
+:  systems( 0 ),
+   unconverged( 0 ),
+   iterations( 0 ),
+   max_iterations( 0 ),
+   max_residual( 0.0 ),
+   outcomes()
+{
+}
+
+//-----------------------------------------------------------------------------
+// FormatIterative
+//
+//    e.g. "iterative: 5000 systems, 23.41 CG iterations per system (max 37),
+//          0 unconverged; max relative residual 9.8e-09"  (on one line)
+//-----------------------------------------------------------------------------
+std::string FormatIterative( const IterativeReport& report )
+{
+   std::ostringstream out;
+
+   out << "iterative: " << report.systems << " systems, ";
+   out << std::fixed << std::setprecision(2) << static_cast<double>(report.iterations) / std::max(report.systems, 1);
+   out << " CG iterations per system (max " << report.max_iterations << "), ";
+   out << report.unconverged << " unconverged; ";
+   out << std::scientific << std::setprecision(1);
+   out << "max relative residual " << report.max_residual;
+
+   return out.str();
+}
+
+//-----------------------------------------------------------------------------
+HMatrixReport::HMatrixReport()
+:  points( 0 ),
+   max_rank( 0 ),
+   storage( 0 ),
+   sampled_error( 0.0 )
+{
+}
+
+//-----------------------------------------------------------------------------
+// FormatHMatrix
+//
+//    e.g. "hmatrix: 20000 points, max rank 143, 1290.4 values per point;
+//          sampled relative error 3.2e-07"  (on one line)
+//-----------------------------------------------------------------------------
+std::string FormatHMatrix( const HMatrixReport& report )
+{
+   std::ostringstream out;
+
+   out << "hmatrix: " << report.points << " points, max rank " << report.max_rank << ", ";
+   out << std::fixed << std::setprecision(1) << static_cast<double>(report.storage) / std::max(report.points, 1);
+   out << " values per point; ";
+   out << std::scientific << std::setprecision(1);
+   out << "sampled relative error " << report.sampled_error;
+
+   return out.str();
+}
+
+//-----------------------------------------------------------------------------
+NystromReport::NystromReport()
+:  rank( 0 ),
+   systems( 0 ),
+   audited( 0 ),
+   max_zhat_error( 0.0 ),
+   max_kstd_error( 0.0 ),
+   max_zeta_error( 0.0 )
+{
+}
+
+//-----------------------------------------------------------------------------
+// FormatNystrom
+//
+//    e.g. "nystrom: rank 200, 5000 systems; versus exact on 16 audited
+//          systems: max relative error zhat 2.1e-03, kstd 4.7e-03; max zeta
+//          error 1.2e-02"  (on one line)
+//-----------------------------------------------------------------------------
+std::string FormatNystrom( const NystromReport& report )
+{
+   std::ostringstream out;
+
+   out << "nystrom: rank " << report.rank << ", " << report.systems << " systems; ";
+   out << "versus exact on " << report.audited << " audited systems: ";
+   out << std::scientific << std::setprecision(1);
+   out << "max relative error zhat " << report.max_zhat_error << ", kstd " << report.max_kstd_error;
+   out << "; max zeta error " << report.max_zeta_error;
+
+   return out.str();
+}
 
 //=============================================================================
+// Engine
 //
+//    The observations are distributed across the worker threads; see
+//    Schedule.
 //=============================================================================
-std::vector<Boomerang> Engine(
-   double nugget,
+void Engine(
    double sill,
-   double range,
    double radius,
-   std::vector<DataRecord> obs )
+   const std::vector<DataRecord>& obs,
+   const Matrix& D,
+   const Matrix& C,
+   const ResultSink& sink,
+   const EngineOptions& options )
 {
-   // Manifest constants.
-   const int MINIMUM_COUNT = 10;
-
    const int N = obs.size();     // number of observations.
    assert(N > 1);
+   assert(D.nRows() == N && C.nRows() == N);
 
-   // Pre-compute the separation distance matrix for all of the observations.
-   Matrix D(N, N);
-   for (int i = 0; i < N-1; ++i) {
-      for (int j = i+1; j < N; ++j)
-      {
-         D(i,j) = hypot( obs[i].x-obs[j].x, obs[i].y-obs[j].y );
-         D(j,i) = D(i,j);
+   // The expected active-set sizes drive the progress ETA, and the cheapest-
+   // first order. Counting them is O(N^2) comparisons, which is negligible
+   // next to the factorizations.
+   std::vector<int> expected(N, 0);
+   if (WantExpected(options)) {
+      for (int k : Targets(N, options)) {
+         for (int j = 0; j < N; ++j)
+            if (j != k && D(k,j) >= radius) ++expected[k];
+         if (options.neighbors > 0)
+            expected[k] = std::min( expected[k], options.neighbors );
       }
    }
 
-   // Pre-compute the covariance matrix for all of the observations.
-   Matrix C(N, N, sill);
-   for (int i = 0; i < N-1; ++i) {
-      for (int j = i+1; j < N; ++j) {
-         C(i,j) = (sill-nugget)*exp(-3.0*D(i,j)/range);
-         C(j,i) = C(i,j);
+   // Small neighborhoods are solved BATCH_LANES observations at a time.
+   const bool batched = options.neighbors > 0 && options.neighbors <= FIXED_MAX;
+
+   // Each worker slices its systems out of C into an arena of order N^2, so
+   // the memory available may allow fewer of them than there are processors.
+   const std::size_t footprint = Workspace::Footprint(N, options.precision, batched) + sizeof(int)*(batched ? BATCH_LANES*N : N);
+
+   PrecisionReport report;
+   Schedule( Targets(N, options), batched ? BATCH_LANES : 1, expected,
+      [&]() {
+         return std::unique_ptr<Worker>( new DenseWorker(sill, radius, obs, D, C, options, batched, report) );
+      },
+      footprint, sink, options );
+
+   if (options.precision == PRECISION_MIXED && options.precision_report)
+      options.precision_report( report );
+}
+
+//-----------------------------------------------------------------------------
+// Engine
+//
+//    The tapered version. The whole of C is factored once, with a nested
+//    dissection ordering, and every observation is then evaluated from that
+//    one factor; see EvaluateTapered. Requires radius < options.taper.
+//    Returns false, and evaluates nothing, if C is not numerically positive
+//    definite.
+//-----------------------------------------------------------------------------
+bool Engine(
+   double sill,
+   double radius,
+   const std::vector<DataRecord>& obs,
+   const SparseMatrix& C,
+   const ResultSink& sink,
+   const EngineOptions& options )
+{
+   const int N = obs.size();     // number of observations.
+   assert(N > 1);
+   assert(C.nRows() == N);
+   assert(radius < options.taper);
+
+   std::vector<int> expected(N, 0);
+   if (WantExpected(options)) {
+      std::vector<int> excluded;
+      for (int k : Targets(N, options)) {
+         ExcludedSet(k, radius, obs, C, excluded);
+         expected[k] = N - excluded.size();
       }
    }
 
-   // Create the matrix of observed values.
-   Matrix Z(N, 1);
+   std::vector<double> x(N), y(N);
+   for (int k = 0; k < N; ++k) {
+      x[k] = obs[k].x;
+      y[k] = obs[k].y;
+   }
+
+   TaperedSystem system;
+   if (!system.factor.Factor( C, NestedDissection(x, y, options.taper) )) return false;
+
+   std::vector<double> r(N);
    for (int k = 0; k < N; ++k)
-      Z(k,0) = obs[k].z;
+      r[k] = obs[k].z;
+   system.yz.resize(N);
+   system.factor.HalfSolve( r.data(), system.yz.data() );
 
-   // Pass through the set of observations one at a time.
-   std::vector<Boomerang> results(N);
+   std::fill( r.begin(), r.end(), 1.0 );
+   system.y1.resize(N);
+   system.factor.HalfSolve( r.data(), system.y1.data() );
 
-   for (int k = 0; k < N; ++k) {
-      // Determine the active subset of the observations for the location of
-      // observation [k]; i.e. those observations outside of the buffer radius.
-      std::vector<int> current(N, 0);
-      current[k] = 1;
+   system.q11 = SumProduct(N, system.y1.data(), system.y1.data());
+   system.q1z = SumProduct(N, system.y1.data(), system.yz.data());
 
-      std::vector<int> first(1, 0);
-      first[0] = 1;
+   Schedule( Targets(N, options), 1, expected,
+      [&]() {
+         return std::unique_ptr<Worker>( new TaperedWorker(sill, radius, obs, C, &system) );
+      },
+      0, sink, options );
+   return true;
+}
 
-      std::vector<int> active(N);
-      for (int j = 0; j < N; ++j) {
-         if( D(k,j) >= radius )
-            active[j] = 1;
-         else
-            active[j] = 0;
+//-----------------------------------------------------------------------------
+// Engine
+//
+//    The hierarchical version. C is factored in place, once, and every
+//    observation is then evaluated from that factor; see
+//    EvaluateHierarchical. Returns false, and evaluates nothing, if C is not
+//    numerically positive definite.
+//-----------------------------------------------------------------------------
+bool Engine(
+   double sill,
+   double radius,
+   const std::vector<DataRecord>& obs,
+   HMatrix& C,
+   const ResultSink& sink,
+   const EngineOptions& options )
+{
+   const int N = obs.size();     // number of observations.
+   assert(N > 1);
+   assert(C.nRows() == N);
+
+   std::vector<int> expected(N, 0);
+   if (WantExpected(options)) {
+      std::vector<int> excluded;
+      for (int k : Targets(N, options)) {
+         C.Within(obs[k].x, obs[k].y, radius, excluded);
+         expected[k] = N - std::max<int>(excluded.size(), 1);
       }
-      active[k] = 0;
+   }
 
-      int M = std::accumulate(active.begin(), active.end(), int(0));
-      if( M < MINIMUM_COUNT )
-      {
-         results[k].zhat   = NAN;
-         results[k].kstd   = NAN;
-         results[k].zeta   = NAN;
-         results[k].pvalue = NAN;
-         results[k].cnt    = M;
-         continue;
+   if (options.hmatrix_report) {
+      HMatrixReport report;
+      report.points        = N;
+      report.max_rank      = C.MaxRank();
+      report.storage       = C.Storage();
+      report.sampled_error = C.SampledError();
+      options.hmatrix_report( report );
+   }
+
+   if (!C.Factor()) return false;
+
+   InverseSystem system;
+   Prepare( obs, [&](const double* v, double* Gv) {
+      std::copy( v, v + N, Gv );
+      C.Solve( Gv );
+   }, system );
+
+   Schedule( Targets(N, options), 1, expected,
+      [&]() {
+         return std::unique_ptr<Worker>( new InverseWorker(
+            [&](int k, InverseWorkspace& ws) {
+               return EvaluateHierarchical(k, sill, radius, obs, C, system, ws);
+            }) );
+      },
+      0, sink, options );
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+// Engine
+//
+//    The Vecchia version. Every observation is evaluated from the sparse
+//    precision Q, in place of C^{-1}; see EvaluateVecchia. Returns false,
+//    and evaluates nothing, if V is empty because it could not be built.
+//-----------------------------------------------------------------------------
+bool Engine(
+   double sill,
+   double radius,
+   const std::vector<DataRecord>& obs,
+   const Vecchia& V,
+   const ResultSink& sink,
+   const EngineOptions& options )
+{
+   const int N = obs.size();     // number of observations.
+   assert(N > 1);
+   if (V.nRows() != N) return false;
+
+   std::vector<int> expected(N, 0);
+   if (WantExpected(options)) {
+      std::vector<int> excluded;
+      for (int k : Targets(N, options)) {
+         V.Index().Within(obs[k].x, obs[k].y, radius, excluded);
+         expected[k] = N - std::max<int>(excluded.size(), 1);
       }
+   }
 
-      // Setup the Ordinary Kriging system for the location of observation [k]
-      // using only the active data.
-      Matrix A;
-      Slice(C, active, active, A);
+   InverseSystem system;
+   Prepare( obs, [&](const double* v, double* Gv) {
+      V.Multiply( v, Gv );
+   }, system );
+
+   Schedule( Targets(N, options), 1, expected,
+      [&]() {
+         return std::unique_ptr<Worker>( new InverseWorker(
+            [&](int k, InverseWorkspace& ws) {
+               return EvaluateVecchia(k, sill, radius, obs, V, system, ws);
+            }) );
+      },
+      0, sink, options );
+   return true;
+}
 
-      Matrix b;
-      Slice(C, active, current, b);
+//-----------------------------------------------------------------------------
+// Engine
+//
+//    The Nystrom version. Every observation is evaluated from the low-rank
+//    approximation V by the Woodbury identity; see EvaluateNystrom. Returns
+//    false, and evaluates nothing, if V is empty because it could not be
+//    built.
+//
+//    For the report, options.nystrom_audit observations, evenly spaced, are
+//    solved again with the matrix-free operator, after the run, on all of
+//    the threads.
+//-----------------------------------------------------------------------------
+bool Engine(
+   double sill,
+   double radius,
+   const std::vector<DataRecord>& obs,
+   const Nystrom& V,
+   const ResultSink& sink,
+   const EngineOptions& options )
+{
+   const int N = obs.size();     // number of observations.
+   assert(N > 1);
+   if (V.nRows() != N) return false;
 
-      Matrix ZZ;
-      Slice(Z, active, first, ZZ);
+   std::vector<int> expected(N, 0);
+   if (WantExpected(options)) {
+      std::vector<int> excluded;
+      for (int k : Targets(N, options)) {
+         V.Index().Within(obs[k].x, obs[k].y, radius, excluded);
+         expected[k] = N - std::max<int>(excluded.size(), 1);
+      }
+   }
 
-      // Solve the Ordinary Kriging system.
-      Matrix L, u, v, lv, w;
-      Matrix ones(M, 1, 1.0);
+   // The lower triangle of S, and the other shared terms.
+   NystromSystem system;
+   {
+      ScopedTimer timer( PHASE_FACTORIZATION );
 
-      if (CholeskyDecomposition(A,L)) {
-         CholeskySolve(L,b,u);
-         CholeskySolve(L,ones,v);
+      const int r = V.Rank();
+      system.S.assign( static_cast<std::size_t>(r)*r, 0.0 );
+      system.w1.assign( r, 0.0 );
+      system.wz.assign( r, 0.0 );
+      for (int a = 0; a < r; ++a)
+         system.S[static_cast<std::size_t>(a)*r + a] = 1.0;
 
-         double lambda = ( Sum(u) - 1 ) / Sum(v);
+      for (int j = 0; j < N; ++j) {
+         const double* u = V.Row(j);
+         const double  w = 1.0 / V.Diagonal(j);
+         for (int a = 0; a < r; ++a) {
+            const double wu = w * u[a];
+            system.w1[a] += wu;
+            system.wz[a] += wu * obs[j].z;
+            double* Sa = &system.S[static_cast<std::size_t>(a)*r];
+            for (int c = 0; c <= a; ++c)
+               Sa[c] += wu * u[c];
+         }
+         system.d11 += w;
+         system.d1z += w * obs[j].z;
+      }
+   }
 
-         Multiply_aM( lambda, v, lv );
-         Subtract_MM( u, lv, w );
+   // The audited observations, and their results from the run. Each costs
+   // O(N^2) per iteration, so the default sample shrinks as 1/N^2 beyond
+   // NYSTROM_AUDIT_POINTS observations, to cost no more than it does there,
+   // and is empty beyond four times that.
+   const std::vector<int> targets = Targets(N, options);
+   const int T = targets.size();
+   int naudit = options.nystrom_audit;
+   if (naudit < 0) {
+      const double shrink = std::min( 1.0, static_cast<double>(NYSTROM_AUDIT_POINTS) / N );
+      naudit = static_cast<int>( NYSTROM_AUDIT * shrink * shrink );
+   }
+   naudit = options.nystrom_report ? std::min( naudit, T ) : 0;
+   std::vector<int> ks(naudit);
+   for (int i = 0; i < naudit; ++i)
+      ks[i] = targets[ (2LL*i + 1) * T / (2LL*naudit) ];
+   std::vector<Boomerang> approximate(naudit, Unsolved(0));
+   std::vector<int> slot(naudit > 0 ? N : 0, -1);
+   for (int i = 0; i < naudit; ++i)
+      slot[ks[i]] = i;
 
-         double zhat = DotProduct(w,ZZ);
-         double kstd = sqrt( sill - DotProduct(b,w) - lambda );
+   NystromReport report;
+   report.rank = V.Rank();
 
-         results[k].zhat = zhat;
-         results[k].kstd = kstd;
-         results[k].zeta = (obs[k].z-zhat) / kstd;
+   Schedule( targets, 1, expected,
+      [&]() {
+         return std::unique_ptr<Worker>( new NystromWorker(sill, radius, obs, V, system) );
+      },
+      0,
+      [&](int k, const Boomerang& result) {
+         if (!std::isnan(result.zhat)) ++report.systems;
+         if (naudit > 0 && slot[k] >= 0) approximate[slot[k]] = result;
+         sink(k, result);
+      },
+      options );
 
-         if (results[k].zeta < 0)
-            results[k].pvalue = GaussianCDF(results[k].zeta);
-         else
-            results[k].pvalue = 1 - GaussianCDF(results[k].zeta);
+   if (!options.nystrom_report) return true;
 
-         results[k].cnt  = M;
+   // An audit past the deadline would only delay the partial results.
+   if (naudit > 0 && !Stopped(options)) {
+      std::vector<double> x(N), y(N);
+      for (int k = 0; k < N; ++k) {
+         x[k] = obs[k].x;
+         y[k] = obs[k].y;
       }
-      else {
-         results[k].zhat   = NAN;
-         results[k].kstd   = NAN;
-         results[k].zeta   = NAN;
-         results[k].pvalue = NAN;
-         results[k].cnt    = M;
-         continue;
+      CovarianceOperator C;
+      const int nthreads = (options.nthreads < 1) ? DefaultThreadCount() : options.nthreads;
+      C.Build( x, y, V.Nugget(), V.Sill(), V.Range(), nthreads );
+
+      // The sample is spread across the threads, in batches of at most
+      // ITERATIVE_BATCH; quietly, and stopped like the run.
+      EngineOptions quiet;
+      quiet.nthreads = nthreads;
+      quiet.deadline = options.deadline;
+      quiet.cancel   = options.cancel;
+      const int step = std::min( ITERATIVE_BATCH, (naudit + nthreads - 1) / nthreads );
+
+      IterativeReport unused;
+      std::vector<Boomerang> exact(naudit, Unsolved(0));
+      Schedule( ks, step, expected,
+         [&]() {
+            return std::unique_ptr<Worker>( new IterativeWorker(sill, radius, obs, C, AUDIT_TOLERANCE, quiet.iterative_outcome, unused) );
+         },
+         sizeof(double)*4*ITERATIVE_BATCH*N,
+         [&](int k, const Boomerang& result) { exact[slot[k]] = result; },
+         quiet );
+
+      for (int i = 0; i < naudit; ++i) {
+         const Boomerang& result    = approximate[i];
+         const Boomerang& reference = exact[i];
+         if (std::isnan(result.zhat) || std::isnan(reference.zhat)) continue;
+
+         ++report.audited;
+         report.max_zhat_error = std::max( report.max_zhat_error, fabs(result.zhat - reference.zhat) / fabs(reference.zhat) );
+         report.max_kstd_error = std::max( report.max_kstd_error, fabs(result.kstd - reference.kstd) / reference.kstd );
+         report.max_zeta_error = std::max( report.max_zeta_error, fabs(result.zeta - reference.zeta) );
+      }
+   }
+
+   options.nystrom_report( report );
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+// Engine
+//
+//    The matrix-free version. Every kriging system is solved by iteration,
+//    with the products of C evaluated as they are needed; see
+//    EvaluateIterative. Returns false, and evaluates nothing, if C is empty
+//    because its preconditioner could not be factored.
+//-----------------------------------------------------------------------------
+bool Engine(
+   double sill,
+   double radius,
+   const std::vector<DataRecord>& obs,
+   const CovarianceOperator& C,
+   const ResultSink& sink,
+   const EngineOptions& options )
+{
+   const int N = obs.size();     // number of observations.
+   assert(N > 1);
+   assert(options.iterative > 0);
+   if (C.nRows() != N) return false;
+
+   std::vector<int> expected(N, 0);
+   if (WantExpected(options)) {
+      std::vector<int> excluded;
+      for (int k : Targets(N, options)) {
+         C.Index().Within(obs[k].x, obs[k].y, radius, excluded);
+         expected[k] = N - std::max<int>(excluded.size(), 1);
+      }
+   }
+
+   IterativeReport report;
+   Schedule( Targets(N, options), ITERATIVE_BATCH, expected,
+      [&]() {
+         return std::unique_ptr<Worker>( new IterativeWorker(sill, radius, obs, C, options.iterative, options.iterative_outcome, report) );
+      },
+      sizeof(double)*4*ITERATIVE_BATCH*N, sink, options );
+
+   std::sort( report.outcomes.begin(), report.outcomes.end(),
+      [](const IterativeOutcome& a, const IterativeOutcome& b){ return a.k < b.k; } );
+
+   if (options.iterative_report)
+      options.iterative_report( report );
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+// Engine
+//
+//    The local version, for a few targets among many observations. Nothing
+//    of order N^2 is formed: the active set of each observation is found
+//    with the k-d tree of L, and the covariance matrix of just that set is
+//    filled in; see EvaluateLocal. With options.neighbors, the work for each
+//    observation is then independent of N but for the search. The results
+//    are those of the dense version, up to rounding.
+//-----------------------------------------------------------------------------
+void Engine(
+   double sill,
+   double radius,
+   const std::vector<DataRecord>& obs,
+   const Locations& L,
+   const ResultSink& sink,
+   const EngineOptions& options )
+{
+   const int N = obs.size();     // number of observations.
+   assert(N > 1);
+   assert(L.nRows() == N);
+
+   const std::vector<int> targets = Targets(N, options);
+
+   std::vector<int> expected(N, 0);
+   if (WantExpected(options)) {
+      std::vector<int> excluded;
+      for (int k : targets) {
+         L.Index().Within(obs[k].x, obs[k].y, radius, excluded);
+         expected[k] = N - std::max<int>(excluded.size(), 1);
+         if (options.neighbors > 0)
+            expected[k] = std::min( expected[k], options.neighbors );
       }
    }
+
+   // The largest possible active set.
+   const int M = (options.neighbors > 0) ? std::min( options.neighbors, N-1 ) : N-1;
+
+   PrecisionReport report;
+   Schedule( targets, 1, expected,
+      [&]() {
+         return std::unique_ptr<Worker>( new LocalWorker(sill, radius, obs, L, options, M, report) );
+      },
+      LocalWorkspace::Footprint(M, options.precision), sink, options );
+
+   if (options.precision == PRECISION_MIXED && options.precision_report)
+      options.precision_report( report );
+}
+
+//-----------------------------------------------------------------------------
+// EvaluateAt
+//-----------------------------------------------------------------------------
+Boomerang EvaluateAt(
+   double x,
+   double y,
+   double z,
+   double sill,
+   double radius,
+   const std::vector<DataRecord>& obs,
+   const Locations& L,
+   const EngineOptions& options )
+{
+   const int N = obs.size();     // number of observations.
+   assert(L.nRows() == N);
+
+   const int M0 = (options.neighbors > 0) ? std::min( options.neighbors, N ) : N;
+   LocalWorkspace ws( M0, options.precision );
+
+   return EvaluateHypothetical(x, y, z, sill, radius, options.neighbors, obs, L, options.precision, ws);
+}
+
+//=============================================================================
+// LocalEvaluator
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+struct LocalEvaluator::Scratch {
+   LocalWorkspace ws;
+
+   Scratch( int M, Precision precision ) : ws( M, precision ) {
+   }
+};
+
+//-----------------------------------------------------------------------------
+LocalEvaluator::LocalEvaluator( int capacity, Precision precision )
+:  m_capacity( capacity ),
+   m_precision( precision ),
+   m_scratch()
+{
+}
+
+//-----------------------------------------------------------------------------
+LocalEvaluator::~LocalEvaluator()
+{
+}
+
+//-----------------------------------------------------------------------------
+// Storage
+//
+//    The kept storage, made at the first call, for an active set of at most
+//    M observations; or, for a larger one, new storage held by "own".
+//-----------------------------------------------------------------------------
+LocalEvaluator::Scratch& LocalEvaluator::Storage( int M, std::unique_ptr<Scratch>& own )
+{
+   if (M > m_capacity) {
+      own.reset( new Scratch(M, m_precision) );
+      return *own;
+   }
+   if (!m_scratch)
+      m_scratch.reset( new Scratch(m_capacity, m_precision) );
+   return *m_scratch;
+}
+
+//-----------------------------------------------------------------------------
+// Evaluate
+//
+//    The active set of observation [k] has at most N-1 observations.
+//-----------------------------------------------------------------------------
+Boomerang LocalEvaluator::Evaluate(
+   int k,
+   double sill,
+   double radius,
+   int neighbors,
+   const std::vector<DataRecord>& obs,
+   const Locations& L )
+{
+   const int N = obs.size();     // number of observations.
+   assert(L.nRows() == N);
+
+   const int M = (neighbors > 0) ? std::min( neighbors, N-1 ) : N-1;
+   std::unique_ptr<Scratch> own;
+   LocalWorkspace& ws = Storage(M, own).ws;
+
+   Boomerang result = EvaluateLocal(k, sill, radius, neighbors, obs, L, m_precision, ws);
+
+   double scratch[2];
+   PValues(1, &result, &scratch[0], &scratch[1]);
+   return result;
+}
+
+//-----------------------------------------------------------------------------
+// EvaluateAt
+//
+//    The active set of a hypothetical observation has at most N observations.
+//-----------------------------------------------------------------------------
+Boomerang LocalEvaluator::EvaluateAt(
+   double x,
+   double y,
+   double z,
+   double sill,
+   double radius,
+   int neighbors,
+   const std::vector<DataRecord>& obs,
+   const Locations& L )
+{
+   const int N = obs.size();     // number of observations.
+   assert(L.nRows() == N);
+
+   const int M = (neighbors > 0) ? std::min( neighbors, N ) : N;
+   std::unique_ptr<Scratch> own;
+   LocalWorkspace& ws = Storage(M, own).ws;
+
+   return EvaluateHypothetical(x, y, z, sill, radius, neighbors, obs, L, m_precision, ws);
+}
+
+//-----------------------------------------------------------------------------
+// Convenience version: assemble, compute, and return all of the results.
+//-----------------------------------------------------------------------------
+std::vector<Boomerang> Engine(
+   double nugget,
+   double sill,
+   double range,
+   double radius,
+   std::vector<DataRecord> obs )
+{
+   const int N = obs.size();     // number of observations.
+   assert(N > 1);
+
+   // Pre-compute the separation distance and covariance matrices for all of
+   // the observations.
+   Assembly assembly(nugget, sill, range);
+   for (int k = 0; k < N; ++k)
+      assembly.Append( obs[k] );
+
+   Matrix D, C;
+   assembly.Finalize(D, C, 0);
+
+   std::vector<Boomerang> results(N);
+   Engine( sill, radius, obs, D, C, [&results](int k, const Boomerang& r){ results[k] = r; }, EngineOptions() );
+
    return results;
 }
+
+//-----------------------------------------------------------------------------
+// The number of worker threads to use when none is specified.
+//-----------------------------------------------------------------------------
+int DefaultThreadCount()
+{
+   int n = std::thread::hardware_concurrency();
+   return (n > 0) ? n : 1;
+}
@@ -12,10 +12,23 @@
 #ifndef ENGINE_H
 #define ENGINE_H
 
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
+#include "hmatrix.h"
+#include "locations.h"
+#include "matrix.h"
+#include "matrix_free.h"
+#include "nystrom.h"
+#include "progress.h"
 #include "read_data.h"
+#include "sparse_matrix.h"
+#include "vecchia.h"
 
 
 //-----------------------------------------------------------------------------
@@ -28,6 +41,366 @@ struct Boomerang {
 };
 
 //-----------------------------------------------------------------------------
+// Assembly
+//
+//    The separation distance and covariance matrices. Append collects the
+//    locations as the observations are read, and Finalize fills the full
+//    symmetric matrices tile by tile on "nthreads" threads (< 1 for the
+//    default). The tapered Finalize fills only the sparse covariance matrix,
+//    tapered to zero beyond a separation distance of "taper"; the
+//    hierarchical Finalize compresses the covariance matrix to an H-matrix;
+//    the Vecchia Finalize builds its sparse approximate inverse; the Nystrom
+//    Finalize builds its low-rank factor; the matrix-free Finalize stores
+//    only the locations and the preconditioner; and the local Finalize only
+//    the indexed locations.
+//-----------------------------------------------------------------------------
+class Assembly {
+   public :
+      Assembly( double nugget, double sill, double range );
+
+      void Append( const DataRecord& rec );
+      void Finalize( Matrix& D, Matrix& C, int nthreads );
+      void Finalize( double taper, SparseMatrix& C, int nthreads );
+      void Finalize( double tolerance, HMatrix& C, int nthreads );
+      void Finalize( int conditioning, Vecchia& V, int nthreads );
+      void Finalize( int rank, Nystrom& V, int nthreads );
+      void Finalize( CovarianceOperator& C, int nthreads );
+      void Finalize( Locations& L );
+
+      int Size() const;
+
+   private :
+      double m_nugget;
+      double m_sill;
+      double m_range;
+
+      std::vector<double> m_x;
+      std::vector<double> m_y;
+};
+
+//-----------------------------------------------------------------------------
+// The results are handed to the sink in the order of evaluation, on the thread
+// that called Engine, while the worker threads continue with later
+// observations. That is observation order unless options.priority says
+// otherwise.
+//-----------------------------------------------------------------------------
+typedef std::function<void(int k, const Boomerang& result)> ResultSink;
+
+//-----------------------------------------------------------------------------
+// Precision
+//
+//    PRECISION_DOUBLE assembles and factors each kriging system in double
+//    precision. PRECISION_MIXED assembles and factors it in float32, and
+//    recovers double-precision solutions by iterative refinement against
+//    double-precision residuals; a system whose refinement does not converge
+//    is re-solved in double precision.
+//-----------------------------------------------------------------------------
+enum Precision {
+   PRECISION_DOUBLE,
+   PRECISION_MIXED
+};
+
+//-----------------------------------------------------------------------------
+// PrecisionReport
+//
+//    The accuracy of a mixed-precision run. A sample of the observations,
+//    every 32nd, is also solved in double precision, and the largest
+//    differences from the all-double results are recorded.
+//-----------------------------------------------------------------------------
+struct PrecisionReport {
+   int       systems;                   // systems solved in mixed precision
+   int       fallbacks;                 // of those, re-solved in double
+   long long solves;                    // total float32 solves per system
+   int       max_solves;                // most float32 solves for one system
+   int       audited;                   // systems also solved in double
+   double    max_zhat_error;            // max |zhat - zhat64| / |zhat64|
+   double    max_kstd_error;            // max |kstd - kstd64| / kstd64
+   double    max_zeta_error;            // max |zeta - zeta64|
+
+   PrecisionReport();
+};
+
+typedef std::function<void(const PrecisionReport& report)> PrecisionCallback;
+
+std::string FormatPrecision( const PrecisionReport& report );
+
+//-----------------------------------------------------------------------------
+// IterativeReport
+//
+//    The convergence of a matrix-free run. Each observation is solved by
+//    preconditioned conjugate gradients to a relative residual of at most
+//    options.iterative; a system that does not converge is unsolved. The
+//    outcome of every system solved is also recorded, in observation order.
+//    Each outcome is also handed to options.iterative_outcome as soon as it
+//    is known, on the worker thread, and before the result of its
+//    observation reaches the sink.
+//-----------------------------------------------------------------------------
+struct IterativeOutcome {
+   int       k;                         // the observation
+   int       iterations;                // CG iterations
+   double    residual;                  // final relative residual
+};
+
+struct IterativeReport {
+   int       systems;                   // systems solved by iteration
+   int       unconverged;               // of those, not converged
+   long long iterations;                // total iterations
+   int       max_iterations;            // most iterations for one system
+   double    max_residual;              // largest final relative residual
+   std::vector<IterativeOutcome> outcomes;  // of each system
+
+   IterativeReport();
+};
+
+typedef std::function<void(const IterativeReport& report)> IterativeCallback;
+typedef std::function<void(const IterativeOutcome& outcome)> OutcomeCallback;
+
+std::string FormatIterative( const IterativeReport& report );
+
+//-----------------------------------------------------------------------------
+// HMatrixReport
+//
+//    The compression of an H-matrix run, with the relative error of the
+//    compressed covariance matrix estimated from a sample of its rows; see
+//    HMatrix::SampledError.
+//-----------------------------------------------------------------------------
+struct HMatrixReport {
+   int         points;                  // order of the matrix
+   int         max_rank;                // of the off-diagonal blocks
+   std::size_t storage;                 // values stored, once factored
+   double      sampled_error;           // ||(C - H) v|| / ||C v||, sampled
+
+   HMatrixReport();
+};
+
+typedef std::function<void(const HMatrixReport& report)> HMatrixCallback;
+
+std::string FormatHMatrix( const HMatrixReport& report );
+
+//-----------------------------------------------------------------------------
+// NystromReport
+//
+//    The accuracy of a Nystrom run. A validation sample of the observations,
+//    options.nystrom_audit of them evenly spaced, is also solved exactly:
+//    by the matrix-free engine to a relative residual of 1e-10, since the
+//    O(N^2) storage of the dense engine is what the Nystrom engine avoids.
+//    The largest differences are recorded. The default sample, for
+//    options.nystrom_audit < 0, is 16 observations up to N = 10000, and
+//    shrinks as 1/N^2 beyond, to none beyond N = 40000.
+//-----------------------------------------------------------------------------
+struct NystromReport {
+   int       rank;                      // landmarks
+   int       systems;                   // systems solved by Woodbury
+   int       audited;                   // systems also solved exactly
+   double    max_zhat_error;            // max |zhat - zhat*| / |zhat*|
+   double    max_kstd_error;            // max |kstd - kstd*| / kstd*
+   double    max_zeta_error;            // max |zeta - zeta*|
+
+   NystromReport();
+};
+
+typedef std::function<void(const NystromReport& report)> NystromCallback;
+
+std::string FormatNystrom( const NystromReport& report );
+
+//-----------------------------------------------------------------------------
+// Priority
+//
+//    The order in which the observations are evaluated. PRIORITY_CHEAPEST
+//    takes the smallest expected active sets first; PRIORITY_SCORE takes the
+//    lowest options.score first, e.g. the p-values of an earlier screening
+//    run, so that the most suspicious observations come first.
+//-----------------------------------------------------------------------------
+enum Priority {
+   PRIORITY_INDEX,
+   PRIORITY_CHEAPEST,
+   PRIORITY_SCORE
+};
+
+//-----------------------------------------------------------------------------
+// EngineOptions
+//
+//    The optional settings of an engine run. The screening threshold is
+//    applied by Pipeline, which then runs the engine twice.
+//
+//    The engines with scratch storage of order N^2 per worker thread, the
+//    dense and local ones, start fewer than options.nthreads workers if that
+//    many would not fit in the memory available.
+//
+//    No observation is started after the deadline, or once *cancel is set;
+//    those in progress are finished and handed to the sink, and the others
+//    are not evaluated.
+//-----------------------------------------------------------------------------
+struct EngineOptions {
+   int               nthreads;          // worker threads; < 1 for the default.
+   double            progress_interval; // minimum seconds between reports.
+   ProgressCallback  progress;          // progress reports; empty for none.
+   Precision         precision;         // arithmetic of the kriging systems.
+   PrecisionCallback precision_report;  // called once after a mixed run.
+   int               neighbors;         // nearest active data used; 0 for all.
+   double            taper;             // Wendland taper distance; 0 for none.
+   double            hmatrix;           // H-matrix tolerance; 0 for dense.
+   HMatrixCallback   hmatrix_report;    // called once in an H-matrix run.
+   int               vecchia;           // Vecchia conditioning set size; 0 for none.
+   int               nystrom;           // Nystrom rank; 0 for none.
+   int               nystrom_audit;     // observations also solved exactly; < 0 for the default.
+   NystromCallback   nystrom_report;    // called once after a Nystrom run.
+   double            iterative;         // CG relative tolerance; 0 for direct.
+   IterativeCallback iterative_report;  // called once after an iterative run.
+   OutcomeCallback   iterative_outcome; // called for each system solved by iteration.
+   double            screen;            // screening p-value threshold; 0 for none.
+   std::vector<int>  targets;           // observations evaluated, ascending; empty for all.
+   Priority          priority;          // order of evaluation.
+   std::vector<double> score;           // of each observation, for PRIORITY_SCORE.
+   double            deadline;          // WallSeconds() to stop by; 0 for none.
+   const std::atomic<bool>* cancel;     // stop when set; null for none.
+
+   EngineOptions();
+
+   // A copy shares the cancellation flag, which the options do not own.
+   EngineOptions( const EngineOptions& ) = default;
+   EngineOptions& operator=( const EngineOptions& ) = default;
+   EngineOptions( EngineOptions&& ) = default;
+   EngineOptions& operator=( EngineOptions&& ) = default;
+};
+
+void Engine(
+   double sill,
+   double radius,
+   const std::vector<DataRecord>& obs,
+   const Matrix& D,
+   const Matrix& C,
+   const ResultSink& sink,
+   const EngineOptions& options
+);
+
+//-----------------------------------------------------------------------------
+// The engines that factor, or build, one approximation of the whole of C
+// return false, and evaluate nothing, if that approximation is not
+// numerically positive definite.
+//-----------------------------------------------------------------------------
+bool Engine(
+   double sill,
+   double radius,
+   const std::vector<DataRecord>& obs,
+   const SparseMatrix& C,
+   const ResultSink& sink,
+   const EngineOptions& options
+);
+
+bool Engine(
+   double sill,
+   double radius,
+   const std::vector<DataRecord>& obs,
+   HMatrix& C,
+   const ResultSink& sink,
+   const EngineOptions& options
+);
+
+bool Engine(
+   double sill,
+   double radius,
+   const std::vector<DataRecord>& obs,
+   const Vecchia& V,
+   const ResultSink& sink,
+   const EngineOptions& options
+);
+
+bool Engine(
+   double sill,
+   double radius,
+   const std::vector<DataRecord>& obs,
+   const Nystrom& V,
+   const ResultSink& sink,
+   const EngineOptions& options
+);
+
+bool Engine(
+   double sill,
+   double radius,
+   const std::vector<DataRecord>& obs,
+   const CovarianceOperator& C,
+   const ResultSink& sink,
+   const EngineOptions& options
+);
+
+void Engine(
+   double sill,
+   double radius,
+   const std::vector<DataRecord>& obs,
+   const Locations& L,
+   const ResultSink& sink,
+   const EngineOptions& options
+);
+
+//-----------------------------------------------------------------------------
+// EvaluateAt
+//
+//    The boomerang statistic, with its p-value, of a hypothetical observation
+//    of value z at (x,y), which is not among the observations: as the local
+//    Engine would compute it, with all of the observations beyond the buffer
+//    radius of (x,y) as data, or the options.neighbors nearest of them. It is
+//    evaluated on the calling thread.
+//-----------------------------------------------------------------------------
+Boomerang EvaluateAt(
+   double x,
+   double y,
+   double z,
+   double sill,
+   double radius,
+   const std::vector<DataRecord>& obs,
+   const Locations& L,
+   const EngineOptions& options
+);
+
+//-----------------------------------------------------------------------------
+// LocalEvaluator
+//
+//    The scratch storage of the local engine for one thread, kept from one
+//    request to the next by a caller that evaluates a few observations at a
+//    time, such as the server. Evaluate and EvaluateAt compute on the calling
+//    thread, as the local Engine and EvaluateAt do, in the storage kept for
+//    active sets of at most "capacity" observations; a larger active set,
+//    e.g. with neighbors = 0, gets storage of its own for that call alone.
+//-----------------------------------------------------------------------------
+class LocalEvaluator {
+   public :
+      LocalEvaluator( int capacity, Precision precision );
+      ~LocalEvaluator();
+
+      LocalEvaluator( const LocalEvaluator& ) = delete;
+      LocalEvaluator& operator=( const LocalEvaluator& ) = delete;
+
+      // Observation [k], with its p-value.
+      Boomerang Evaluate(
+         int k,
+         double sill,
+         double radius,
+         int neighbors,
+         const std::vector<DataRecord>& obs,
+         const Locations& L );
+
+      // A hypothetical observation of value z at (x,y).
+      Boomerang EvaluateAt(
+         double x,
+         double y,
+         double z,
+         double sill,
+         double radius,
+         int neighbors,
+         const std::vector<DataRecord>& obs,
+         const Locations& L );
+
+   private :
+      struct Scratch;
+
+      Scratch& Storage( int M, std::unique_ptr<Scratch>& own );
+
+      int                      m_capacity;
+      Precision                m_precision;
+      std::unique_ptr<Scratch> m_scratch;
+};
+
 std::vector<Boomerang> Engine(
    double nugget,
    double sill,
@@ -36,6 +409,8 @@ std::vector<Boomerang> Engine(
    std::vector<DataRecord> obs
 );
 
+int DefaultThreadCount();
+
 
 //=============================================================================
 #endif  // ENGINE_H
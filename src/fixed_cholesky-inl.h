@@ -0,0 +1,120 @@
+//=============================================================================
+// fixed_cholesky-inl.h
+//
+//    Cholesky factorization and solution of small symmetric positive definite
+//    systems whose order N is a compile-time constant.
+//
+//    With N fixed, every loop bound is known to the compiler, the storage
+//    lives on the stack, and there are no dimension checks. The
+//    factorization is the right-looking (outer product) form: after each
+//    column of L is formed, it is subtracted from the trailing rows with
+//    independent, contiguous multiply-subtracts, rather than with the
+//    serial dot products of the general routine, so the inner loops run at
+//    the throughput, rather than the latency, of the floating-point units.
+//
+//    The trailing update runs in blocks of FIXED_BLOCK columns, so that each
+//    block is a fixed-length multiply-subtract the compiler can vectorize.
+//    To let the last block of a row run past the diagonal, the systems are
+//    stored row-major with leading dimension FixedStride<N>(); the entries
+//    above the diagonal, and the padding columns, are scratch.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef FIXED_CHOLESKY_INL_H
+#define FIXED_CHOLESKY_INL_H
+
+#include <math.h>
+
+//-----------------------------------------------------------------------------
+// The orders of the specializations: multiples of FIXED_STEP up to
+// FIXED_MAX. A system of order M <= FIXED_MAX is padded to the next multiple.
+//-----------------------------------------------------------------------------
+const int FIXED_STEP  = 8;
+const int FIXED_MAX   = 64;
+const int FIXED_BLOCK = 4;
+
+//-----------------------------------------------------------------------------
+// The leading dimension of a system of order N.
+//-----------------------------------------------------------------------------
+template <int N>
+inline int FixedStride()
+{
+   return N + FIXED_BLOCK;
+}
+
+//-----------------------------------------------------------------------------
+// FixedCholesky
+//
+//    On entrance the lower triangle of A holds that of a symmetric positive
+//    definite matrix; on exit it holds L, where A = LL'. The upper triangle
+//    and the padding columns are overwritten. Returns false if A is not
+//    numerically positive definite.
+//-----------------------------------------------------------------------------
+template <int N>
+inline bool FixedCholesky( double* A )
+{
+   const int LD = N + FIXED_BLOCK;
+   const double MIN_DIVISOR = 1e-12;
+   double c[N + FIXED_BLOCK] = {};        // the current column of L
+
+   for (int j = 0; j < N; ++j) {
+      double* Aj = A + j*LD;
+
+      if (!(Aj[j] >= MIN_DIVISOR)) return false;
+      const double d = sqrt( Aj[j] );
+      const double r = 1.0 / d;
+      Aj[j] = d;
+
+      for (int i = j+1; i < N; ++i) {
+         A[i*LD + j] *= r;
+         c[i] = A[i*LD + j];
+      }
+
+      // Subtract the outer product of the column from the trailing rows.
+      for (int i = j+1; i < N; ++i) {
+         double* Ai = A + i*LD;
+         const double lij = c[i];
+         for (int k = j+1; k <= i; k += FIXED_BLOCK)
+            for (int t = 0; t < FIXED_BLOCK; ++t)
+               Ai[k+t] -= lij * c[k+t];
+      }
+   }
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+// FixedSolve
+//
+//    Solve LL' x = b, where L is from FixedCholesky. On entrance x holds b;
+//    on exit, the solution.
+//-----------------------------------------------------------------------------
+template <int N>
+inline void FixedSolve( const double* L, double* x )
+{
+   const int LD = N + FIXED_BLOCK;
+
+   // Solve L y = b, by columns.
+   for (int j = 0; j < N; ++j) {
+      x[j] /= L[j*LD + j];
+      const double xj = x[j];
+      for (int i = j+1; i < N; ++i)
+         x[i] -= L[i*LD + j] * xj;
+   }
+
+   // Solve L' x = y, by the rows of L, which are the columns of L'.
+   for (int j = N-1; j >= 0; --j) {
+      const double* Lj = L + j*LD;
+      x[j] /= Lj[j];
+      const double xj = x[j];
+      for (int i = 0; i < j; ++i)
+         x[i] -= Lj[i] * xj;
+   }
+}
+
+#endif  // FIXED_CHOLESKY_INL_H
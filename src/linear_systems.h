@@ -18,8 +18,17 @@
 //=============================================================================
 //
 //=============================================================================
-bool CholeskyDecomposition( const Matrix& A, Matrix& L );
-void CholeskySolve( const Matrix& L, const Matrix& b, Matrix& x );
+// The Cholesky routines are instantiated for T = double and T = float.
+template <typename T>
+bool CholeskyDecomposition( const BasicMatrix<T>& A, BasicMatrix<T>& L );
+template <typename T>
+void CholeskySolve( const BasicMatrix<T>& L, const BasicMatrix<T>& b, BasicMatrix<T>& x );
+
+// In-place versions on raw row-major storage with leading dimension "ld".
+template <typename T>
+bool CholeskyDecomposition( int n, T* A, int ld );
+template <typename T>
+void CholeskySolve( int n, const T* L, int ld, T* x );
 void CholeskyInverse( const Matrix& L, Matrix& Ainv );
 
 bool RSPDInv( const Matrix& A, Matrix& Ainv );
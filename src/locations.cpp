@@ -0,0 +1,118 @@
+//=============================================================================
+// locations.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <cassert>
+#include <math.h>
+
+#include "fast_exp-inl.h"
+#include "locations.h"
+
+//=============================================================================
+// Locations
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+Locations::Locations()
+:  m_Points( std::make_shared<Points>() ),
+   m_scale( 0.0 ),
+   m_factor( 0.0 ),
+   m_sill( 0.0 )
+{
+}
+
+//-----------------------------------------------------------------------------
+void Locations::Build(
+   const std::vector<double>& x,
+   const std::vector<double>& y,
+   double nugget,
+   double sill,
+   double range )
+{
+   assert( x.size() == y.size() );
+
+   // The points of any copies are left as they were.
+   std::shared_ptr<Points> points = std::make_shared<Points>();
+   points->x = x;
+   points->y = y;
+   points->index.Build( points->x, points->y );
+   m_Points = points;
+
+   SetModel( nugget, sill, range );
+}
+
+//-----------------------------------------------------------------------------
+void Locations::SetModel( double nugget, double sill, double range )
+{
+   m_scale  = sill - nugget;
+   m_factor = -3.0 / range;
+   m_sill   = sill;
+}
+
+//-----------------------------------------------------------------------------
+double Locations::Distance( int i, int j ) const
+{
+   const std::vector<double>& x = m_Points->x;
+   const std::vector<double>& y = m_Points->y;
+   const double dx = x[i] - x[j];
+   const double dy = y[i] - y[j];
+   return sqrt( dx*dx + dy*dy );
+}
+
+//-----------------------------------------------------------------------------
+double Locations::Covariance( int i, int j ) const
+{
+   return (i == j) ? m_sill : m_scale * FastExp( m_factor*Distance(i, j) );
+}
+
+//-----------------------------------------------------------------------------
+double Locations::Distance( int i, double x, double y ) const
+{
+   const double dx = m_Points->x[i] - x;
+   const double dy = m_Points->y[i] - y;
+   return sqrt( dx*dx + dy*dy );
+}
+
+//-----------------------------------------------------------------------------
+double Locations::Covariance( int i, double x, double y ) const
+{
+   return m_scale * FastExp( m_factor*Distance(i, x, y) );
+}
+
+//-----------------------------------------------------------------------------
+// Covariances
+//
+//    Only the lower triangle is computed; the upper is its mirror image.
+//-----------------------------------------------------------------------------
+void Locations::Covariances( const int* idx, int n, Matrix& C ) const
+{
+   assert( n <= C.nRows() && n <= C.nCols() );
+
+   for (int r = 0; r < n; ++r) {
+      double* Cr = C.Base(r, 0);
+      for (int c = 0; c < r; ++c) {
+         Cr[c] = Covariance( idx[r], idx[c] );
+         C(c, r) = Cr[c];
+      }
+      Cr[r] = m_sill;
+   }
+}
+
+//-----------------------------------------------------------------------------
+const KdTree& Locations::Index() const
+{
+   return m_Points->index;
+}
+
+//-----------------------------------------------------------------------------
+int Locations::nRows() const
+{
+   return m_Points->x.size();
+}
@@ -0,0 +1,81 @@
+//=============================================================================
+// locations.h
+//
+//    The locations of the observations, indexed by a k-d tree, from which the
+//    distances and covariances of any few of them are computed as they are
+//    needed. Nothing of order N^2 is ever formed: this is the representation
+//    for evaluating a small set of target observations against all of the
+//    data.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef LOCATIONS_H
+#define LOCATIONS_H
+
+#include <memory>
+#include <vector>
+
+#include "matrix.h"
+#include "spatial_index.h"
+
+//=============================================================================
+// Locations
+//=============================================================================
+class Locations
+{
+public:
+   Locations();
+
+   // The covariance C(i,j) = (sill - nugget) exp(-3 h / range) at separation
+   // distance h, with C(i,i) = sill. Index the points.
+   void Build(
+      const std::vector<double>& x,
+      const std::vector<double>& y,
+      double nugget,
+      double sill,
+      double range );
+
+   // Replace the covariance parameters, keeping the index. A copy shares
+   // the points and their index with the original, so a copy with another
+   // model costs only the parameters.
+   void SetModel( double nugget, double sill, double range );
+
+   // The separation distance, and the covariance, exactly as the entries of
+   // the full matrices of Assembly::Finalize.
+   double Distance( int i, int j ) const;
+   double Covariance( int i, int j ) const;
+
+   // The same, between point [i] and the location (x,y).
+   double Distance( int i, double x, double y ) const;
+   double Covariance( int i, double x, double y ) const;
+
+   // Fill the leading n x n block of C with the covariances of the points
+   // idx[0], ..., idx[n-1].
+   void Covariances( const int* idx, int n, Matrix& C ) const;
+
+   const KdTree& Index() const;                          // of the points
+   int nRows() const;                                    // the # of points
+
+private:
+   struct Points {
+      KdTree              index;
+      std::vector<double> x, y;
+
+      Points() : index(), x(), y() {
+      }
+   };
+
+   std::shared_ptr<const Points> m_Points;
+   double              m_scale;        // sill - nugget
+   double              m_factor;       // -3 / range
+   double              m_sill;
+};
+
+//=============================================================================
+#endif  // LOCATIONS_H
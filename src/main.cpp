@@ -11,20 +11,74 @@
 // version:
 //    26 June 2017
 //=============================================================================
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
 #include <cstring>
-#include <ctime>
 #include <iostream>
+#include <mutex>
+#include <string>
 
+#include "checkpoint.h"
 #include "engine.h"
 #include "now.h"
 #include "numerical_constants.h"
+#include "perf_counters.h"
+#include "pipeline.h"
+#include "profile.h"
+#include "progress.h"
 #include "read_data.h"
+#include "server.h"
+#include "trace.h"
 #include "version.h"
 #include "write_results.h"
 
 
+namespace{
+   //--------------------------------------------------------------------------
+   // An interrupt stops a time-budgeted run as the deadline does; a second
+   // one terminates it.
+   //--------------------------------------------------------------------------
+   std::atomic<bool> g_cancel( false );
+
+   extern "C" void Interrupt( int )
+   {
+      g_cancel = true;
+      std::signal( SIGINT, SIG_DFL );
+   }
+
+   //--------------------------------------------------------------------------
+   // Parse the whole of "text" as a finite number; atof would take "abc" for
+   // zero.
+   //--------------------------------------------------------------------------
+   bool ParseNumber( const char* text, double& value )
+   {
+      char* end = nullptr;
+      errno = 0;
+      value = strtod( text, &end );
+      return end != text && *end == '\0' && errno == 0 && std::isfinite(value);
+   }
+
+   //--------------------------------------------------------------------------
+   // Parse the whole of "text" as an int; atoi would take "8x" for 8.
+   //--------------------------------------------------------------------------
+   bool ParseCount( const char* text, int& value )
+   {
+      char* end = nullptr;
+      errno = 0;
+      const long count = strtol( text, &end, 10 );
+      value = static_cast<int>( count );
+      return end != text && *end == '\0' && errno == 0 && count >= INT_MIN && count <= INT_MAX;
+   }
+}
+
 //-----------------------------------------------------------------------------
 int main(int argc, char* argv[]) {
+   const double start = WallSeconds();
+
    // Check the command line.
    switch (argc) {
       case 1: {
@@ -40,11 +94,212 @@ int main(int argc, char* argv[]) {
             Usage();
          return 0;
       }
-      case 7: {
+      default: {
+         if (argc < 7) {
+            Usage();
+            return 1;
+         }
+
+         // A server answers on stdout, so everything else goes to stderr.
+         for (int i = 7; i < argc; ++i) {
+            if ( strcmp(argv[i], "--serve") == 0 || strcmp(argv[i], "--serve-socket") == 0 )
+               std::cout.rdbuf( std::cerr.rdbuf() );
+         }
          Banner( std::cout );
          break;
       }
-      default: {
+   }
+
+   // Get the optional arguments, which follow the six required arguments.
+   std::string profilename;
+   std::string tracename;
+   std::string checkpointname;
+   bool resume = false;
+   TargetSelection selection;
+   bool counters = false;
+   double interval = 30.0;
+   Precision precision = PRECISION_DOUBLE;
+   int neighbors = 0;
+   double taper = 0.0;
+   bool tapered = false;
+   double hmatrix = 0.0;
+   bool compressed = false;
+   int vecchia = 0;
+   int nystrom = 0;
+   int audit = -1;
+   double iterative = 0.0;
+   bool iterated = false;
+   double screen = 0.0;
+   bool screened = false;
+   double budget = 0.0;
+   Priority priority = PRIORITY_INDEX;
+   bool prioritized = false;
+   bool serve = false;
+   std::string socketname;
+
+   for (int i = 7; i < argc; ++i) {
+      if ( strcmp(argv[i], "--profile") == 0 && i+1 < argc ) {
+         profilename = argv[++i];
+      }
+      else if ( strcmp(argv[i], "--progress") == 0 && i+1 < argc ) {
+         ++i;
+         if ( !ParseNumber(argv[i], interval) || interval < 0 ) {
+            std::cerr << "ERROR: progress = " << argv[i] << " is not valid;  0 <= seconds." << std::endl;
+            std::cerr << std::endl;
+            Usage();
+            return 1;
+         }
+      }
+      else if ( strcmp(argv[i], "--counters") == 0 ) {
+         counters = true;
+      }
+      else if ( strcmp(argv[i], "--trace") == 0 && i+1 < argc ) {
+         tracename = argv[++i];
+      }
+      else if ( strcmp(argv[i], "--precision") == 0 && i+1 < argc ) {
+         ++i;
+         if ( strcmp(argv[i], "double") == 0 )
+            precision = PRECISION_DOUBLE;
+         else if ( strcmp(argv[i], "mixed") == 0 )
+            precision = PRECISION_MIXED;
+         else {
+            std::cerr << "ERROR: precision = " << argv[i] << " is not valid;  double or mixed." << std::endl;
+            std::cerr << std::endl;
+            Usage();
+            return 1;
+         }
+      }
+      else if ( strcmp(argv[i], "--neighbors") == 0 && i+1 < argc ) {
+         ++i;
+         if ( !ParseCount(argv[i], neighbors) || neighbors < 1 ) {
+            std::cerr << "ERROR: neighbors = " << argv[i] << " is not valid;  0 < neighbors." << std::endl;
+            std::cerr << std::endl;
+            Usage();
+            return 1;
+         }
+      }
+      else if ( strcmp(argv[i], "--taper") == 0 && i+1 < argc ) {
+         ++i;
+         if ( !ParseNumber(argv[i], taper) ) {
+            std::cerr << "ERROR: taper = " << argv[i] << " is not valid;  radius < taper." << std::endl;
+            std::cerr << std::endl;
+            Usage();
+            return 1;
+         }
+         tapered = true;
+      }
+      else if ( strcmp(argv[i], "--hmatrix") == 0 && i+1 < argc ) {
+         ++i;
+         if ( !ParseNumber(argv[i], hmatrix) || !(hmatrix > 0 && hmatrix < 1) ) {
+            std::cerr << "ERROR: hmatrix = " << argv[i] << " is not valid;  0 < tolerance < 1." << std::endl;
+            std::cerr << std::endl;
+            Usage();
+            return 1;
+         }
+         compressed = true;
+      }
+      else if ( strcmp(argv[i], "--vecchia") == 0 && i+1 < argc ) {
+         ++i;
+         if ( !ParseCount(argv[i], vecchia) || vecchia < 1 ) {
+            std::cerr << "ERROR: vecchia = " << argv[i] << " is not valid;  1 <= m." << std::endl;
+            std::cerr << std::endl;
+            Usage();
+            return 1;
+         }
+      }
+      else if ( strcmp(argv[i], "--nystrom") == 0 && i+1 < argc ) {
+         ++i;
+         if ( !ParseCount(argv[i], nystrom) || nystrom < 1 ) {
+            std::cerr << "ERROR: nystrom = " << argv[i] << " is not valid;  1 <= rank." << std::endl;
+            std::cerr << std::endl;
+            Usage();
+            return 1;
+         }
+      }
+      else if ( strcmp(argv[i], "--nystrom-audit") == 0 && i+1 < argc ) {
+         ++i;
+         if ( !ParseCount(argv[i], audit) || audit < 0 ) {
+            std::cerr << "ERROR: nystrom-audit = " << argv[i] << " is not valid;  0 <= count." << std::endl;
+            std::cerr << std::endl;
+            Usage();
+            return 1;
+         }
+      }
+      else if ( strcmp(argv[i], "--iterative") == 0 && i+1 < argc ) {
+         ++i;
+         if ( !ParseNumber(argv[i], iterative) || !(iterative > 0 && iterative < 1) ) {
+            std::cerr << "ERROR: iterative = " << argv[i] << " is not valid;  0 < tolerance < 1." << std::endl;
+            std::cerr << std::endl;
+            Usage();
+            return 1;
+         }
+         iterated = true;
+      }
+      else if ( strcmp(argv[i], "--time-budget") == 0 && i+1 < argc ) {
+         ++i;
+         if ( !ParseNumber(argv[i], budget) || !(budget > 0) ) {
+            std::cerr << "ERROR: time-budget = " << argv[i] << " is not valid;  0 < seconds." << std::endl;
+            std::cerr << std::endl;
+            Usage();
+            return 1;
+         }
+      }
+      else if ( strcmp(argv[i], "--priority") == 0 && i+1 < argc ) {
+         ++i;
+         prioritized = true;
+         if ( strcmp(argv[i], "index") == 0 )
+            priority = PRIORITY_INDEX;
+         else if ( strcmp(argv[i], "cheapest") == 0 )
+            priority = PRIORITY_CHEAPEST;
+         else {
+            std::cerr << "ERROR: priority = " << argv[i] << " is not valid;  index or cheapest." << std::endl;
+            std::cerr << std::endl;
+            Usage();
+            return 1;
+         }
+      }
+      else if ( strcmp(argv[i], "--checkpoint") == 0 && i+1 < argc ) {
+         checkpointname = argv[++i];
+      }
+      else if ( strcmp(argv[i], "--resume") == 0 ) {
+         resume = true;
+      }
+      else if ( strcmp(argv[i], "--targets") == 0 && i+1 < argc ) {
+         selection.idfilename = argv[++i];
+      }
+      else if ( strcmp(argv[i], "--bbox") == 0 && i+4 < argc ) {
+         selection.box = true;
+         bool parsed = ParseNumber( argv[++i], selection.xmin );
+         parsed = ParseNumber( argv[++i], selection.ymin ) && parsed;
+         parsed = ParseNumber( argv[++i], selection.xmax ) && parsed;
+         parsed = ParseNumber( argv[++i], selection.ymax ) && parsed;
+         if ( !parsed || !(selection.xmin <= selection.xmax && selection.ymin <= selection.ymax) ) {
+            std::cerr << "ERROR: bbox is not valid;  four numbers, xmin <= xmax and ymin <= ymax." << std::endl;
+            std::cerr << std::endl;
+            Usage();
+            return 1;
+         }
+      }
+      else if ( strcmp(argv[i], "--serve") == 0 ) {
+         serve = true;
+      }
+      else if ( strcmp(argv[i], "--serve-socket") == 0 && i+1 < argc ) {
+         serve = true;
+         socketname = argv[++i];
+      }
+      else if ( strcmp(argv[i], "--screen") == 0 && i+1 < argc ) {
+         ++i;
+         if ( !ParseNumber(argv[i], screen) || !(screen > 0 && screen < 1) ) {
+            std::cerr << "ERROR: screen = " << argv[i] << " is not valid;  0 < p < 1." << std::endl;
+            std::cerr << std::endl;
+            Usage();
+            return 1;
+         }
+         screened = true;
+      }
+      else {
+         std::cerr << "ERROR: option " << argv[i] << " is not valid." << std::endl;
+         std::cerr << std::endl;
          Usage();
          return 1;
       }
@@ -86,12 +341,165 @@ int main(int argc, char* argv[]) {
       return 2;
    }
 
-   // Read in the observation data from the specified input data file.
-   std::vector<DataRecord> obs;
+   // Check the taper distance, which must exceed the buffer radius so that
+   // every excluded observation is within it.
+   if ( tapered ) {
+      if ( !(taper > radius) ) {
+         std::cerr << "ERROR: taper = " << taper << " is not valid;  radius < taper." << std::endl;
+         std::cerr << std::endl;
+         Usage();
+         return 2;
+      }
+      if ( neighbors > 0 || precision != PRECISION_DOUBLE ) {
+         std::cerr << "ERROR: --taper cannot be combined with --neighbors or --precision mixed." << std::endl;
+         std::cerr << std::endl;
+         Usage();
+         return 2;
+      }
+   }
+
+   // The H-matrix is a separate representation of the whole of C.
+   if ( compressed && (tapered || neighbors > 0 || precision != PRECISION_DOUBLE) ) {
+      std::cerr << "ERROR: --hmatrix cannot be combined with --taper, --neighbors, or --precision mixed." << std::endl;
+      std::cerr << std::endl;
+      Usage();
+      return 2;
+   }
+
+   // So is the Vecchia approximation of its inverse.
+   if ( vecchia > 0 && (compressed || tapered || neighbors > 0 || precision != PRECISION_DOUBLE) ) {
+      std::cerr << "ERROR: --vecchia cannot be combined with --hmatrix, --taper, --neighbors, or --precision mixed." << std::endl;
+      std::cerr << std::endl;
+      Usage();
+      return 2;
+   }
+
+   // So is the Nystrom approximation.
+   if ( nystrom > 0 && (vecchia > 0 || compressed || tapered || neighbors > 0 || precision != PRECISION_DOUBLE) ) {
+      std::cerr << "ERROR: --nystrom cannot be combined with --vecchia, --hmatrix, --taper, --neighbors, or --precision mixed." << std::endl;
+      std::cerr << std::endl;
+      Usage();
+      return 2;
+   }
+
+   // And so is the matrix-free operator.
+   if ( iterated && (nystrom > 0 || vecchia > 0 || compressed || tapered || neighbors > 0 || precision != PRECISION_DOUBLE) ) {
+      std::cerr << "ERROR: --iterative cannot be combined with --nystrom, --vecchia, --hmatrix, --taper, --neighbors, or --precision mixed." << std::endl;
+      std::cerr << std::endl;
+      Usage();
+      return 2;
+   }
+
+   // Screening confirms its candidates with the dense engine.
+   if ( screened && (iterated || nystrom > 0 || vecchia > 0 || compressed || tapered) ) {
+      std::cerr << "ERROR: --screen cannot be combined with --iterative, --nystrom, --vecchia, --hmatrix, or --taper." << std::endl;
+      std::cerr << std::endl;
+      Usage();
+      return 2;
+   }
+
+   // The targets are selected one way or the other.
+   if ( selection.box && !selection.idfilename.empty() ) {
+      std::cerr << "ERROR: --targets cannot be combined with --bbox." << std::endl;
+      std::cerr << std::endl;
+      Usage();
+      return 2;
+   }
+
+   // A run resumes from its checkpoint.
+   if ( resume && checkpointname.empty() ) {
+      std::cerr << "ERROR: --resume requires --checkpoint." << std::endl;
+      std::cerr << std::endl;
+      Usage();
+      return 2;
+   }
+
+   // A server evaluates each request with the local engine.
+   if ( serve && (screened || iterated || nystrom > 0 || vecchia > 0 || compressed || tapered
+                  || budget > 0 || !checkpointname.empty() || selection.box || !selection.idfilename.empty()) ) {
+      std::cerr << "ERROR: --serve cannot be combined with --screen, --iterative, --nystrom, --vecchia, --hmatrix, --taper," << std::endl;
+      std::cerr << "       --time-budget, --checkpoint, --targets, or --bbox." << std::endl;
+      std::cerr << std::endl;
+      Usage();
+      return 2;
+   }
+
+   // Read in the observation data, execute all of the computations, and
+   // write out the results, with the writing overlapped with the
+   // computations.
+   const int nthreads = DefaultThreadCount();
+
+   EngineOptions options;
+   options.nthreads = nthreads;
+
+   std::mutex console;
+   if (interval > 0) {
+      options.progress_interval = interval;
+      options.progress = [&console](const ProgressReport& report) {
+         std::lock_guard<std::mutex> lock(console);
+         std::cout << FormatProgress(report) << std::endl;
+      };
+   }
+
+   options.precision = precision;
+   options.neighbors = neighbors;
+   options.taper = taper;
+   options.hmatrix = hmatrix;
+   options.vecchia = vecchia;
+   options.nystrom = nystrom;
+   if (audit >= 0) options.nystrom_audit = audit;
+   options.iterative = iterative;
+   options.screen = screen;
+
+   // A time-budgeted run takes the cheapest observations first, unless told
+   // otherwise, and counts its budget from the start of the program.
+   if (budget > 0) {
+      options.deadline = start + budget;
+      options.cancel = &g_cancel;
+      std::signal( SIGINT, Interrupt );
+      if (!prioritized) priority = PRIORITY_CHEAPEST;
+   }
+   options.priority = priority;
+   options.precision_report = [&console](const PrecisionReport& report) {
+      std::lock_guard<std::mutex> lock(console);
+      std::cout << FormatPrecision(report) << std::endl;
+   };
+   options.hmatrix_report = [&console](const HMatrixReport& report) {
+      std::lock_guard<std::mutex> lock(console);
+      std::cout << FormatHMatrix(report) << std::endl;
+   };
+   options.nystrom_report = [&console](const NystromReport& report) {
+      std::lock_guard<std::mutex> lock(console);
+      std::cout << FormatNystrom(report) << std::endl;
+   };
+   options.iterative_report = [&console](const IterativeReport& report) {
+      std::lock_guard<std::mutex> lock(console);
+      std::cout << FormatIterative(report) << std::endl;
+   };
+   EnableProfiling( !profilename.empty() );
+
+   if ( counters ) {
+      std::string reason;
+      if ( profilename.empty() )
+         std::cout << "NOTICE: --counters is reported through --profile; ignored." << std::endl;
+      else if ( !EnableCounters(reason) )
+         std::cout << "NOTICE: hardware counters unavailable; " << reason << ". Continuing without them." << std::endl;
+   }
+   EnableTracing( !tracename.empty() );
+   SetTraceThreadName( "main" );
 
    try {
-      obs = read_data( argv[5] );
-      std::cout << obs.size() << " data records read from <" << argv[5] << ">." << std::endl;
+      if ( serve ) {
+         // Index the observations once, then answer requests until the input
+         // is closed. The output file is not written.
+         Server server( nugget, sill, range, radius, read_data(argv[5]), options );
+         std::cout << "serving " << server.Size() << " observations." << std::endl;
+         Serve( server, socketname, nthreads );
+      }
+      else {
+         Pipeline( nugget, sill, range, radius, argv[5], argv[6], checkpointname, resume, selection, options );
+         std::cout << "Output file <" << argv[6] << "> created. " << std::endl;
+      }
    }
    catch (InvalidInputFile& e) {
       std::cerr << e.what() << std::endl;
@@ -101,11 +509,21 @@ int main(int argc, char* argv[]) {
       std::cerr << e.what() << std::endl;
       return 3;
    }
-
-   // Execute all of the computations.
-   std::vector<Boomerang> results;
-   try {
-       results = Engine(nugget, sill, range, radius, obs);
+   catch (InvalidOutputFile& e) {
+      std::cerr << e.what() << std::endl;
+      return 4;
+   }
+   catch (InvalidCheckpointFile& e) {
+      std::cerr << e.what() << std::endl;
+      return 4;
+   }
+   catch (InvalidSocket& e) {
+      std::cerr << e.what() << std::endl;
+      return 4;
+   }
+   catch (FailedFactorization& e) {
+      std::cerr << e.what() << std::endl;
+      return 5;
    }
    catch (...) {
       std::cerr << "The Webinan Engine failed for an unknown reason." << std::endl;
@@ -119,19 +537,33 @@ int main(int argc, char* argv[]) {
 // --  Check that the variance of residuals is close to 1.
 
 
-   // Write out the results to the specified output data file.
-   try {
-      write_results( argv[6], obs, results );
-      std::cout << "Output file <" << argv[6] << "> created. " << std::endl;
+   // Write out the profile report, if requested.
+   if ( !profilename.empty() ) {
+      try {
+         WriteProfile( profilename, nthreads );
+         std::cout << "Profile report <" << profilename << "> created. " << std::endl;
+      }
+      catch (InvalidProfileFile& e) {
+         std::cerr << e.what() << std::endl;
+         return 4;
+      }
    }
-   catch (InvalidOutputFile& e) {
-      std::cerr << e.what() << std::endl;
-      return 4;
+
+   // Write out the trace events, if requested.
+   if ( !tracename.empty() ) {
+      try {
+         WriteTrace( tracename );
+         std::cout << "Trace file <" << tracename << "> created. " << std::endl;
+      }
+      catch (InvalidTraceFile& e) {
+         std::cerr << e.what() << std::endl;
+         return 4;
+      }
    }
 
    // Successful termination.
-   double elapsed = static_cast<double>(clock())/CLOCKS_PER_SEC;
-   std::cout << "elapsed time: " << std::fixed << elapsed << " seconds." << std::endl;
+   std::cout << "elapsed time: " << std::fixed << WallSeconds() - start << " seconds." << std::endl;
+   std::cout << "cpu time:     " << std::fixed << ProcessCpuSeconds() << " seconds." << std::endl;
    std::cout << std::endl;
 
    // Terminate execution.
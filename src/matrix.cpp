@@ -1,9 +1,9 @@
 //=============================================================================
 // matrix.cpp
 //
-//    A minimal matrix class with some basic operations and arithmetic.  This
-//    matrix class is explicitly based on <double>. This matrix class is NOT
-//    a template.
+//    A minimal matrix class with some basic operations and arithmetic.  The
+//    class is a template on the scalar type, explicitly instantiated here for
+//    <double> and <float>; the arithmetic is explicitly based on <double>.
 //
 // author:
 //    Dr. Randal J. Barnes
@@ -21,53 +21,101 @@
 #include <iostream>
 #include <numeric>
 #include <sstream>
+#include <utility>
 #include <vector>
 
 #include "matrix.h"
+#include "profile.h"
 #include "sum_product-inl.h"
 
 //=============================================================================
-// Matrix
+// BasicMatrix
 //=============================================================================
 
 //-----------------------------------------------------------------------------
 // Null constructor.
 //-----------------------------------------------------------------------------
-Matrix::Matrix()
+template <typename T>
+BasicMatrix<T>::BasicMatrix()
 :  m_nRows( 0 ),
    m_nCols( 0 ),
-   m_Data( nullptr ) 
+   m_Capacity( 0 ),
+   m_Data( nullptr ),
+   m_Resource( DefaultResource() )
 {
 }
 
+//-----------------------------------------------------------------------------
+// Null constructor, with the storage drawn from the given resource.
+//-----------------------------------------------------------------------------
+template <typename T>
+BasicMatrix<T>::BasicMatrix( MemoryResource* resource )
+:  m_nRows( 0 ),
+   m_nCols( 0 ),
+   m_Capacity( 0 ),
+   m_Data( nullptr ),
+   m_Resource( resource )
+{
+   assert( resource != nullptr );
+}
+
 //-----------------------------------------------------------------------------
 // Copy constructor.
+//
+//    The copy draws its storage from the default resource.
 //-----------------------------------------------------------------------------
-Matrix::Matrix( const Matrix& A )
+template <typename T>
+BasicMatrix<T>::BasicMatrix( const BasicMatrix& A )
 :  m_nRows( 0 ),
    m_nCols( 0 ),
-   m_Data( nullptr )
+   m_Capacity( 0 ),
+   m_Data( nullptr ),
+   m_Resource( DefaultResource() )
 {
    if ( A.nRows() > 0 && A.nCols() > 0 ) {
-      m_nRows = A.nRows();
-      m_nCols = A.nCols();
-      m_Data  = new double[ m_nRows*m_nCols ];
-      memcpy( m_Data, A.Base(), sizeof(double)*m_nRows*m_nCols );
+      m_nRows    = A.nRows();
+      m_nCols    = A.nCols();
+      m_Capacity = Elements();
+      m_Data     = Allocate( m_Capacity );
+      memcpy( m_Data, A.Base(), sizeof(T)*Elements() );
    }
 }
 
+//-----------------------------------------------------------------------------
+// Move constructor.
+//
+//    The storage is taken from A, which is left as a null Matrix.
+//-----------------------------------------------------------------------------
+template <typename T>
+BasicMatrix<T>::BasicMatrix( BasicMatrix&& A ) noexcept
+:  m_nRows( A.m_nRows ),
+   m_nCols( A.m_nCols ),
+   m_Capacity( A.m_Capacity ),
+   m_Data( A.m_Data ),
+   m_Resource( A.m_Resource )
+{
+   A.m_nRows    = 0;
+   A.m_nCols    = 0;
+   A.m_Capacity = 0;
+   A.m_Data     = nullptr;
+}
+
 //-----------------------------------------------------------------------------
 // constructor from an std:vector
 //-----------------------------------------------------------------------------
-Matrix::Matrix( const std::vector<double>v )
+template <typename T>
+BasicMatrix<T>::BasicMatrix( const std::vector<T>v )
 :  m_nRows( 0 ),
    m_nCols( 0 ),
-   m_Data( nullptr )
+   m_Capacity( 0 ),
+   m_Data( nullptr ),
+   m_Resource( DefaultResource() )
 {
    if ( v.size() > 0 ) {
-      m_nRows = v.size();
-      m_nCols = 1;
-      m_Data  = new double[ m_nRows ];
+      m_nRows    = v.size();
+      m_nCols    = 1;
+      m_Capacity = m_nRows;
+      m_Data     = Allocate( m_Capacity );
 
       for (int k = 0; k < m_nRows; ++k)
          m_Data[k] = v[k];
@@ -77,52 +125,62 @@ Matrix::Matrix( const std::vector<double>v )
 //-----------------------------------------------------------------------------
 // Dimensioned constructor, with zero fill.
 //-----------------------------------------------------------------------------
-Matrix::Matrix( int nrows, int ncols )
+template <typename T>
+BasicMatrix<T>::BasicMatrix( int nrows, int ncols )
 :  m_nRows( 0 ),
    m_nCols( 0 ),
-   m_Data( nullptr )
+   m_Capacity( 0 ),
+   m_Data( nullptr ),
+   m_Resource( DefaultResource() )
 {
    assert( nrows >= 0 && ncols >= 0 );
 
-   m_nRows = nrows;
-   m_nCols = ncols;
-   m_Data  = new double[ m_nRows*m_nCols ];
-   memset( m_Data, 0, sizeof(double)*m_nRows*m_nCols );
+   Resize( nrows, ncols );
 }
 
 //-----------------------------------------------------------------------------
-// Constructor with scalar fill.
+// Dimensioned constructor, without fill.
 //-----------------------------------------------------------------------------
-Matrix::Matrix( int nrows, int ncols, double a )
+template <typename T>
+BasicMatrix<T>::BasicMatrix( int nrows, int ncols, Uninitialized tag )
 :  m_nRows( 0 ),
    m_nCols( 0 ),
-   m_Data( nullptr )
+   m_Capacity( 0 ),
+   m_Data( nullptr ),
+   m_Resource( DefaultResource() )
 {
-   assert( nrows >= 0 && ncols >= 0 );
-
-   m_nRows = nrows;
-   m_nCols = ncols;
-   m_Data  = new double[ m_nRows*m_nCols ];
+   Resize( nrows, ncols, tag );
+}
 
-   for (int i = 0; i < nrows; ++i)
-      for (int j = 0; j < ncols; ++j)
-         m_Data[i*ncols + j] = a;
+//-----------------------------------------------------------------------------
+// Constructor with scalar fill.
+//-----------------------------------------------------------------------------
+template <typename T>
+BasicMatrix<T>::BasicMatrix( int nrows, int ncols, T a )
+:  m_nRows( 0 ),
+   m_nCols( 0 ),
+   m_Capacity( 0 ),
+   m_Data( nullptr ),
+   m_Resource( DefaultResource() )
+{
+   Resize( nrows, ncols, UNINITIALIZED );
+   std::fill( begin(), end(), a );
 }
 
 //-----------------------------------------------------------------------------
 // Constructor with array fill.
 //-----------------------------------------------------------------------------
-Matrix::Matrix( int nrows, int ncols, const double* data )
+template <typename T>
+BasicMatrix<T>::BasicMatrix( int nrows, int ncols, const T* data )
 :  m_nRows( 0 ),
    m_nCols( 0 ),
-   m_Data( nullptr )
+   m_Capacity( 0 ),
+   m_Data( nullptr ),
+   m_Resource( DefaultResource() )
 {
-   assert( nrows >= 0 && ncols >= 0 );
-
-   m_nRows = nrows;
-   m_nCols = ncols;
-   m_Data  = new double[ m_nRows*m_nCols ];
-   memcpy( m_Data, data, sizeof(double)*m_nRows*m_nCols );
+   Resize( nrows, ncols, UNINITIALIZED );
+   if ( Elements() > 0 )
+      memcpy( m_Data, data, sizeof(T)*Elements() );
 }
 
 //-----------------------------------------------------------------------------
@@ -143,10 +201,13 @@ Matrix::Matrix( int nrows, int ncols, const double* data )
 //
 //    Any token that cannot be interpreted as a valid double is set to zero.
 //-----------------------------------------------------------------------------
-Matrix::Matrix( const std::string& str )
+template <typename T>
+BasicMatrix<T>::BasicMatrix( const std::string& str )
 :  m_nRows( 0 ),
    m_nCols( 0 ),
-   m_Data( nullptr )
+   m_Capacity( 0 ),
+   m_Data( nullptr ),
+   m_Resource( DefaultResource() )
 {
    assert( str.find_first_not_of("-0123456789eE.,; \t") == std::string::npos );
 
@@ -182,15 +243,12 @@ Matrix::Matrix( const std::string& str )
    }
 
    // Construct the Matrix from the parsed values.
-   m_nRows = rows.size();
-
-   m_nCols = 0;
+   int ncols = 0;
    for (std::vector< std::vector< double > >::const_iterator i = rows.begin(); i != rows.end(); ++i) {
-      if ( static_cast<int>(i->size()) > m_nCols) m_nCols = i->size();
+      if ( static_cast<int>(i->size()) > ncols) ncols = i->size();
    }
 
-   m_Data  = new double[ m_nRows*m_nCols ];
-   memset( m_Data, 0, sizeof(double)*m_nRows*m_nCols );
+   Resize( rows.size(), ncols );
 
    for (std::vector<std::vector<double>>::const_iterator i = rows.begin(); i != rows.end(); ++i)
       for (std::vector<double>::const_iterator j = i->begin(); j != i->end(); ++j) {
@@ -199,16 +257,48 @@ Matrix::Matrix( const std::string& str )
       }
 }
 
+//-----------------------------------------------------------------------------
+// All of the Matrix storage is allocated here, so that it can be counted.
+//-----------------------------------------------------------------------------
+template <typename T>
+T* BasicMatrix<T>::Allocate( std::size_t n )
+{
+   CountMatrixAllocation( sizeof(T)*n );
+   return static_cast<T*>( m_Resource->Allocate( sizeof(T)*n ) );
+}
+
+//-----------------------------------------------------------------------------
+// Return the storage to the resource.
+//-----------------------------------------------------------------------------
+template <typename T>
+void BasicMatrix<T>::Release()
+{
+   if ( m_Data != nullptr )
+      m_Resource->Deallocate( m_Data, sizeof(T)*m_Capacity );
+
+   m_Data     = nullptr;
+   m_Capacity = 0;
+}
+
+//-----------------------------------------------------------------------------
+// Number of elements in use: nRows*nCols.
+//-----------------------------------------------------------------------------
+template <typename T>
+std::size_t BasicMatrix<T>::Elements() const
+{
+   return static_cast<std::size_t>(m_nRows) * m_nCols;
+}
+
 //-----------------------------------------------------------------------------
 // Destructor.
 //-----------------------------------------------------------------------------
-Matrix::~Matrix()
+template <typename T>
+BasicMatrix<T>::~BasicMatrix()
 {
-   delete [] m_Data;
+   Release();
 
    m_nRows = 0;
    m_nCols = 0;
-   m_Data  = nullptr;
 }
 
 //-----------------------------------------------------------------------------
@@ -216,55 +306,102 @@ Matrix::~Matrix()
 //
 //    The resized Matrix is filled with zeros.
 //-----------------------------------------------------------------------------
-void Matrix::Resize( int nrows, int ncols )
+template <typename T>
+void BasicMatrix<T>::Resize( int nrows, int ncols )
+{
+   Resize( nrows, ncols, UNINITIALIZED );
+
+   if ( Elements() > 0 )
+      memset( m_Data, 0, sizeof(T)*Elements() );
+}
+
+//-----------------------------------------------------------------------------
+// Destructive resize, without fill.
+//
+//    The storage is reused whenever it is large enough, so a Matrix that is
+//    resized repeatedly allocates only when it grows beyond its capacity.
+//    The capacity is released only by the destructor or a move.
+//-----------------------------------------------------------------------------
+template <typename T>
+void BasicMatrix<T>::Resize( int nrows, int ncols, Uninitialized )
 {
    // Check the arguments.
    assert( nrows >= 0 && ncols >= 0 );
 
-   // Reallocate memory if necessary.
-   if (m_nRows != nrows || m_nCols != ncols) {
-      delete [] m_Data;
+   if ( nrows == 0 || ncols == 0 ) {
+      m_nRows = 0;
+      m_nCols = 0;
+      return;
+   }
 
-      if ( nrows > 0 && ncols > 0 ) {
-         m_nRows = nrows;
-         m_nCols = ncols;
-         m_Data  = new double[ m_nRows*m_nCols ];
-      }
-      else {
-         m_nRows = 0;
-         m_nCols = 0;
-         m_Data  = nullptr;
-      }
+   const std::size_t n = static_cast<std::size_t>(nrows) * ncols;
+
+   // Reallocate memory only if necessary.
+   if ( n > m_Capacity ) {
+      Release();
+
+      m_Data     = Allocate( n );
+      m_Capacity = n;
    }
 
-   memset( m_Data, 0, sizeof(double)*m_nRows*m_nCols );
+   m_nRows = nrows;
+   m_nCols = ncols;
 }
 
 //-----------------------------------------------------------------------------
 // Assignment operator.
+//
+//    The existing storage is reused whenever it is large enough.
 //-----------------------------------------------------------------------------
-Matrix& Matrix::operator=( const Matrix& A )
+template <typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator=( const BasicMatrix& A )
 {
    // Check for self-assignment.
    if ( this == &A ) return *this;
 
    // Commensurate memory allocation.
-   Resize( A.nRows(), A.nCols() );
+   Resize( A.nRows(), A.nCols(), UNINITIALIZED );
 
    // Copy the data.
-   if ( m_nRows*m_nCols > 0 )
-      memcpy( m_Data, A.Base(), sizeof(double)*m_nRows*m_nCols );
+   if ( Elements() > 0 )
+      memcpy( m_Data, A.Base(), sizeof(T)*Elements() );
 
    return *this;
 }
 
+//-----------------------------------------------------------------------------
+// Move assignment operator.
+//
+//    The storage is taken from A, together with its resource, and A is left
+//    as a null Matrix on its own resource. Nothing is allocated or copied.
+//-----------------------------------------------------------------------------
+template <typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator=( BasicMatrix&& A ) noexcept
+{
+   if ( this != &A ) {
+      Release();
+
+      m_nRows    = A.m_nRows;
+      m_nCols    = A.m_nCols;
+      m_Capacity = A.m_Capacity;
+      m_Data     = A.m_Data;
+      m_Resource = A.m_Resource;
+
+      A.m_nRows    = 0;
+      A.m_nCols    = 0;
+      A.m_Capacity = 0;
+      A.m_Data     = nullptr;
+   }
+   return *this;
+}
+
 //-----------------------------------------------------------------------------
 // Scalar assignment operator.
 //-----------------------------------------------------------------------------
-Matrix& Matrix::operator=( double a )
+template <typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator=( T a )
 {
-   for (int k = 0; k < m_nRows*m_nCols; ++k)
-      m_Data[k] = a;
+   std::fill( begin(), end(), a );
 
    return *this;
 }
@@ -272,29 +409,32 @@ Matrix& Matrix::operator=( double a )
 //-----------------------------------------------------------------------------
 // Non-constant element access operator (put).
 //-----------------------------------------------------------------------------
-double& Matrix::operator()( int row, int col )
+template <typename T>
+T& BasicMatrix<T>::operator()( int row, int col )
 {
    assert( row >= 0 && row < m_nRows );
    assert( col >= 0 && col < m_nCols );
 
-   return m_Data[ row*m_nCols + col ];
+   return m_Data[ static_cast<std::size_t>(row)*m_nCols + col ];
 }
 
 //-----------------------------------------------------------------------------
 // Constant element access operator (get).
 //-----------------------------------------------------------------------------
-double Matrix::operator()( int row, int col ) const
+template <typename T>
+T BasicMatrix<T>::operator()( int row, int col ) const
 {
    assert( row >= 0 && row < m_nRows );
    assert( col >= 0 && col < m_nCols );
 
-   return m_Data[ row*m_nCols + col ];
+   return m_Data[ static_cast<std::size_t>(row)*m_nCols + col ];
 }
 
 //-----------------------------------------------------------------------------
 // Number of rows.
 //-----------------------------------------------------------------------------
-int Matrix::nRows() const
+template <typename T>
+int BasicMatrix<T>::nRows() const
 {
    return m_nRows;
 }
@@ -302,15 +442,35 @@ int Matrix::nRows() const
 //-----------------------------------------------------------------------------
 // Number of columns.
 //-----------------------------------------------------------------------------
-int Matrix::nCols() const
+template <typename T>
+int BasicMatrix<T>::nCols() const
 {
    return m_nCols;
 }
 
+//-----------------------------------------------------------------------------
+// Return the allocated number of elements, which may exceed nRows*nCols.
+//-----------------------------------------------------------------------------
+template <typename T>
+std::size_t BasicMatrix<T>::Capacity() const
+{
+   return m_Capacity;
+}
+
+//-----------------------------------------------------------------------------
+// Return the resource from which the storage is drawn.
+//-----------------------------------------------------------------------------
+template <typename T>
+MemoryResource* BasicMatrix<T>::Resource() const
+{
+   return m_Resource;
+}
+
 //-----------------------------------------------------------------------------
 // Read only access to raw storage.
 //-----------------------------------------------------------------------------
-const double* Matrix::Base() const
+template <typename T>
+const T* BasicMatrix<T>::Base() const
 {
    return m_Data;
 }
@@ -318,18 +478,20 @@ const double* Matrix::Base() const
 //-----------------------------------------------------------------------------
 // Read only access to raw storage with an offset.
 //-----------------------------------------------------------------------------
-const double* Matrix::Base( int row, int col ) const
+template <typename T>
+const T* BasicMatrix<T>::Base( int row, int col ) const
 {
    assert( row >= 0 && row < m_nRows );
    assert( col >= 0 && col < m_nCols );
 
-   return m_Data + row*m_nCols + col;
+   return m_Data + static_cast<std::size_t>(row)*m_nCols + col;
 }
 
 //-----------------------------------------------------------------------------
 // Read/Write access to raw storage.
 //-----------------------------------------------------------------------------
-double* Matrix::Base()
+template <typename T>
+T* BasicMatrix<T>::Base()
 {
    return m_Data;
 }
@@ -337,40 +499,51 @@ double* Matrix::Base()
 //-----------------------------------------------------------------------------
 // Read/Write access to raw storage with an offset.
 //-----------------------------------------------------------------------------
-double* Matrix::Base( int row, int col )
+template <typename T>
+T* BasicMatrix<T>::Base( int row, int col )
 {
    assert( row >= 0 && row < m_nRows );
    assert( col >= 0 && col < m_nCols );
 
-   return m_Data + row*m_nCols + col;
+   return m_Data + static_cast<std::size_t>(row)*m_nCols + col;
 }
 
 //-----------------------------------------------------------------------------
 // Read only STL-conforming begin() iterators.
 //-----------------------------------------------------------------------------
-const double* Matrix::begin() const
+template <typename T>
+const T* BasicMatrix<T>::begin() const
 {
    return m_Data;
 }
 
-const double* Matrix::end() const
+template <typename T>
+const T* BasicMatrix<T>::end() const
 {
-   return m_Data + m_nRows*m_nCols;
+   return m_Data + Elements();
 }
 
 //-----------------------------------------------------------------------------
 // Read/write STL-conforming end() iterator.
 //-----------------------------------------------------------------------------
-double* Matrix::begin()
+template <typename T>
+T* BasicMatrix<T>::begin()
 {
    return m_Data;
 }
 
-double* Matrix::end()
+template <typename T>
+T* BasicMatrix<T>::end()
 {
-   return m_Data + m_nRows*m_nCols;
+   return m_Data + Elements();
 }
 
+//-----------------------------------------------------------------------------
+// Explicit instantiations.
+//-----------------------------------------------------------------------------
+template class BasicMatrix<double>;
+template class BasicMatrix<float>;
+
 
 //=============================================================================
 // I/O routines.
@@ -575,14 +748,14 @@ void Transpose( const Matrix& A, Matrix& C )
    assert( A.nCols() > 0 && A.nRows() > 0 );
 
    // Commensurate memory allocation.
-   Matrix At( A.nCols(), A.nRows() );
+   Matrix At( A.nCols(), A.nRows(), Matrix::UNINITIALIZED );
 
    // Set the transpose.
    for (int i = 0; i < A.nRows(); ++i)
       for (int j = 0; j < A.nCols(); ++j)
          At(j,i) = A(i,j);
 
-   C = At;
+   C = std::move( At );
 }
 
 //-----------------------------------------------------------------------------
@@ -593,7 +766,7 @@ void Negative( const Matrix& A, Matrix& C )
    // Check the arguments.
    assert( A.nCols() > 0 && A.nRows() > 0 );
 
-   C.Resize( A.nRows(), A.nCols() );
+   C.Resize( A.nRows(), A.nCols(), Matrix::UNINITIALIZED );
    std::transform( A.begin(), A.end(), C.begin(), [](double a){return -(a);});
 }
 
@@ -620,7 +793,7 @@ void Slice( const Matrix& A, const std::vector<int>& row_flag, const std::vector
 
    int nRows = std::count_if( row_flag.begin(), row_flag.end(), [](int i){return i != 0;} );
    int nCols = std::count_if( col_flag.begin(), col_flag.end(), [](int i){return i != 0;} );
-   C.Resize( nRows, nCols );
+   C.Resize( nRows, nCols, Matrix::UNINITIALIZED );
 
    if( nRows*nCols > 0 ) {
       int row = 0;
@@ -649,7 +822,7 @@ void SliceRows( const Matrix& A, const std::vector<int>& row_flag, Matrix& C ) {
       return i != 0;
    } );
    int nCols = A.nCols();
-   C.Resize( nRows, nCols );
+   C.Resize( nRows, nCols, Matrix::UNINITIALIZED );
 
    if( nRows*nCols > 0 ) {
       int row = 0;
@@ -742,7 +915,7 @@ void Add_MM( const Matrix& A, const Matrix& B, Matrix& C )
    assert( A.nRows() == B.nRows() && A.nCols() == B.nCols() );
 
    // Commensurate memory allocation.
-   C.Resize( A.nRows(), A.nCols() );
+   C.Resize( A.nRows(), A.nCols(), Matrix::UNINITIALIZED );
 
    // Compute the Matrix addition:  C = A + B
    const double* p = A.Base();
@@ -765,7 +938,7 @@ void Subtract_MM( const Matrix& A, const Matrix& B, Matrix& C )
    assert( A.nRows() == B.nRows() && A.nCols() == B.nCols() );
 
    // Commensurate memory allocation.
-   C.Resize( A.nRows(), A.nCols() );
+   C.Resize( A.nRows(), A.nCols(), Matrix::UNINITIALIZED );
 
    // Compute the Matrix subtraction:  C = A - B
    const double* p = A.Base();
@@ -793,14 +966,14 @@ void Multiply_MM( const Matrix& A, const Matrix& B, Matrix& C )
    assert( A.nCols() == B.nRows() );
 
    // Commensurate memory allocation.
-   Matrix AB( A.nRows(), B.nCols() );
+   Matrix AB( A.nRows(), B.nCols(), Matrix::UNINITIALIZED );
 
    // Compute the Matrix product.
    for (int i = 0; i < A.nRows(); ++i)
       for (int j = 0; j < B.nCols(); ++j)
          AB(i,j) = SumProduct( A.nCols(), A.Base(i,0), B.Base(0,j), B.nCols() );
 
-   C = AB;
+   C = std::move( AB );
 }
 
 //-----------------------------------------------------------------------------
@@ -814,14 +987,14 @@ void Multiply_MtM( const Matrix& A, const Matrix& B, Matrix& C )
    assert( A.nRows() == B.nRows() );
 
    // Commensurate memory allocation.
-   Matrix AtB( A.nCols(), B.nCols() );
+   Matrix AtB( A.nCols(), B.nCols(), Matrix::UNINITIALIZED );
 
    // Compute the Matrix product.
    for (int i = 0; i < A.nCols(); ++i)
       for (int j = 0; j < B.nCols(); ++j)
          AtB(i,j) = SumProduct( A.nRows(), A.Base(0,i), A.nCols(), B.Base(0,j), B.nCols() );
 
-   C = AtB;
+   C = std::move( AtB );
 }
 
 //-----------------------------------------------------------------------------
@@ -835,14 +1008,14 @@ void Multiply_MMt( const Matrix& A, const Matrix& B, Matrix& C )
    assert( A.nCols() == B.nCols() );
 
    // Commensurate memory allocation.
-   Matrix ABt( A.nRows(), B.nRows() );
+   Matrix ABt( A.nRows(), B.nRows(), Matrix::UNINITIALIZED );
 
    // Compute the Matrix product.
    for (int i = 0; i < A.nRows(); ++i)
       for (int j = 0; j < B.nRows(); ++j)
          ABt(i,j) = SumProduct( A.nCols(), A.Base(i,0), B.Base(j,0) );
 
-   C = ABt;
+   C = std::move( ABt );
 }
 
 //-----------------------------------------------------------------------------
@@ -856,14 +1029,14 @@ void Multiply_MtMt( const Matrix& A, const Matrix& B, Matrix& C )
    assert( A.nRows() == B.nCols() );
 
    // Commensurate memory allocation.
-   Matrix AtBt( A.nCols(), B.nRows() );
+   Matrix AtBt( A.nCols(), B.nRows(), Matrix::UNINITIALIZED );
 
    // Compute the Matrix product.
    for (int i = 0; i < A.nCols(); ++i)
       for (int j=0; j < B.nRows(); ++j)
          AtBt(i,j) = SumProduct( A.nRows(), A.Base(0,i), A.nCols(), B.Base(j,0) );
 
-   C = AtBt;
+   C = std::move( AtBt );
 }
 
 //-----------------------------------------------------------------------------
@@ -12,59 +12,97 @@
 #ifndef MATRIX_H
 #define MATRIX_H
 
+#include <cstddef>
 #include <iostream>
+#include <string>
 #include <vector>
 
+#include "arena.h"
+
 //=============================================================================
-// Matrix
+// BasicMatrix
+//
+//    A dense, row-major matrix of scalars of type T; instantiated for double
+//    (Matrix) and float (FloatMatrix). The arithmetic below is provided for
+//    Matrix only.
+//
+//    The storage is drawn from a MemoryResource: by default the aligned heap.
+//    A move takes the storage together with its resource. A matrix holding
+//    storage from an Arena must be destroyed, or moved from, before the next
+//    Arena::Reset.
 //=============================================================================
-class Matrix
+template <typename T>
+class BasicMatrix
 {
 public:
-   // Life cycle
-   Matrix();                                          // null constructor
-   Matrix( const Matrix& A );                         // copy constructor
-   Matrix( const std::vector<double>v );              // constructor w/ std:vector
+   // Tag for construction and resizing without the zero fill, for storage
+   // that is about to be overwritten: Matrix A( n, n, Matrix::UNINITIALIZED ).
+   enum Uninitialized { UNINITIALIZED };
 
-   Matrix( int nrows, int ncols );                    // dimensioned constructor
-   Matrix( int nrows, int ncols, double a );          // constructor w/ scalar fill
-   Matrix( int nrows, int ncols, const double* a );   // constructor w/ array fill
-   Matrix( const std::string& str );
-
-   ~Matrix();                                         // destructor
-   void Resize( int nrows, int ncols );               // destructive resize.
+   // Life cycle
+   BasicMatrix();                                        // null constructor
+   explicit BasicMatrix( MemoryResource* resource );     // null, w/ storage resource
+   BasicMatrix( const BasicMatrix& A );                  // copy constructor
+   BasicMatrix( BasicMatrix&& A ) noexcept;              // move constructor
+   BasicMatrix( const std::vector<T>v );                 // constructor w/ std:vector
+
+   BasicMatrix( int nrows, int ncols );                  // dimensioned constructor
+   BasicMatrix( int nrows, int ncols, Uninitialized );   // dimensioned, without fill
+   BasicMatrix( int nrows, int ncols, T a );             // constructor w/ scalar fill
+   BasicMatrix( int nrows, int ncols, const T* a );      // constructor w/ array fill
+   BasicMatrix( const std::string& str );
+
+   ~BasicMatrix();                                       // destructor
+   void Resize( int nrows, int ncols );                  // destructive resize.
+   void Resize( int nrows, int ncols, Uninitialized );   // destructive resize, without fill
 
    // Operators
-   Matrix& operator=( const Matrix& A );              // assignment operator
-   Matrix& operator=( double a );                     // scalar assignment
+   BasicMatrix& operator=( const BasicMatrix& A );       // assignment operator
+   BasicMatrix& operator=( BasicMatrix&& A ) noexcept;   // move assignment operator
+   BasicMatrix& operator=( T a );                        // scalar assignment
 
-   double& operator()( int row, int col );            // mutable access
-   double  operator()( int row, int col ) const;      // const access
+   T& operator()( int row, int col );                    // mutable access
+   T  operator()( int row, int col ) const;              // const access
 
    // Inquiry.
-   int nRows() const;                                 // return the row size
-   int nCols() const;                                 // return the column size
+   int nRows() const;                                    // return the row size
+   int nCols() const;                                    // return the column size
+   std::size_t Capacity() const;                         // return the allocated # of elements
+   MemoryResource* Resource() const;                     // return the storage resource
 
    // Access to the raw storage.
-   const double* Base() const;                        // r/o access
-   const double* Base( int row, int col ) const;      // r/o access
+   const T* Base() const;                                // r/o access
+   const T* Base( int row, int col ) const;              // r/o access
 
-   double* Base();                                    // r/w access
-   double* Base( int row, int col );                  // r/w access with offset
+   T* Base();                                            // r/w access
+   T* Base( int row, int col );                          // r/w access with offset
 
    // STL-like iterators.
-   const double* begin() const;                       // r/o access
-   const double* end() const;                         // r/o access
+   const T* begin() const;                               // r/o access
+   const T* end() const;                                 // r/o access
 
-   double* begin();                                   // r/w access
-   double* end();                                     // r/w access
+   T* begin();                                           // r/w access
+   T* end();                                             // r/w access
 
 private:
-   int     m_nRows;                                   // allocated # of rows
-   int     m_nCols;                                   // allocated # of columns
-   double* m_Data;                                    // allocated memory
+   T* Allocate( std::size_t n );                         // counted allocation
+   void Release();                                       // return the storage
+   std::size_t Elements() const;                         // m_nRows * m_nCols
+
+   int             m_nRows;                              // allocated # of rows
+   int             m_nCols;                              // allocated # of columns
+   std::size_t     m_Capacity;                           // allocated # of elements
+   T*              m_Data;                               // allocated memory
+   MemoryResource* m_Resource;                           // source of m_Data
 };
 
+typedef BasicMatrix<double> Matrix;
+typedef BasicMatrix<float>  FloatMatrix;
+
+// The members are defined, and instantiated for both types, in matrix.cpp.
+extern template class BasicMatrix<double>;
+extern template class BasicMatrix<float>;
+
 
 //=============================================================================
 // IO Stream
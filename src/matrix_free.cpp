@@ -0,0 +1,437 @@
+//=============================================================================
+// matrix_free.cpp
+//
+//    The exponential covariance matrix C of a set of points as an operator,
+//    and the preconditioned conjugate gradient solution of its systems.
+//
+// notes:
+// o  A product evaluates each tile of C below the diagonal once, and applies
+//    it and its transpose to every right-hand side, so that all of the
+//    systems solved together share the evaluations of the exponential,
+//    which are most of the cost.
+//
+// o  Each system has its own step lengths, and is skipped once it has
+//    converged.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <math.h>
+#include <thread>
+
+#include "fast_exp-inl.h"
+#include "linear_systems.h"
+#include "matrix_free.h"
+#include "profile.h"
+#include "sum_product-inl.h"
+
+//=============================================================================
+// Exclusion
+//=============================================================================
+Exclusion::Exclusion()
+:  excluded(),
+   positions(),
+   blocks(),
+   factors()
+{
+}
+
+//=============================================================================
+// OperatorWorkspace
+//=============================================================================
+OperatorWorkspace::OperatorWorkspace()
+:  R(), Z(), P(), Q(),
+   X(),
+   rz(),
+   bnorm(),
+   converged()
+{
+}
+
+//=============================================================================
+// CovarianceOperator
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+CovarianceOperator::CovarianceOperator()
+:  m_Index(),
+   m_Order(),
+   m_Position(),
+   m_x(),
+   m_y(),
+   m_sill( 0.0 ),
+   m_scale( 0.0 ),
+   m_factor( 0.0 ),
+   m_Factors()
+{
+}
+
+//-----------------------------------------------------------------------------
+// Build
+//-----------------------------------------------------------------------------
+bool CovarianceOperator::Build(
+   const std::vector<double>& x,
+   const std::vector<double>& y,
+   double nugget,
+   double sill,
+   double range,
+   int nthreads )
+{
+   assert( x.size() == y.size() );
+
+   const int n = x.size();
+   {
+      ScopedTimer timer( PHASE_ASSEMBLY );
+      m_Index.Build( x, y );
+      m_Order = m_Index.Order();
+
+      m_Position.resize(n);
+      m_x.resize(n);
+      m_y.resize(n);
+      for (int p = 0; p < n; ++p) {
+         m_Position[m_Order[p]] = p;
+         m_x[p] = x[m_Order[p]];
+         m_y[p] = y[m_Order[p]];
+      }
+   }
+   m_sill   = sill;
+   m_scale  = sill - nugget;
+   m_factor = -3.0 / range;
+
+   const int nblocks = (n + OPERATOR_BLOCK - 1) / OPERATOR_BLOCK;
+   m_Factors.resize( static_cast<std::size_t>(nblocks)*OPERATOR_BLOCK*OPERATOR_BLOCK );
+   nthreads = std::max( 1, std::min(nthreads, nblocks) );
+
+   std::atomic<int>  next(0);
+   std::atomic<bool> failed(false);
+   auto worker = [&]() {
+      ScopedTimer timer( PHASE_FACTORIZATION );
+
+      for (int b = next++; b < nblocks; b = next++) {
+         if (!FactorBlock( b, nullptr, &m_Factors[static_cast<std::size_t>(b)*OPERATOR_BLOCK*OPERATOR_BLOCK] ))
+            failed = true;
+      }
+   };
+
+   std::vector<std::thread> workers;
+   for (int t = 1; t < nthreads; ++t)
+      workers.push_back( std::thread(worker) );
+   worker();
+   for (auto& t : workers) t.join();
+
+   if (failed) {
+      *this = CovarianceOperator();
+      return false;
+   }
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+// Exclude
+//-----------------------------------------------------------------------------
+void CovarianceOperator::Exclude( const std::vector<int>& excluded, Exclusion& set ) const
+{
+   const int n = nRows();
+
+   set.excluded.resize( n, 0 );
+   for (int p : set.positions)
+      set.excluded[p] = 0;
+
+   set.positions.clear();
+   set.blocks.clear();
+   for (int j : excluded) {
+      set.positions.push_back( m_Position[j] );
+      set.excluded[m_Position[j]] = 1;
+      set.blocks.push_back( m_Position[j] / OPERATOR_BLOCK );
+   }
+   std::sort( set.blocks.begin(), set.blocks.end() );
+   set.blocks.erase( std::unique(set.blocks.begin(), set.blocks.end()), set.blocks.end() );
+
+   // A principal submatrix of a factored block is positive definite, but
+   // should the factorization fail, the identity is the preconditioner.
+   const std::size_t size = OPERATOR_BLOCK*OPERATOR_BLOCK;
+   set.factors.resize( set.blocks.size() * size );
+   for (std::size_t a = 0; a < set.blocks.size(); ++a) {
+      double* L = &set.factors[a*size];
+      if (!FactorBlock( set.blocks[a], set.excluded.data(), L )) {
+         const int p0 = set.blocks[a]*OPERATOR_BLOCK;
+         const int nb = std::min( OPERATOR_BLOCK, n - p0 );
+         std::fill( L, L + nb*nb, 0.0 );
+         for (int i = 0; i < nb; ++i)
+            L[i*nb + i] = 1.0;
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+// Column
+//-----------------------------------------------------------------------------
+void CovarianceOperator::Column( int k, double* c ) const
+{
+   const int n = nRows();
+   const int pk = m_Position[k];
+
+   for (int p = 0; p < n; ++p) {
+      const double dx = m_x[p] - m_x[pk];
+      const double dy = m_y[p] - m_y[pk];
+      c[m_Order[p]] = m_scale * FastExp( m_factor*sqrt(dx*dx + dy*dy) );
+   }
+   c[k] = m_sill;
+}
+
+//-----------------------------------------------------------------------------
+// Solve
+//-----------------------------------------------------------------------------
+void CovarianceOperator::Solve(
+   int nrhs,
+   const Exclusion* const* sets,
+   const double* B,
+   double* X,
+   double tolerance,
+   int max_iterations,
+   OperatorWorkspace& ws,
+   int* iterations,
+   double* residual ) const
+{
+   const int n = nRows();
+   const std::size_t size = static_cast<std::size_t>(nrhs)*n;
+
+   ws.R.resize(size);
+   ws.Z.resize(size);
+   ws.P.resize(size);
+   ws.Q.resize(size);
+   ws.X.resize(size);
+   ws.rz.resize(nrhs);
+   ws.bnorm.resize(nrhs);
+   ws.converged.assign(nrhs, 0);
+
+   // Into the tree order, with the entries in E zeroed.
+   for (int r = 0; r < nrhs; ++r) {
+      double* Xr = &ws.X[r*n];
+      double* Rr = &ws.R[r*n];
+      for (int p = 0; p < n; ++p) {
+         Xr[p] = X[r*n + m_Order[p]];
+         Rr[p] = B[r*n + m_Order[p]];
+      }
+      for (int p : sets[r]->positions)
+         Xr[p] = Rr[p] = 0.0;
+
+      ws.bnorm[r] = sqrt( SumProduct(n, Rr) );
+      iterations[r] = 0;
+   }
+
+   // R = B - A X.
+   Multiply( nrhs, sets, nullptr, ws.X.data(), ws.Q.data() );
+   for (std::size_t i = 0; i < size; ++i)
+      ws.R[i] -= ws.Q[i];
+
+   Precondition( nrhs, sets, ws.R.data(), ws.Z.data() );
+   ws.P = ws.Z;
+   for (int r = 0; r < nrhs; ++r)
+      ws.rz[r] = SumProduct(n, &ws.R[r*n], &ws.Z[r*n]);
+
+   for (int iteration = 0; ; ++iteration) {
+      bool done = true;
+      for (int r = 0; r < nrhs; ++r) {
+         if (ws.converged[r]) continue;
+
+         const double rnorm = sqrt( SumProduct(n, &ws.R[r*n]) );
+         residual[r] = (ws.bnorm[r] > 0) ? rnorm/ws.bnorm[r] : 0.0;
+         iterations[r] = iteration;
+         ws.converged[r] = (residual[r] <= tolerance);
+         done = done && ws.converged[r];
+      }
+      if (done || iteration == max_iterations) break;
+
+      Multiply( nrhs, sets, ws.converged.data(), ws.P.data(), ws.Q.data() );
+      for (int r = 0; r < nrhs; ++r) {
+         if (ws.converged[r]) continue;
+
+         double* Xr = &ws.X[r*n];
+         double* Rr = &ws.R[r*n];
+         const double* Pr = &ws.P[r*n];
+         const double* Qr = &ws.Q[r*n];
+
+         const double alpha = ws.rz[r] / SumProduct(n, Pr, Qr);
+         for (int p = 0; p < n; ++p) {
+            Xr[p] += alpha * Pr[p];
+            Rr[p] -= alpha * Qr[p];
+         }
+      }
+
+      Precondition( nrhs, sets, ws.R.data(), ws.Z.data() );
+      for (int r = 0; r < nrhs; ++r) {
+         if (ws.converged[r]) continue;
+
+         double* Pr = &ws.P[r*n];
+         const double* Zr = &ws.Z[r*n];
+
+         const double rz = SumProduct(n, &ws.R[r*n], Zr);
+         const double beta = rz / ws.rz[r];
+         ws.rz[r] = rz;
+         for (int p = 0; p < n; ++p)
+            Pr[p] = Zr[p] + beta * Pr[p];
+      }
+   }
+
+   // Back to the original order.
+   for (int r = 0; r < nrhs; ++r)
+      for (int p = 0; p < n; ++p)
+         X[r*n + m_Order[p]] = ws.X[r*n + p];
+}
+
+//-----------------------------------------------------------------------------
+// Multiply
+//
+//    Y = A X, tile by tile; see the notes. The flagged vectors, if any, are
+//    skipped.
+//-----------------------------------------------------------------------------
+void CovarianceOperator::Multiply(
+   int nrhs,
+   const Exclusion* const* sets,
+   const char* skip,
+   const double* X,
+   double* Y ) const
+{
+   const int n = nRows();
+   std::fill( Y, Y + static_cast<std::size_t>(nrhs)*n, 0.0 );
+
+   double K[OPERATOR_BLOCK*OPERATOR_BLOCK];
+   for (int i0 = 0; i0 < n; i0 += OPERATOR_BLOCK) {
+      const int i1 = std::min( i0 + OPERATOR_BLOCK, n );
+      const int ni = i1 - i0;
+
+      for (int j0 = 0; j0 <= i0; j0 += OPERATOR_BLOCK) {
+         const int j1 = std::min( j0 + OPERATOR_BLOCK, n );
+         const int nj = j1 - j0;
+         Tile( i0, i1, j0, j1, K );
+
+         for (int r = 0; r < nrhs; ++r) {
+            if (skip != nullptr && skip[r]) continue;
+
+            const double* Xr = X + static_cast<std::size_t>(r)*n;
+            double*       Yr = Y + static_cast<std::size_t>(r)*n;
+
+            for (int a = 0; a < ni; ++a)
+               Yr[i0 + a] += SumProduct(nj, K + a*nj, Xr + j0);
+
+            if (j0 < i0) {
+               for (int a = 0; a < ni; ++a) {
+                  const double xa = Xr[i0 + a];
+                  const double* Ka = K + a*nj;
+                  for (int c = 0; c < nj; ++c)
+                     Yr[j0 + c] += Ka[c] * xa;
+               }
+            }
+         }
+      }
+   }
+
+   for (int r = 0; r < nrhs; ++r)
+      for (int p : sets[r]->positions)
+         Y[static_cast<std::size_t>(r)*n + p] = 0.0;
+}
+
+//-----------------------------------------------------------------------------
+// Precondition
+//
+//    Z = P^{-1} R, with P the block diagonal of each A.
+//-----------------------------------------------------------------------------
+void CovarianceOperator::Precondition(
+   int nrhs,
+   const Exclusion* const* sets,
+   const double* R,
+   double* Z ) const
+{
+   const int n = nRows();
+   const std::size_t size = OPERATOR_BLOCK*OPERATOR_BLOCK;
+
+   std::copy( R, R + static_cast<std::size_t>(nrhs)*n, Z );
+
+   for (int r = 0; r < nrhs; ++r) {
+      const Exclusion& set = *sets[r];
+      double* Zr = Z + static_cast<std::size_t>(r)*n;
+
+      std::size_t a = 0;                // the next block in set.blocks
+      for (int b = 0; b*OPERATOR_BLOCK < n; ++b) {
+         const int p0 = b*OPERATOR_BLOCK;
+         const int nb = std::min( OPERATOR_BLOCK, n - p0 );
+
+         const double* L = &m_Factors[b*size];
+         if (a < set.blocks.size() && set.blocks[a] == b)
+            L = &set.factors[size*a++];
+
+         CholeskySolve( nb, L, nb, Zr + p0 );
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+// Tile
+//
+//    K = C(i0:i1, j0:j1), in the tree order, row-major.
+//-----------------------------------------------------------------------------
+void CovarianceOperator::Tile( int i0, int i1, int j0, int j1, double* K ) const
+{
+   const int nj = j1 - j0;
+   const double* xj = &m_x[j0];
+   const double* yj = &m_y[j0];
+
+   for (int i = i0; i < i1; ++i) {
+      const double xi = m_x[i];
+      const double yi = m_y[i];
+      double* Ki = K + (i - i0)*nj;
+
+      for (int c = 0; c < nj; ++c) {
+         const double dx = xi - xj[c];
+         const double dy = yi - yj[c];
+         Ki[c] = m_scale * FastExp( m_factor*sqrt(dx*dx + dy*dy) );
+      }
+      if (j0 <= i && i < j1)
+         Ki[i - j0] = m_sill;
+   }
+}
+
+//-----------------------------------------------------------------------------
+// FactorBlock
+//
+//    Factor the diagonal block [b] of C into L, with the rows and columns of
+//    the flagged points, if any, replaced by those of the identity.
+//-----------------------------------------------------------------------------
+bool CovarianceOperator::FactorBlock( int b, const char* excluded, double* L ) const
+{
+   const int p0 = b*OPERATOR_BLOCK;
+   const int p1 = std::min( p0 + OPERATOR_BLOCK, nRows() );
+   const int nb = p1 - p0;
+
+   Tile( p0, p1, p0, p1, L );
+   if (excluded != nullptr) {
+      for (int a = 0; a < nb; ++a) {
+         if (!excluded[p0 + a]) continue;
+         for (int c = 0; c < nb; ++c)
+            L[a*nb + c] = L[c*nb + a] = 0.0;
+         L[a*nb + a] = 1.0;
+      }
+   }
+   return CholeskyDecomposition( nb, L, nb );
+}
+
+//-----------------------------------------------------------------------------
+const KdTree& CovarianceOperator::Index() const
+{
+   return m_Index;
+}
+
+//-----------------------------------------------------------------------------
+int CovarianceOperator::nRows() const
+{
+   return m_x.size();
+}
@@ -0,0 +1,143 @@
+//=============================================================================
+// matrix_free.h
+//
+//    The exponential covariance matrix C of a set of points as an operator:
+//    its products are evaluated from the coordinates, tile by tile, as they
+//    are needed, so that C is never stored and the memory is O(N). The
+//    kriging systems are solved by the preconditioned conjugate gradient
+//    method, with a block-Jacobi preconditioner over spatial clusters.
+//
+//    The points are kept in the order of a k-d tree, in which the points of
+//    every subtree are contiguous. The clusters are the consecutive blocks
+//    of OPERATOR_BLOCK points in that order, and the Cholesky factors of
+//    their diagonal blocks of C are computed once and kept.
+//
+//    A system A x = b, with A the submatrix of C without the rows and
+//    columns of an excluded set E, is solved in place, as C with the rows
+//    and columns of E replaced by those of the identity and with x_E = 0.
+//    Only the clusters holding an excluded point need a new factor. Many
+//    systems, each with its own excluded set, are solved together, so that
+//    every tile of C evaluated serves all of them.
+//
+// References:
+//
+// o  Saad, Y., 2003, Iterative Methods for Sparse Linear Systems, 2nd
+//    edition, SIAM, Philadelphia, 528 pp. (Sections 9.2 and 10.5.)
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef MATRIX_FREE_H
+#define MATRIX_FREE_H
+
+#include <vector>
+
+#include "spatial_index.h"
+
+//-----------------------------------------------------------------------------
+// The number of points in each cluster of the preconditioner, and on each
+// side of a tile of the products.
+//-----------------------------------------------------------------------------
+const int OPERATOR_BLOCK = 64;
+
+//=============================================================================
+// Exclusion
+//
+//    An excluded set E, and the preconditioner factors that it changes; see
+//    CovarianceOperator::Exclude.
+//=============================================================================
+struct Exclusion {
+   std::vector<char>   excluded;           // of each point, in the tree order
+   std::vector<int>    positions;          // the excluded points, in the tree order
+   std::vector<int>    blocks;             // the clusters holding them
+   std::vector<double> factors;            // and their new factors
+
+   Exclusion();
+};
+
+//=============================================================================
+// OperatorWorkspace
+//
+//    The scratch storage of one thread for the solves of a
+//    CovarianceOperator.
+//=============================================================================
+struct OperatorWorkspace {
+   std::vector<double> R, Z, P, Q;         // the CG vectors, in the tree order
+   std::vector<double> X;                  // the solutions, in the tree order
+   std::vector<double> rz, bnorm;          // for each right-hand side
+   std::vector<char>   converged;          // of each right-hand side
+
+   OperatorWorkspace();
+};
+
+//=============================================================================
+// CovarianceOperator
+//=============================================================================
+class CovarianceOperator
+{
+public:
+   CovarianceOperator();
+
+   // The covariance C(i,j) = (sill - nugget) exp(-3 h / range) at separation
+   // distance h, with C(i,i) = sill. Index the points and factor the blocks
+   // of the preconditioner on "nthreads" threads. Returns false, and leaves
+   // the operator empty, if a block is not numerically positive definite.
+   bool Build(
+      const std::vector<double>& x,
+      const std::vector<double>& y,
+      double nugget,
+      double sill,
+      double range,
+      int nthreads );
+
+   // Set E to the given points, and factor the blocks of the preconditioner
+   // that hold them.
+   void Exclude( const std::vector<int>& excluded, Exclusion& set ) const;
+
+   // The covariances c[j] = C(j,k) of every point with point [k].
+   void Column( int k, double* c ) const;
+
+   // Solve A_r x_r = b_r for the "nrhs" vectors of B and X, stored one after
+   // another, with A_r that of the excluded set *sets[r]. X holds the
+   // initial guesses on entry. Each system is iterated until its residual,
+   // relative to b_r, is at most "tolerance", or for "max_iterations".
+   // Sets iterations[r] and residual[r], the final relative residual; x_r
+   // has not converged if that exceeds the tolerance. The entries of x_r in
+   // its E are zero on return.
+   void Solve(
+      int nrhs,
+      const Exclusion* const* sets,
+      const double* B,
+      double* X,
+      double tolerance,
+      int max_iterations,
+      OperatorWorkspace& ws,
+      int* iterations,
+      double* residual ) const;
+
+   const KdTree& Index() const;                          // of the points
+   int nRows() const;                                    // 0 if empty
+
+private:
+   void Multiply( int nrhs, const Exclusion* const* sets, const char* skip, const double* X, double* Y ) const;
+   void Precondition( int nrhs, const Exclusion* const* sets, const double* R, double* Z ) const;
+   void Tile( int i0, int i1, int j0, int j1, double* K ) const;
+   bool FactorBlock( int b, const char* excluded, double* L ) const;
+
+   KdTree              m_Index;
+   std::vector<int>    m_Order;        // original index of each point
+   std::vector<int>    m_Position;     // tree-order position of each point
+   std::vector<double> m_x, m_y;       // the points, in the tree order
+   double              m_sill;
+   double              m_scale;        // sill - nugget
+   double              m_factor;       // -3 / range
+   std::vector<double> m_Factors;      // of the diagonal blocks
+};
+
+//=============================================================================
+#endif  // MATRIX_FREE_H
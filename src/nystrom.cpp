@@ -0,0 +1,193 @@
+//=============================================================================
+// nystrom.cpp
+//
+//    The Nystrom low-rank approximation of a covariance matrix with a
+//    nugget effect.
+//
+// notes:
+// o  Row [i] of U is the solution of L u = K(L,i), with L the Cholesky
+//    factor of K(L,L), so that U U' = K(:,L) K(L,L)^{-1} K(L,:).
+//
+// o  The rows of U of the landmarks reproduce K exactly, so D(i,i) is the
+//    nugget at each landmark. Elsewhere it can only be larger, up to the
+//    rounding of |U(i,:)|^2, which is kept from pushing it below the nugget.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <math.h>
+#include <thread>
+
+#include "fast_exp-inl.h"
+#include "linear_systems.h"
+#include "nystrom.h"
+#include "profile.h"
+#include "vecchia.h"
+
+namespace{
+   // Manifest constants.
+   const int ROW_BLOCK = 256;           // rows handed to a thread at a time
+}
+
+//=============================================================================
+// Nystrom
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+Nystrom::Nystrom()
+:  m_Index(),
+   m_Landmarks(),
+   m_U(),
+   m_D(),
+   m_nugget( 0.0 ),
+   m_sill( 0.0 ),
+   m_range( 0.0 )
+{
+}
+
+//-----------------------------------------------------------------------------
+// Build
+//-----------------------------------------------------------------------------
+bool Nystrom::Build(
+   const std::vector<double>& x,
+   const std::vector<double>& y,
+   double nugget,
+   double sill,
+   double range,
+   int rank,
+   int nthreads )
+{
+   assert( x.size() == y.size() );
+   assert( rank > 0 );
+
+   const int n = x.size();
+   const int r = std::min( rank, n );
+   const double scale  = sill - nugget;
+   const double factor = -3.0 / range;
+
+   std::vector<double> L( static_cast<std::size_t>(r)*r );
+   {
+      ScopedTimer timer( PHASE_ASSEMBLY );
+      m_Index.Build( x, y );
+      std::vector<int> order = MaxminOrder( x, y, m_Index );
+      m_Landmarks.assign( order.begin(), order.begin() + r );
+
+      for (int a = 0; a < r; ++a) {
+         const int la = m_Landmarks[a];
+         for (int b = 0; b <= a; ++b) {
+            const int lb = m_Landmarks[b];
+            L[a*r + b] = L[b*r + a] = scale * FastExp( factor*hypot(x[la] - x[lb], y[la] - y[lb]) );
+         }
+      }
+   }
+   {
+      ScopedTimer timer( PHASE_FACTORIZATION );
+      if (!CholeskyDecomposition(r, L.data(), r)) {
+         *this = Nystrom();
+         return false;
+      }
+   }
+
+   m_U.resize( static_cast<std::size_t>(n)*r );
+   m_D.resize( n );
+
+   const int nblocks = (n + ROW_BLOCK - 1) / ROW_BLOCK;
+   nthreads = std::max( 1, std::min(nthreads, nblocks) );
+
+   std::atomic<int> next(0);
+   auto worker = [&]() {
+      ScopedTimer timer( PHASE_ASSEMBLY );
+
+      for (int block = next++; block < nblocks; block = next++) {
+         const int i1 = std::min( (block+1)*ROW_BLOCK, n );
+         for (int i = block*ROW_BLOCK; i < i1; ++i) {
+            double* u = &m_U[static_cast<std::size_t>(i)*r];
+
+            // Forward substitution of L u = K(L,i).
+            double norm = 0.0;
+            for (int a = 0; a < r; ++a) {
+               const int la = m_Landmarks[a];
+               double sum = scale * FastExp( factor*hypot(x[i] - x[la], y[i] - y[la]) );
+               for (int b = 0; b < a; ++b)
+                  sum -= L[a*r + b] * u[b];
+               u[a] = sum / L[a*r + a];
+               norm += u[a]*u[a];
+            }
+            m_D[i] = std::max( sill - norm, nugget );
+         }
+      }
+   };
+
+   std::vector<std::thread> workers;
+   for (int t = 1; t < nthreads; ++t)
+      workers.push_back( std::thread(worker) );
+   worker();
+   for (auto& t : workers) t.join();
+
+   m_nugget = nugget;
+   m_sill   = sill;
+   m_range  = range;
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+const double* Nystrom::Row( int i ) const
+{
+   return &m_U[static_cast<std::size_t>(i)*Rank()];
+}
+
+//-----------------------------------------------------------------------------
+double Nystrom::Diagonal( int i ) const
+{
+   return m_D[i];
+}
+
+//-----------------------------------------------------------------------------
+const KdTree& Nystrom::Index() const
+{
+   return m_Index;
+}
+
+//-----------------------------------------------------------------------------
+const std::vector<int>& Nystrom::Landmarks() const
+{
+   return m_Landmarks;
+}
+
+//-----------------------------------------------------------------------------
+int Nystrom::Rank() const
+{
+   return m_Landmarks.size();
+}
+
+//-----------------------------------------------------------------------------
+int Nystrom::nRows() const
+{
+   return m_D.size();
+}
+
+//-----------------------------------------------------------------------------
+double Nystrom::Nugget() const
+{
+   return m_nugget;
+}
+
+//-----------------------------------------------------------------------------
+double Nystrom::Sill() const
+{
+   return m_sill;
+}
+
+//-----------------------------------------------------------------------------
+double Nystrom::Range() const
+{
+   return m_range;
+}
@@ -0,0 +1,92 @@
+//=============================================================================
+// nystrom.h
+//
+//    The Nystrom low-rank approximation of a covariance matrix with a
+//    nugget effect,
+//
+//       C  ~  U U' + D,
+//
+//    with U the N x r matrix K(:,L) K(L,L)^{-1/2} of the covariances, K =
+//    (sill - nugget) R without the nugget, with r landmark points L, and D
+//    the diagonal matrix that restores the diagonal of C exactly: D(i,i) =
+//    sill - |U(i,:)|^2 >= nugget. By the Woodbury identity,
+//
+//       (U U' + D)^{-1} = D^{-1} - D^{-1} U (I + U' D^{-1} U)^{-1} U' D^{-1},
+//
+//    so that every solve needs only an r x r factorization, and removing a
+//    set E of rows and columns only subtracts the |E| terms of E from the
+//    r x r matrix I + U' D^{-1} U.
+//
+//    The landmarks are the first r points of the maxmin order: each is the
+//    point farthest from those before it.
+//
+// References:
+//
+// o  Williams, C.K.I., and Seeger, M., 2001, Using the Nystrom method to
+//    speed up kernel machines, Advances in Neural Information Processing
+//    Systems 13, p. 682-688.
+//
+// o  Snelson, E., and Ghahramani, Z., 2006, Sparse Gaussian processes using
+//    pseudo-inputs, Advances in Neural Information Processing Systems 18,
+//    p. 1257-1264.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef NYSTROM_H
+#define NYSTROM_H
+
+#include <vector>
+
+#include "spatial_index.h"
+
+//=============================================================================
+// Nystrom
+//=============================================================================
+class Nystrom
+{
+public:
+   Nystrom();
+
+   // The covariance C(i,j) = (sill - nugget) exp(-3 h / range) at separation
+   // distance h, with C(i,i) = sill. Select the landmarks and compute U and
+   // D, on "nthreads" threads. Returns false, and leaves the approximation
+   // empty, if K(L,L) is not numerically positive definite.
+   bool Build(
+      const std::vector<double>& x,
+      const std::vector<double>& y,
+      double nugget,
+      double sill,
+      double range,
+      int rank,
+      int nthreads );
+
+   const double* Row( int i ) const;                     // U(i,:)
+   double Diagonal( int i ) const;                       // D(i,i)
+
+   const KdTree& Index() const;                          // of the points
+   const std::vector<int>& Landmarks() const;            // L
+   int Rank() const;                                     // r
+   int nRows() const;                                    // 0 if empty
+
+   double Nugget() const;
+   double Sill() const;
+   double Range() const;
+
+private:
+   KdTree              m_Index;
+   std::vector<int>    m_Landmarks;
+   std::vector<double> m_U;            // N x r, row-major
+   std::vector<double> m_D;
+   double              m_nugget;
+   double              m_sill;
+   double              m_range;
+};
+
+//=============================================================================
+#endif  // NYSTROM_H
@@ -0,0 +1,170 @@
+//=============================================================================
+// perf_counters.cpp
+//
+//    Hardware performance counters (cycles, instructions, last-level cache
+//    misses, and branch misses) via the Linux perf_event_open interface.
+//
+// notes:
+// o  The counters are opened per thread, the first time a thread reads
+//    them, as one group so that all four are scheduled together. Only user
+//    space is counted, which is allowed with the default
+//    perf_event_paranoid setting of 2.
+//
+// o  On other platforms, and wherever perf_event_open is refused, the
+//    counters are simply unavailable.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+#ifdef __linux__
+   #include <linux/perf_event.h>
+   #include <sys/ioctl.h>
+   #include <sys/syscall.h>
+   #include <unistd.h>
+#endif
+
+#include "perf_counters.h"
+
+namespace{
+   std::atomic<bool> g_enabled(false);
+
+   const char* COUNTER_NAMES[NUMBER_OF_COUNTERS] = {
+      "cycles",
+      "instructions",
+      "llc_misses",
+      "branch_misses"
+   };
+
+#ifdef __linux__
+   const unsigned long long COUNTER_CONFIG[NUMBER_OF_COUNTERS] = {
+      PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES,
+      PERF_COUNT_HW_BRANCH_MISSES
+   };
+
+   //--------------------------------------------------------------------------
+   // CounterGroup
+   //
+   //    The perf event file descriptors for one thread. The first counter is
+   //    the group leader; the whole group is read with one system call.
+   //--------------------------------------------------------------------------
+   class CounterGroup {
+      public :
+         CounterGroup() : m_fd(), m_error(0) {
+            for (int c = 0; c < NUMBER_OF_COUNTERS; ++c) m_fd[c] = -1;
+
+            for (int c = 0; c < NUMBER_OF_COUNTERS; ++c) {
+               struct perf_event_attr attr;
+               memset( &attr, 0, sizeof(attr) );
+               attr.size           = sizeof(attr);
+               attr.type           = PERF_TYPE_HARDWARE;
+               attr.config         = COUNTER_CONFIG[c];
+               attr.exclude_kernel = 1;
+               attr.exclude_hv     = 1;
+               attr.read_format    = PERF_FORMAT_GROUP;
+
+               long fd = syscall( __NR_perf_event_open, &attr, 0, -1, (c == 0 ? -1 : m_fd[0]), 0 );
+               if (fd < 0) {
+                  m_error = errno;
+                  Close();
+                  return;
+               }
+               m_fd[c] = static_cast<int>(fd);
+            }
+         }
+
+         ~CounterGroup() {
+            Close();
+         }
+
+         bool Read( CounterSample& sample ) const {
+            if (m_fd[0] < 0) return false;
+
+            unsigned long long buffer[1 + NUMBER_OF_COUNTERS];
+            if ( read(m_fd[0], buffer, sizeof(buffer)) != static_cast<ssize_t>(sizeof(buffer)) )
+               return false;
+
+            for (int c = 0; c < NUMBER_OF_COUNTERS; ++c)
+               sample.value[c] = buffer[1 + c];
+            return true;
+         }
+
+         int Error() const {
+            return m_error;
+         }
+
+      private :
+         void Close() {
+            for (int c = NUMBER_OF_COUNTERS-1; c >= 0; --c) {
+               if (m_fd[c] >= 0) close( m_fd[c] );
+               m_fd[c] = -1;
+            }
+         }
+
+         int m_fd[NUMBER_OF_COUNTERS];
+         int m_error;
+   };
+
+   CounterGroup& LocalGroup() {
+      thread_local CounterGroup group;
+      return group;
+   }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+const char* CounterName( int counter )
+{
+   return COUNTER_NAMES[counter];
+}
+
+//-----------------------------------------------------------------------------
+bool EnableCounters( std::string& reason )
+{
+#ifdef __linux__
+   CounterSample sample;
+   if ( LocalGroup().Read(sample) ) {
+      g_enabled = true;
+      return true;
+   }
+
+   std::stringstream message;
+   message << "perf_event_open failed: " << strerror( LocalGroup().Error() );
+   if ( LocalGroup().Error() == EACCES || LocalGroup().Error() == EPERM )
+      message << " (check /proc/sys/kernel/perf_event_paranoid, or the container's seccomp profile)";
+   else if ( LocalGroup().Error() == ENOENT || LocalGroup().Error() == EOPNOTSUPP )
+      message << " (the hardware events are not exposed; e.g. in a virtual machine)";
+   reason = message.str();
+#else
+   reason = "hardware performance counters are only supported on Linux";
+#endif
+   g_enabled = false;
+   return false;
+}
+
+//-----------------------------------------------------------------------------
+bool CountersEnabled()
+{
+   return g_enabled.load(std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+bool ReadCounters( CounterSample& sample )
+{
+#ifdef __linux__
+   if ( CountersEnabled() ) return LocalGroup().Read(sample);
+#endif
+   (void) sample;
+   return false;
+}
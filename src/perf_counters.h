@@ -0,0 +1,47 @@
+//=============================================================================
+// perf_counters.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <string>
+
+//-----------------------------------------------------------------------------
+// The hardware events counted for each profiled phase.
+//-----------------------------------------------------------------------------
+enum HardwareCounter {
+   COUNTER_CYCLES,
+   COUNTER_INSTRUCTIONS,
+   COUNTER_LLC_MISSES,
+   COUNTER_BRANCH_MISSES,
+   NUMBER_OF_COUNTERS
+};
+
+struct CounterSample {
+   unsigned long long value[NUMBER_OF_COUNTERS];
+};
+
+const char* CounterName( int counter );
+
+//-----------------------------------------------------------------------------
+// EnableCounters probes the counters on the calling thread. If they cannot be
+// opened (e.g. not Linux, or perf events are restricted in a container) it
+// returns false and explains why in "reason", and the counters stay off.
+//-----------------------------------------------------------------------------
+bool EnableCounters( std::string& reason );
+bool CountersEnabled();
+
+// Read the counters of the calling thread; false if they are not available.
+bool ReadCounters( CounterSample& sample );
+
+
+//=============================================================================
+#endif  // PERF_COUNTERS_H
@@ -0,0 +1,522 @@
+//=============================================================================
+// pipeline.cpp
+//
+//    Read, assemble, compute, and write. The reading of the file runs on a
+//    thread of its own, and the writing of the results is overlapped with
+//    the computing; the assembly starts only once the last record is read.
+//
+//    o  A reader thread parses the input file and queues the records.
+//    o  The calling thread collects the records as they arrive, and once
+//       they are all read fills the covariance matrices on all of the
+//       worker threads; see Assembly::Append for why it waits. Dense,
+//       or sparse and tapered if options.taper > 0, or compressed to an
+//       HODLR H-matrix if options.hmatrix > 0, or replaced by a Vecchia
+//       approximation of the inverse if options.vecchia > 0, or by a
+//       Nystrom low-rank approximation if options.nystrom > 0, or never
+//       formed at all if options.iterative > 0.
+//    o  The engine worker threads evaluate the observations, and the calling
+//       thread streams each completed prefix of the results to the output
+//       file.
+//
+//    The wall-clock time is that of the reading, the assembly, and the
+//    computing, with the writing hidden behind the computing.
+//
+//    With options.screen > 0 there are two passes: a screening pass over
+//    every observation with a small neighborhood, by the local engine, so
+//    that nothing of order N^2 is formed for it, and then an exact pass by
+//    the dense engine over only the candidates, those with a screening
+//    p-value below options.screen, most suspicious first. The dense
+//    matrices are filled only if there is a candidate. The other
+//    observations keep their screening results, and are marked "screened"
+//    in the Status column.
+//
+//    A run with a deadline or a cancellation flag writes only once the
+//    engine has stopped, with the observations it did not reach marked
+//    "unfinished"; so does a run in any order but that of the observations.
+//    So does an iterative run, with the Iterations and Residual of each
+//    observation, and those whose systems did not converge marked
+//    "unconverged".
+//
+//    With a selection of targets only those observations are evaluated and
+//    written, with all of the observations as data. The dense engine is then
+//    replaced by the local one, so that neither matrix of all N is formed.
+//
+//    With a checkpoint file every result is also appended to it as it is
+//    completed, and a resumed run takes back the results recorded there by
+//    an earlier run of the same data and parameters, and evaluates only the
+//    rest.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "checkpoint.h"
+#include "engine.h"
+#include "pipeline.h"
+#include "profile.h"
+#include "read_data.h"
+#include "trace.h"
+#include "write_results.h"
+
+namespace{
+   // Manifest constants.
+   const int SCREEN_NEIGHBORS = 64;     // default screening neighborhood
+
+   // The Status column of a buffered run.
+   enum Status {
+      STATUS_UNFINISHED,
+      STATUS_DONE,
+      STATUS_SCREENED,
+      STATUS_EXACT,
+      STATUS_UNCONVERGED
+   };
+   const char* const STATUS_NAMES[] = { "unfinished", "done", "screened", "exact", "unconverged" };
+
+   //--------------------------------------------------------------------------
+   // The parameters that determine the results, which a checkpoint must share
+   // to be resumed.
+   //--------------------------------------------------------------------------
+   std::string Parameters( double nugget, double sill, double range, double radius, const EngineOptions& options )
+   {
+      std::ostringstream text;
+      text << std::setprecision(17);
+      text << "nugget=" << nugget << " sill=" << sill << " range=" << range << " radius=" << radius;
+      text << " precision=" << options.precision << " neighbors=" << options.neighbors;
+      text << " taper=" << options.taper << " hmatrix=" << options.hmatrix;
+      text << " vecchia=" << options.vecchia << " nystrom=" << options.nystrom;
+      text << " iterative=" << options.iterative << " screen=" << options.screen;
+      return text.str();
+   }
+
+   // The observations of "evaluated" that are still unfinished.
+   std::vector<int> Unfinished( const std::vector<Status>& status, const std::vector<int>& evaluated )
+   {
+      std::vector<int> ks;
+      for (int k : evaluated)
+         if (status[k] == STATUS_UNFINISHED) ks.push_back(k);
+      return ks;
+   }
+
+   //--------------------------------------------------------------------------
+   // SelectTargets
+   //
+   //    The indices, ascending, of the observations selected, or none if the
+   //    selection is empty. Every ID listed must be that of an observation;
+   //    blank lines and comment lines, starting with '!' or '#' as in the
+   //    observation file, are skipped.
+   //--------------------------------------------------------------------------
+   std::vector<int> SelectTargets( const std::vector<DataRecord>& obs, const TargetSelection& selection )
+   {
+      const int N = obs.size();
+      std::vector<char> selected( N, 0 );
+
+      if (!selection.idfilename.empty()) {
+         std::ifstream file( selection.idfilename );
+         if ( file.fail() ) {
+            std::stringstream message;
+            message << "Could not open <" << selection.idfilename << "> for input.";
+            throw InvalidInputFile(message.str());
+         }
+
+         std::unordered_map<std::string, std::vector<int>> index;
+         for (int k = 0; k < N; ++k)
+            index[obs[k].id].push_back(k);
+
+         std::string line;
+         for (int n = 1; std::getline(file, line); ++n) {
+            const std::size_t first = line.find_first_not_of( " \t\r" );
+            if (first == std::string::npos || line[first] == '!' || line[first] == '#')
+               continue;
+            const std::string id = line.substr( first, line.find_last_not_of(" \t\r") + 1 - first );
+
+            auto found = index.find(id);
+            if (found == index.end()) {
+               std::stringstream message;
+               message << "ID " << id << " on line " << n << " of <" << selection.idfilename << "> is not an observation.";
+               throw InvalidInputFile(message.str());
+            }
+            for (int k : found->second)
+               selected[k] = 1;
+         }
+      }
+
+      if (selection.box) {
+         for (int k = 0; k < N; ++k) {
+            const bool inside = selection.xmin <= obs[k].x && obs[k].x <= selection.xmax &&
+                                selection.ymin <= obs[k].y && obs[k].y <= selection.ymax;
+            if (inside) selected[k] = 1;
+         }
+      }
+
+      std::vector<int> targets;
+      for (int k = 0; k < N; ++k)
+         if (selected[k]) targets.push_back(k);
+
+      if (targets.empty() && (selection.box || !selection.idfilename.empty()))
+         throw InvalidInputFile( "No observation is selected as a target." );
+      return targets;
+   }
+
+   //--------------------------------------------------------------------------
+   // RecordQueue
+   //
+   //    A minimal single-producer, single-consumer queue. The consumer takes
+   //    everything that has accumulated in one lock, to keep the locking off
+   //    the per-record path.
+   //--------------------------------------------------------------------------
+   class RecordQueue {
+      public :
+         RecordQueue() : m_mutex(), m_ready(), m_records(), m_closed(false) {
+         }
+
+         void Push( const DataRecord& rec ) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_records.push_back(rec);
+            if (m_records.size() == 1) m_ready.notify_one();
+         }
+
+         void Close() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+            m_ready.notify_one();
+         }
+
+         // Returns false once the queue is closed and drained.
+         bool PopAll( std::deque<DataRecord>& batch ) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_ready.wait( lock, [this]{ return m_closed || !m_records.empty(); } );
+            batch.clear();
+            batch.swap( m_records );
+            return !batch.empty();
+         }
+
+      private :
+         std::mutex              m_mutex;
+         std::condition_variable m_ready;
+         std::deque<DataRecord>  m_records;
+         bool                    m_closed;
+   };
+}
+
+//-----------------------------------------------------------------------------
+// Pipeline
+//
+//    Returns the number of observations processed. Exceptions from any stage
+//    are propagated to the caller, and FailedFactorization is thrown if the
+//    approximation of C that the method needs could not be factored. The
+//    checkpoint file is optional; with "resume", an existing one is
+//    continued rather than replaced.
+//-----------------------------------------------------------------------------
+int Pipeline(
+   double nugget,
+   double sill,
+   double range,
+   double radius,
+   const std::string& inpfilename,
+   const std::string& outfilename,
+   const std::string& checkpointname,
+   bool resume,
+   const TargetSelection& selection,
+   const EngineOptions& options )
+{
+   // Read the observation data on a separate thread.
+   RecordQueue queue;
+   std::exception_ptr failure;
+
+   std::thread reader( [&]() {
+      SetTraceThreadName( "reader" );
+      try {
+         ScopedTimer timer( PHASE_READ );
+         read_data( inpfilename, [&queue](const DataRecord& rec){ queue.Push(rec); } );
+      }
+      catch (...) {
+         failure = std::current_exception();
+      }
+      queue.Close();
+   });
+
+   // Collect the records and their locations as they arrive; the covariances
+   // are filled afterwards, on all of the threads, by Assembly::Finalize.
+   std::vector<DataRecord> obs;
+   Assembly assembly(nugget, sill, range);
+
+   std::deque<DataRecord> batch;
+   while (queue.PopAll(batch)) {
+      for (const auto& rec : batch) {
+         obs.push_back(rec);
+         assembly.Append(rec);
+      }
+   }
+
+   reader.join();
+   if (failure) std::rethrow_exception(failure);
+
+   std::cout << obs.size() << " data records read from <" << inpfilename << ">." << std::endl;
+
+   // The observations to evaluate: the targets selected, or all of them.
+   const int N = obs.size();
+   const std::vector<int> targets = SelectTargets( obs, selection );
+
+   EngineOptions selected = options;
+   selected.targets = targets;
+
+   std::vector<int> evaluated = targets;
+   if (evaluated.empty()) {
+      for (int k = 0; k < N; ++k)
+         evaluated.push_back(k);
+   }
+   const int T = evaluated.size();
+   if (!targets.empty())
+      std::cout << "targets: " << T << " of " << N << " observations selected." << std::endl;
+
+   // Compute, streaming the results to the output file in order. A run that
+   // can stop early, that evaluates out of order, or that was resumed keeps
+   // every result until the end instead, and marks each with its status.
+   const bool stoppable = options.deadline > 0 || options.cancel != nullptr;
+
+   std::unique_ptr<Checkpoint> checkpoint;
+   std::vector<CheckpointEntry> restored;
+   if (!checkpointname.empty()) {
+      checkpoint.reset( new Checkpoint(checkpointname, HashObservations(obs), Parameters(nugget, sill, range, radius, options), N) );
+      if (resume && !checkpoint->Load(restored))
+         std::cout << "resume: no checkpoint <" << checkpointname << ">; starting from the beginning." << std::endl;
+      checkpoint->Open();
+   }
+
+   // An iterative run keeps them too, and writes each with the convergence
+   // of its systems; those that did not converge are marked "unconverged".
+   const bool iterative = options.iterative > 0;
+   const bool buffered = stoppable || options.screen > 0 || options.priority != PRIORITY_INDEX || !restored.empty() || iterative;
+
+   ResultWriter writer( outfilename, stoppable || options.screen > 0 || iterative, iterative );
+
+   const Boomerang unfinished = { NAN, NAN, NAN, NAN, 0 };
+   std::vector<Boomerang> results( buffered ? N : 0, unfinished );
+   std::vector<Status>    status( buffered ? N : 0, STATUS_UNFINISHED );
+   std::vector<int>       iterations( iterative ? N : 0, 0 );
+   std::vector<double>    residual( iterative ? N : 0, NAN );
+   std::vector<char>      solved( iterative ? N : 0, 0 );
+
+   for (const auto& entry : restored) {
+      if (entry.status != STATUS_DONE && entry.status != STATUS_EXACT && entry.status != STATUS_UNCONVERGED)
+         throw InvalidCheckpointFile( "<" + checkpointname + "> has a record of an unknown status." );
+      results[entry.k] = entry.result;
+      status[entry.k]  = static_cast<Status>(entry.status);
+      if (iterative) {
+         iterations[entry.k] = entry.iterations;
+         residual[entry.k]   = entry.residual;
+      }
+   }
+   if (!restored.empty()) {
+      std::cout << "resume: " << T - Unfinished(status, evaluated).size() << " of " << T;
+      std::cout << " observations restored from <" << checkpointname << ">." << std::endl;
+   }
+
+   // The outcome of an iterative system is known before its result reaches
+   // the sink, so the checkpoint records whether it converged, with its
+   // iterations and residual.
+   ResultSink sink = [&](int k, const Boomerang& result){
+      Status done = STATUS_DONE;
+      if (iterative && solved[k] && !(residual[k] <= options.iterative))
+         done = STATUS_UNCONVERGED;
+
+      if (checkpoint) {
+         if (iterative)
+            checkpoint->Append( k, done, result, iterations[k], residual[k] );
+         else
+            checkpoint->Append( k, done, result );
+      }
+      if (buffered) {
+         results[k] = result;
+         status[k]  = done;
+         return;
+      }
+      ScopedTimer timer( PHASE_OUTPUT );
+      writer.Write( obs[k], result, STATUS_NAMES[done] );
+   };
+
+   // A resumed run evaluates only what is left.
+   EngineOptions remaining = selected;
+   if (!restored.empty())
+      remaining.targets = Unfinished( status, evaluated );
+
+   // The dense engine, or, for selected targets, the local one, which forms
+   // nothing of order N^2.
+   const bool local = !targets.empty();
+   Matrix D, C;
+   Locations L;
+   auto finalize = [&]() {
+      if (local)
+         assembly.Finalize(L);
+      else
+         assembly.Finalize(D, C, options.nthreads);
+   };
+   auto dense = [&](const ResultSink& s, const EngineOptions& o) {
+      if (local)
+         Engine( sill, radius, obs, L, s, o );
+      else
+         Engine( sill, radius, obs, D, C, s, o );
+   };
+
+   if (options.screen > 0) {
+      // The screening pass, with the --neighbors (or default) neighborhood,
+      // from the k-d tree of the locations alone. The assembly keeps them
+      // for the dense matrices of the exact pass.
+      if (local) {
+         assembly.Finalize(L);
+      }
+      else {
+         std::vector<double> x(N), y(N);
+         for (int k = 0; k < N; ++k) {
+            x[k] = obs[k].x;
+            y[k] = obs[k].y;
+         }
+         L.Build(x, y, nugget, sill, range);
+      }
+
+      EngineOptions screening = remaining;
+      screening.precision = PRECISION_DOUBLE;
+      screening.neighbors = (options.neighbors > 0) ? options.neighbors : SCREEN_NEIGHBORS;
+      if (restored.empty() || !screening.targets.empty())
+         Engine( sill, radius, obs, L, sink, screening );
+
+      // The exact pass, most suspicious first. An unsolved screening result
+      // is a candidate too; a candidate left unfinished keeps its screening
+      // result.
+      EngineOptions exact = options;
+      exact.neighbors = 0;
+      exact.priority  = PRIORITY_SCORE;
+      exact.score.assign( N, NAN );
+
+      int candidates = 0;
+      int confirmed = 0;
+      for (int k : evaluated) {
+         if (status[k] == STATUS_UNFINISHED) continue;
+
+         if (status[k] == STATUS_EXACT) {
+            ++candidates;
+            ++confirmed;
+         }
+         else if (results[k].pvalue >= options.screen) {
+            status[k] = STATUS_SCREENED;
+         }
+         else {
+            ++candidates;
+            status[k] = STATUS_UNFINISHED;
+            exact.score[k] = results[k].pvalue;
+            exact.targets.push_back(k);
+         }
+      }
+
+      if (!exact.targets.empty()) {
+         if (!local)
+            assembly.Finalize(D, C, options.nthreads);
+         dense( [&](int k, const Boomerang& result){
+            if (checkpoint) checkpoint->Append( k, STATUS_EXACT, result );
+            results[k] = result;
+            status[k]  = STATUS_EXACT;
+            ++confirmed;
+         }, exact );
+      }
+
+      std::ostringstream percent;
+      percent << std::fixed << std::setprecision(1) << 100.0 * candidates / T;
+      std::cout << "screening: " << candidates << " of " << T << " observations (" << percent.str();
+      std::cout << "%) below p = " << options.screen << ", " << confirmed << " confirmed exactly." << std::endl;
+   }
+   else if (!restored.empty() && remaining.targets.empty()) {
+      // Everything was restored.
+   }
+   else if (options.taper > 0) {
+      SparseMatrix C;
+      assembly.Finalize(options.taper, C, options.nthreads);
+      if (!Engine( sill, radius, obs, C, sink, remaining ))
+         throw FailedFactorization( "The tapered covariance matrix could not be factored; it is not numerically positive definite." );
+   }
+   else if (options.hmatrix > 0) {
+      HMatrix C;
+      assembly.Finalize(options.hmatrix, C, options.nthreads);
+      if (!Engine( sill, radius, obs, C, sink, remaining ))
+         throw FailedFactorization( "The H-matrix could not be factored; it is not numerically positive definite. Try a smaller --hmatrix tolerance." );
+   }
+   else if (options.vecchia > 0) {
+      Vecchia V;
+      assembly.Finalize(options.vecchia, V, options.nthreads);
+      if (!Engine( sill, radius, obs, V, sink, remaining ))
+         throw FailedFactorization( "The Vecchia approximation could not be built; a conditioning set is not numerically positive definite." );
+   }
+   else if (options.nystrom > 0) {
+      Nystrom V;
+      assembly.Finalize(options.nystrom, V, options.nthreads);
+      if (!Engine( sill, radius, obs, V, sink, remaining ))
+         throw FailedFactorization( "The Nystrom approximation could not be built; the landmark covariance matrix is not numerically positive definite." );
+   }
+   else if (options.iterative > 0) {
+      remaining.iterative_outcome = [&](const IterativeOutcome& outcome) {
+         iterations[outcome.k] = outcome.iterations;
+         residual[outcome.k]   = outcome.residual;
+         solved[outcome.k]     = 1;
+      };
+
+      CovarianceOperator C;
+      assembly.Finalize(C, options.nthreads);
+      if (!Engine( sill, radius, obs, C, sink, remaining ))
+         throw FailedFactorization( "The preconditioner of the iterative method could not be factored; it is not numerically positive definite." );
+   }
+   else {
+      finalize();
+      dense( sink, remaining );
+   }
+
+   if (checkpoint) checkpoint->Close();
+
+   int done = T;
+   {
+      ScopedTimer timer( PHASE_OUTPUT );
+      if (buffered) {
+         done = 0;
+         for (int k : evaluated) {
+            if (iterative)
+               writer.Write( obs[k], results[k], STATUS_NAMES[status[k]], iterations[k], residual[k] );
+            else
+               writer.Write( obs[k], results[k], STATUS_NAMES[status[k]] );
+            if (status[k] != STATUS_UNFINISHED) ++done;
+         }
+      }
+      writer.Close();
+   }
+
+   if (done < T)
+      std::cout << "stopped early: " << T - done << " of " << T << " observations unfinished." << std::endl;
+
+   return obs.size();
+}
+
+//-----------------------------------------------------------------------------
+TargetSelection::TargetSelection()
+:  idfilename(),
+   box( false ),
+   xmin( 0.0 ),
+   ymin( 0.0 ),
+   xmax( 0.0 ),
+   ymax( 0.0 )
+{
+}
@@ -0,0 +1,58 @@
+//=============================================================================
+// pipeline.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdexcept>
+#include <string>
+
+#include "engine.h"
+
+//-----------------------------------------------------------------------------
+class FailedFactorization : public std::runtime_error {
+   public :
+      FailedFactorization( const std::string& message ) : std::runtime_error(message) {
+      }
+};
+
+//-----------------------------------------------------------------------------
+// TargetSelection
+//
+//    The observations to evaluate, when not all of them: those whose IDs are
+//    listed in a file, one per line, or those within a bounding box. Every
+//    observation remains kriging data either way.
+//-----------------------------------------------------------------------------
+struct TargetSelection {
+   std::string idfilename;              // IDs to evaluate; empty for none.
+   bool        box;                     // evaluate those within the box.
+   double      xmin, ymin, xmax, ymax;
+
+   TargetSelection();
+};
+
+//-----------------------------------------------------------------------------
+int Pipeline(
+   double nugget,
+   double sill,
+   double range,
+   double radius,
+   const std::string& inpfilename,
+   const std::string& outfilename,
+   const std::string& checkpointname,
+   bool resume,
+   const TargetSelection& selection,
+   const EngineOptions& options
+);
+
+
+//=============================================================================
+#endif  // PIPELINE_H
@@ -0,0 +1,322 @@
+//=============================================================================
+// profile.cpp
+//
+//    Lightweight per-phase timing and resource accounting, reported by the
+//    --profile command line option.
+//
+// notes:
+// o  The phase tallies are atomics, so any thread may time any phase. The
+//    wall-clock and CPU seconds of a phase are summed over all threads; with
+//    several worker threads the phase totals may exceed the elapsed time.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#ifdef _WIN32
+   #include <windows.h>
+   #include <psapi.h>
+#else
+   #include <sys/resource.h>
+   #include <time.h>
+   #include <unistd.h>
+#endif
+
+#include "profile.h"
+#include "trace.h"
+
+namespace{
+   struct PhaseTally {
+      std::atomic<long long> calls;
+      std::atomic<long long> wall_ns;
+      std::atomic<long long> cpu_ns;
+      std::atomic<unsigned long long> counter[NUMBER_OF_COUNTERS];
+   };
+
+   std::atomic<bool> g_enabled(false);
+   PhaseTally g_tally[NUMBER_OF_PHASES];
+
+   std::atomic<long long> g_matrix_count(0);
+   std::atomic<long long> g_matrix_bytes(0);
+
+   const double g_start = WallSeconds();
+
+   const char* PHASE_NAMES[NUMBER_OF_PHASES] = {
+      "read",
+      "assembly",
+      "slice",
+      "factorization",
+      "solve",
+      "pvalue",
+      "output"
+   };
+
+   long long ToNanoseconds( double seconds ) {
+      return static_cast<long long>( seconds*1e9 + 0.5 );
+   }
+
+#ifdef _WIN32
+   double FileTimeSeconds( const FILETIME& ft ) {
+      ULARGE_INTEGER t;
+      t.LowPart  = ft.dwLowDateTime;
+      t.HighPart = ft.dwHighDateTime;
+      return static_cast<double>(t.QuadPart) * 1e-7;
+   }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+const char* PhaseName( ProfilePhase phase )
+{
+   return PHASE_NAMES[phase];
+}
+
+//=============================================================================
+// ScopedTimer
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+// When tracing is enabled, each timed phase is also recorded as a trace span.
+//-----------------------------------------------------------------------------
+ScopedTimer::ScopedTimer( ProfilePhase phase )
+:  m_phase( phase ),
+   m_profile( g_enabled.load(std::memory_order_relaxed) ),
+   m_trace( TracingEnabled() ),
+   m_counted( false ),
+   m_wall( 0.0 ),
+   m_cpu( 0.0 ),
+   m_counters()
+{
+   if (m_profile || m_trace) m_wall = WallSeconds();
+   if (m_profile) {
+      m_cpu = ThreadCpuSeconds();
+      m_counted = ReadCounters( m_counters );
+   }
+}
+
+//-----------------------------------------------------------------------------
+ScopedTimer::~ScopedTimer()
+{
+   if (m_profile || m_trace) {
+      double end = WallSeconds();
+
+      if (m_profile) {
+         PhaseTally& tally = g_tally[m_phase];
+         tally.cpu_ns.fetch_add( ToNanoseconds(ThreadCpuSeconds() - m_cpu), std::memory_order_relaxed );
+         tally.wall_ns.fetch_add( ToNanoseconds(end - m_wall), std::memory_order_relaxed );
+         tally.calls.fetch_add( 1, std::memory_order_relaxed );
+
+         CounterSample counters;
+         if ( m_counted && ReadCounters(counters) ) {
+            for (int c = 0; c < NUMBER_OF_COUNTERS; ++c)
+               tally.counter[c].fetch_add( counters.value[c] - m_counters.value[c], std::memory_order_relaxed );
+         }
+      }
+
+      if (m_trace) TraceEvent( PHASE_NAMES[m_phase], m_wall, end );
+   }
+}
+
+//-----------------------------------------------------------------------------
+void EnableProfiling( bool flag )
+{
+   g_enabled = flag;
+}
+
+//-----------------------------------------------------------------------------
+bool ProfilingEnabled()
+{
+   return g_enabled;
+}
+
+//-----------------------------------------------------------------------------
+// WriteProfile
+//
+//    Write the accumulated profile to the specified file as JSON.
+//-----------------------------------------------------------------------------
+void WriteProfile( const std::string& filename, int nthreads )
+{
+   std::ofstream out( filename );
+   if ( out.fail() ) {
+      std::stringstream message;
+      message << "Could not open <" << filename << "> for output.";
+      throw InvalidProfileFile(message.str());
+   }
+
+   out << std::setprecision(9);
+   out << "{\n";
+   out << "   \"wall_seconds\": " << WallSeconds() - g_start << ",\n";
+   out << "   \"cpu_seconds\": " << ProcessCpuSeconds() << ",\n";
+   out << "   \"threads\": " << nthreads << ",\n";
+   out << "   \"peak_rss_bytes\": " << PeakResidentBytes() << ",\n";
+   out << "   \"matrix_allocations\": { \"count\": " << MatrixAllocationCount()
+       << ", \"bytes\": " << MatrixAllocationBytes() << " },\n";
+   out << "   \"hardware_counters\": " << (CountersEnabled() ? "true" : "false") << ",\n";
+   out << "   \"phases\": [\n";
+
+   for (int p = 0; p < NUMBER_OF_PHASES; ++p) {
+      const PhaseTally& tally = g_tally[p];
+      out << "      { \"name\": \"" << PHASE_NAMES[p] << "\""
+          << ", \"calls\": " << tally.calls.load()
+          << ", \"wall_seconds\": " << tally.wall_ns.load()*1e-9
+          << ", \"cpu_seconds\": " << tally.cpu_ns.load()*1e-9;
+
+      if ( CountersEnabled() ) {
+         for (int c = 0; c < NUMBER_OF_COUNTERS; ++c)
+            out << ", \"" << CounterName(c) << "\": " << tally.counter[c].load();
+
+         // Instructions per cycle, and last-level cache misses per thousand
+         // instructions: a high MPKI with a low IPC suggests bandwidth-bound.
+         double cycles = static_cast<double>( tally.counter[COUNTER_CYCLES].load() );
+         double instructions = static_cast<double>( tally.counter[COUNTER_INSTRUCTIONS].load() );
+         double misses = static_cast<double>( tally.counter[COUNTER_LLC_MISSES].load() );
+
+         out << ", \"ipc\": " << (cycles > 0 ? instructions/cycles : 0.0)
+             << ", \"llc_mpki\": " << (instructions > 0 ? 1000.0*misses/instructions : 0.0);
+      }
+      out << " }" << (p+1 < NUMBER_OF_PHASES ? "," : "") << "\n";
+   }
+
+   out << "   ]\n";
+   out << "}\n";
+
+   out.close();
+   if ( out.fail() ) {
+      std::stringstream message;
+      message << "Writing to <" << filename << "> failed.";
+      throw InvalidProfileFile(message.str());
+   }
+}
+
+//=============================================================================
+// Clocks and resource usage.
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+double WallSeconds()
+{
+   typedef std::chrono::steady_clock clock;
+   return std::chrono::duration<double>( clock::now().time_since_epoch() ).count();
+}
+
+//-----------------------------------------------------------------------------
+double ThreadCpuSeconds()
+{
+#ifdef _WIN32
+   FILETIME creation, exit, kernel, user;
+   if ( GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user) )
+      return FileTimeSeconds(kernel) + FileTimeSeconds(user);
+   return 0.0;
+#else
+   struct timespec ts;
+   if ( clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0 )
+      return ts.tv_sec + ts.tv_nsec*1e-9;
+   return 0.0;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+double ProcessCpuSeconds()
+{
+#ifdef _WIN32
+   FILETIME creation, exit, kernel, user;
+   if ( GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user) )
+      return FileTimeSeconds(kernel) + FileTimeSeconds(user);
+   return 0.0;
+#else
+   struct timespec ts;
+   if ( clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) == 0 )
+      return ts.tv_sec + ts.tv_nsec*1e-9;
+   return static_cast<double>(clock())/CLOCKS_PER_SEC;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+std::size_t PeakResidentBytes()
+{
+#ifdef _WIN32
+   PROCESS_MEMORY_COUNTERS pmc;
+   if ( GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)) )
+      return pmc.PeakWorkingSetSize;
+   return 0;
+#else
+   struct rusage usage;
+   if ( getrusage(RUSAGE_SELF, &usage) == 0 ) {
+   #ifdef __APPLE__
+      return usage.ru_maxrss;                      // bytes
+   #else
+      return static_cast<std::size_t>(usage.ru_maxrss) * 1024;   // kilobytes
+   #endif
+   }
+   return 0;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// AvailableBytes
+//
+//    The physical memory that can be allocated without swapping: on Linux
+//    MemAvailable, which counts the reclaimable page cache, rather than the
+//    free pages alone.
+//-----------------------------------------------------------------------------
+std::size_t AvailableBytes()
+{
+#ifdef _WIN32
+   MEMORYSTATUSEX status;
+   status.dwLength = sizeof(status);
+   if ( GlobalMemoryStatusEx(&status) )
+      return static_cast<std::size_t>(status.ullAvailPhys);
+   return 0;
+#else
+   std::ifstream meminfo( "/proc/meminfo" );
+   std::string key;
+   unsigned long long kilobytes;
+   while ( meminfo >> key >> kilobytes ) {
+      if ( key == "MemAvailable:" )
+         return static_cast<std::size_t>(kilobytes) * 1024;
+      meminfo.ignore( 256, '\n' );
+   }
+
+   #ifdef _SC_AVPHYS_PAGES
+   const long pages = sysconf( _SC_AVPHYS_PAGES );
+   const long size  = sysconf( _SC_PAGESIZE );
+   if ( pages > 0 && size > 0 )
+      return static_cast<std::size_t>(pages) * static_cast<std::size_t>(size);
+   #endif
+   return 0;
+#endif
+}
+
+//=============================================================================
+// Matrix allocation counters.
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+void CountMatrixAllocation( std::size_t bytes )
+{
+   g_matrix_count.fetch_add( 1, std::memory_order_relaxed );
+   g_matrix_bytes.fetch_add( bytes, std::memory_order_relaxed );
+}
+
+//-----------------------------------------------------------------------------
+long long MatrixAllocationCount()
+{
+   return g_matrix_count.load();
+}
+
+//-----------------------------------------------------------------------------
+long long MatrixAllocationBytes()
+{
+   return g_matrix_bytes.load();
+}
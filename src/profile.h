@@ -0,0 +1,95 @@
+//=============================================================================
+// profile.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include "perf_counters.h"
+
+//-----------------------------------------------------------------------------
+class InvalidProfileFile : public std::runtime_error {
+   public :
+      InvalidProfileFile( const std::string& message ) : std::runtime_error(message) {
+      }
+};
+
+//-----------------------------------------------------------------------------
+// The instrumented phases of a run.
+//-----------------------------------------------------------------------------
+enum ProfilePhase {
+   PHASE_READ,                   // parsing the input file
+   PHASE_ASSEMBLY,               // distance and covariance assembly
+   PHASE_SLICE,                  // slicing out the active kriging system
+   PHASE_FACTORIZATION,          // Cholesky factorization
+   PHASE_SOLVE,                  // Cholesky forward and back substitution
+   PHASE_PVALUE,                 // p-value computation
+   PHASE_OUTPUT,                 // writing the output file
+   NUMBER_OF_PHASES
+};
+
+const char* PhaseName( ProfilePhase phase );
+
+//-----------------------------------------------------------------------------
+// ScopedTimer
+//
+//    Accumulates the wall-clock time, the CPU time of the calling thread, and
+//    the call count of a phase from construction to destruction, and the
+//    hardware counters of the calling thread when they are enabled. When
+//    both profiling and tracing are disabled a ScopedTimer costs two flag
+//    tests.
+//-----------------------------------------------------------------------------
+class ScopedTimer {
+   public :
+      explicit ScopedTimer( ProfilePhase phase );
+      ~ScopedTimer();
+
+      ScopedTimer( const ScopedTimer& ) = delete;
+      ScopedTimer& operator=( const ScopedTimer& ) = delete;
+
+   private :
+      ProfilePhase m_phase;
+      bool         m_profile;
+      bool         m_trace;
+      bool         m_counted;
+      double       m_wall;
+      double       m_cpu;
+      CounterSample m_counters;
+};
+
+//-----------------------------------------------------------------------------
+void EnableProfiling( bool flag );
+bool ProfilingEnabled();
+
+void WriteProfile( const std::string& filename, int nthreads );
+
+//-----------------------------------------------------------------------------
+// Clocks and resource usage.
+//-----------------------------------------------------------------------------
+double WallSeconds();            // monotonic wall clock
+double ThreadCpuSeconds();       // CPU time consumed by the calling thread
+double ProcessCpuSeconds();      // CPU time consumed by all threads
+std::size_t PeakResidentBytes(); // peak resident set size; 0 if unknown
+std::size_t AvailableBytes();    // physical memory available now; 0 if unknown
+
+//-----------------------------------------------------------------------------
+// Matrix allocation counters. These are always maintained.
+//-----------------------------------------------------------------------------
+void CountMatrixAllocation( std::size_t bytes );
+long long MatrixAllocationCount();
+long long MatrixAllocationBytes();
+
+
+//=============================================================================
+#endif  // PROFILE_H
@@ -0,0 +1,129 @@
+//=============================================================================
+// progress.cpp
+//
+//    Periodic progress reports, with throughput and ETA, for long runs.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+#include "profile.h"
+#include "progress.h"
+
+//-----------------------------------------------------------------------------
+// Progress
+//
+// Arguments:
+//    expected    the expected active-set size M for each observation.
+//    interval    the minimum number of seconds between reports.
+//    callback    invoked with each report.
+//-----------------------------------------------------------------------------
+Progress::Progress( const std::vector<int>& expected, double interval, const ProgressCallback& callback )
+:  m_total( expected.size() ),
+   m_interval( interval ),
+   m_callback( callback ),
+   m_start( WallSeconds() ),
+   m_expected( expected ),
+   m_total_cost( 0.0 ),
+   m_done( 0 ),
+   m_sum_active( 0 ),
+   m_done_cost( 0.0 ),
+   m_next_report( m_start + interval )
+{
+   for (int M : m_expected)
+      m_total_cost += Cost(M);
+}
+
+//-----------------------------------------------------------------------------
+// Record the completion of observation [k] with active-set size M.
+//-----------------------------------------------------------------------------
+void Progress::Complete( int k, int M )
+{
+   m_sum_active.fetch_add( M, std::memory_order_relaxed );
+
+   // std::atomic<double> has no fetch_add before C++20.
+   double cost = Cost( m_expected[k] );
+   double old  = m_done_cost.load( std::memory_order_relaxed );
+   while ( !m_done_cost.compare_exchange_weak(old, old + cost, std::memory_order_relaxed) ) {
+   }
+
+   int done = m_done.fetch_add( 1, std::memory_order_acq_rel ) + 1;
+
+   if ( !m_callback ) return;
+
+   // Claim the report by advancing the deadline; only one thread succeeds.
+   double now = WallSeconds();
+   double deadline = m_next_report.load( std::memory_order_relaxed );
+
+   if ( done == m_total ||
+        (now >= deadline && m_next_report.compare_exchange_strong(deadline, now + m_interval)) )
+      m_callback( Report() );
+}
+
+//-----------------------------------------------------------------------------
+ProgressReport Progress::Report() const
+{
+   ProgressReport report;
+
+   report.done    = m_done.load();
+   report.total   = m_total;
+   report.elapsed = WallSeconds() - m_start;
+   report.rate    = (report.elapsed > 0) ? report.done / report.elapsed : 0.0;
+
+   report.mean_active = (report.done > 0) ? static_cast<double>(m_sum_active.load()) / report.done : 0.0;
+
+   double done_cost = m_done_cost.load();
+   if (report.done == report.total)
+      report.eta = 0.0;
+   else if (done_cost > 0)
+      report.eta = report.elapsed * (m_total_cost - done_cost) / done_cost;
+   else
+      report.eta = NAN;
+
+   return report;
+}
+
+//-----------------------------------------------------------------------------
+// The expected cost of an observation with active-set size M, in arbitrary
+// units: the factorization is M^3/3 flops and finding the active set is N.
+//-----------------------------------------------------------------------------
+double Progress::Cost( int M ) const
+{
+   return static_cast<double>(M)*M*M/3.0 + m_total;
+}
+
+//-----------------------------------------------------------------------------
+// FormatProgress
+//
+//    e.g. "progress: 1200/50000 (2.4%), 3.10 obs/s, mean M = 43211, ETA 4h 12m 3s"
+//-----------------------------------------------------------------------------
+std::string FormatProgress( const ProgressReport& report )
+{
+   std::ostringstream out;
+
+   out << "progress: " << report.done << '/' << report.total;
+   out << std::fixed << std::setprecision(1) << " (" << 100.0*report.done/std::max(report.total,1) << "%), ";
+   out << std::setprecision(2) << report.rate << " obs/s, ";
+   out << std::setprecision(0) << "mean M = " << report.mean_active << ", ETA ";
+
+   if ( std::isnan(report.eta) ) {
+      out << "unknown";
+   }
+   else {
+      long long s = static_cast<long long>( report.eta + 0.5 );
+      if (s >= 3600) out << s/3600 << "h ";
+      if (s >= 60)   out << (s/60)%60 << "m ";
+      out << s%60 << 's';
+   }
+
+   return out.str();
+}
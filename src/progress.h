@@ -0,0 +1,77 @@
+//=============================================================================
+// progress.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+struct ProgressReport {
+   int    done;                  // observations completed
+   int    total;                 // observations in the run
+   double elapsed;               // seconds since the engine started
+   double rate;                  // observations per second
+   double mean_active;           // mean active-set size M of those completed
+   double eta;                   // estimated seconds remaining
+};
+
+typedef std::function<void(const ProgressReport& report)> ProgressCallback;
+
+std::string FormatProgress( const ProgressReport& report );
+
+//-----------------------------------------------------------------------------
+// Progress
+//
+//    Thread-safe progress accounting for the engine loop. Complete is called
+//    by the worker threads once per observation and uses only atomics. The
+//    worker that first notices that the reporting interval has elapsed
+//    invokes the callback, so the callback runs on a worker thread and must
+//    be thread-safe.
+//
+//    The ETA uses an M^3 cost model: the expected cost of each observation
+//    is proportional to the cube of its active-set size (the Cholesky
+//    factorization) plus N (finding the active set). The remaining time is
+//    the elapsed time scaled by the ratio of the remaining to completed cost.
+//-----------------------------------------------------------------------------
+class Progress {
+   public :
+      Progress( const std::vector<int>& expected, double interval, const ProgressCallback& callback );
+
+      void Complete( int k, int M );
+      ProgressReport Report() const;
+
+      Progress( const Progress& ) = delete;
+      Progress& operator=( const Progress& ) = delete;
+
+   private :
+      double Cost( int M ) const;
+
+      const int              m_total;
+      const double           m_interval;
+      const ProgressCallback m_callback;
+      const double           m_start;
+
+      std::vector<int>       m_expected;      // expected M for each observation
+      double                 m_total_cost;
+
+      std::atomic<int>       m_done;
+      std::atomic<long long> m_sum_active;
+      std::atomic<double>    m_done_cost;
+      std::atomic<double>    m_next_report;
+};
+
+
+//=============================================================================
+#endif  // PROGRESS_H
@@ -27,6 +27,16 @@
 //-----------------------------------------------------------------------------
 std::vector<DataRecord> read_data( const std::string& inpfilename ) {
    std::vector<DataRecord> obs;
+   read_data( inpfilename, [&obs](const DataRecord& s){ obs.push_back(s); } );
+   return obs;
+}
+
+//-----------------------------------------------------------------------------
+// Streaming version: each record is handed to the sink as soon as it has been
+// parsed, so downstream work can overlap the reading of the file.
+//-----------------------------------------------------------------------------
+void read_data( const std::string& inpfilename, const std::function<void(const DataRecord&)>& sink ) {
+   int nrecords = 0;
 
    try {
       io::CSVReader<4,
@@ -40,7 +50,8 @@ std::vector<DataRecord> read_data( const std::string& inpfilename ) {
 
       while (in.read_row(id,X,Y,Z)){
          DataRecord s = { id, X, Y, Z };
-         obs.push_back(s);
+         sink(s);
+         ++nrecords;
       }
    }
    catch (io::error::can_not_open_file& e) {
@@ -50,9 +61,7 @@ std::vector<DataRecord> read_data( const std::string& inpfilename ) {
    }
    catch (...) {
       std::stringstream message;
-      message << "Reading the observation data failed on line " << obs.size()+1 << " of file " << inpfilename << ".";
+      message << "Reading the observation data failed on line " << nrecords+1 << " of file " << inpfilename << ".";
       throw InvalidDataRecord(message.str());
    }
-
-   return obs;
 }
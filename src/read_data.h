@@ -12,6 +12,7 @@
 #ifndef READ_DATA_H
 #define READ_DATA_H
 
+#include <functional>
 #include <stdexcept>
 #include <string>
 #include <tuple>
@@ -39,6 +40,7 @@ struct DataRecord{
 };
 
 std::vector<DataRecord> read_data( const std::string& inpfilename );
+void read_data( const std::string& inpfilename, const std::function<void(const DataRecord&)>& sink );
 
 
 //=============================================================================
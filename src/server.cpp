@@ -0,0 +1,764 @@
+//=============================================================================
+// server.cpp
+//
+// notes:
+// o  The JSON parser accepts the whole of RFC 8259, but keeps only what the
+//    requests need: every number as a double, along with its text.
+//
+// o  The requests of all of the clients go into one queue, served by a fixed
+//    set of threads, so that concurrent requests share the processors
+//    rather than each starting its own workers.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+#ifndef _WIN32
+   #include <csignal>
+   #include <sys/socket.h>
+   #include <sys/un.h>
+   #include <unistd.h>
+#endif
+
+#include "numerical_constants.h"
+#include "profile.h"
+#include "server.h"
+#include "trace.h"
+
+namespace{
+   //--------------------------------------------------------------------------
+   class InvalidRequest : public std::runtime_error {
+      public :
+         InvalidRequest( const std::string& message ) : std::runtime_error(message) {
+         }
+   };
+
+   //--------------------------------------------------------------------------
+   // JsonValue
+   //--------------------------------------------------------------------------
+   struct JsonValue {
+      enum Type { JSON_NULL, JSON_BOOLEAN, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT };
+
+      Type        type;
+      bool        boolean;
+      double      number;
+      std::string text;                 // of a string, or of a number as written
+      std::vector<JsonValue> items;
+      std::vector<std::pair<std::string, JsonValue>> members;
+
+      JsonValue() : type(JSON_NULL), boolean(false), number(0.0), text(), items(), members() {
+      }
+
+      // The member named "key" of an object, or null if there is none.
+      const JsonValue* Find( const std::string& key ) const {
+         for (const auto& member : members)
+            if (member.first == key) return &member.second;
+         return nullptr;
+      }
+   };
+
+   //--------------------------------------------------------------------------
+   // JsonParser
+   //
+   //    A recursive-descent parser of one JSON text. Throws InvalidRequest.
+   //--------------------------------------------------------------------------
+   class JsonParser {
+      public :
+         explicit JsonParser( const std::string& text ) : m_text(text), m_pos(0) {
+         }
+
+         JsonValue Parse() {
+            JsonValue value = Value(0);
+            Space();
+            if (m_pos != m_text.size()) Fail("unexpected text after the value");
+            return value;
+         }
+
+      private :
+         static const int MAX_DEPTH = 64;
+
+         void Fail( const char* what ) const {
+            std::stringstream message;
+            message << "invalid JSON at character " << m_pos + 1 << ": " << what;
+            throw InvalidRequest(message.str());
+         }
+
+         void Space() {
+            while (m_pos < m_text.size() && (m_text[m_pos] == ' ' || m_text[m_pos] == '\t' || m_text[m_pos] == '\r' || m_text[m_pos] == '\n'))
+               ++m_pos;
+         }
+
+         bool Next( char c ) {
+            Space();
+            if (m_pos < m_text.size() && m_text[m_pos] == c) {
+               ++m_pos;
+               return true;
+            }
+            return false;
+         }
+
+         void Expect( char c, const char* what ) {
+            if (!Next(c)) Fail(what);
+         }
+
+         bool Literal( const char* word ) {
+            const std::size_t n = strlen(word);
+            if (m_text.compare(m_pos, n, word) != 0) return false;
+            m_pos += n;
+            return true;
+         }
+
+         JsonValue Value( int depth ) {
+            if (depth > MAX_DEPTH) Fail("nested too deeply");
+            Space();
+            if (m_pos >= m_text.size()) Fail("a value is missing");
+
+            JsonValue value;
+            const char c = m_text[m_pos];
+            if (c == '{') {
+               ++m_pos;
+               value.type = JsonValue::JSON_OBJECT;
+               if (Next('}')) return value;
+               do {
+                  Space();
+                  if (m_pos >= m_text.size() || m_text[m_pos] != '"') Fail("a member name is missing");
+                  std::string key = String();
+                  Expect(':', "':' is missing");
+                  value.members.push_back( std::make_pair(key, Value(depth+1)) );
+               } while (Next(','));
+               Expect('}', "'}' is missing");
+            }
+            else if (c == '[') {
+               ++m_pos;
+               value.type = JsonValue::JSON_ARRAY;
+               if (Next(']')) return value;
+               do {
+                  value.items.push_back( Value(depth+1) );
+               } while (Next(','));
+               Expect(']', "']' is missing");
+            }
+            else if (c == '"') {
+               value.type = JsonValue::JSON_STRING;
+               value.text = String();
+            }
+            else if (Literal("true")) {
+               value.type = JsonValue::JSON_BOOLEAN;
+               value.boolean = true;
+            }
+            else if (Literal("false")) {
+               value.type = JsonValue::JSON_BOOLEAN;
+            }
+            else if (Literal("null")) {
+            }
+            else {
+               value.type = JsonValue::JSON_NUMBER;
+               Number(value);
+            }
+            return value;
+         }
+
+         void Number( JsonValue& value ) {
+            const std::size_t begin = m_pos;
+            auto digits = [this]() {
+               const std::size_t start = m_pos;
+               while (m_pos < m_text.size() && isdigit(static_cast<unsigned char>(m_text[m_pos]))) ++m_pos;
+               return m_pos > start;
+            };
+
+            if (m_pos < m_text.size() && m_text[m_pos] == '-') ++m_pos;
+            if (m_pos < m_text.size() && m_text[m_pos] == '0')
+               ++m_pos;
+            else if (!digits())
+               Fail("a value is not valid");
+            if (m_pos < m_text.size() && m_text[m_pos] == '.') {
+               ++m_pos;
+               if (!digits()) Fail("a number is not valid");
+            }
+            if (m_pos < m_text.size() && (m_text[m_pos] == 'e' || m_text[m_pos] == 'E')) {
+               ++m_pos;
+               if (m_pos < m_text.size() && (m_text[m_pos] == '+' || m_text[m_pos] == '-')) ++m_pos;
+               if (!digits()) Fail("a number is not valid");
+            }
+
+            value.text   = m_text.substr(begin, m_pos - begin);
+            value.number = strtod(value.text.c_str(), nullptr);
+         }
+
+         unsigned Hex4() {
+            if (m_pos + 4 > m_text.size()) Fail("a \\u escape is cut short");
+            unsigned code = 0;
+            for (int i = 0; i < 4; ++i) {
+               const char h = m_text[m_pos++];
+               code <<= 4;
+               if      (h >= '0' && h <= '9') code |= h - '0';
+               else if (h >= 'a' && h <= 'f') code |= h - 'a' + 10;
+               else if (h >= 'A' && h <= 'F') code |= h - 'A' + 10;
+               else Fail("a \\u escape is not valid");
+            }
+            return code;
+         }
+
+         static void Utf8( unsigned code, std::string& out ) {
+            if (code < 0x80) {
+               out += static_cast<char>(code);
+            }
+            else if (code < 0x800) {
+               out += static_cast<char>(0xC0 | (code >> 6));
+               out += static_cast<char>(0x80 | (code & 0x3F));
+            }
+            else if (code < 0x10000) {
+               out += static_cast<char>(0xE0 | (code >> 12));
+               out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+               out += static_cast<char>(0x80 | (code & 0x3F));
+            }
+            else {
+               out += static_cast<char>(0xF0 | (code >> 18));
+               out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+               out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+               out += static_cast<char>(0x80 | (code & 0x3F));
+            }
+         }
+
+         std::string String() {
+            ++m_pos;                    // the opening quote
+            std::string out;
+            for (;;) {
+               if (m_pos >= m_text.size()) Fail("a string is not closed");
+               const char c = m_text[m_pos++];
+               if (c == '"') return out;
+               if (static_cast<unsigned char>(c) < 0x20) Fail("a string holds a control character");
+               if (c != '\\') {
+                  out += c;
+                  continue;
+               }
+
+               if (m_pos >= m_text.size()) Fail("a string is not closed");
+               const char e = m_text[m_pos++];
+               switch (e) {
+                  case '"':  out += '"';  break;
+                  case '\\': out += '\\'; break;
+                  case '/':  out += '/';  break;
+                  case 'b':  out += '\b'; break;
+                  case 'f':  out += '\f'; break;
+                  case 'n':  out += '\n'; break;
+                  case 'r':  out += '\r'; break;
+                  case 't':  out += '\t'; break;
+                  case 'u': {
+                     unsigned code = Hex4();
+                     if (code >= 0xD800 && code < 0xDC00 && m_text.compare(m_pos, 2, "\\u") == 0) {
+                        m_pos += 2;
+                        const unsigned low = Hex4();
+                        if (low < 0xDC00 || low >= 0xE000) Fail("a surrogate pair is not valid");
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                     }
+                     Utf8(code, out);
+                     break;
+                  }
+                  default:
+                     Fail("an escape is not valid");
+               }
+            }
+         }
+
+         const std::string& m_text;
+         std::size_t        m_pos;
+   };
+
+   //--------------------------------------------------------------------------
+   // Output
+   //--------------------------------------------------------------------------
+   std::string Quote( const std::string& text )
+   {
+      std::ostringstream out;
+      out << '"';
+      for (char c : text) {
+         if (c == '"' || c == '\\')
+            out << '\\' << c;
+         else if (static_cast<unsigned char>(c) < 0x20)
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+         else
+            out << c;
+      }
+      out << '"';
+      return out.str();
+   }
+
+   // A number as JSON: null if it has no value.
+   void Write( std::ostream& out, double x )
+   {
+      if (std::isfinite(x))
+         out << x;
+      else
+         out << "null";
+   }
+
+   void Write( std::ostream& out, const Boomerang& result )
+   {
+      out << "\"count\":" << result.cnt;
+      out << ",\"zhat\":";   Write(out, result.zhat);
+      out << ",\"kstd\":";   Write(out, result.kstd);
+      out << ",\"zeta\":";   Write(out, result.zeta);
+      out << ",\"pvalue\":"; Write(out, result.pvalue);
+   }
+
+   //--------------------------------------------------------------------------
+   // A parameter of a request: the number given, or the fallback if none is.
+   //--------------------------------------------------------------------------
+   double Parameter( const JsonValue& request, const char* key, double fallback )
+   {
+      const JsonValue* value = request.Find(key);
+      if (value == nullptr) return fallback;
+      if (value->type != JsonValue::JSON_NUMBER) {
+         std::stringstream message;
+         message << "\"" << key << "\" is not a number";
+         throw InvalidRequest(message.str());
+      }
+      return value->number;
+   }
+
+   //--------------------------------------------------------------------------
+   // Channel
+   //
+   //    Where the responses to the requests of one client go. Each response
+   //    is written whole, even when several threads answer the client at
+   //    once.
+   //--------------------------------------------------------------------------
+   class Channel {
+      public :
+         virtual ~Channel() {}
+         virtual void Reply( const std::string& line ) = 0;
+   };
+
+   class StdoutChannel : public Channel {
+      public :
+         StdoutChannel() : m_mutex() {
+         }
+
+         void Reply( const std::string& line ) override {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            fwrite( line.data(), 1, line.size(), stdout );
+            fputc( '\n', stdout );
+            fflush( stdout );
+         }
+
+      private :
+         std::mutex m_mutex;
+   };
+
+   //--------------------------------------------------------------------------
+   // RequestQueue
+   //--------------------------------------------------------------------------
+   struct Request {
+      std::string line;
+      std::shared_ptr<Channel> channel;
+
+      Request() : line(), channel() {
+      }
+
+      Request( const std::string& line_, const std::shared_ptr<Channel>& channel_ ) : line(line_), channel(channel_) {
+      }
+   };
+
+   class RequestQueue {
+      public :
+         RequestQueue() : m_mutex(), m_ready(), m_requests(), m_closed(false) {
+         }
+
+         void Push( const std::string& line, const std::shared_ptr<Channel>& channel ) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_requests.push_back( Request{line, channel} );
+            m_ready.notify_one();
+         }
+
+         void Close() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+            m_ready.notify_all();
+         }
+
+         // Returns false once the queue is closed and drained.
+         bool Pop( Request& request ) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_ready.wait( lock, [this]{ return m_closed || !m_requests.empty(); } );
+            if (m_requests.empty()) return false;
+            request = std::move( m_requests.front() );
+            m_requests.pop_front();
+            return true;
+         }
+
+      private :
+         std::mutex              m_mutex;
+         std::condition_variable m_ready;
+         std::deque<Request>     m_requests;
+         bool                    m_closed;
+   };
+
+   // Queue a line, unless it is blank; a line may end with "\r\n".
+   void Enqueue( std::string line, const std::shared_ptr<Channel>& channel, RequestQueue& queue )
+   {
+      if (!line.empty() && line.back() == '\r') line.pop_back();
+      if (line.find_first_not_of(" \t") != std::string::npos)
+         queue.Push( line, channel );
+   }
+
+#ifndef _WIN32
+   //--------------------------------------------------------------------------
+   // SocketChannel
+   //
+   //    A client of the Unix-domain socket. The connection is closed once the
+   //    client has hung up and its last request has been answered.
+   //--------------------------------------------------------------------------
+   class SocketChannel : public Channel {
+      public :
+         explicit SocketChannel( int fd ) : m_fd(fd), m_mutex() {
+         }
+
+         ~SocketChannel() {
+            close( m_fd );
+         }
+
+         void Reply( const std::string& line ) override {
+            const std::string text = line + '\n';
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            const char* p = text.data();
+            std::size_t left = text.size();
+            while (left > 0) {
+               const ssize_t n = send( m_fd, p, left, 0 );
+               if (n < 0 && errno == EINTR) continue;
+               if (n <= 0) return;      // the client is gone
+               p += n;
+               left -= n;
+            }
+         }
+
+         int Descriptor() const {
+            return m_fd;
+         }
+
+      private :
+         int        m_fd;
+         std::mutex m_mutex;
+   };
+
+   //--------------------------------------------------------------------------
+   // Listen
+   //
+   //    Accept the clients of the socket, each read on a thread of its own,
+   //    until accept fails.
+   //--------------------------------------------------------------------------
+   void Listen( const std::string& socketname, const std::shared_ptr<RequestQueue>& queue )
+   {
+      sockaddr_un address;
+      memset( &address, 0, sizeof(address) );
+      address.sun_family = AF_UNIX;
+      if (socketname.size() >= sizeof(address.sun_path)) {
+         std::stringstream message;
+         message << "The socket name <" << socketname << "> is too long.";
+         throw InvalidSocket(message.str());
+      }
+      strncpy( address.sun_path, socketname.c_str(), sizeof(address.sun_path) - 1 );
+
+      const int fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+      unlink( socketname.c_str() );
+      if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(fd, SOMAXCONN) < 0) {
+         std::stringstream message;
+         message << "Could not listen on <" << socketname << ">: " << strerror(errno) << ".";
+         if (fd >= 0) close( fd );
+         throw InvalidSocket(message.str());
+      }
+
+      // A client that hangs up early must not end the server.
+      signal( SIGPIPE, SIG_IGN );
+      std::cerr << "listening on <" << socketname << ">." << std::endl;
+
+      for (;;) {
+         const int client = accept( fd, nullptr, nullptr );
+         if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            std::stringstream message;
+            message << "Accepting a client of <" << socketname << "> failed: " << strerror(errno) << ".";
+            close( fd );
+            throw InvalidSocket(message.str());
+         }
+
+         std::shared_ptr<SocketChannel> channel = std::make_shared<SocketChannel>(client);
+         std::thread( [channel, queue]() {
+            SetTraceThreadName( "client" );
+            char buffer[4096];
+            std::string pending;
+            for (;;) {
+               const ssize_t n = recv( channel->Descriptor(), buffer, sizeof(buffer), 0 );
+               if (n < 0 && errno == EINTR) continue;
+               if (n <= 0) break;
+
+               pending.append( buffer, n );
+               std::size_t begin = 0;
+               for (std::size_t end; (end = pending.find('\n', begin)) != std::string::npos; begin = end + 1)
+                  Enqueue( pending.substr(begin, end - begin), channel, *queue );
+               pending.erase( 0, begin );
+            }
+            Enqueue( pending, channel, *queue );
+         }).detach();
+      }
+   }
+#endif
+}
+
+//=============================================================================
+// Server
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+// Spare
+//
+//    A spare evaluator of the server, or a new one if none is spare, which
+//    is returned to the server when the request is done.
+//-----------------------------------------------------------------------------
+class Server::Spare {
+   public :
+      explicit Spare( const Server& server ) : m_server(server), m_evaluator() {
+         std::lock_guard<std::mutex> lock(m_server.m_mutex);
+         if (!m_server.m_spare.empty()) {
+            m_evaluator = std::move( m_server.m_spare.back() );
+            m_server.m_spare.pop_back();
+         }
+         else {
+            m_evaluator.reset( new LocalEvaluator(std::min(m_server.m_neighbors, m_server.Size()), m_server.m_precision) );
+         }
+      }
+
+      ~Spare() {
+         std::lock_guard<std::mutex> lock(m_server.m_mutex);
+         m_server.m_spare.push_back( std::move(m_evaluator) );
+      }
+
+      Spare( const Spare& ) = delete;
+      Spare& operator=( const Spare& ) = delete;
+
+      LocalEvaluator* operator->() const {
+         return m_evaluator.get();
+      }
+
+   private :
+      const Server&                   m_server;
+      std::unique_ptr<LocalEvaluator> m_evaluator;
+};
+
+//-----------------------------------------------------------------------------
+Server::Server(
+   double nugget,
+   double sill,
+   double range,
+   double radius,
+   const std::vector<DataRecord>& obs,
+   const EngineOptions& options )
+:  m_nugget( nugget ),
+   m_sill( sill ),
+   m_range( range ),
+   m_radius( radius ),
+   m_neighbors( (options.neighbors > 0) ? options.neighbors : SERVER_NEIGHBORS ),
+   m_precision( options.precision ),
+   m_obs( obs ),
+   m_L(),
+   m_ids(),
+   m_mutex(),
+   m_spare()
+{
+   Assembly assembly(nugget, sill, range);
+   for (const auto& rec : m_obs)
+      assembly.Append(rec);
+   assembly.Finalize(m_L);
+
+   for (int k = 0; k < Size(); ++k)
+      m_ids[m_obs[k].id].push_back(k);
+}
+
+//-----------------------------------------------------------------------------
+// Respond
+//-----------------------------------------------------------------------------
+std::string Server::Respond( const std::string& line ) const
+{
+   TraceSpan span( "request" );
+   const double start = WallSeconds();
+
+   std::string id = "null";
+   std::ostringstream out;
+   out << std::setprecision(17);
+
+   try {
+      const JsonValue request = JsonParser(line).Parse();
+      if (request.type != JsonValue::JSON_OBJECT)
+         throw InvalidRequest("a request must be an object");
+
+      // The id of the request, as it was written.
+      const JsonValue* given = request.Find("id");
+      if (given != nullptr && given->type == JsonValue::JSON_STRING)
+         id = Quote(given->text);
+      else if (given != nullptr && given->type == JsonValue::JSON_NUMBER)
+         id = given->text;
+
+      const JsonValue* op = request.Find("op");
+      if (op == nullptr || op->type != JsonValue::JSON_STRING)
+         throw InvalidRequest("\"op\" is missing");
+
+      // The parameters of this request.
+      const double nugget = Parameter(request, "nugget", m_nugget);
+      const double sill   = Parameter(request, "sill",   m_sill);
+      const double range  = Parameter(request, "range",  m_range);
+      const double radius = Parameter(request, "radius", m_radius);
+      const double neighbors = Parameter(request, "neighbors", m_neighbors);
+
+      if (!(nugget > EPS))  throw InvalidRequest("\"nugget\" is not valid;  0 < nugget");
+      if (!(sill > EPS))    throw InvalidRequest("\"sill\" is not valid;  0 < sill");
+      if (!(range > EPS))   throw InvalidRequest("\"range\" is not valid;  0 < range");
+      if (!(radius >= 0))   throw InvalidRequest("\"radius\" is not valid;  0 <= radius");
+      if (!(neighbors >= 0 && neighbors <= Size() && !(fabs(neighbors - floor(neighbors)) > 0.0)))
+         throw InvalidRequest("\"neighbors\" is not valid;  a count, 0 for all");
+      const int count = static_cast<int>(neighbors);
+
+      // Another model shares the points and index of the dataset.
+      const Locations* L = &m_L;
+      Locations other;
+      if (fabs(nugget - m_nugget) > 0.0 || fabs(sill - m_sill) > 0.0 || fabs(range - m_range) > 0.0) {
+         other = m_L;
+         other.SetModel(nugget, sill, range);
+         L = &other;
+      }
+
+      if (op->text == "score") {
+         const JsonValue* ids = request.Find("ids");
+         if (ids == nullptr || ids->type != JsonValue::JSON_ARRAY || ids->items.empty())
+            throw InvalidRequest("\"ids\" must be a list of observation IDs");
+
+         std::vector<int> ks;
+         for (const auto& item : ids->items) {
+            if (item.type != JsonValue::JSON_STRING && item.type != JsonValue::JSON_NUMBER)
+               throw InvalidRequest("\"ids\" must be a list of observation IDs");
+            auto found = m_ids.find(item.text);
+            if (found == m_ids.end())
+               throw InvalidRequest("ID " + item.text + " is not an observation");
+            ks.insert( ks.end(), found->second.begin(), found->second.end() );
+         }
+
+         // An observation requested more than once is evaluated once.
+         Spare evaluator(*this);
+         std::unordered_map<int, Boomerang> results;
+         for (int k : ks) {
+            if (results.find(k) == results.end())
+               results[k] = evaluator->Evaluate( k, sill, radius, count, m_obs, *L );
+         }
+
+         out << ",\"results\":[";
+         for (std::size_t i = 0; i < ks.size(); ++i) {
+            const DataRecord& rec = m_obs[ks[i]];
+            out << (i > 0 ? ",{" : "{");
+            out << "\"ID\":" << Quote(rec.id) << ",\"x\":" << rec.x << ",\"y\":" << rec.y << ",\"z\":" << rec.z << ',';
+            Write( out, results[ks[i]] );
+            out << '}';
+         }
+         out << ']';
+      }
+      else if (op->text == "hypothetical") {
+         const JsonValue* x = request.Find("x");
+         const JsonValue* y = request.Find("y");
+         const JsonValue* z = request.Find("z");
+         if (x == nullptr || y == nullptr || z == nullptr)
+            throw InvalidRequest("\"x\", \"y\", and \"z\" are required");
+         const double xv = Parameter(request, "x", 0.0);
+         const double yv = Parameter(request, "y", 0.0);
+         const double zv = Parameter(request, "z", 0.0);
+
+         Spare evaluator(*this);
+         const Boomerang result = evaluator->EvaluateAt( xv, yv, zv, sill, radius, count, m_obs, *L );
+         out << ",\"result\":{";
+         Write( out, result );
+         out << '}';
+      }
+      else if (op->text == "info") {
+         out << ",\"observations\":" << Size();
+         out << ",\"nugget\":" << nugget << ",\"sill\":" << sill << ",\"range\":" << range;
+         out << ",\"radius\":" << radius << ",\"neighbors\":" << count;
+      }
+      else {
+         throw InvalidRequest("\"op\" must be \"score\", \"hypothetical\", or \"info\"");
+      }
+   }
+   catch (std::exception& e) {
+      return "{\"id\":" + id + ",\"error\":" + Quote(e.what()) + "}";
+   }
+
+   out << ",\"ms\":" << std::fixed << std::setprecision(3) << 1000.0*(WallSeconds() - start);
+   return "{\"id\":" + id + out.str() + "}";
+}
+
+//-----------------------------------------------------------------------------
+int Server::Size() const
+{
+   return m_obs.size();
+}
+
+//=============================================================================
+// Serve
+//=============================================================================
+void Serve( const Server& server, const std::string& socketname, int nthreads )
+{
+   if (nthreads < 1) nthreads = DefaultThreadCount();
+
+   std::shared_ptr<RequestQueue> queue = std::make_shared<RequestQueue>();
+   std::vector<std::thread> workers;
+   for (int t = 0; t < nthreads; ++t) {
+      workers.push_back( std::thread( [&server, queue]() {
+         SetTraceThreadName( "server" );
+         Request request;
+         while (queue->Pop(request)) {
+            request.channel->Reply( server.Respond(request.line) );
+            request.channel.reset();
+         }
+      }) );
+   }
+
+   try {
+      if (socketname.empty()) {
+         std::shared_ptr<Channel> channel = std::make_shared<StdoutChannel>();
+         std::string line;
+         while (std::getline(std::cin, line))
+            Enqueue( line, channel, *queue );
+      }
+      else {
+#ifndef _WIN32
+         Listen( socketname, queue );
+#else
+         throw InvalidSocket("Unix-domain sockets are not supported on this platform; serve on stdin and stdout instead.");
+#endif
+      }
+   }
+   catch (...) {
+      queue->Close();
+      for (auto& t : workers) t.join();
+      throw;
+   }
+
+   queue->Close();
+   for (auto& t : workers) t.join();
+}
@@ -0,0 +1,117 @@
+//=============================================================================
+// server.h
+//
+//    A long-running server, with the observations and their k-d tree kept in
+//    memory, that answers requests given as line-delimited JSON.
+//
+//    Each request is one JSON object on one line, and is answered by one
+//    JSON object on one line. The "id" of a request, a string or a number,
+//    is returned with its response, since concurrent requests may be
+//    answered out of order. The optional "nugget", "sill", "range",
+//    "radius", and "neighbors" of a request replace those of the command
+//    line for that request alone.
+//
+//       {"id":1, "op":"score", "ids":["W17","W18"], "radius":75}
+//       {"id":1, "results":[{"ID":"W17", "x":..., "y":..., "z":...,
+//          "count":..., "zhat":..., "kstd":..., "zeta":..., "pvalue":...},
+//          ...], "ms":0.9}
+//
+//       {"id":2, "op":"hypothetical", "x":1200.5, "y":880.0, "z":104.2}
+//       {"id":2, "result":{"count":..., "zhat":..., ...}, "ms":0.4}
+//
+//       {"id":3, "op":"info"}
+//       {"id":3, "observations":20000, "nugget":..., ..., "ms":0.0}
+//
+//    A failed request is answered with {"id":..., "error":"..."}. A
+//    statistic without a value, e.g. with too few active observations, is
+//    null.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "engine.h"
+#include "locations.h"
+#include "read_data.h"
+
+//-----------------------------------------------------------------------------
+class InvalidSocket : public std::runtime_error {
+   public :
+      InvalidSocket( const std::string& message ) : std::runtime_error(message) {
+      }
+};
+
+// The nearest active data of a request when the command line gives none.
+const int SERVER_NEIGHBORS = 64;
+
+//-----------------------------------------------------------------------------
+// Server
+//
+//    The dataset, indexed once, and the answers to requests. Respond may be
+//    called from any number of threads at once; each request is evaluated
+//    by the local engine on the calling thread, in scratch storage kept for
+//    the next request. A request uses the options.neighbors nearest active
+//    data, or, if that is 0, SERVER_NEIGHBORS of them, unless it gives its
+//    own "neighbors"; 0 for all of them costs storage of order N^2.
+//-----------------------------------------------------------------------------
+class Server {
+   public :
+      Server(
+         double nugget,
+         double sill,
+         double range,
+         double radius,
+         const std::vector<DataRecord>& obs,
+         const EngineOptions& options );
+
+      // One response line, without the newline, for one request line.
+      std::string Respond( const std::string& request ) const;
+
+      int Size() const;                                  // the # of observations
+
+   private :
+      double m_nugget;
+      double m_sill;
+      double m_range;
+      double m_radius;
+      int m_neighbors;
+      Precision m_precision;
+      std::vector<DataRecord> m_obs;
+      Locations m_L;
+      std::unordered_map<std::string, std::vector<int>> m_ids;
+
+      // The scratch storage not in use, one for each concurrent request at
+      // the most; a Spare holds one for the length of a request.
+      class Spare;
+
+      mutable std::mutex m_mutex;
+      mutable std::vector<std::unique_ptr<LocalEvaluator>> m_spare;
+};
+
+//-----------------------------------------------------------------------------
+// Serve
+//
+//    Answer the requests read from stdin on stdout, until stdin is closed;
+//    or, if "socketname" is not empty, those of every client connected to a
+//    Unix-domain socket of that name, until the process is stopped. The
+//    requests are answered by "nthreads" threads, shared by all of them.
+//-----------------------------------------------------------------------------
+void Serve( const Server& server, const std::string& socketname, int nthreads );
+
+
+//=============================================================================
+#endif  // SERVER_H
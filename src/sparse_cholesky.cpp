@@ -0,0 +1,609 @@
+//=============================================================================
+// sparse_cholesky.cpp
+//
+//    Supernodal Cholesky factorization of a sparse symmetric positive
+//    definite matrix, with a fill-reducing ordering.
+//
+// notes:
+// o  The symbolic analysis follows Davis, 2006: the elimination tree by
+//    Liu's algorithm with path compression, its postorder, and the row
+//    structures of L, from which the column counts and the supernode
+//    patterns are taken, by walking the row subtrees.
+//
+// o  The numeric factorization is the left-looking supernodal algorithm of
+//    Ng and Peyton, 1993. Each supernode keeps a position in its row list;
+//    it is linked to the next supernode it updates, and relinked after each
+//    update, so that every update is found without a search.
+//
+// References:
+//
+// o  Davis, T.A., 2006, DIRECT METHODS FOR SPARSE LINEAR SYSTEMS, SIAM,
+//    Philadelphia, 217 pp.
+//
+// o  Ng, E.G., and Peyton, B.W., 1993, Block sparse Cholesky algorithms on
+//    advanced uniprocessor computers, SIAM Journal on Scientific Computing,
+//    v. 14, no. 5, p. 1034-1056.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <algorithm>
+#include <cassert>
+#include <math.h>
+
+#include "profile.h"
+#include "sparse_cholesky.h"
+
+namespace{
+   // Manifest constants.
+   const int    DISSECTION_LEAF = 64;
+   const double MIN_DIVISOR = 1e-12;
+
+   //--------------------------------------------------------------------------
+   // Dissect
+   //
+   //    Append the nested dissection order of "points" to "order". The
+   //    points are consumed.
+   //--------------------------------------------------------------------------
+   void Dissect(
+      const double* x,
+      const double* y,
+      double cutoff,
+      std::vector<int>& points,
+      std::vector<int>& order )
+   {
+      const int n = points.size();
+      if (n <= DISSECTION_LEAF) {
+         order.insert( order.end(), points.begin(), points.end() );
+         return;
+      }
+
+      double xmin = x[points[0]], xmax = xmin;
+      double ymin = y[points[0]], ymax = ymin;
+      for (int i : points) {
+         xmin = std::min( xmin, x[i] );
+         xmax = std::max( xmax, x[i] );
+         ymin = std::min( ymin, y[i] );
+         ymax = std::max( ymax, y[i] );
+      }
+      const double* c = (xmax - xmin >= ymax - ymin) ? x : y;
+
+      std::nth_element( points.begin(), points.begin() + n/2, points.end(),
+         [c](int i, int j){ return c[i] < c[j]; } );
+      const double split = c[points[n/2]];
+
+      // No point of the left part is within cutoff of a point of the right.
+      std::vector<int> left, right, separator;
+      for (int i : points) {
+         if (fabs(c[i] - split) < 0.5*cutoff)
+            separator.push_back(i);
+         else if (c[i] < split)
+            left.push_back(i);
+         else
+            right.push_back(i);
+      }
+      std::vector<int>().swap( points );
+
+      Dissect( x, y, cutoff, left, order );
+      Dissect( x, y, cutoff, right, order );
+      order.insert( order.end(), separator.begin(), separator.end() );
+   }
+
+   //--------------------------------------------------------------------------
+   // EliminationTree
+   //
+   //    The elimination tree of A with its unknowns in the order "perm";
+   //    parent[j] = -1 for a root. "inverse" is set to the inverse of perm.
+   //--------------------------------------------------------------------------
+   void EliminationTree(
+      const SparseMatrix& A,
+      const std::vector<int>& perm,
+      std::vector<int>& inverse,
+      std::vector<int>& parent )
+   {
+      const int n = A.nRows();
+      const int* Ap = A.RowStart();
+      const int* Aj = A.Columns();
+
+      for (int i = 0; i < n; ++i)
+         inverse[perm[i]] = i;
+
+      std::vector<int> ancestor(n);
+      for (int k = 0; k < n; ++k) {
+         parent[k]   = -1;
+         ancestor[k] = -1;
+
+         for (int p = Ap[perm[k]]; p < Ap[perm[k]+1]; ++p) {
+            for (int i = inverse[Aj[p]]; i != -1 && i < k; ) {
+               const int next = ancestor[i];
+               ancestor[i] = k;
+               if (next == -1) parent[i] = k;
+               i = next;
+            }
+         }
+      }
+   }
+
+   //--------------------------------------------------------------------------
+   // Postorder
+   //
+   //    A depth-first postorder of the forest: element [k] is the k-th node
+   //    visited.
+   //--------------------------------------------------------------------------
+   std::vector<int> Postorder( const std::vector<int>& parent )
+   {
+      const int n = parent.size();
+      std::vector<int> head(n, -1), next(n), stack, post;
+      post.reserve(n);
+
+      for (int j = n-1; j >= 0; --j) {
+         if (parent[j] != -1) {
+            next[j] = head[parent[j]];
+            head[parent[j]] = j;
+         }
+      }
+
+      for (int j = 0; j < n; ++j) {
+         if (parent[j] != -1) continue;
+
+         stack.push_back(j);
+         while (!stack.empty()) {
+            const int p = stack.back();
+            const int i = head[p];
+            if (i == -1) {
+               stack.pop_back();
+               post.push_back(p);
+            }
+            else {
+               head[p] = next[i];
+               stack.push_back(i);
+            }
+         }
+      }
+      return post;
+   }
+}
+
+//=============================================================================
+// NestedDissection
+//=============================================================================
+std::vector<int> NestedDissection(
+   const std::vector<double>& x,
+   const std::vector<double>& y,
+   double cutoff )
+{
+   assert( x.size() == y.size() );
+
+   std::vector<int> points( x.size() );
+   for (std::size_t i = 0; i < points.size(); ++i)
+      points[i] = i;
+
+   std::vector<int> order;
+   order.reserve( x.size() );
+   Dissect( x.data(), y.data(), cutoff, points, order );
+   return order;
+}
+
+//=============================================================================
+// SparseWorkspace
+//=============================================================================
+SparseWorkspace::SparseWorkspace()
+:  stamp(),
+   visit( 0 ),
+   offset(),
+   supernodes(),
+   columns(),
+   rows()
+{
+}
+
+//=============================================================================
+// SparseCholesky
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+SparseCholesky::SparseCholesky()
+:  m_n( 0 ),
+   m_Perm(),
+   m_Inverse(),
+   m_Super(),
+   m_Parent(),
+   m_First( 1, 0 ),
+   m_RowStart( 1, 0 ),
+   m_Rows(),
+   m_ValueStart( 1, 0 ),
+   m_Values()
+{
+}
+
+//-----------------------------------------------------------------------------
+// Factor
+//-----------------------------------------------------------------------------
+bool SparseCholesky::Factor( const SparseMatrix& A, const std::vector<int>& order )
+{
+   ScopedTimer timer( PHASE_FACTORIZATION );
+
+   const int n = A.nRows();
+   assert( static_cast<int>(order.size()) == n );
+
+   const int*    Ap = A.RowStart();
+   const int*    Aj = A.Columns();
+   const double* Ax = A.Values();
+
+   // The elimination tree, relabeled in postorder, so that the columns of
+   // every supernode are consecutive. The postorder does not change the fill.
+   std::vector<int> inverse(n), parent(n);
+   EliminationTree( A, order, inverse, parent );
+
+   const std::vector<int> post = Postorder( parent );
+   m_n = n;
+   m_Perm.resize(n);
+   for (int k = 0; k < n; ++k)
+      m_Perm[k] = order[post[k]];
+   EliminationTree( A, m_Perm, inverse, parent );
+
+   // The column counts of L, from the row subtrees.
+   std::vector<int> count(n, 0), mark(n, -1), children(n, 0);
+   for (int j = 0; j < n; ++j)
+      if (parent[j] != -1) ++children[parent[j]];
+
+   for (int k = 0; k < n; ++k) {
+      mark[k] = k;
+      ++count[k];
+      for (int p = Ap[m_Perm[k]]; p < Ap[m_Perm[k]+1]; ++p) {
+         for (int i = inverse[Aj[p]]; i < k && mark[i] != k; i = parent[i]) {
+            mark[i] = k;
+            ++count[i];
+         }
+      }
+   }
+
+   // The fundamental supernodes: column j joins the supernode of column j-1
+   // if it is the only child of j-1, and their patterns agree below j.
+   std::vector<int> super(n);
+   m_First.clear();
+   for (int j = 0; j < n; ++j) {
+      if (j == 0 || !(parent[j-1] == j && children[j] == 1 && count[j-1] == count[j] + 1))
+         m_First.push_back(j);
+      super[j] = m_First.size() - 1;
+   }
+   const int ns = m_First.size();
+   m_First.push_back(n);
+
+   // The row pattern of each supernode is that of its first column.
+   m_Inverse = inverse;
+   m_Super = super;
+   m_RowStart.assign(ns+1, 0);
+   m_ValueStart.assign(ns+1, 0);
+   for (int s = 0; s < ns; ++s) {
+      const int m = count[m_First[s]];
+      const int w = m_First[s+1] - m_First[s];
+      m_RowStart[s+1]   = m_RowStart[s] + m;
+      m_ValueStart[s+1] = m_ValueStart[s] + static_cast<std::size_t>(m)*w;
+   }
+
+   m_Rows.resize( m_RowStart[ns] );
+   std::vector<int> fill( m_RowStart.begin(), m_RowStart.end()-1 );
+   for (int s = 0; s < ns; ++s)
+      m_Rows[fill[s]++] = m_First[s];
+
+   std::fill( mark.begin(), mark.end(), -1 );
+   for (int k = 0; k < n; ++k) {
+      mark[k] = k;
+      for (int p = Ap[m_Perm[k]]; p < Ap[m_Perm[k]+1]; ++p) {
+         for (int i = inverse[Aj[p]]; i < k && mark[i] != k; i = parent[i]) {
+            mark[i] = k;
+            if (m_First[super[i]] == i)
+               m_Rows[fill[super[i]]++] = k;
+         }
+      }
+   }
+
+   // The parent of a supernode holds the first row below its diagonal block.
+   m_Parent.resize(ns);
+   for (int s = 0; s < ns; ++s) {
+      const int w = m_First[s+1] - m_First[s];
+      const int m = m_RowStart[s+1] - m_RowStart[s];
+      m_Parent[s] = (w < m) ? super[m_Rows[m_RowStart[s] + w]] : -1;
+   }
+
+   // The numeric factorization, one supernode at a time.
+   m_Values.assign( m_ValueStart[ns], 0.0 );
+
+   std::vector<int> relative(n);              // position of each row in the panel
+   std::vector<int> head(ns, -1), link(ns);   // the supernodes waiting to update each
+   std::vector<int> where(ns);                // the next row of each, to update with
+   std::vector<double> update;
+
+   for (int s = 0; s < ns; ++s) {
+      const int  f = m_First[s];
+      const int  w = m_First[s+1] - f;
+      const int  m = m_RowStart[s+1] - m_RowStart[s];
+      const int* R = &m_Rows[m_RowStart[s]];
+      double*    P = &m_Values[m_ValueStart[s]];
+
+      for (int i = 0; i < m; ++i)
+         relative[R[i]] = i;
+
+      // Scatter the lower triangle of the columns of A.
+      for (int c = 0; c < w; ++c) {
+         const int j = f + c;
+         double* Pc = P + static_cast<std::size_t>(c)*m;
+         for (int p = Ap[m_Perm[j]]; p < Ap[m_Perm[j]+1]; ++p) {
+            const int i = inverse[Aj[p]];
+            if (i >= j) Pc[relative[i]] = Ax[p];
+         }
+      }
+
+      // Subtract the updates from every earlier supernode with rows among
+      // the columns of this one: U = L(rows,:) L(cols,:)'.
+      for (int d = head[s]; d != -1; ) {
+         const int  next = link[d];
+         const int  wd = m_First[d+1] - m_First[d];
+         const int  md = m_RowStart[d+1] - m_RowStart[d];
+         const int* Rd = &m_Rows[m_RowStart[d]];
+         const double* Pd = &m_Values[m_ValueStart[d]];
+
+         const int p0 = where[d];
+         int p1 = p0;
+         while (p1 < md && Rd[p1] < f + w) ++p1;
+
+         const int r  = md - p0;
+         const int nc = p1 - p0;
+         update.assign( static_cast<std::size_t>(r)*nc, 0.0 );
+
+         for (int t = 0; t < wd; ++t) {
+            const double* Lt = Pd + static_cast<std::size_t>(t)*md + p0;
+            for (int jj = 0; jj < nc; ++jj) {
+               const double a = Lt[jj];
+               double* U = &update[static_cast<std::size_t>(jj)*r];
+               for (int ii = jj; ii < r; ++ii)
+                  U[ii] += Lt[ii] * a;
+            }
+         }
+
+         for (int jj = 0; jj < nc; ++jj) {
+            double* Pc = P + static_cast<std::size_t>(Rd[p0+jj] - f)*m;
+            const double* U = &update[static_cast<std::size_t>(jj)*r];
+            for (int ii = jj; ii < r; ++ii)
+               Pc[relative[Rd[p0+ii]]] -= U[ii];
+         }
+
+         where[d] = p1;
+         if (p1 < md) {
+            const int target = super[Rd[p1]];
+            link[d] = head[target];
+            head[target] = d;
+         }
+         d = next;
+      }
+
+      // Factor the panel: the diagonal block and the rows below it.
+      for (int c = 0; c < w; ++c) {
+         double* Pc = P + static_cast<std::size_t>(c)*m;
+         for (int t = 0; t < c; ++t) {
+            const double* Pt = P + static_cast<std::size_t>(t)*m;
+            const double a = Pt[c];
+            for (int i = c; i < m; ++i)
+               Pc[i] -= Pt[i] * a;
+         }
+
+         if (!(Pc[c] >= MIN_DIVISOR)) return false;
+         Pc[c] = sqrt( Pc[c] );
+
+         const double r = 1.0 / Pc[c];
+         for (int i = c+1; i < m; ++i)
+            Pc[i] *= r;
+      }
+
+      if (w < m) {
+         const int target = super[R[w]];
+         where[s] = w;
+         link[s] = head[target];
+         head[target] = s;
+      }
+   }
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+// Solve
+//
+//    Forward and back substitution, by supernodes, with every right-hand
+//    side taken through each panel while it is in cache.
+//-----------------------------------------------------------------------------
+void SparseCholesky::Solve( int nrhs, double* X, double* work ) const
+{
+   ScopedTimer timer( PHASE_SOLVE );
+
+   const int n  = m_n;
+   const int ns = Supernodes();
+
+   for (int r = 0; r < nrhs; ++r)
+      for (int i = 0; i < n; ++i)
+         work[r*n + i] = X[r*n + m_Perm[i]];
+
+   // Solve L Y = B.
+   for (int s = 0; s < ns; ++s)
+      Forward( s, nrhs, work );
+
+   // Solve L' X = Y.
+   for (int s = ns-1; s >= 0; --s) {
+      const int  f = m_First[s];
+      const int  w = m_First[s+1] - f;
+      const int  m = m_RowStart[s+1] - m_RowStart[s];
+      const int* R = &m_Rows[m_RowStart[s]];
+      const double* P = &m_Values[m_ValueStart[s]];
+
+      for (int r = 0; r < nrhs; ++r) {
+         double* x = work + r*n;
+         for (int c = w-1; c >= 0; --c) {
+            const double* Pc = P + static_cast<std::size_t>(c)*m;
+            double sum = x[f+c];
+            for (int i = c+1; i < m; ++i)
+               sum -= Pc[i] * x[R[i]];
+            x[f+c] = sum / Pc[c];
+         }
+      }
+   }
+
+   for (int r = 0; r < nrhs; ++r)
+      for (int i = 0; i < n; ++i)
+         X[r*n + m_Perm[i]] = work[r*n + i];
+}
+
+//-----------------------------------------------------------------------------
+// HalfSolve
+//-----------------------------------------------------------------------------
+void SparseCholesky::HalfSolve( const double* r, double* y ) const
+{
+   ScopedTimer timer( PHASE_SOLVE );
+
+   for (int i = 0; i < m_n; ++i)
+      y[i] = r[m_Perm[i]];
+
+   for (int s = 0; s < Supernodes(); ++s)
+      Forward( s, 1, y );
+}
+
+//-----------------------------------------------------------------------------
+// Reach
+//
+//    The nonzeros of the solution of L y = b lie on the paths in the
+//    elimination tree from the nonzeros of b to the root. Those supernodes
+//    are collected in increasing order, and their columns given consecutive
+//    compact slots. The set is closed: every row of a panel reached is a
+//    column of a supernode reached.
+//-----------------------------------------------------------------------------
+int SparseCholesky::Reach( const int* support, int nsupport, SparseWorkspace& ws ) const
+{
+   const int ns = Supernodes();
+   if (static_cast<int>(ws.stamp.size()) != ns) {
+      ws.stamp.assign(ns, 0);
+      ws.offset.assign(ns, 0);
+      ws.visit = 0;
+   }
+   ++ws.visit;
+
+   ws.supernodes.clear();
+   for (int p = 0; p < nsupport; ++p) {
+      for (int s = m_Super[m_Inverse[support[p]]]; s != -1 && ws.stamp[s] != ws.visit; s = m_Parent[s]) {
+         ws.stamp[s] = ws.visit;
+         ws.supernodes.push_back(s);
+      }
+   }
+   std::sort( ws.supernodes.begin(), ws.supernodes.end() );
+
+   ws.columns.clear();
+   for (int s : ws.supernodes) {
+      ws.offset[s] = ws.columns.size();
+      for (int j = m_First[s]; j < m_First[s+1]; ++j)
+         ws.columns.push_back(j);
+   }
+   return ws.columns.size();
+}
+
+//-----------------------------------------------------------------------------
+int SparseCholesky::Slot( int i, const SparseWorkspace& ws ) const
+{
+   const int j = m_Inverse[i];
+   const int s = m_Super[j];
+   assert( ws.stamp[s] == ws.visit );
+   return ws.offset[s] + j - m_First[s];
+}
+
+//-----------------------------------------------------------------------------
+// HalfSolve
+//
+//    Forward substitution through the supernodes found by Reach, as in
+//    Forward, with the rows of each panel mapped to their compact slots.
+//-----------------------------------------------------------------------------
+void SparseCholesky::HalfSolve( int nrhs, double* Y, SparseWorkspace& ws ) const
+{
+   ScopedTimer timer( PHASE_SOLVE );
+
+   const std::size_t nc = ws.columns.size();
+
+   for (int s : ws.supernodes) {
+      const int  w = m_First[s+1] - m_First[s];
+      const int  m = m_RowStart[s+1] - m_RowStart[s];
+      const int* R = &m_Rows[m_RowStart[s]];
+      const double* P = &m_Values[m_ValueStart[s]];
+
+      ws.rows.resize(m);
+      for (int i = 0; i < m; ++i) {
+         const int t = m_Super[R[i]];
+         ws.rows[i] = ws.offset[t] + R[i] - m_First[t];
+      }
+      const int* S = ws.rows.data();
+
+      for (int r = 0; r < nrhs; ++r) {
+         double* x = Y + r*nc;
+         for (int c = 0; c < w; ++c) {
+            const double* Pc = P + static_cast<std::size_t>(c)*m;
+            x[S[c]] /= Pc[c];
+            const double xj = x[S[c]];
+            for (int i = c+1; i < m; ++i)
+               x[S[i]] -= Pc[i] * xj;
+         }
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+// Forward
+//
+//    The columns of supernode s in the solution of L Y = B, for the "nrhs"
+//    columns of Y, in the elimination order.
+//-----------------------------------------------------------------------------
+void SparseCholesky::Forward( int s, int nrhs, double* Y ) const
+{
+   const int  n = m_n;
+   const int  f = m_First[s];
+   const int  w = m_First[s+1] - f;
+   const int  m = m_RowStart[s+1] - m_RowStart[s];
+   const int* R = &m_Rows[m_RowStart[s]];
+   const double* P = &m_Values[m_ValueStart[s]];
+
+   for (int r = 0; r < nrhs; ++r) {
+      double* x = Y + static_cast<std::size_t>(r)*n;
+      for (int c = 0; c < w; ++c) {
+         const double* Pc = P + static_cast<std::size_t>(c)*m;
+         x[f+c] /= Pc[c];
+         const double xj = x[f+c];
+         for (int i = c+1; i < m; ++i)
+            x[R[i]] -= Pc[i] * xj;
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+int SparseCholesky::nRows() const
+{
+   return m_n;
+}
+
+//-----------------------------------------------------------------------------
+int SparseCholesky::Supernodes() const
+{
+   return static_cast<int>( m_First.size() ) - 1;
+}
+
+//-----------------------------------------------------------------------------
+// The entries of the lower triangle of L; the panels also hold the unused
+// upper triangles of their diagonal blocks.
+//-----------------------------------------------------------------------------
+std::size_t SparseCholesky::NonZeros() const
+{
+   std::size_t total = 0;
+   for (int s = 0; s < Supernodes(); ++s) {
+      const std::size_t w = m_First[s+1] - m_First[s];
+      total += m_ValueStart[s+1] - m_ValueStart[s] - w*(w-1)/2;
+   }
+   return total;
+}
@@ -0,0 +1,120 @@
+//=============================================================================
+// sparse_cholesky.h
+//
+//    Supernodal Cholesky factorization of a sparse symmetric positive
+//    definite matrix, with a fill-reducing ordering.
+//
+//    The factorization is left-looking: the columns of L are grouped into
+//    fundamental supernodes, runs of consecutive columns with the same
+//    sparsity pattern below the diagonal, and each supernode is stored as a
+//    dense column-major panel. The updates from earlier supernodes, and the
+//    factorization of the panel itself, are then dense kernels on
+//    contiguous storage, rather than scalar sparse operations.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef SPARSE_CHOLESKY_H
+#define SPARSE_CHOLESKY_H
+
+#include <cstddef>
+#include <vector>
+
+#include "sparse_matrix.h"
+
+//-----------------------------------------------------------------------------
+// NestedDissection
+//
+//    A fill-reducing elimination order for a matrix whose entry (i,j) can be
+//    nonzero only if points [i] and [j] are closer than "cutoff". The points
+//    are split at the median of their wider extent, the band of points within
+//    cutoff/2 of the split, which separates the two halves, is ordered last,
+//    and the halves are ordered recursively. Returns the order: element [i]
+//    is the index of the point eliminated i-th.
+//-----------------------------------------------------------------------------
+std::vector<int> NestedDissection(
+   const std::vector<double>& x,
+   const std::vector<double>& y,
+   double cutoff
+);
+
+//=============================================================================
+// SparseWorkspace
+//
+//    The scratch storage of one thread for the sparse HalfSolve. After
+//    Reach, "columns" lists the positions, in the elimination order, at which
+//    the results may be nonzero; the compact storage of a right-hand side
+//    holds one value for each, in the same order.
+//=============================================================================
+struct SparseWorkspace {
+   std::vector<int> stamp;                 // the last visit to each supernode
+   int              visit;                 // the current visit
+   std::vector<int> offset;                // compact slot of each first column reached
+   std::vector<int> supernodes;            // the supernodes reached
+   std::vector<int> columns;               // their columns
+   std::vector<int> rows;                  // compact slots of the rows of one panel
+
+   SparseWorkspace();
+};
+
+//=============================================================================
+// SparseCholesky
+//=============================================================================
+class SparseCholesky
+{
+public:
+   SparseCholesky();
+
+   // Factor the symmetric matrix A, both triangles stored, eliminating the
+   // unknowns in the given order. Returns false if A is not numerically
+   // positive definite.
+   bool Factor( const SparseMatrix& A, const std::vector<int>& order );
+
+   // Solve A X = B for the "nrhs" columns of X, each of nRows() values,
+   // stored one after the other. On entrance X holds B; on exit, the
+   // solutions. "work" is scratch for nrhs*nRows() values.
+   void Solve( int nrhs, double* X, double* work ) const;
+
+   // The half solve y = L^{-1} P r, where P A P' = LL', with y in the
+   // elimination order. Inner products with the inverse follow from it:
+   // r1' A^{-1} r2 = y1' y2.
+   void HalfSolve( const double* r, double* y ) const;
+
+   // The half solves of sparse right-hand sides, in compact storage. Reach
+   // finds the supernodes on the paths to the root from the "nsupport"
+   // original indices in "support", at which every nonzero of the
+   // right-hand sides must be, and returns the number of positions reached:
+   // the length of each right-hand side in compact storage. Slot gives the
+   // compact slot of original index i, which must be among those reached.
+   // HalfSolve then overwrites the "nrhs" right-hand sides, stored one after
+   // the other in Y, with their half solves, visiting only those supernodes.
+   int  Reach( const int* support, int nsupport, SparseWorkspace& ws ) const;
+   int  Slot( int i, const SparseWorkspace& ws ) const;
+   void HalfSolve( int nrhs, double* Y, SparseWorkspace& ws ) const;
+
+   int nRows() const;                                    // return the order
+   int Supernodes() const;                               // return the # of supernodes
+   std::size_t NonZeros() const;                         // return the # of entries in L
+
+private:
+   void Forward( int s, int nrhs, double* Y ) const;     // supernode s of L Y = B
+
+   int                      m_n;
+   std::vector<int>         m_Perm;        // original index of each unknown
+   std::vector<int>         m_Inverse;     // position of each original index
+   std::vector<int>         m_Super;       // supernode of each column
+   std::vector<int>         m_Parent;      // parent of each supernode; -1 for a root
+   std::vector<int>         m_First;       // first column of each supernode
+   std::vector<int>         m_RowStart;    // offsets of each supernode in m_Rows
+   std::vector<int>         m_Rows;        // row indices of each supernode
+   std::vector<std::size_t> m_ValueStart;  // offsets of each panel in m_Values
+   std::vector<double>      m_Values;      // the column-major panels
+};
+
+//=============================================================================
+#endif  // SPARSE_CHOLESKY_H
@@ -0,0 +1,86 @@
+//=============================================================================
+// sparse_matrix.cpp
+//
+//    A square sparse matrix in compressed sparse row (CSR) form.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#include "sparse_matrix.h"
+
+//-----------------------------------------------------------------------------
+// The empty 0 x 0 matrix.
+//-----------------------------------------------------------------------------
+SparseMatrix::SparseMatrix()
+:  m_Start( 1, 0 ),
+   m_Columns(),
+   m_Values()
+{
+}
+
+//-----------------------------------------------------------------------------
+// Take over complete CSR arrays: "start" holds nRows()+1 offsets, and the
+// columns of each row are in increasing order.
+//-----------------------------------------------------------------------------
+SparseMatrix::SparseMatrix( std::vector<int> start, std::vector<int> columns, std::vector<double> values )
+:  m_Start( std::move(start) ),
+   m_Columns( std::move(columns) ),
+   m_Values( std::move(values) )
+{
+   assert( !m_Start.empty() && m_Start.front() == 0 );
+   assert( m_Start.back() == static_cast<int>(m_Columns.size()) );
+   assert( m_Columns.size() == m_Values.size() );
+}
+
+//-----------------------------------------------------------------------------
+// Random access, by binary search within the row.
+//-----------------------------------------------------------------------------
+double SparseMatrix::operator()( int i, int j ) const
+{
+   assert( 0 <= i && i < nRows() );
+
+   const int* first = m_Columns.data() + m_Start[i];
+   const int* last  = m_Columns.data() + m_Start[i+1];
+   const int* p = std::lower_bound( first, last, j );
+
+   return (p != last && *p == j) ? m_Values[p - m_Columns.data()] : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+int SparseMatrix::nRows() const
+{
+   return static_cast<int>( m_Start.size() ) - 1;
+}
+
+//-----------------------------------------------------------------------------
+int SparseMatrix::NonZeros() const
+{
+   return static_cast<int>( m_Columns.size() );
+}
+
+//-----------------------------------------------------------------------------
+const int* SparseMatrix::RowStart() const
+{
+   return m_Start.data();
+}
+
+//-----------------------------------------------------------------------------
+const int* SparseMatrix::Columns() const
+{
+   return m_Columns.data();
+}
+
+//-----------------------------------------------------------------------------
+const double* SparseMatrix::Values() const
+{
+   return m_Values.data();
+}
@@ -0,0 +1,53 @@
+//=============================================================================
+// sparse_matrix.h
+//
+//    A square sparse matrix in compressed sparse row (CSR) form.
+//
+//    The entries of row [i] are Columns()[p] and Values()[p], for p from
+//    RowStart()[i] up to RowStart()[i+1], in increasing column order. Both
+//    triangles of a symmetric matrix are stored, so that any row of it can
+//    be read directly.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef SPARSE_MATRIX_H
+#define SPARSE_MATRIX_H
+
+#include <vector>
+
+//=============================================================================
+// SparseMatrix
+//=============================================================================
+class SparseMatrix
+{
+public:
+   // Life cycle
+   SparseMatrix();                                       // the 0 x 0 matrix
+   SparseMatrix( std::vector<int> start,                 // take over the arrays
+                 std::vector<int> columns,
+                 std::vector<double> values );
+
+   // Inquiry.
+   int nRows() const;                                    // return the order
+   int NonZeros() const;                                 // return the # of entries
+   double operator()( int row, int col ) const;          // 0 if not stored
+
+   // Access to the raw storage.
+   const int*    RowStart() const;                       // nRows()+1 offsets
+   const int*    Columns() const;                        // column of each entry
+   const double* Values() const;                         // value of each entry
+
+private:
+   std::vector<int>    m_Start;
+   std::vector<int>    m_Columns;
+   std::vector<double> m_Values;
+};
+
+//=============================================================================
+#endif  // SPARSE_MATRIX_H
@@ -0,0 +1,219 @@
+//=============================================================================
+// spatial_index.cpp
+//
+//    A static two-dimensional k-d tree over a set of points, for searches by
+//    distance: the points within a radius of a location, and the k nearest
+//    points to it.
+//
+// notes:
+// o  The points are split at the median of the wider extent of their
+//    bounding box, down to leaves of at most KDTREE_LEAF points, and every
+//    node keeps the bounding box of its points, so that the searches skip
+//    whole subtrees by the distance to the box.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <algorithm>
+#include <cassert>
+#include <math.h>
+#include <queue>
+#include <utility>
+
+#include "spatial_index.h"
+
+namespace{
+   // Manifest constants.
+   const int KDTREE_LEAF = 16;
+
+   //--------------------------------------------------------------------------
+   // The squared distance from (x,y) to the box; zero inside it.
+   //--------------------------------------------------------------------------
+   inline double BoxDistance2(
+      double x, double y,
+      double xmin, double xmax, double ymin, double ymax )
+   {
+      const double dx = std::max( 0.0, std::max(xmin - x, x - xmax) );
+      const double dy = std::max( 0.0, std::max(ymin - y, y - ymax) );
+      return dx*dx + dy*dy;
+   }
+}
+
+//-----------------------------------------------------------------------------
+KdTree::KdTree()
+:  m_Nodes(),
+   m_Index(),
+   m_x(),
+   m_y()
+{
+}
+
+//-----------------------------------------------------------------------------
+// Build
+//-----------------------------------------------------------------------------
+void KdTree::Build( const std::vector<double>& x, const std::vector<double>& y )
+{
+   assert( x.size() == y.size() );
+
+   const int n = x.size();
+   m_Nodes.clear();
+   m_Index.resize(n);
+   for (int i = 0; i < n; ++i)
+      m_Index[i] = i;
+   if (n == 0) return;
+
+   Build( x.data(), y.data(), 0, n );
+
+   m_x.resize(n);
+   m_y.resize(n);
+   for (int p = 0; p < n; ++p) {
+      m_x[p] = x[m_Index[p]];
+      m_y[p] = y[m_Index[p]];
+   }
+}
+
+//-----------------------------------------------------------------------------
+// Create the node for points [begin, end) of m_Index, and, recursively, its
+// children. Returns the index of the node.
+//-----------------------------------------------------------------------------
+int KdTree::Build( const double* x, const double* y, int begin, int end )
+{
+   const int id = m_Nodes.size();
+   m_Nodes.push_back( Node() );
+
+   double xmin = x[m_Index[begin]], xmax = xmin;
+   double ymin = y[m_Index[begin]], ymax = ymin;
+   for (int p = begin; p < end; ++p) {
+      xmin = std::min( xmin, x[m_Index[p]] );
+      xmax = std::max( xmax, x[m_Index[p]] );
+      ymin = std::min( ymin, y[m_Index[p]] );
+      ymax = std::max( ymax, y[m_Index[p]] );
+   }
+
+   int child[2] = { -1, -1 };
+   if (end - begin > KDTREE_LEAF) {
+      const double* c = (xmax - xmin >= ymax - ymin) ? x : y;
+      const int mid = begin + (end - begin)/2;
+      std::nth_element( m_Index.begin() + begin, m_Index.begin() + mid, m_Index.begin() + end,
+         [c](int i, int j){ return c[i] < c[j]; } );
+
+      child[0] = Build( x, y, begin, mid );
+      child[1] = Build( x, y, mid, end );
+   }
+
+   Node& node = m_Nodes[id];
+   node.begin = begin;
+   node.end   = end;
+   node.child[0] = child[0];
+   node.child[1] = child[1];
+   node.xmin = xmin;
+   node.xmax = xmax;
+   node.ymin = ymin;
+   node.ymax = ymax;
+   return id;
+}
+
+//-----------------------------------------------------------------------------
+// Within
+//-----------------------------------------------------------------------------
+void KdTree::Within( double x, double y, double radius, std::vector<int>& found ) const
+{
+   found.clear();
+   if (m_Nodes.empty()) return;
+
+   const double r2 = radius*radius;
+   std::vector<int> stack(1, 0);
+   while (!stack.empty()) {
+      const Node& node = m_Nodes[stack.back()];
+      stack.pop_back();
+
+      if (BoxDistance2(x, y, node.xmin, node.xmax, node.ymin, node.ymax) >= r2) continue;
+
+      if (node.child[0] == -1) {
+         for (int p = node.begin; p < node.end; ++p)
+            if (hypot(m_x[p] - x, m_y[p] - y) < radius)
+               found.push_back( m_Index[p] );
+      }
+      else {
+         stack.push_back( node.child[1] );
+         stack.push_back( node.child[0] );
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+// Nearest
+//
+//    A depth-first search, nearer child first, keeping the best k so far in
+//    a max-heap on (squared distance, index); a subtree is skipped once its
+//    box is farther than the worst of a full heap.
+//-----------------------------------------------------------------------------
+void KdTree::Nearest(
+   double x,
+   double y,
+   int k,
+   const std::function<bool(int j)>& accept,
+   std::vector<int>& found ) const
+{
+   found.clear();
+   if (m_Nodes.empty() || k < 1) return;
+
+   std::priority_queue<std::pair<double,int>> best;
+   std::vector<int> stack(1, 0);
+   while (!stack.empty()) {
+      const Node& node = m_Nodes[stack.back()];
+      stack.pop_back();
+
+      const double d2 = BoxDistance2(x, y, node.xmin, node.xmax, node.ymin, node.ymax);
+      if (static_cast<int>(best.size()) == k && d2 > best.top().first) continue;
+
+      if (node.child[0] == -1) {
+         for (int p = node.begin; p < node.end; ++p) {
+            const int j = m_Index[p];
+            if (!accept(j)) continue;
+
+            const double dx = m_x[p] - x;
+            const double dy = m_y[p] - y;
+            const std::pair<double,int> candidate( dx*dx + dy*dy, j );
+            if (static_cast<int>(best.size()) < k)
+               best.push( candidate );
+            else if (candidate < best.top()) {
+               best.pop();
+               best.push( candidate );
+            }
+         }
+      }
+      else {
+         // Push the farther child first, so that the nearer is searched first.
+         const Node& a = m_Nodes[node.child[0]];
+         const Node& b = m_Nodes[node.child[1]];
+         const double da = BoxDistance2(x, y, a.xmin, a.xmax, a.ymin, a.ymax);
+         const double db = BoxDistance2(x, y, b.xmin, b.xmax, b.ymin, b.ymax);
+         stack.push_back( da <= db ? node.child[1] : node.child[0] );
+         stack.push_back( da <= db ? node.child[0] : node.child[1] );
+      }
+   }
+
+   found.resize( best.size() );
+   for (int i = static_cast<int>(best.size()) - 1; i >= 0; --i) {
+      found[i] = best.top().second;
+      best.pop();
+   }
+}
+
+//-----------------------------------------------------------------------------
+int KdTree::Size() const
+{
+   return m_Index.size();
+}
+
+//-----------------------------------------------------------------------------
+const std::vector<int>& KdTree::Order() const
+{
+   return m_Index;
+}
@@ -0,0 +1,67 @@
+//=============================================================================
+// spatial_index.h
+//
+//    A static two-dimensional k-d tree over a set of points, for searches by
+//    distance: the points within a radius of a location, and the k nearest
+//    points to it.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <functional>
+#include <vector>
+
+//=============================================================================
+// KdTree
+//=============================================================================
+class KdTree
+{
+public:
+   KdTree();
+
+   // Index the points.
+   void Build( const std::vector<double>& x, const std::vector<double>& y );
+
+   // The indices of the points closer than "radius" to (x,y).
+   void Within( double x, double y, double radius, std::vector<int>& found ) const;
+
+   // The indices of the k points nearest to (x,y), nearest first, among those
+   // for which accept(j) is true; ties go to the lower index. Fewer than k
+   // are found only if fewer are accepted.
+   void Nearest(
+      double x,
+      double y,
+      int k,
+      const std::function<bool(int j)>& accept,
+      std::vector<int>& found ) const;
+
+   int Size() const;                                     // the # of points
+
+   // The indices of the points in the tree order, in which the points of
+   // every subtree are contiguous.
+   const std::vector<int>& Order() const;
+
+private:
+   struct Node {
+      int    begin, end;                // the points, in the tree order
+      int    child[2];                  // -1 for a leaf
+      double xmin, xmax, ymin, ymax;    // the bounding box
+   };
+
+   int Build( const double* x, const double* y, int begin, int end );
+
+   std::vector<Node>   m_Nodes;        // the root is [0]
+   std::vector<int>    m_Index;        // original index of each point
+   std::vector<double> m_x, m_y;       // the points, in the tree order
+};
+
+//=============================================================================
+#endif  // SPATIAL_INDEX_H
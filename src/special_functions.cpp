@@ -18,6 +18,7 @@
 #include <cassert>
 #include <cmath>
 
+#include "fast_exp-inl.h"
 #include "numerical_constants.h"
 #include "special_functions.h"
 
@@ -377,6 +378,117 @@ double IncompleteGammaInv( double p, double a )
    return x;
 }
 
+//-----------------------------------------------------------------------------
+// NormalCDF
+//
+//    The Standard Normal cumulative distribution function, shared by the
+//    scalar and batched GaussianCDF.
+//
+// notes:
+// o  Phi(x) = erfc(-x/sqrt(2))/2 is evaluated with the rational Chebyshev
+//    approximations of Cody (1969), as in his CALERF routine, in three
+//    ranges of y = |x|/sqrt(2). The relative error of the approximations is
+//    below 1e-16; the error in Phi is below 1e-15 for all x.
+//
+// o  The tail is computed directly, never as 1 - Phi, so the lower tail
+//    keeps full relative accuracy down to about 1e-308. A NaN argument
+//    yields NaN.
+//
+// o  exp(-y^2) is computed as exp(-ysq^2)*exp(-(y-ysq)(y+ysq)) with ysq = y
+//    rounded to a multiple of 1/16, so the rounding of y^2 is not
+//    magnified; FastExp is accurate to 3 ulp.
+//
+// references:
+// o  W. J. Cody, 1969, Rational Chebyshev Approximations for the Error
+//    Function, Mathematics of Computation, v. 23, n. 107, pp. 631-637.
+//-----------------------------------------------------------------------------
+namespace{
+   const int HALLEY_STEPS = 2;
+
+   inline double NormalCDF( double x )
+   {
+      const double a[] = {
+         3.16112374387056560e00, 1.13864154151050156e02,
+         3.77485237685302021e02, 3.20937758913846947e03,
+         1.85777706184603153e-1 };
+      const double b[] = {
+         2.36012909523441209e01, 2.44024637934444173e02,
+         1.28261652607737228e03, 2.84423683343917062e03 };
+      const double c[] = {
+         5.64188496988670089e-1, 8.88314979438837594e00,
+         6.61191906371416295e01, 2.98635138197400131e02,
+         8.81952221241769090e02, 1.71204761263407058e03,
+         2.05107837782607147e03, 1.23033935479799725e03,
+         2.15311535474403846e-8 };
+      const double d[] = {
+         1.57449261107098347e01, 1.17693950891312499e02,
+         5.37181101862009858e02, 1.62138957456669019e03,
+         3.29079923573345963e03, 4.36261909014324716e03,
+         3.43936767414372164e03, 1.23033935480374942e03 };
+      const double p[] = {
+         3.05326634961232344e-1, 3.60344899949804439e-1,
+         1.25781726111229246e-1, 1.60837851487422766e-2,
+         6.58749161529837803e-4, 1.63153871373020978e-2 };
+      const double q[] = {
+         2.56852019228982242e00, 1.87295284992346725e00,
+         5.27905102951428412e-1, 6.05183413124413191e-2,
+         2.33520497626869185e-3 };
+
+      const double THRESHOLD = 0.46875;
+      const double XBIG      = 26.543;
+
+      const double s = x / SQRT_TWO;
+      const double y = fabs(s);
+
+      // Near the center: Phi = (1 + erf(s))/2.
+      if (y <= THRESHOLD) {
+         double ysq  = y*y;
+         double xnum = a[4]*ysq;
+         double xden = ysq;
+         for (int i = 0; i < 3; ++i) {
+            xnum = (xnum + a[i]) * ysq;
+            xden = (xden + b[i]) * ysq;
+         }
+         return 0.5 + 0.5 * s * (xnum + a[3]) / (xden + b[3]);
+      }
+
+      // In the tails: tail = erfc(y)/2.
+      double r;
+      if (y <= 4.0) {
+         double xnum = c[8]*y;
+         double xden = y;
+         for (int i = 0; i < 7; ++i) {
+            xnum = (xnum + c[i]) * y;
+            xden = (xden + d[i]) * y;
+         }
+         r = (xnum + c[7]) / (xden + d[7]);
+      }
+      else if (y < XBIG) {
+         double ysq  = 1.0/(y*y);
+         double xnum = p[5]*ysq;
+         double xden = ysq;
+         for (int i = 0; i < 4; ++i) {
+            xnum = (xnum + p[i]) * ysq;
+            xden = (xden + q[i]) * ysq;
+         }
+         r = ysq * (xnum + p[4]) / (xden + q[4]);
+         r = (ONE_OVER_SQRT_PI - r) / y;
+      }
+      else if (y >= XBIG) {
+         return (x < 0) ? 0.0 : 1.0;
+      }
+      else {
+         return x;                                 // NaN
+      }
+
+      double ysq = floor(16.0*y) / 16.0;
+      double del = (y - ysq)*(y + ysq);
+      double tail = 0.5 * FastExp(-ysq*ysq) * FastExp(-del) * r;
+
+      return (x < 0) ? tail : 1.0 - tail;
+   }
+}
+
 //-----------------------------------------------------------------------------
 // GaussianCDF
 //
@@ -384,27 +496,34 @@ double IncompleteGammaInv( double p, double a )
 //    function at the argument.
 //
 // notes:
-// o  This routine is relatively slow, but the associated error is less than
-//    1e-15 for all x.
-//
-// references:
-// o  Marsaglia, George, 2004, Evaluating the Normal Distribution, Journal of
-//    Statistical Software, v. 11, n. 4, June 2004.  Available on-line at
-//    http://www.jstatsoft.org/v11/a05/paper.
+// o  See NormalCDF. The error is less than 1e-15 for all x.
 //-----------------------------------------------------------------------------
 double GaussianCDF(double x)
 {
-   if (x < -8.0)
-      return 0.0;
-   else if (x > 8.0)
-      return 1.0;
-   else
-   {
-      long double s=x, t=0, b=x, q=x*x, i=1;
-      while (abs(s-t) > EPS)
-         s = (t=s) + (b *= q/(i+=2));
-      return static_cast<double>( 0.5 + s*exp(-0.5*q - 0.91893853320467274178L) );
-   }
+   return NormalCDF(x);
+}
+
+//-----------------------------------------------------------------------------
+// GaussianCDF
+//
+//    The batched version: p[i] = GaussianCDF(x[i]) for i = 0..n-1.
+//
+// notes:
+// o  The p-values of a whole run, or of a whole block of results, are
+//    computed in one call, with the approximation inlined in one loop.
+//
+// o  The loop is not vectorized, deliberately. A branch-free NormalCDF,
+//    evaluating both the center and the tail approximations and selecting
+//    the result, does vectorize, but only at -O3 with -fno-trapping-math,
+//    and with two lanes of SSE2 it gained about 15% there, while it was 1.8
+//    times slower at the -O2 of the release build, since every argument
+//    then pays for the tail and its two exponentials. The p-values take
+//    about 0.02% of a run.
+//-----------------------------------------------------------------------------
+void GaussianCDF(int n, const double* x, double* p)
+{
+   for (int i = 0; i < n; ++i)
+      p[i] = NormalCDF(x[i]);
 }
 
 //-----------------------------------------------------------------------------
@@ -415,7 +534,10 @@ double GaussianCDF(double x)
 //    yields an error < 4.5e4.
 //
 // o  Applying Halley's "one-point third-order" iterative update yields
-//    almost full machine precision.
+//    almost full machine precision. A second update is needed only in the
+//    far tails, where the first leaves a relative error of up to 1e-7 in p
+//    (p < 1e-20); it is applied everywhere, at the cost of one more CDF
+//    evaluation.
 //
 // o  The idea of applying Halley's formula is based on a C program written by
 //    Jeremy Lea (Research Engineer, Infrastructure Engineering, Transportek,
@@ -443,9 +565,61 @@ double GaussianCDFInv(double p)
    double den = 1 + (d[0] + (d[1] + d[2]*t)*t)*t;
    double u = -t + num/den;
 
-   t = GaussianCDF(u) - q;             // error
-   t = t * SQRT_TWO_PI*exp(u*u/2);     // f(u)/df(u)
-   u = u - t/(1 + u*t/2);              // Halley's update formula
+   for (int j = 0; j < HALLEY_STEPS; ++j) {
+      t = GaussianCDF(u) - q;          // error
+      t = t * SQRT_TWO_PI*exp(u*u/2);  // f(u)/df(u)
+      u = u - t/(1 + u*t/2);           // Halley's update formula
+   }
 
    return (p<0.5 ? u : -u);
 }
+
+//-----------------------------------------------------------------------------
+// GaussianCDFInv
+//
+//    The batched version: x[i] = GaussianCDFInv(p[i]) for i = 0..n-1.
+//
+// notes:
+// o  The same initial approximation and Halley updates as the scalar
+//    version, but the CDF evaluations of the updates are batched in blocks,
+//    without allocation.
+//-----------------------------------------------------------------------------
+void GaussianCDFInv(int n, const double* p, double* x)
+{
+   const int BLOCK = 64;
+
+   const double c[] = { 2.515517, 0.802853, 0.010328 };
+   const double d[] = { 1.432788, 0.189269, 0.001308 };
+
+   double q[BLOCK];
+   double f[BLOCK];
+
+   for (int i0 = 0; i0 < n; i0 += BLOCK) {
+      const int m = (n - i0 < BLOCK) ? n - i0 : BLOCK;
+
+      for (int i = 0; i < m; ++i) {
+         assert(p[i0+i]>0 && p[i0+i]<1);
+
+         q[i] = (p[i0+i]<0.5 ? p[i0+i] : 1-p[i0+i]);
+
+         double t = sqrt(-2*log(q[i]));
+         double num = c[0] + (c[1] + c[2]*t)*t;
+         double den = 1 + (d[0] + (d[1] + d[2]*t)*t)*t;
+         x[i0+i] = -t + num/den;
+      }
+
+      for (int j = 0; j < HALLEY_STEPS; ++j) {
+         GaussianCDF( m, x+i0, f );
+
+         for (int i = 0; i < m; ++i) {
+            double u = x[i0+i];
+            double t = f[i] - q[i];          // error
+            t = t * SQRT_TWO_PI*exp(u*u/2);  // f(u)/df(u)
+            x[i0+i] = u - t/(1 + u*t/2);     // Halley's update formula
+         }
+      }
+
+      for (int i = 0; i < m; ++i)
+         x[i0+i] = (p[i0+i]<0.5 ? x[i0+i] : -x[i0+i]);
+   }
+}
@@ -25,5 +25,9 @@ double IncompleteGammaInv( double p, double a );
 double GaussianCDF( double x );
 double GaussianCDFInv( double p );
 
+// Batched versions: out[i] = f(in[i]) for i = 0..n-1.
+void GaussianCDF( int n, const double* x, double* p );
+void GaussianCDFInv( int n, const double* p, double* x );
+
 //=============================================================================
 #endif  // SPECIAL_FUNCTIONS_H
@@ -33,6 +33,29 @@ inline double SumProduct( int n, const double* x, const double* y )
    return Sum;
 }
 
+//-----------------------------------------------------------------------------
+// The float32 version, for the mixed-precision factorization. The sum is
+// split across eight independent partial sums, which breaks the dependence
+// chain of the additions and lets the compiler pack them into SIMD
+// registers; the double version keeps its strict left-to-right order, so
+// that its results do not change.
+//-----------------------------------------------------------------------------
+inline float SumProduct( int n, const float* x, const float* y )
+{
+   float s[8] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+   int i = 0;
+   for ( ; i+8 <= n; i += 8)
+      for (int j = 0; j < 8; ++j)
+         s[j] += x[i+j] * y[i+j];
+
+   float Sum = ((s[0] + s[4]) + (s[1] + s[5])) + ((s[2] + s[6]) + (s[3] + s[7]));
+   for ( ; i < n; ++i)
+      Sum += x[i] * y[i];
+
+   return Sum;
+}
+
 //-----------------------------------------------------------------------------
 // This routine computes a dot product between two vectors.  Both vectors
 // allow for a non-unit stride.
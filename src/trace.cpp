@@ -0,0 +1,249 @@
+//=============================================================================
+// trace.cpp
+//
+//    Chrome/Perfetto trace-event export of the engine activity, reported by
+//    the --trace command line option. Load the file in chrome://tracing or
+//    https://ui.perfetto.dev.
+//
+// notes:
+// o  Each thread records its spans into its own fixed-size ring buffer, so
+//    recording a span takes no locks. The buffers are allocated the first
+//    time a thread records a span, and written out by WriteTrace after the
+//    worker threads have finished.
+//
+// o  When a ring buffer fills, the oldest spans of that thread are
+//    overwritten. The number of dropped spans is reported in the file.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include "profile.h"
+#include "trace.h"
+
+namespace{
+   const long long RING_CAPACITY = 1 << 16;     // spans per thread
+
+   struct Event {
+      const char* name;
+      double      begin;
+      double      end;
+      int         nargs;
+      const char* keys[3];
+      long long   values[3];
+   };
+
+   struct ThreadBuffer {
+      int                tid;
+      const char*        name;
+      long long          count;                  // spans ever recorded
+      std::vector<Event> ring;
+
+      explicit ThreadBuffer( int id )
+      :  tid( id ),
+         name( nullptr ),
+         count( 0 ),
+         ring( RING_CAPACITY )
+      {
+      }
+
+      ThreadBuffer( const ThreadBuffer& ) = delete;
+      ThreadBuffer& operator=( const ThreadBuffer& ) = delete;
+   };
+
+   std::atomic<bool> g_enabled(false);
+
+   std::mutex g_registry_mutex;
+   std::vector< std::unique_ptr<ThreadBuffer> > g_registry;
+
+   thread_local ThreadBuffer* t_buffer = nullptr;
+
+   const double g_origin = WallSeconds();
+
+   //--------------------------------------------------------------------------
+   // The ring buffer for the calling thread, registered on first use.
+   //--------------------------------------------------------------------------
+   ThreadBuffer* LocalBuffer()
+   {
+      if (t_buffer == nullptr) {
+         std::lock_guard<std::mutex> lock(g_registry_mutex);
+         std::unique_ptr<ThreadBuffer> buffer( new ThreadBuffer(g_registry.size() + 1) );
+         t_buffer = buffer.get();
+         g_registry.push_back( std::move(buffer) );
+      }
+      return t_buffer;
+   }
+
+   //--------------------------------------------------------------------------
+   void Record( const Event& event )
+   {
+      ThreadBuffer* buffer = LocalBuffer();
+      buffer->ring[ buffer->count % RING_CAPACITY ] = event;
+      ++buffer->count;
+   }
+
+   //--------------------------------------------------------------------------
+   // Microseconds since the start of the program.
+   //--------------------------------------------------------------------------
+   double Microseconds( double seconds )
+   {
+      return (seconds - g_origin) * 1e6;
+   }
+}
+
+//=============================================================================
+// TraceSpan
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+TraceSpan::TraceSpan( const char* name )
+:  m_name( name ),
+   m_active( g_enabled.load(std::memory_order_relaxed) ),
+   m_begin( 0.0 ),
+   m_nargs( 0 ),
+   m_keys(),
+   m_values()
+{
+   if (m_active) m_begin = WallSeconds();
+}
+
+//-----------------------------------------------------------------------------
+TraceSpan::~TraceSpan()
+{
+   if (m_active) {
+      Event event;
+      event.name  = m_name;
+      event.begin = m_begin;
+      event.end   = WallSeconds();
+      event.nargs = m_nargs;
+      for (int i = 0; i < m_nargs; ++i) {
+         event.keys[i]   = m_keys[i];
+         event.values[i] = m_values[i];
+      }
+      Record( event );
+   }
+}
+
+//-----------------------------------------------------------------------------
+void TraceSpan::Arg( const char* key, long long value )
+{
+   if (m_active && m_nargs < 3) {
+      m_keys[m_nargs]   = key;
+      m_values[m_nargs] = value;
+      ++m_nargs;
+   }
+}
+
+//=============================================================================
+// Free functions.
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+void EnableTracing( bool flag )
+{
+   g_enabled = flag;
+}
+
+//-----------------------------------------------------------------------------
+bool TracingEnabled()
+{
+   return g_enabled;
+}
+
+//-----------------------------------------------------------------------------
+// Label the calling thread in the trace viewer.
+//-----------------------------------------------------------------------------
+void SetTraceThreadName( const char* name )
+{
+   if (g_enabled) LocalBuffer()->name = name;
+}
+
+//-----------------------------------------------------------------------------
+// Record a span whose end points were measured by the caller; e.g. by a
+// ScopedTimer.
+//-----------------------------------------------------------------------------
+void TraceEvent( const char* name, double begin, double end )
+{
+   Event event;
+   event.name  = name;
+   event.begin = begin;
+   event.end   = end;
+   event.nargs = 0;
+   Record( event );
+}
+
+//-----------------------------------------------------------------------------
+// WriteTrace
+//
+//    Write all of the recorded spans to the specified file in the Chrome
+//    trace-event JSON object format. This must not be called while other
+//    threads are still recording.
+//-----------------------------------------------------------------------------
+void WriteTrace( const std::string& filename )
+{
+   std::ofstream out( filename );
+   if ( out.fail() ) {
+      std::stringstream message;
+      message << "Could not open <" << filename << "> for output.";
+      throw InvalidTraceFile(message.str());
+   }
+
+   std::lock_guard<std::mutex> lock(g_registry_mutex);
+
+   long long dropped = 0;
+   bool first = true;
+
+   out << std::fixed << std::setprecision(3);
+   out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+   for (const auto& buffer : g_registry) {
+      if (buffer->name != nullptr) {
+         out << (first ? "" : ",\n");
+         out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+             << ",\"args\":{\"name\":\"" << buffer->name << "\"}}";
+         first = false;
+      }
+
+      long long begin = (buffer->count > RING_CAPACITY) ? buffer->count - RING_CAPACITY : 0;
+      dropped += begin;
+
+      for (long long n = begin; n < buffer->count; ++n) {
+         const Event& event = buffer->ring[ n % RING_CAPACITY ];
+
+         out << (first ? "" : ",\n");
+         out << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+             << ",\"ts\":" << Microseconds(event.begin)
+             << ",\"dur\":" << (event.end - event.begin)*1e6;
+
+         if (event.nargs > 0) {
+            out << ",\"args\":{";
+            for (int i = 0; i < event.nargs; ++i)
+               out << (i > 0 ? "," : "") << '"' << event.keys[i] << "\":" << event.values[i];
+            out << '}';
+         }
+         out << '}';
+         first = false;
+      }
+   }
+
+   out << "\n],\"otherData\":{\"dropped_spans\":" << dropped << "}}\n";
+
+   out.close();
+   if ( out.fail() ) {
+      std::stringstream message;
+      message << "Writing to <" << filename << "> failed.";
+      throw InvalidTraceFile(message.str());
+   }
+}
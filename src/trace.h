@@ -0,0 +1,64 @@
+//=============================================================================
+// trace.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdexcept>
+#include <string>
+
+//-----------------------------------------------------------------------------
+class InvalidTraceFile : public std::runtime_error {
+   public :
+      InvalidTraceFile( const std::string& message ) : std::runtime_error(message) {
+      }
+};
+
+//-----------------------------------------------------------------------------
+// TraceSpan
+//
+//    Records one Chrome trace-event "complete" span, from construction to
+//    destruction, on the calling thread. Up to three integer arguments may be
+//    attached to the span. The name and argument keys must be string
+//    literals, since only the pointers are stored. When tracing is disabled
+//    a TraceSpan costs one test of a flag.
+//-----------------------------------------------------------------------------
+class TraceSpan {
+   public :
+      explicit TraceSpan( const char* name );
+      ~TraceSpan();
+
+      void Arg( const char* key, long long value );
+
+      TraceSpan( const TraceSpan& ) = delete;
+      TraceSpan& operator=( const TraceSpan& ) = delete;
+
+   private :
+      const char* m_name;
+      bool        m_active;
+      double      m_begin;
+      int         m_nargs;
+      const char* m_keys[3];
+      long long   m_values[3];
+};
+
+//-----------------------------------------------------------------------------
+void EnableTracing( bool flag );
+bool TracingEnabled();
+
+void SetTraceThreadName( const char* name );
+void TraceEvent( const char* name, double begin, double end );
+
+void WriteTrace( const std::string& filename );
+
+
+//=============================================================================
+#endif  // TRACE_H
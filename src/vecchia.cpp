@@ -0,0 +1,385 @@
+//=============================================================================
+// vecchia.cpp
+//
+//    The Vecchia approximation of a Gaussian process: a sparse approximation
+//    of the inverse of a covariance matrix C.
+//
+// notes:
+// o  The maxmin order is found exactly, with a lazy max-heap of the distance
+//    from each point to the points already ordered. When a point at distance
+//    d is ordered, only the points within d of it can come closer to the
+//    ordered set, and those are found with the k-d tree.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <math.h>
+#include <queue>
+#include <thread>
+#include <utility>
+
+#include "linear_systems.h"
+#include "numerical_constants.h"
+#include "profile.h"
+#include "vecchia.h"
+
+namespace{
+   // Manifest constants.
+   const int ROW_BLOCK = 256;           // rows handed to a thread at a time
+   const double SQRT_EPS = sqrt(EPS);
+
+   //--------------------------------------------------------------------------
+   // The transpose of a square sparse matrix.
+   //--------------------------------------------------------------------------
+   SparseMatrix Transpose( const SparseMatrix& A )
+   {
+      const int n = A.nRows();
+      const int*    Ap = A.RowStart();
+      const int*    Aj = A.Columns();
+      const double* Ax = A.Values();
+
+      std::vector<int> start(n+1, 0);
+      for (int p = 0; p < Ap[n]; ++p)
+         ++start[Aj[p] + 1];
+      for (int j = 0; j < n; ++j)
+         start[j+1] += start[j];
+
+      std::vector<int> fill( start.begin(), start.end()-1 );
+      std::vector<int> columns( Ap[n] );
+      std::vector<double> values( Ap[n] );
+      for (int i = 0; i < n; ++i) {
+         for (int p = Ap[i]; p < Ap[i+1]; ++p) {
+            const int q = fill[Aj[p]]++;
+            columns[q] = i;
+            values[q]  = Ax[p];
+         }
+      }
+      return SparseMatrix( std::move(start), std::move(columns), std::move(values) );
+   }
+}
+
+//=============================================================================
+// MaxminOrder
+//=============================================================================
+std::vector<int> MaxminOrder(
+   const std::vector<double>& x,
+   const std::vector<double>& y,
+   const KdTree& index )
+{
+   const int n = x.size();
+   std::vector<int> order;
+   order.reserve(n);
+   if (n == 0) return order;
+
+   double xc = 0.0, yc = 0.0;
+   for (int i = 0; i < n; ++i) {
+      xc += x[i] / n;
+      yc += y[i] / n;
+   }
+   std::vector<int> first;
+   index.Nearest( xc, yc, 1, [](int) { return true; }, first );
+
+   std::vector<double> distance(n);
+   std::vector<char> ordered(n, 0);
+   std::priority_queue<std::pair<double,int>> heap;
+
+   ordered[first[0]] = 1;
+   order.push_back( first[0] );
+   for (int j = 0; j < n; ++j) {
+      distance[j] = hypot( x[j] - x[first[0]], y[j] - y[first[0]] );
+      if (!ordered[j]) heap.push( std::make_pair(distance[j], -j) );
+   }
+
+   // Ties go to the lower index, for a reproducible order. The distances
+   // only decrease, so an entry that has been superseded is the larger.
+   std::vector<int> near;
+   while (!heap.empty()) {
+      const double d = heap.top().first;
+      const int    i = -heap.top().second;
+      heap.pop();
+      if (ordered[i] || distance[i] < d) continue;
+
+      ordered[i] = 1;
+      order.push_back(i);
+
+      index.Within( x[i], y[i], d, near );
+      for (int j : near) {
+         if (ordered[j]) continue;
+         const double h = hypot( x[j] - x[i], y[j] - y[i] );
+         if (h < distance[j]) {
+            distance[j] = h;
+            heap.push( std::make_pair(h, -j) );
+         }
+      }
+   }
+   return order;
+}
+
+//=============================================================================
+// VecchiaWorkspace
+//=============================================================================
+VecchiaWorkspace::VecchiaWorkspace()
+:  position(),
+   rows(),
+   touched(),
+   entries(),
+   values()
+{
+}
+
+//=============================================================================
+// Vecchia
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+Vecchia::Vecchia()
+:  m_Index(),
+   m_Order(),
+   m_U(),
+   m_Ut()
+{
+}
+
+//-----------------------------------------------------------------------------
+// Build
+//-----------------------------------------------------------------------------
+bool Vecchia::Build(
+   const std::vector<double>& x,
+   const std::vector<double>& y,
+   const EntryFunction& covariance,
+   int m,
+   int nthreads )
+{
+   assert( x.size() == y.size() );
+   assert( m > 0 );
+
+   const int n = x.size();
+   std::vector<int> rank(n);
+   {
+      ScopedTimer timer( PHASE_ASSEMBLY );
+      m_Index.Build( x, y );
+      m_Order = MaxminOrder( x, y, m_Index );
+      for (int r = 0; r < n; ++r)
+         rank[m_Order[r]] = r;
+   }
+
+   // Row [i] of U has min(m, rank) + 1 entries.
+   std::vector<int> start(n+1, 0);
+   for (int i = 0; i < n; ++i)
+      start[i+1] = start[i] + std::min( m, rank[i] ) + 1;
+   std::vector<int>    columns( start[n] );
+   std::vector<double> values( start[n] );
+
+   const int nblocks = (n + ROW_BLOCK - 1) / ROW_BLOCK;
+   nthreads = std::max( 1, std::min(nthreads, nblocks) );
+
+   std::atomic<int>  next(0);
+   std::atomic<bool> failed(false);
+   auto worker = [&]() {
+      ScopedTimer timer( PHASE_FACTORIZATION );
+
+      std::vector<int> c;
+      std::vector<double> A, b;
+      std::vector<std::pair<int,double>> row;
+
+      for (int block = next++; block < nblocks; block = next++) {
+         const int i1 = std::min( (block+1)*ROW_BLOCK, n );
+         for (int i = block*ROW_BLOCK; i < i1; ++i) {
+            const int ri = rank[i];
+            m_Index.Nearest( x[i], y[i], std::min(m, ri), [&rank, ri](int j) { return rank[j] < ri; }, c );
+            const int mi = c.size();
+
+            // b = C(c,c)^{-1} C(c,i), and d = C(i,i) - C(i,c) b.
+            A.resize( static_cast<std::size_t>(mi)*mi );
+            b.resize( mi );
+            for (int a = 0; a < mi; ++a) {
+               for (int e = 0; e <= a; ++e)
+                  A[a*mi + e] = A[e*mi + a] = covariance( c[a], c[e] );
+               b[a] = covariance( c[a], i );
+            }
+            const double cii = covariance( i, i );
+            double d = cii;
+            if (mi > 0) {
+               if (!CholeskyDecomposition(mi, A.data(), mi)) {
+                  failed = true;
+                  continue;
+               }
+               std::vector<double> ci( b );
+               CholeskySolve(mi, A.data(), mi, b.data());
+               for (int a = 0; a < mi; ++a)
+                  d -= ci[a] * b[a];
+            }
+            // A conditional variance lost in the rounding of C(i,i) is zero.
+            if (!(d > SQRT_EPS * cii)) {
+               failed = true;
+               continue;
+            }
+
+            const double s = 1.0 / sqrt(d);
+            row.clear();
+            row.push_back( std::make_pair(i, s) );
+            for (int a = 0; a < mi; ++a)
+               row.push_back( std::make_pair(c[a], -b[a]*s) );
+            std::sort( row.begin(), row.end() );
+
+            for (int a = 0; a <= mi; ++a) {
+               columns[start[i] + a] = row[a].first;
+               values[start[i] + a]  = row[a].second;
+            }
+         }
+      }
+   };
+
+   std::vector<std::thread> workers;
+   for (int t = 1; t < nthreads; ++t)
+      workers.push_back( std::thread(worker) );
+   worker();
+   for (auto& t : workers) t.join();
+
+   if (failed) {
+      *this = Vecchia();
+      return false;
+   }
+
+   m_U  = SparseMatrix( std::move(start), std::move(columns), std::move(values) );
+   m_Ut = Transpose( m_U );
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+// Precision
+//
+//    Q(i,j) is the sum, over the rows [l] of U with entries in both columns
+//    [i] and [j], of U(l,i) U(l,j): the intersection of rows [i] and [j] of
+//    U', which are sorted.
+//-----------------------------------------------------------------------------
+double Vecchia::Precision( int i, int j ) const
+{
+   const int*    Tp = m_Ut.RowStart();
+   const int*    Tj = m_Ut.Columns();
+   const double* Tx = m_Ut.Values();
+
+   double sum = 0.0;
+   int p = Tp[i], q = Tp[j];
+   while (p < Tp[i+1] && q < Tp[j+1]) {
+      if (Tj[p] < Tj[q])
+         ++p;
+      else if (Tj[q] < Tj[p])
+         ++q;
+      else
+         sum += Tx[p++] * Tx[q++];
+   }
+   return sum;
+}
+
+//-----------------------------------------------------------------------------
+// PrecisionBlock
+//
+//    Q(E,E) = U(:,E)' U(:,E) is the sum of the outer products of the parts
+//    in E of the rows of U with an entry in E: about n(m+1) rows of m+1
+//    entries, rather than n^2 intersections of columns.
+//-----------------------------------------------------------------------------
+void Vecchia::PrecisionBlock( int n, const int* index, double* G, VecchiaWorkspace& ws ) const
+{
+   const int*    Up = m_U.RowStart();
+   const int*    Uj = m_U.Columns();
+   const double* Ux = m_U.Values();
+   const int*    Tp = m_Ut.RowStart();
+   const int*    Tj = m_Ut.Columns();
+
+   ws.position.resize( nRows(), -1 );
+   ws.touched.resize( nRows(), 0 );
+   ws.rows.clear();
+   for (int a = 0; a < n; ++a) {
+      ws.position[index[a]] = a;
+      for (int p = Tp[index[a]]; p < Tp[index[a]+1]; ++p) {
+         if (!ws.touched[Tj[p]]) {
+            ws.touched[Tj[p]] = 1;
+            ws.rows.push_back( Tj[p] );
+         }
+      }
+   }
+
+   std::fill( G, G + static_cast<std::size_t>(n)*n, 0.0 );
+   for (int l : ws.rows) {
+      ws.entries.clear();
+      ws.values.clear();
+      for (int p = Up[l]; p < Up[l+1]; ++p) {
+         if (ws.position[Uj[p]] >= 0) {
+            ws.entries.push_back( ws.position[Uj[p]] );
+            ws.values.push_back( Ux[p] );
+         }
+      }
+      // Each pair once, into the lower triangle.
+      const int ne = ws.entries.size();
+      for (int a = 0; a < ne; ++a) {
+         const int    ea = ws.entries[a];
+         const double va = ws.values[a];
+         for (int c = 0; c <= a; ++c) {
+            const int ec = ws.entries[c];
+            G[std::max(ea, ec)*n + std::min(ea, ec)] += va * ws.values[c];
+         }
+      }
+   }
+   for (int a = 0; a < n; ++a)
+      for (int c = 0; c < a; ++c)
+         G[c*n + a] = G[a*n + c];
+
+   for (int a = 0; a < n; ++a)
+      ws.position[index[a]] = -1;
+   for (int l : ws.rows)
+      ws.touched[l] = 0;
+}
+
+//-----------------------------------------------------------------------------
+// Multiply
+//-----------------------------------------------------------------------------
+void Vecchia::Multiply( const double* v, double* Qv ) const
+{
+   const int n = nRows();
+   const int*    Up = m_U.RowStart();
+   const int*    Uj = m_U.Columns();
+   const double* Ux = m_U.Values();
+
+   std::vector<double> t(n, 0.0);
+   for (int l = 0; l < n; ++l)
+      for (int p = Up[l]; p < Up[l+1]; ++p)
+         t[l] += Ux[p] * v[Uj[p]];
+
+   std::fill( Qv, Qv + n, 0.0 );
+   for (int l = 0; l < n; ++l)
+      for (int p = Up[l]; p < Up[l+1]; ++p)
+         Qv[Uj[p]] += Ux[p] * t[l];
+}
+
+//-----------------------------------------------------------------------------
+const KdTree& Vecchia::Index() const
+{
+   return m_Index;
+}
+
+//-----------------------------------------------------------------------------
+const std::vector<int>& Vecchia::Order() const
+{
+   return m_Order;
+}
+
+//-----------------------------------------------------------------------------
+const SparseMatrix& Vecchia::Factor() const
+{
+   return m_U;
+}
+
+//-----------------------------------------------------------------------------
+int Vecchia::nRows() const
+{
+   return m_U.nRows();
+}
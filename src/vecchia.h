@@ -0,0 +1,119 @@
+//=============================================================================
+// vecchia.h
+//
+//    The Vecchia approximation of a Gaussian process: a sparse approximation
+//    of the inverse of a covariance matrix C.
+//
+//    The points are put in maxmin order: each point is the one farthest from
+//    all of those before it. The joint density is then approximated by the
+//    product of the conditional densities of each point given only its m
+//    nearest predecessors c(i),
+//
+//       z_i | z_c(i)  ~  N( b_i' z_c(i), d_i ),
+//       b_i = C(c,c)^{-1} C(c,i),   d_i = C(i,i) - C(i,c) b_i,
+//
+//    which is the Gaussian density with precision Q = U'U, where row [i] of
+//    the sparse matrix U holds 1/sqrt(d_i) in column [i] and -b_i/sqrt(d_i)
+//    in the columns c(i). Each row is an independent m x m solve, so the work
+//    and the storage are linear in N for a fixed m.
+//
+// References:
+//
+// o  Vecchia, A.V., 1988, Estimation and model identification for
+//    continuous spatial processes, Journal of the Royal Statistical
+//    Society, Series B, v. 50, no. 2, p. 297-312.
+//
+// o  Guinness, J., 2018, Permutation and grouping methods for sharpening
+//    Gaussian process approximations, Technometrics, v. 60, no. 4,
+//    p. 415-429.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef VECCHIA_H
+#define VECCHIA_H
+
+#include <functional>
+#include <vector>
+
+#include "spatial_index.h"
+#include "sparse_matrix.h"
+
+//-----------------------------------------------------------------------------
+// MaxminOrder
+//
+//    The maxmin order of the points: element [r] is the index of the point
+//    r-th in the order. The first is the point nearest the centroid.
+//-----------------------------------------------------------------------------
+std::vector<int> MaxminOrder(
+   const std::vector<double>& x,
+   const std::vector<double>& y,
+   const KdTree& index
+);
+
+//=============================================================================
+// VecchiaWorkspace
+//
+//    The scratch storage of one thread for Vecchia::PrecisionBlock.
+//=============================================================================
+struct VecchiaWorkspace {
+   std::vector<int>    position;           // of each column in the block; -1 if none
+   std::vector<int>    rows;               // the rows of U that touch the block
+   std::vector<char>   touched;            // of each row; all zero between calls
+   std::vector<int>    entries;            // positions of one row's entries
+   std::vector<double> values;             // and their values
+
+   VecchiaWorkspace();
+};
+
+//=============================================================================
+// Vecchia
+//=============================================================================
+class Vecchia
+{
+public:
+   // Entry (i,j) of the covariance matrix.
+   typedef std::function<double(int i, int j)> EntryFunction;
+
+   Vecchia();
+
+   // Order the points, select the "m" conditioning neighbors of each, and
+   // compute U, on "nthreads" threads. Returns false, and leaves the
+   // approximation empty, if a conditional variance is not numerically
+   // positive.
+   bool Build(
+      const std::vector<double>& x,
+      const std::vector<double>& y,
+      const EntryFunction& covariance,
+      int m,
+      int nthreads );
+
+   // Entry (i,j) of the precision Q = U'U.
+   double Precision( int i, int j ) const;
+
+   // The n x n block Q(index,index), row-major, in G. The indices must be
+   // distinct.
+   void PrecisionBlock( int n, const int* index, double* G, VecchiaWorkspace& ws ) const;
+
+   // Qv = Q v.
+   void Multiply( const double* v, double* Qv ) const;
+
+   const KdTree& Index() const;                          // of the points
+   const std::vector<int>& Order() const;                // the maxmin order
+   const SparseMatrix& Factor() const;                   // U
+   int nRows() const;                                    // 0 if empty
+
+private:
+   KdTree           m_Index;
+   std::vector<int> m_Order;
+   SparseMatrix     m_U;
+   SparseMatrix     m_Ut;              // U', for the columns of U
+};
+
+//=============================================================================
+#endif  // VECCHIA_H
@@ -100,6 +100,144 @@ void Help()
       "                   be overwritten. (See below.) \n"
    << std::endl;
 
+   std::cout <<
+      "Options: \n"
+      "   --progress <seconds>  Print a progress line at most every <seconds> \n"
+      "                   while the engine runs: the observations done, the \n"
+      "                   observations per second, the mean number of active \n"
+      "                   data, and an ETA based upon an M^3 cost model. The \n"
+      "                   default is 30 seconds; 0 turns the reports off. \n"
+      "\n"
+      "   --profile <file>  Write a JSON report of the wall-clock time, CPU time, \n"
+      "                   and call counts of each phase of the run (read, \n"
+      "                   assembly, slice, factorization, solve, pvalue, and \n"
+      "                   output), the peak resident memory, and the number and \n"
+      "                   bytes of Matrix allocations. \n"
+      "\n"
+      "   --counters      Add Linux hardware performance counters (cycles, \n"
+      "                   instructions, last-level cache misses, and branch \n"
+      "                   misses) for each phase to the --profile report. If \n"
+      "                   perf events are unavailable (e.g. in a container) a \n"
+      "                   notice is printed and the run continues without them. \n"
+      "\n"
+      "   --trace <file>  Write a Chrome/Perfetto trace-event JSON file with one \n"
+      "                   span per observation (with the number of active data, \n"
+      "                   M) and spans for the factorization, solve, and I/O \n"
+      "                   phases on each thread. \n"
+      "\n"
+      "   --precision <double|mixed>  The arithmetic of the kriging systems. \n"
+      "                   With 'mixed' each system is assembled and factored in \n"
+      "                   float32, and double-precision results are recovered \n"
+      "                   by iterative refinement; a line reporting the largest \n"
+      "                   differences from the all-double results, on a sample \n"
+      "                   of the observations, is printed at the end of the run. \n"
+      "                   The default is 'double'. \n"
+      "\n"
+      "   --neighbors <K>  Krige each observation from only the K nearest of \n"
+      "                   its active data. With K <= 64 the systems are \n"
+      "                   factored and solved four at a time, in lockstep. The \n"
+      "                   default is to use all of the active data. \n"
+      "\n"
+      "   --taper <distance>  Multiply the covariance by a Wendland taper that \n"
+      "                   falls to zero at <distance>, which must exceed the \n"
+      "                   buffer radius. The tapered covariance matrix is stored \n"
+      "                   sparse and factored once, so the memory grows with N \n"
+      "                   rather than N^2; for very large data sets. \n"
+      "\n"
+      "   --hmatrix <tolerance>  Compress the covariance matrix to a weakly \n"
+      "                   admissible hierarchical (HODLR) matrix, with every \n"
+      "                   off-diagonal block low-rank and accurate to the \n"
+      "                   relative <tolerance> (e.g. 1e-8), and factor it once. \n"
+      "                   The ranks grow with N, so the memory grows as about \n"
+      "                   N^1.3 and the time as about N^1.5, rather than N^2 \n"
+      "                   and N^3; practical up to a few tens of thousands of \n"
+      "                   data. The results differ from the dense ones by \n"
+      "                   roughly the tolerance; a sampled estimate of the \n"
+      "                   error is reported. \n"
+      "\n"
+      "   --vecchia <m>   Replace the inverse of the covariance matrix by the \n"
+      "                   sparse Vecchia approximation, in which each datum, in \n"
+      "                   maxmin order, is conditioned on only its m nearest \n"
+      "                   predecessors (e.g. 30). The memory and the time grow \n"
+      "                   as N m^2, and the results approach the dense ones as \n"
+      "                   m grows; for very large data sets. \n"
+      "\n"
+      "   --nystrom <r>   Replace the covariance matrix by a Nystrom low-rank \n"
+      "                   approximation from r landmark data, chosen farthest \n"
+      "                   first (e.g. 200), plus a diagonal, and solve every \n"
+      "                   kriging system by the Woodbury identity. The memory \n"
+      "                   grows as N r, and the time as N r^2 (r + E), with E \n"
+      "                   the data excluded per observation. The error versus \n"
+      "                   the exact results on a validation sample of the \n"
+      "                   observations is printed at the end of the run. \n"
+      "\n"
+      "   --nystrom-audit <count>  The size of that sample (0 for none). The \n"
+      "                   sample is solved exactly by the --iterative method, \n"
+      "                   in O(N^2) time per iteration, so the default, 16 up \n"
+      "                   to 10000 observations, shrinks as 1/N^2 beyond that, \n"
+      "                   and is none beyond 40000. \n"
+      "\n"
+      "   --iterative <tolerance>  Never form the covariance matrix: solve each \n"
+      "                   kriging system by preconditioned conjugate gradients, \n"
+      "                   to the relative residual <tolerance> (e.g. 1e-10), \n"
+      "                   with the covariances evaluated as they are needed. \n"
+      "                   The memory grows with N rather than N^2. The \n"
+      "                   iteration counts are printed at the end of the run. \n"
+      "                   The output gains Status, Iterations, and Residual \n"
+      "                   columns, and the observations whose systems did not \n"
+      "                   converge are marked unconverged. \n"
+      "\n"
+      "   --screen <p>    Screen every observation first with a neighborhood of \n"
+      "                   the --neighbors nearest active data (default 64), and \n"
+      "                   re-run only those with a p-value below <p> (e.g. 0.05) \n"
+      "                   exactly. The full covariance matrices are filled \n"
+      "                   only if there is such a candidate. The output gains \n"
+      "                   a Status column: exact, or screened for the results \n"
+      "                   of the screening pass. \n"
+      "\n"
+      "   --time-budget <seconds>  Start no observation after <seconds> from \n"
+      "                   the start of the run, or after an interrupt (Ctrl-C), \n"
+      "                   and write the results so far. The output gains a \n"
+      "                   Status column, in which the observations not reached \n"
+      "                   are unfinished. \n"
+      "\n"
+      "   --priority <index|cheapest>  The order in which the observations are \n"
+      "                   evaluated: as read, or the smallest kriging systems \n"
+      "                   first (the default with --time-budget). With --screen, \n"
+      "                   the candidates are confirmed lowest p-value first. \n"
+      "\n"
+      "   --checkpoint <file>  Append each completed result to the binary \n"
+      "                   <file>, with a hash of the input and the parameters. \n"
+      "\n"
+      "   --resume        Take back the results recorded in the --checkpoint \n"
+      "                   file by an earlier run of the same input and \n"
+      "                   parameters, evaluate only the rest, and keep \n"
+      "                   appending to it. Without the file, start afresh. \n"
+      "\n"
+      "   --targets <file>  Evaluate, and write, only the observations whose \n"
+      "                   IDs are listed in <file>, one per line; all of the \n"
+      "                   observations remain kriging data. No matrix of all \n"
+      "                   of the observations is formed, so with --neighbors \n"
+      "                   a few targets take seconds at any size. \n"
+      "\n"
+      "   --bbox <xmin> <ymin> <xmax> <ymax>  As --targets, for the observations \n"
+      "                   within the bounding box. \n"
+      "\n"
+      "   --serve         Read the observations once, then answer requests, one \n"
+      "                   JSON object per line on stdin, with one JSON object \n"
+      "                   per line on stdout, until stdin is closed; the output \n"
+      "                   file is not written. The operations are \"score\" of \n"
+      "                   \"ids\", \"hypothetical\" at \"x\", \"y\" with value \"z\", \n"
+      "                   and \"info\"; a request may give its own \"nugget\", \n"
+      "                   \"sill\", \"range\", \"radius\", and \"neighbors\". A \n"
+      "                   request uses the --neighbors nearest active data \n"
+      "                   (default 64). \n"
+      "\n"
+      "   --serve-socket <path>  As --serve, for any number of clients of the \n"
+      "                   Unix-domain socket <path>, until the process is \n"
+      "                   stopped. \n"
+   << std::endl;
+
    std::cout <<
       "Example: \n"
       "   Webinan 3 25 3500 50 input.csv output.csv \n"
@@ -199,7 +337,7 @@ void Usage()
 {
    std::cout <<
       "Usage: \n"
-      "   Webinan <nugget> <sill> <range> <radius> <input file> <output file> \n"
+      "   Webinan <nugget> <sill> <range> <radius> <input file> <output file> [options] \n"
       "   Webinan --help \n"
       "   Webinan --version \n"
    << std::endl;
@@ -20,34 +20,68 @@
 #include "write_results.h"
 
 //-----------------------------------------------------------------------------
-void write_results( const std::string& outfilename, std::vector<DataRecord> obs, std::vector<Boomerang> results ) {
-
-   // Open the specified output file.
-   std::ofstream outfile( outfilename );
-   if ( outfile.fail() ) {
+// Open the specified output file and write out the header line.
+//-----------------------------------------------------------------------------
+ResultWriter::ResultWriter( const std::string& outfilename, bool status, bool convergence )
+:  m_filename( outfilename ),
+   m_outfile( outfilename ),
+   m_status( status ),
+   m_convergence( convergence )
+{
+   if ( m_outfile.fail() ) {
       std::stringstream message;
       message << "Could not open <" << outfilename << "> for output.";
       throw InvalidOutputFile(message.str());
    }
 
    // Write out the header line to the output file.
-   outfile << "ID,X,Y,Z,Count,Zhat,Kstd,Zeta,pValue" << std::endl;
+   m_outfile << "ID,X,Y,Z,Count,Zhat,Kstd,Zeta,pValue";
+   if ( m_status ) m_outfile << ",Status";
+   if ( m_convergence ) m_outfile << ",Iterations,Residual";
+   m_outfile << std::endl;
 
    // Fill the output file with the observation-by-observation results using
    // a maximum precision .csv format.
-   outfile << std::setprecision(std::numeric_limits<long double>::digits10 + 1);
-
-   for ( unsigned n = 0; n < obs.size(); ++n ) {
-      outfile << obs[n].id << ',';
-      outfile << obs[n].x  << ',';
-      outfile << obs[n].y  << ',';
-      outfile << obs[n].z  << ',';
-      outfile << results[n].cnt  << ',';
-      outfile << results[n].zhat << ',';
-      outfile << results[n].kstd << ',';
-      outfile << results[n].zeta << ',';
-      outfile << results[n].pvalue;
-      outfile << std::endl;
+   m_outfile << std::setprecision(std::numeric_limits<long double>::digits10 + 1);
+}
+
+//-----------------------------------------------------------------------------
+// Write out the results for one observation.
+//-----------------------------------------------------------------------------
+void ResultWriter::Write( const DataRecord& obs, const Boomerang& result, const char* status,
+                          int iterations, double residual )
+{
+   m_outfile << obs.id << ',';
+   m_outfile << obs.x  << ',';
+   m_outfile << obs.y  << ',';
+   m_outfile << obs.z  << ',';
+   m_outfile << result.cnt  << ',';
+   m_outfile << result.zhat << ',';
+   m_outfile << result.kstd << ',';
+   m_outfile << result.zeta << ',';
+   m_outfile << result.pvalue;
+   if ( m_status ) m_outfile << ',' << status;
+   if ( m_convergence ) m_outfile << ',' << iterations << ',' << residual;
+   m_outfile << '\n';
+}
+
+//-----------------------------------------------------------------------------
+void ResultWriter::Close()
+{
+   m_outfile.close();
+   if ( m_outfile.fail() ) {
+      std::stringstream message;
+      message << "Writing to <" << m_filename << "> failed.";
+      throw InvalidOutputFile(message.str());
    }
-   outfile.close();
+}
+
+//-----------------------------------------------------------------------------
+void write_results( const std::string& outfilename, std::vector<DataRecord> obs, std::vector<Boomerang> results ) {
+   ResultWriter writer( outfilename );
+
+   for ( unsigned n = 0; n < obs.size(); ++n )
+      writer.Write( obs[n], results[n] );
+
+   writer.Close();
 }
@@ -12,11 +12,14 @@
 #ifndef WRITE_RESULTS_H
 #define WRITE_RESULTS_H
 
+#include <fstream>
 #include <stdexcept>
 #include <string>
 #include <tuple>
 #include <vector>
 
+#include "engine.h"
+
 //-----------------------------------------------------------------------------
 class InvalidOutputFile : public std::runtime_error {
    public :
@@ -24,6 +27,30 @@ class InvalidOutputFile : public std::runtime_error {
       }
 };
 
+//-----------------------------------------------------------------------------
+// ResultWriter
+//
+//    Writes the output file one observation at a time, so the results can be
+//    streamed out while the engine is still running. With "status", each
+//    line ends with a Status column, e.g. "exact" or "screened". With
+//    "convergence", it ends with the Iterations and Residual of its
+//    iterative solution.
+//-----------------------------------------------------------------------------
+class ResultWriter {
+   public :
+      explicit ResultWriter( const std::string& outfilename, bool status = false, bool convergence = false );
+
+      void Write( const DataRecord& obs, const Boomerang& result, const char* status = "",
+                  int iterations = 0, double residual = 0.0 );
+      void Close();
+
+   private :
+      std::string   m_filename;
+      std::ofstream m_outfile;
+      bool          m_status;
+      bool          m_convergence;
+};
+
 //-----------------------------------------------------------------------------
 void write_results( const std::string& outfilename, std::vector<DataRecord> obs, std::vector<Boomerang> results );
 
@@ -0,0 +1,180 @@
+//=============================================================================
+// test_arena.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "test_arena.h"
+#include "unit_test.h"
+#include "..\src\arena.h"
+#include "..\src\matrix.h"
+
+//-----------------------------------------------------------------------------
+// Hide all of the testing details inside an unnamed namespace. This allows me
+// to create many small unit tests with polluting the global namespace.
+//-----------------------------------------------------------------------------
+namespace{
+   const double TOLERANCE = 1e-9;
+
+   //--------------------------------------------------------------------------
+   bool isAligned( const void* p )
+   {
+      return reinterpret_cast<std::uintptr_t>(p) % ARENA_ALIGNMENT == 0;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestDefaultResourceAlignment
+   //--------------------------------------------------------------------------
+   bool TestDefaultResourceAlignment()
+   {
+      MemoryResource* resource = DefaultResource();
+
+      bool flag = true;
+
+      for (std::size_t bytes = 1; bytes < 1000; bytes += 37) {
+         void* p = resource->Allocate( bytes );
+         flag &= CHECK( isAligned(p) );
+         resource->Deallocate( p, bytes );
+      }
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestArenaAllocate
+   //--------------------------------------------------------------------------
+   bool TestArenaAllocate()
+   {
+      Arena arena( 1024 );
+
+      bool flag = true;
+
+      char* p = static_cast<char*>( arena.Allocate( 10 ) );
+      char* q = static_cast<char*>( arena.Allocate( 100 ) );
+      double* r = arena.Allocate<double>( 3 );
+
+      flag &= CHECK( isAligned(p) && isAligned(q) && isAligned(r) );
+      flag &= CHECK( q == p + ARENA_ALIGNMENT );
+      flag &= CHECK( reinterpret_cast<char*>(r) == q + 2*ARENA_ALIGNMENT );
+      flag &= CHECK( arena.Used() == 4*ARENA_ALIGNMENT );
+      flag &= CHECK( arena.Capacity() == 1024 );
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestArenaReset
+   //--------------------------------------------------------------------------
+   bool TestArenaReset()
+   {
+      Arena arena( 1024 );
+
+      bool flag = true;
+
+      void* p = arena.Allocate( 500 );
+      arena.Allocate( 500 );
+      arena.Reset();
+
+      const long long count = AllocationCount();
+      flag &= CHECK( arena.Used() == 0 );
+      flag &= CHECK( arena.Allocate( 500 ) == p );
+      flag &= CHECK( AllocationCount() == count );
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestArenaGrowth
+   //--------------------------------------------------------------------------
+   bool TestArenaGrowth()
+   {
+      Arena arena;
+
+      bool flag = true;
+
+      // Overflow the first chunk several times.
+      for (int i = 0; i < 10; ++i) {
+         double* p = arena.Allocate<double>( 1000 );
+         p[0] = p[999] = i;
+         flag &= CHECK( isAligned(p) );
+      }
+      flag &= CHECK( arena.Used() >= 10*1000*sizeof(double) );
+
+      // After the Reset, the same cycle fits in a single chunk.
+      arena.Reset();
+      const std::size_t capacity = arena.Capacity();
+      const long long count = AllocationCount();
+
+      for (int i = 0; i < 10; ++i)
+         arena.Allocate<double>( 1000 );
+
+      flag &= CHECK( AllocationCount() == count );
+      flag &= CHECK( arena.Capacity() == capacity );
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestMatrixOnArena
+   //--------------------------------------------------------------------------
+   bool TestMatrixOnArena()
+   {
+      Arena arena( 4096 );
+
+      bool flag = true;
+
+      Matrix A( &arena );
+      A.Resize( 3, 3 );
+      A(1,2) = 5.0;
+
+      flag &= CHECK( A.Resource() == &arena );
+      flag &= CHECK( isAligned(A.Base()) );
+      flag &= CHECK( arena.Used() >= 9*sizeof(double) );
+
+      // A copy draws from the default resource.
+      Matrix B( A );
+      flag &= CHECK( B.Resource() == DefaultResource() );
+      flag &= CHECK( isClose(A, B, TOLERANCE) );
+
+      // A move between resources takes the storage with its resource.
+      const double* base = B.Base();
+      Matrix C( &arena );
+      C = std::move( B );
+      flag &= CHECK( C.Resource() == DefaultResource() );
+      flag &= CHECK( C.Base() == base );
+      flag &= CHECK( B.Base() == nullptr );
+      flag &= CHECK( isClose(A, C, TOLERANCE) );
+
+      // A move within a resource steals the storage.
+      base = A.Base();
+      Matrix D( &arena );
+      D = std::move( A );
+      flag &= CHECK( D.Resource() == &arena );
+      flag &= CHECK( D.Base() == base );
+      flag &= CHECK( A.Base() == nullptr );
+      flag &= CHECK( std::is_nothrow_move_assignable<Matrix>::value );
+      return flag;
+   }
+}
+
+//-----------------------------------------------------------------------------
+// test_Arena
+//-----------------------------------------------------------------------------
+std::pair<int,int> test_Arena()
+{
+   int nsucc = 0;
+   int nfail = 0;
+
+   TALLY( TestDefaultResourceAlignment() );
+   TALLY( TestArenaAllocate() );
+   TALLY( TestArenaReset() );
+   TALLY( TestArenaGrowth() );
+   TALLY( TestMatrixOnArena() );
+
+   return std::make_pair( nsucc, nfail );
+}
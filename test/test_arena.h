@@ -0,0 +1,21 @@
+//=============================================================================
+// test_arena.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef TEST_ARENA_H
+#define TEST_ARENA_H
+
+#include <utility>
+
+//-----------------------------------------------------------------------------
+std::pair<int,int> test_Arena();
+
+//=============================================================================
+#endif  // TEST_ARENA_H
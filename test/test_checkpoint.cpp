@@ -0,0 +1,256 @@
+//=============================================================================
+// test_checkpoint.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "test_checkpoint.h"
+#include "unit_test.h"
+#include "..\src\checkpoint.h"
+#include "..\src\pipeline.h"
+
+//-----------------------------------------------------------------------------
+// Hide all of the testing details inside an unnamed namespace. This allows me
+// to create many small unit tests with polluting the global namespace.
+//-----------------------------------------------------------------------------
+namespace{
+   const char* const FILENAME   = "test_checkpoint.tmp";
+   const char* const DATANAME   = "test_checkpoint_data.tmp";
+   const char* const OUTPUTNAME = "test_checkpoint_output.tmp";
+   const char* const PARAMETERS = "nugget=2 sill=16";
+   const int N = 1000;
+
+   Boomerang Result( int k )
+   {
+      return Boomerang{ 100.0 + k, 1.0 + 0.01*k, 0.5 - 0.001*k, 0.001*k, k % 37 };
+   }
+
+   bool Same( const CheckpointEntry& entry, int k, int status )
+   {
+      const Boomerang r = Result(k);
+      return entry.k == k && entry.status == status && entry.result.cnt == r.cnt &&
+             entry.result.zhat == r.zhat && entry.result.kstd == r.kstd &&
+             entry.result.zeta == r.zeta && entry.result.pvalue == r.pvalue &&
+             entry.iterations == k % 7 && entry.residual == 1e-9*k;
+   }
+
+   // The whole of a file.
+   std::string Contents( const char* filename )
+   {
+      std::ifstream file( filename, std::ios::binary );
+      return std::string( std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() );
+   }
+
+   // The lines of the output file, less the header, split at the commas.
+   std::vector<std::vector<std::string>> Rows( const char* filename )
+   {
+      std::ifstream file( filename );
+      std::vector<std::vector<std::string>> rows;
+      std::string line;
+      std::getline( file, line );
+      while (std::getline(file, line)) {
+         std::vector<std::string> fields;
+         std::stringstream text( line );
+         for (std::string field; std::getline(text, field, ','); )
+            fields.push_back( field );
+         rows.push_back( fields );
+      }
+      return rows;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestCheckpointResume
+   //
+   //    The entries appended must be loaded back exactly, in order. A record
+   //    cut short must be ignored, and overwritten by the next run.
+   //--------------------------------------------------------------------------
+   bool TestCheckpointResume()
+   {
+      std::remove( FILENAME );
+      bool flag = true;
+
+      std::vector<CheckpointEntry> entries;
+      {
+         Checkpoint checkpoint( FILENAME, 12345, PARAMETERS, N );
+         flag &= CHECK( !checkpoint.Load(entries) );
+         checkpoint.Open();
+         for (int k = 0; k < 600; ++k)
+            checkpoint.Append( k, k % 2, Result(k), k % 7, 1e-9*k );
+         checkpoint.Close();
+      }
+
+      // Half of a record, as if the run had been killed while writing it.
+      {
+         std::ofstream file( FILENAME, std::ios::binary | std::ios::app );
+         file.write( "\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a", 10 );
+      }
+
+      {
+         Checkpoint checkpoint( FILENAME, 12345, PARAMETERS, N );
+         flag &= CHECK( checkpoint.Load(entries) );
+         flag &= CHECK( entries.size() == 600 );
+         checkpoint.Open();
+         for (int k = 600; k < N; ++k)
+            checkpoint.Append( k, 1, Result(k), k % 7, 1e-9*k );
+         checkpoint.Close();
+      }
+
+      {
+         Checkpoint checkpoint( FILENAME, 12345, PARAMETERS, N );
+         flag &= CHECK( checkpoint.Load(entries) );
+         flag &= CHECK( entries.size() == N );
+         for (int k = 0; k < N && k < static_cast<int>(entries.size()); ++k)
+            flag &= CHECK( Same(entries[k], k, (k < 600) ? k % 2 : 1) );
+      }
+
+      std::remove( FILENAME );
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestCheckpointMismatch
+   //
+   //    A checkpoint of other data, or of other parameters, must be refused,
+   //    and the hash must see a change of a single coordinate.
+   //--------------------------------------------------------------------------
+   bool TestCheckpointMismatch()
+   {
+      std::remove( FILENAME );
+      bool flag = true;
+
+      std::vector<DataRecord> obs;
+      for (int i = 0; i < 20; ++i) {
+         DataRecord rec = { "W" + std::to_string(i), 10.0*i, 5.0*i, 100.0 - i };
+         obs.push_back(rec);
+      }
+      const unsigned long long hash = HashObservations(obs);
+      obs[7].y += 1e-9;
+      flag &= CHECK( HashObservations(obs) != hash );
+
+      {
+         Checkpoint checkpoint( FILENAME, hash, PARAMETERS, N );
+         checkpoint.Open();
+         checkpoint.Append( 3, 1, Result(3) );
+         checkpoint.Close();
+      }
+
+      std::vector<CheckpointEntry> entries;
+      bool refused = false;
+      try {
+         Checkpoint checkpoint( FILENAME, HashObservations(obs), PARAMETERS, N );
+         checkpoint.Load(entries);
+      }
+      catch (InvalidCheckpointFile&) {
+         refused = true;
+      }
+      flag &= CHECK( refused );
+
+      refused = false;
+      try {
+         Checkpoint checkpoint( FILENAME, hash, "nugget=2 sill=17", N );
+         checkpoint.Load(entries);
+      }
+      catch (InvalidCheckpointFile&) {
+         refused = true;
+      }
+      flag &= CHECK( refused );
+
+      std::remove( FILENAME );
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestCheckpointIterative
+   //
+   //    An iterative run with a tolerance too tight for most systems must be
+   //    resumed, from the whole of its checkpoint and from a part of it, to
+   //    the same output: the Status, Iterations, and Residual of every row,
+   //    "unconverged" ones among them, are restored as they were written.
+   //--------------------------------------------------------------------------
+   bool TestCheckpointIterative()
+   {
+      const int n = 80;
+      std::vector<double> x, y;
+      ScatteredPoints(n, x, y, false);
+      {
+         std::ofstream data( DATANAME );
+         data.precision(17);
+         for (int i = 0; i < n; ++i)
+            data << "W" << i << ',' << x[i] << ',' << y[i] << ',' << 100.0 + 5.0*sin(0.05*x[i]) + 0.3*(i % 7) << '\n';
+      }
+      std::remove( FILENAME );
+
+      EngineOptions options;
+      options.iterative = 1e-200;
+
+      bool flag = true;
+
+      Pipeline( 2.0, 16.0, 1000.0, 50.0, DATANAME, OUTPUTNAME, FILENAME, false, TargetSelection(), options );
+      const std::string original = Contents( OUTPUTNAME );
+      const std::vector<std::vector<std::string>> rows = Rows( OUTPUTNAME );
+
+      int unconverged = 0;
+      flag &= CHECK( rows.size() == static_cast<std::size_t>(n) );
+      for (const auto& row : rows) {
+         flag &= CHECK( row.size() == 12 );
+         if (row.size() == 12 && row[9] == "unconverged") {
+            ++unconverged;
+            flag &= CHECK( atoi(row[10].c_str()) > 0 );
+            flag &= CHECK( !(strtod(row[11].c_str(), nullptr) <= options.iterative) );
+         }
+      }
+      flag &= CHECK( unconverged > 0 );
+
+      // Everything restored.
+      Pipeline( 2.0, 16.0, 1000.0, 50.0, DATANAME, OUTPUTNAME, FILENAME, true, TargetSelection(), options );
+      flag &= CHECK( Contents(OUTPUTNAME) == original );
+
+      // The header and the first half of the records, as if the run had been
+      // killed there.
+      const std::string checkpoint = Contents( FILENAME );
+      const std::size_t record = 4*4 + 5*8;
+      const std::size_t header = checkpoint.size() - n*record;
+      {
+         std::ofstream file( FILENAME, std::ios::binary | std::ios::trunc );
+         file.write( checkpoint.data(), header + (n/2)*record );
+      }
+      Pipeline( 2.0, 16.0, 1000.0, 50.0, DATANAME, OUTPUTNAME, FILENAME, true, TargetSelection(), options );
+      flag &= CHECK( Contents(OUTPUTNAME) == original );
+
+      std::remove( FILENAME );
+      std::remove( DATANAME );
+      std::remove( OUTPUTNAME );
+      return flag;
+   }
+}
+
+
+//-----------------------------------------------------------------------------
+// test_Checkpoint
+//-----------------------------------------------------------------------------
+std::pair<int,int> test_Checkpoint()
+{
+   int nsucc = 0;
+   int nfail = 0;
+
+   TALLY( TestCheckpointResume() );
+   TALLY( TestCheckpointMismatch() );
+   TALLY( TestCheckpointIterative() );
+
+   return std::make_pair( nsucc, nfail );
+}
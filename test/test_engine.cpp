@@ -9,11 +9,18 @@
 // version:
 //    2 July 2017
 //=============================================================================
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
 #include <utility>
 
 #include "test_engine.h"
 #include "unit_test.h"
 #include "..\src\engine.h"
+#include "..\src\linear_systems.h"
+#include "..\src\matrix.h"
+#include "..\src\sparse_matrix.h"
 
 //-----------------------------------------------------------------------------
 // Hide all of the testing details inside an unnamed namespace. This allows me
@@ -98,6 +105,736 @@ namespace{
 
       return true;
    }
+
+   //--------------------------------------------------------------------------
+   // TestEngineOrdering
+   //
+   //    The streaming engine must hand the results to the sink in order, and
+   //    the results must not depend upon the number of worker threads.
+   //--------------------------------------------------------------------------
+   bool TestEngineOrdering()
+   {
+      std::vector<DataRecord> obs;
+      for (int i = 0; i < 8; ++i)
+         for (int j = 0; j < 8; ++j) {
+            DataRecord rec = { "", 100.0*i, 100.0*j + 7.0*i, 100.0 + i - j + 0.1*((i*j)%5) };
+            obs.push_back(rec);
+         }
+
+      std::vector<Boomerang> serial = Engine(2.0, 16.0, 1000.0, 150.0, obs);
+
+      Assembly assembly(2.0, 16.0, 1000.0);
+      for (const auto& rec : obs)
+         assembly.Append(rec);
+
+      Matrix D, C;
+      assembly.Finalize(D, C, 2);
+
+      bool flag = true;
+      int expected = 0;
+
+      EngineOptions options;
+      options.nthreads = 3;
+
+      ProgressReport last = ProgressReport();
+      std::mutex mutex;
+      options.progress = [&](const ProgressReport& report) {
+         std::lock_guard<std::mutex> lock(mutex);
+         if (report.done > last.done) last = report;
+      };
+
+      Engine( 16.0, 150.0, obs, D, C, [&](int k, const Boomerang& r) {
+         flag &= CHECK( k == expected++ );
+         flag &= CHECK( r.cnt == serial[k].cnt );
+         flag &= CHECK( isClose(r.zhat, serial[k].zhat, TOLERANCE) );
+         flag &= CHECK( isClose(r.kstd, serial[k].kstd, TOLERANCE) );
+      }, options );
+
+      flag &= CHECK( expected == int(obs.size()) );
+      flag &= CHECK( last.done == int(obs.size()) && last.total == int(obs.size()) );
+      flag &= CHECK( isClose(last.eta, 0.0, TOLERANCE) );
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestEngineTargets
+   //
+   //    With options.targets, only those observations are evaluated, in
+   //    order, with the same results as in a full run, batched or not.
+   //--------------------------------------------------------------------------
+   bool TestEngineTargets()
+   {
+      std::vector<DataRecord> obs;
+      for (int i = 0; i < 8; ++i)
+         for (int j = 0; j < 8; ++j) {
+            DataRecord rec = { "", 100.0*i, 100.0*j + 7.0*i, 100.0 + i - j + 0.1*((i*j)%5) };
+            obs.push_back(rec);
+         }
+
+      Assembly assembly(2.0, 16.0, 1000.0);
+      for (const auto& rec : obs)
+         assembly.Append(rec);
+
+      Matrix D, C;
+      assembly.Finalize(D, C, 2);
+
+      bool flag = true;
+      for (int neighbors : { 0, 20 }) {
+         EngineOptions options;
+         options.nthreads = 3;
+         options.neighbors = neighbors;
+
+         std::vector<Boomerang> full(obs.size());
+         Engine( 16.0, 150.0, obs, D, C, [&](int k, const Boomerang& r) { full[k] = r; }, options );
+
+         options.targets = { 1, 2, 3, 9, 30, 31, 50, 63 };
+         std::vector<int> seen;
+         Engine( 16.0, 150.0, obs, D, C, [&](int k, const Boomerang& r) {
+            seen.push_back(k);
+            flag &= CHECK( r.cnt == full[k].cnt );
+            flag &= CHECK( isClose(r.zhat, full[k].zhat, TOLERANCE) );
+            flag &= CHECK( isClose(r.pvalue, full[k].pvalue, TOLERANCE) );
+         }, options );
+         flag &= CHECK( seen == options.targets );
+      }
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestEngineLocal
+   //
+   //    The local engine must evaluate only the targets, in order, with the
+   //    results of the dense engine, for all of the data or a neighborhood.
+   //--------------------------------------------------------------------------
+   bool TestEngineLocal()
+   {
+      std::vector<DataRecord> obs;
+      for (int i = 0; i < 9; ++i)
+         for (int j = 0; j < 9; ++j) {
+            DataRecord rec = { "", 90.0*i + 11.0*j, 100.0*j + 7.0*i, 100.0 + i - j + 0.1*((i*j)%5) };
+            obs.push_back(rec);
+         }
+
+      Assembly assembly(2.0, 16.0, 1000.0);
+      for (const auto& rec : obs)
+         assembly.Append(rec);
+      Assembly local = assembly;
+
+      Matrix D, C;
+      assembly.Finalize(D, C, 2);
+      Locations L;
+      local.Finalize(L);
+
+      bool flag = true;
+      for (int neighbors : { 0, 20 }) {
+         EngineOptions options;
+         options.nthreads = 3;
+         options.neighbors = neighbors;
+
+         std::vector<Boomerang> full(obs.size());
+         Engine( 16.0, 150.0, obs, D, C, [&](int k, const Boomerang& r) { full[k] = r; }, options );
+
+         options.targets = { 0, 4, 17, 40, 41, 66, 80 };
+         std::vector<int> seen;
+         Engine( 16.0, 150.0, obs, L, [&](int k, const Boomerang& r) {
+            seen.push_back(k);
+            flag &= CHECK( r.cnt == full[k].cnt );
+            flag &= CHECK( isClose(r.zhat, full[k].zhat, TOLERANCE) );
+            flag &= CHECK( isClose(r.kstd, full[k].kstd, TOLERANCE) );
+            flag &= CHECK( isClose(r.pvalue, full[k].pvalue, TOLERANCE) );
+         }, options );
+         flag &= CHECK( seen == options.targets );
+      }
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestEngineStopping
+   //
+   //    PRIORITY_CHEAPEST must evaluate the smallest systems first, with the
+   //    same results. A raised cancellation flag or a deadline already passed
+   //    must stop the engine before it evaluates anything.
+   //--------------------------------------------------------------------------
+   bool TestEngineStopping()
+   {
+      std::vector<DataRecord> obs;
+      for (int i = 0; i < 8; ++i)
+         for (int j = 0; j < 8; ++j) {
+            DataRecord rec = { "", 40.0*i*i, 100.0*j + 7.0*i, 100.0 + i - j + 0.1*((i*j)%5) };
+            obs.push_back(rec);
+         }
+      const int N = obs.size();
+
+      Assembly assembly(2.0, 16.0, 1000.0);
+      for (const auto& rec : obs)
+         assembly.Append(rec);
+
+      Matrix D, C;
+      assembly.Finalize(D, C, 2);
+
+      bool flag = true;
+      EngineOptions options;
+      options.nthreads = 3;
+
+      std::vector<Boomerang> full(N);
+      Engine( 16.0, 150.0, obs, D, C, [&](int k, const Boomerang& r) { full[k] = r; }, options );
+
+      options.priority = PRIORITY_CHEAPEST;
+      std::vector<int> seen;
+      Engine( 16.0, 150.0, obs, D, C, [&](int k, const Boomerang& r) {
+         seen.push_back(k);
+         flag &= CHECK( r.cnt == full[k].cnt );
+         flag &= CHECK( isClose(r.zhat, full[k].zhat, TOLERANCE) );
+      }, options );
+      flag &= CHECK( static_cast<int>(seen.size()) == N );
+      for (std::size_t i = 1; i < seen.size(); ++i)
+         flag &= CHECK( full[seen[i-1]].cnt <= full[seen[i]].cnt );
+
+      int count = 0;
+      std::atomic<bool> cancel( true );
+      options.cancel = &cancel;
+      Engine( 16.0, 150.0, obs, D, C, [&](int, const Boomerang&) { ++count; }, options );
+      flag &= CHECK( count == 0 );
+
+      options.cancel = nullptr;
+      options.deadline = 1e-9;
+      Engine( 16.0, 150.0, obs, D, C, [&](int, const Boomerang&) { ++count; }, options );
+      flag &= CHECK( count == 0 );
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestEngineAllocations
+   //
+   //    Once the worker has its workspace, evaluating the observations and
+   //    handing the results to the sink must not touch the heap. The
+   //    progress callback runs on the worker after every observation.
+   //--------------------------------------------------------------------------
+   bool TestEngineAllocations()
+   {
+      std::vector<DataRecord> obs;
+      for (int i = 0; i < 10; ++i)
+         for (int j = 0; j < 10; ++j) {
+            DataRecord rec = { "", 50.0*i + 3.0*j, 50.0*j, 100.0 + 0.3*i*j - j };
+            obs.push_back(rec);
+         }
+      const int N = obs.size();
+
+      Assembly assembly(2.0, 16.0, 1000.0);
+      for (const auto& rec : obs)
+         assembly.Append(rec);
+
+      Matrix D, C;
+      assembly.Finalize(D, C, 1);
+
+      long long first = -1;
+      long long last  = -1;
+
+      EngineOptions options;
+      options.nthreads = 1;
+      options.progress_interval = 0.0;
+      options.progress = [&](const ProgressReport& report) {
+         if (report.done == 2) first = AllocationCount();
+         if (report.done == N) last  = AllocationCount();
+      };
+
+      int count = 0;
+      Engine( 16.0, 75.0, obs, D, C, [&](int, const Boomerang&) { ++count; }, options );
+
+      return count == N && first >= 0 && last == first;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestEngineMixedPrecision
+   //
+   //    The float32 factorization with iterative refinement must reproduce
+   //    the all-double results to near double precision, and report so.
+   //--------------------------------------------------------------------------
+   bool TestEngineMixedPrecision()
+   {
+      std::vector<DataRecord> obs;
+      for (int i = 0; i < 10; ++i)
+         for (int j = 0; j < 10; ++j) {
+            DataRecord rec = { "", 40.0*i + 5.0*j, 40.0*j - 3.0*i, 100.0 + 0.2*i*j - 0.5*j + ((i+j)%3) };
+            obs.push_back(rec);
+         }
+
+      std::vector<Boomerang> serial = Engine(2.0, 16.0, 500.0, 60.0, obs);
+
+      Assembly assembly(2.0, 16.0, 500.0);
+      for (const auto& rec : obs)
+         assembly.Append(rec);
+
+      Matrix D, C;
+      assembly.Finalize(D, C, 1);
+
+      EngineOptions options;
+      options.nthreads = 2;
+      options.precision = PRECISION_MIXED;
+
+      PrecisionReport report;
+      int reports = 0;
+      options.precision_report = [&](const PrecisionReport& r) { report = r; ++reports; };
+
+      bool flag = true;
+
+      Engine( 16.0, 60.0, obs, D, C, [&](int k, const Boomerang& r) {
+         flag &= CHECK( r.cnt == serial[k].cnt );
+         flag &= CHECK( isClose(r.zhat, serial[k].zhat, 1e-10*fabs(serial[k].zhat)) );
+         flag &= CHECK( isClose(r.kstd, serial[k].kstd, 1e-10*serial[k].kstd) );
+      }, options );
+
+      flag &= CHECK( reports == 1 );
+      flag &= CHECK( report.systems == int(obs.size()) );
+      flag &= CHECK( report.fallbacks == 0 );
+      flag &= CHECK( report.max_solves >= 2 );
+      flag &= CHECK( report.audited > 0 );
+      flag &= CHECK( report.max_zhat_error < 1e-10 && report.max_kstd_error < 1e-10 );
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestEngineNeighbors
+   //
+   //    With a neighbor limit, each observation must be kriged from exactly
+   //    the nearest of its active data. The reference is the Ordinary Kriging
+   //    system solved directly, with the general Matrix routines. The limits
+   //    cover the batched path, with a partial last batch, and the
+   //    observation-at-a-time path.
+   //--------------------------------------------------------------------------
+   bool TestEngineNeighbors()
+   {
+      const double nugget = 2.0, sill = 16.0, range = 500.0, radius = 60.0;
+
+      std::vector<DataRecord> obs;
+      for (int i = 0; i < 11; ++i)
+         for (int j = 0; j < 9; ++j) {
+            DataRecord rec = { "", 40.0*i + 5.0*j, 40.0*j - 3.0*i, 100.0 + 0.2*i*j - 0.5*j + ((i+j)%3) };
+            obs.push_back(rec);
+         }
+      const int N = obs.size();
+
+      Assembly assembly(nugget, sill, range);
+      for (const auto& rec : obs)
+         assembly.Append(rec);
+
+      Matrix D, C;
+      assembly.Finalize(D, C, 1);
+
+      bool flag = true;
+
+      const int limits[] = {13, 30, 70};
+      for (int K : limits) {
+         EngineOptions options;
+         options.nthreads = 2;
+         options.neighbors = K;
+
+         std::vector<Boomerang> results(N);
+         Engine( sill, radius, obs, D, C, [&](int k, const Boomerang& r) { results[k] = r; }, options );
+
+         for (int k = 0; k < N; k += (k < N-8) ? 7 : 1) {
+            std::vector<std::pair<double,int>> near;
+            for (int j = 0; j < N; ++j)
+               if (j != k && D(k,j) >= radius) near.push_back( std::make_pair(D(k,j), j) );
+            std::sort( near.begin(), near.end() );
+
+            const int M = std::min<int>( K, near.size() );
+            Matrix A(M, M), L, b(M, 1), ones(M, 1), u, v;
+            for (int r = 0; r < M; ++r) {
+               for (int c = 0; c < M; ++c)
+                  A(r,c) = C(near[r].second, near[c].second);
+               b(r,0) = C(near[r].second, k);
+               ones(r,0) = 1.0;
+            }
+            CholeskyDecomposition(A, L);
+            CholeskySolve(L, b, u);
+            CholeskySolve(L, ones, v);
+
+            double sum_u = 0.0, sum_v = 0.0;
+            for (int r = 0; r < M; ++r) {
+               sum_u += u(r,0);
+               sum_v += v(r,0);
+            }
+            const double lambda = (sum_u - 1.0) / sum_v;
+
+            double zhat = 0.0, bw = 0.0;
+            for (int r = 0; r < M; ++r) {
+               const double w = u(r,0) - lambda*v(r,0);
+               zhat += w * obs[near[r].second].z;
+               bw   += w * b(r,0);
+            }
+            const double kstd = sqrt( sill - bw - lambda );
+
+            flag &= CHECK( results[k].cnt == M );
+            flag &= CHECK( isClose(results[k].zhat, zhat, 1e-10*fabs(zhat)) );
+            flag &= CHECK( isClose(results[k].kstd, kstd, 1e-10*kstd) );
+         }
+      }
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestEngineTapered
+   //
+   //    The tapered engine, which evaluates every observation from the one
+   //    sparse factor, must reproduce the dense engine run on the same
+   //    tapered covariance matrix, and the sparse assembly must hold exactly
+   //    the entries within the taper distance.
+   //--------------------------------------------------------------------------
+   bool TestEngineTapered()
+   {
+      const double nugget = 2.0, sill = 16.0, range = 500.0, radius = 60.0, taper = 150.0;
+
+      std::vector<DataRecord> obs;
+      for (int i = 0; i < 12; ++i)
+         for (int j = 0; j < 10; ++j) {
+            DataRecord rec = { "", 40.0*i + 5.0*j + 3.0*((i*j)%4), 40.0*j - 3.0*i, 100.0 + 0.2*i*j - 0.5*j + ((i+j)%3) };
+            obs.push_back(rec);
+         }
+      const int N = obs.size();
+
+      Assembly dense(nugget, sill, range), sparse(nugget, sill, range);
+      for (const auto& rec : obs) {
+         dense.Append(rec);
+         sparse.Append(rec);
+      }
+
+      Matrix D, C;
+      dense.Finalize(D, C, 1);
+
+      SparseMatrix S;
+      sparse.Finalize(taper, S, 2);
+
+      bool flag = true;
+
+      int entries = 0;
+      for (int i = 0; i < N; ++i) {
+         for (int j = 0; j < N; ++j) {
+            if (D(i,j) < taper) {
+               const double t = D(i,j) / taper;
+               if (i != j) C(i,j) *= pow(1.0 - t, 4) * (4.0*t + 1.0);
+               flag &= CHECK( isClose(S(i,j), C(i,j), 1e-14*sill) );
+               ++entries;
+            }
+            else {
+               C(i,j) = 0.0;
+            }
+         }
+      }
+      flag &= CHECK( S.NonZeros() == entries );
+
+      EngineOptions options;
+      options.nthreads = 2;
+
+      std::vector<Boomerang> reference(N);
+      Engine( sill, radius, obs, D, C, [&](int k, const Boomerang& r) { reference[k] = r; }, options );
+
+      options.taper = taper;
+      int count = 0;
+      Engine( sill, radius, obs, S, [&](int k, const Boomerang& r) {
+         flag &= CHECK( r.cnt == reference[k].cnt );
+         flag &= CHECK( isClose(r.zhat, reference[k].zhat, 1e-9*fabs(reference[k].zhat)) );
+         flag &= CHECK( isClose(r.kstd, reference[k].kstd, 1e-9*reference[k].kstd) );
+         flag &= CHECK( isClose(r.pvalue, reference[k].pvalue, 1e-6) );
+         ++count;
+      }, options );
+      flag &= CHECK( count == N );
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestEngineHierarchical
+   //
+   //    The hierarchical engine, with the covariance compressed to a tight
+   //    tolerance, must reproduce the dense engine closely.
+   //--------------------------------------------------------------------------
+   bool TestEngineHierarchical()
+   {
+      const double nugget = 2.0, sill = 16.0, range = 500.0, radius = 60.0;
+
+      std::vector<DataRecord> obs;
+      for (int i = 0; i < 15; ++i)
+         for (int j = 0; j < 20; ++j) {
+            DataRecord rec = { "", 40.0*i + 5.0*j + 3.0*((i*j)%4), 40.0*j - 3.0*i, 100.0 + 0.2*i*j - 0.5*j + ((i+j)%3) };
+            obs.push_back(rec);
+         }
+      const int N = obs.size();
+
+      Assembly dense(nugget, sill, range), hierarchical(nugget, sill, range);
+      for (const auto& rec : obs) {
+         dense.Append(rec);
+         hierarchical.Append(rec);
+      }
+
+      Matrix D, C;
+      dense.Finalize(D, C, 1);
+
+      HMatrix H;
+      hierarchical.Finalize(1e-12, H, 2);
+
+      EngineOptions options;
+      options.nthreads = 2;
+
+      std::vector<Boomerang> reference(N);
+      Engine( sill, radius, obs, D, C, [&](int k, const Boomerang& r) { reference[k] = r; }, options );
+
+      bool flag = true;
+
+      options.hmatrix = 1e-12;
+      int count = 0;
+      Engine( sill, radius, obs, H, [&](int k, const Boomerang& r) {
+         flag &= CHECK( r.cnt == reference[k].cnt );
+         flag &= CHECK( isClose(r.zhat, reference[k].zhat, 1e-8*fabs(reference[k].zhat)) );
+         flag &= CHECK( isClose(r.kstd, reference[k].kstd, 1e-8*reference[k].kstd) );
+         flag &= CHECK( isClose(r.pvalue, reference[k].pvalue, 1e-6) );
+         ++count;
+      }, options );
+      flag &= CHECK( count == N );
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestEngineVecchia
+   //
+   //    With every predecessor in the conditioning sets the Vecchia
+   //    approximation is exact, and the engine must reproduce the dense one;
+   //    an empty approximation must be refused.
+   //--------------------------------------------------------------------------
+   bool TestEngineVecchia()
+   {
+      const double nugget = 2.0, sill = 16.0, range = 500.0, radius = 60.0;
+
+      std::vector<DataRecord> obs;
+      for (int i = 0; i < 10; ++i)
+         for (int j = 0; j < 15; ++j) {
+            DataRecord rec = { "", 40.0*i + 5.0*j + 3.0*((i*j)%4), 40.0*j - 3.0*i, 100.0 + 0.2*i*j - 0.5*j + ((i+j)%3) };
+            obs.push_back(rec);
+         }
+      const int N = obs.size();
+
+      Assembly dense(nugget, sill, range), vecchia(nugget, sill, range);
+      for (const auto& rec : obs) {
+         dense.Append(rec);
+         vecchia.Append(rec);
+      }
+
+      Matrix D, C;
+      dense.Finalize(D, C, 1);
+
+      Vecchia V;
+      vecchia.Finalize(N-1, V, 2);
+
+      EngineOptions options;
+      options.nthreads = 2;
+
+      std::vector<Boomerang> reference(N);
+      Engine( sill, radius, obs, D, C, [&](int k, const Boomerang& r) { reference[k] = r; }, options );
+
+      bool flag = true;
+      flag &= CHECK( V.nRows() == N );
+
+      options.vecchia = N-1;
+      int count = 0;
+      flag &= CHECK( Engine( sill, radius, obs, V, [&](int k, const Boomerang& r) {
+         flag &= CHECK( r.cnt == reference[k].cnt );
+         flag &= CHECK( isClose(r.zhat, reference[k].zhat, 1e-8*fabs(reference[k].zhat)) );
+         flag &= CHECK( isClose(r.kstd, reference[k].kstd, 1e-8*reference[k].kstd) );
+         flag &= CHECK( isClose(r.pvalue, reference[k].pvalue, 1e-6) );
+         ++count;
+      }, options ) );
+      flag &= CHECK( count == N );
+
+      // An approximation that could not be built evaluates nothing.
+      Vecchia empty;
+      count = 0;
+      flag &= CHECK( !Engine( sill, radius, obs, empty, [&](int, const Boomerang&) { ++count; }, options ) );
+      flag &= CHECK( count == 0 );
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestEngineNystrom
+   //
+   //    With every observation a landmark the Nystrom approximation is exact,
+   //    and the engine must reproduce the dense one, and report so on its
+   //    audited sample.
+   //--------------------------------------------------------------------------
+   bool TestEngineNystrom()
+   {
+      const double nugget = 2.0, sill = 16.0, range = 500.0, radius = 60.0;
+
+      std::vector<DataRecord> obs;
+      for (int i = 0; i < 10; ++i)
+         for (int j = 0; j < 15; ++j) {
+            DataRecord rec = { "", 40.0*i + 5.0*j + 3.0*((i*j)%4), 40.0*j - 3.0*i, 100.0 + 0.2*i*j - 0.5*j + ((i+j)%3) };
+            obs.push_back(rec);
+         }
+      const int N = obs.size();
+
+      Assembly dense(nugget, sill, range), nystrom(nugget, sill, range);
+      for (const auto& rec : obs) {
+         dense.Append(rec);
+         nystrom.Append(rec);
+      }
+
+      Matrix D, C;
+      dense.Finalize(D, C, 1);
+
+      Nystrom V;
+      nystrom.Finalize(N, V, 2);
+
+      EngineOptions options;
+      options.nthreads = 2;
+
+      std::vector<Boomerang> reference(N);
+      Engine( sill, radius, obs, D, C, [&](int k, const Boomerang& r) { reference[k] = r; }, options );
+
+      bool flag = true;
+      flag &= CHECK( V.nRows() == N );
+
+      NystromReport report;
+      int reports = 0;
+      options.nystrom = N;
+      options.nystrom_audit = 20;
+      options.nystrom_report = [&](const NystromReport& r) { report = r; ++reports; };
+
+      int count = 0;
+      Engine( sill, radius, obs, V, [&](int k, const Boomerang& r) {
+         flag &= CHECK( r.cnt == reference[k].cnt );
+         flag &= CHECK( isClose(r.zhat, reference[k].zhat, 1e-8*fabs(reference[k].zhat)) );
+         flag &= CHECK( isClose(r.kstd, reference[k].kstd, 1e-8*reference[k].kstd) );
+         flag &= CHECK( isClose(r.pvalue, reference[k].pvalue, 1e-6) );
+         ++count;
+      }, options );
+      flag &= CHECK( count == N );
+
+      flag &= CHECK( reports == 1 );
+      flag &= CHECK( report.rank == N );
+      flag &= CHECK( report.systems == N );
+      flag &= CHECK( report.audited == 20 );
+      flag &= CHECK( report.max_zhat_error < 1e-8 );
+      flag &= CHECK( report.max_kstd_error < 1e-8 );
+      flag &= CHECK( !FormatNystrom(report).empty() );
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestEngineIterative
+   //
+   //    The matrix-free engine, iterated to a tight tolerance, must reproduce
+   //    the dense engine closely, and report its iterations, for each
+   //    observation.
+   //--------------------------------------------------------------------------
+   bool TestEngineIterative()
+   {
+      const double nugget = 2.0, sill = 16.0, range = 500.0, radius = 60.0;
+
+      std::vector<DataRecord> obs;
+      for (int i = 0; i < 10; ++i)
+         for (int j = 0; j < 15; ++j) {
+            DataRecord rec = { "", 40.0*i + 5.0*j + 3.0*((i*j)%4), 40.0*j - 3.0*i, 100.0 + 0.2*i*j - 0.5*j + ((i+j)%3) };
+            obs.push_back(rec);
+         }
+      const int N = obs.size();
+
+      Assembly dense(nugget, sill, range), iterative(nugget, sill, range);
+      for (const auto& rec : obs) {
+         dense.Append(rec);
+         iterative.Append(rec);
+      }
+
+      Matrix D, C;
+      dense.Finalize(D, C, 1);
+
+      CovarianceOperator op;
+      iterative.Finalize(op, 2);
+
+      EngineOptions options;
+      options.nthreads = 2;
+
+      std::vector<Boomerang> reference(N);
+      Engine( sill, radius, obs, D, C, [&](int k, const Boomerang& r) { reference[k] = r; }, options );
+
+      bool flag = true;
+
+      IterativeReport report;
+      int reports = 0;
+      options.iterative = 1e-12;
+      options.iterative_report = [&](const IterativeReport& r) { report = r; ++reports; };
+
+      int count = 0;
+      Engine( sill, radius, obs, op, [&](int k, const Boomerang& r) {
+         flag &= CHECK( r.cnt == reference[k].cnt );
+         flag &= CHECK( isClose(r.zhat, reference[k].zhat, 1e-8*fabs(reference[k].zhat)) );
+         flag &= CHECK( isClose(r.kstd, reference[k].kstd, 1e-8*reference[k].kstd) );
+         flag &= CHECK( isClose(r.pvalue, reference[k].pvalue, 1e-6) );
+         ++count;
+      }, options );
+      flag &= CHECK( count == N );
+
+      flag &= CHECK( reports == 1 );
+      flag &= CHECK( report.systems == N );
+      flag &= CHECK( report.unconverged == 0 );
+      flag &= CHECK( report.max_iterations > 0 && report.max_iterations < N );
+      flag &= CHECK( report.max_residual <= 1e-12 );
+      flag &= CHECK( !FormatIterative(report).empty() );
+
+      flag &= CHECK( static_cast<int>(report.outcomes.size()) == N );
+      for (int i = 0; i < static_cast<int>(report.outcomes.size()); ++i) {
+         flag &= CHECK( report.outcomes[i].k == i );
+         flag &= CHECK( report.outcomes[i].iterations > 0 );
+         flag &= CHECK( report.outcomes[i].residual <= 1e-12 );
+      }
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestAssembly
+   //
+   //    The tiled, multithreaded assembly must reproduce the direct
+   //    evaluation, including across partial tiles.
+   //--------------------------------------------------------------------------
+   bool TestAssembly()
+   {
+      const int N = 150;
+      const double nugget = 2.0, sill = 16.0, range = 300.0;
+
+      bool flag = true;
+
+      for (int nthreads = 1; nthreads <= 4; nthreads += 3) {
+         Assembly assembly(nugget, sill, range);
+         for (int i = 0; i < N; ++i) {
+            DataRecord rec = { "", 37.0*(i%13) + 0.5*i, 41.0*(i%11) - 0.25*i, 0.0 };
+            assembly.Append(rec);
+         }
+
+         Matrix D, C;
+         assembly.Finalize(D, C, nthreads);
+
+         for (int i = 0; i < N; ++i) {
+            for (int j = 0; j < N; ++j) {
+               double h = hypot( 37.0*(i%13) + 0.5*i - 37.0*(j%13) - 0.5*j, 41.0*(i%11) - 0.25*i - 41.0*(j%11) + 0.25*j );
+               double c = (i == j) ? sill : (sill-nugget)*exp(-3.0*h/range);
+
+               flag &= isClose( D(i,j), h, 1e-12*(1.0+h) );
+               flag &= isClose( C(i,j), c, 1e-14*sill );
+            }
+         }
+      }
+
+      return flag;
+   }
 }
 
 
@@ -110,6 +847,19 @@ std::pair<int,int> test_Engine()
    int nfail = 0;
 
    TALLY( TestEngine() );
+   TALLY( TestEngineOrdering() );
+   TALLY( TestEngineTargets() );
+   TALLY( TestEngineLocal() );
+   TALLY( TestEngineStopping() );
+   TALLY( TestAssembly() );
+   TALLY( TestEngineAllocations() );
+   TALLY( TestEngineMixedPrecision() );
+   TALLY( TestEngineNeighbors() );
+   TALLY( TestEngineTapered() );
+   TALLY( TestEngineHierarchical() );
+   TALLY( TestEngineVecchia() );
+   TALLY( TestEngineNystrom() );
+   TALLY( TestEngineIterative() );
 
    return std::make_pair( nsucc, nfail );
 }
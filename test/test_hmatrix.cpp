@@ -0,0 +1,179 @@
+//=============================================================================
+// test_hmatrix.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "test_hmatrix.h"
+#include "unit_test.h"
+#include "..\src\hmatrix.h"
+#include "..\src\linear_systems.h"
+#include "..\src\matrix.h"
+
+//-----------------------------------------------------------------------------
+// Hide all of the testing details inside an unnamed namespace. This allows me
+// to create many small unit tests with polluting the global namespace.
+//-----------------------------------------------------------------------------
+namespace{
+   const double TOLERANCE = 1e-12;
+
+   //--------------------------------------------------------------------------
+   // An exponential covariance with a nugget, as an H-matrix compressed to
+   // TOLERANCE and as a dense matrix.
+   //--------------------------------------------------------------------------
+   void Compressed( const std::vector<double>& x, const std::vector<double>& y, HMatrix& H, Matrix& dense )
+   {
+      const int n = x.size();
+      auto entry = [&](int i, int j) {
+         return ExponentialCovariance(x, y, i, j, 2.0, 10.0, 300.0);
+      };
+
+      H.Compress(x, y, entry, TOLERANCE, 2);
+
+      dense.Resize(n, n);
+      for (int i = 0; i < n; ++i)
+         for (int j = 0; j < n; ++j)
+            dense(i,j) = entry(i,j);
+   }
+
+   //--------------------------------------------------------------------------
+   // TestHMatrixCompress
+   //
+   //    The compressed matrix must reproduce the dense products, with fewer
+   //    values stored, and its sampled error must be of the order of the
+   //    tolerance.
+   //--------------------------------------------------------------------------
+   bool TestHMatrixCompress()
+   {
+      const int n = 500;
+      std::vector<double> x, y;
+      ScatteredPoints(n, x, y, false);
+
+      HMatrix H;
+      Matrix A;
+      Compressed(x, y, H, A);
+
+      std::vector<double> v(n), Hv(n);
+      for (int i = 0; i < n; ++i)
+         v[i] = sin(0.1*i);
+      H.Multiply(v.data(), Hv.data());
+
+      bool flag = true;
+
+      flag &= CHECK( H.nRows() == n );
+      flag &= CHECK( H.MaxRank() > 0 && H.MaxRank() < n/4 );
+      flag &= CHECK( H.Storage() < static_cast<std::size_t>(n)*n );
+      flag &= CHECK( H.SampledError() < 1e3*TOLERANCE );
+
+      for (int i = 0; i < n; ++i) {
+         double Av = 0.0;
+         for (int j = 0; j < n; ++j)
+            Av += A(i,j) * v[j];
+         flag &= CHECK( fabs(Hv[i] - Av) < 1e3*TOLERANCE );
+      }
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestHMatrixFactor
+   //
+   //    The solves, and the blocks of the inverse, must match those of the
+   //    dense factorization.
+   //--------------------------------------------------------------------------
+   bool TestHMatrixFactor()
+   {
+      const int n = 500;
+      std::vector<double> x, y;
+      ScatteredPoints(n, x, y, false);
+
+      HMatrix H;
+      Matrix A;
+      Compressed(x, y, H, A);
+
+      Matrix L, Ainv, B(n, 1), X;
+      for (int i = 0; i < n; ++i)
+         B(i,0) = cos(0.07*i);
+      CholeskyDecomposition(A, L);
+      CholeskySolve(L, B, X);
+      CholeskyInverse(L, Ainv);
+
+      bool flag = true;
+
+      flag &= CHECK( H.Factor() );
+
+      std::vector<double> b(n);
+      for (int i = 0; i < n; ++i)
+         b[i] = B(i,0);
+      H.Solve(b.data());
+      for (int i = 0; i < n; ++i)
+         flag &= CHECK( fabs(b[i] - X(i,0)) < 1e-9 );
+
+      const int index[] = { 7, 411, 3, 250, 251, 499, 0 };
+      const int m = sizeof(index) / sizeof(index[0]);
+      std::vector<double> G(m*m);
+      H.InverseBlock(m, index, G.data());
+      for (int a = 0; a < m; ++a)
+         for (int c = 0; c < m; ++c)
+            flag &= CHECK( fabs(G[a*m + c] - Ainv(index[a], index[c])) < 1e-9 );
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestHMatrixWithin
+   //
+   //    The search of the cluster tree must find exactly the points that a
+   //    direct search finds.
+   //--------------------------------------------------------------------------
+   bool TestHMatrixWithin()
+   {
+      const int n = 500;
+      std::vector<double> x, y;
+      ScatteredPoints(n, x, y, false);
+
+      HMatrix H;
+      Matrix A;
+      Compressed(x, y, H, A);
+
+      bool flag = true;
+
+      for (int k = 0; k < n; k += 37) {
+         std::vector<int> found, expected;
+         H.Within(x[k], y[k], 45.0, found);
+         for (int j = 0; j < n; ++j)
+            if (hypot(x[k]-x[j], y[k]-y[j]) < 45.0) expected.push_back(j);
+
+         std::sort( found.begin(), found.end() );
+         flag &= CHECK( found == expected );
+      }
+
+      return flag;
+   }
+}
+
+
+//-----------------------------------------------------------------------------
+// test_HMatrix
+//-----------------------------------------------------------------------------
+std::pair<int,int> test_HMatrix()
+{
+   int nsucc = 0;
+   int nfail = 0;
+
+   TALLY( TestHMatrixCompress() );
+   TALLY( TestHMatrixFactor() );
+   TALLY( TestHMatrixWithin() );
+
+   return std::make_pair( nsucc, nfail );
+}
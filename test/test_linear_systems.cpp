@@ -9,10 +9,13 @@
 // version:
 //    2 July 2017
 //=============================================================================
+#include <cmath>
 #include <utility>
 
 #include "test_linear_systems.h"
 #include "unit_test.h"
+#include "..\src\batched_cholesky-inl.h"
+#include "..\src\fixed_cholesky-inl.h"
 #include "..\src\linear_systems.h"
 
 //-----------------------------------------------------------------------------
@@ -51,6 +54,127 @@ namespace{
       return CHECK( isClose(X, Z, TOLERANCE) );
    }
 
+   //--------------------------------------------------------------------------
+   // TestCholeskyFloat
+   //--------------------------------------------------------------------------
+   bool TestCholeskyFloat()
+   {
+      FloatMatrix A("4,6,4,4; 6,10,9,7; 4,9,17,11; 4,7,11,18");
+      FloatMatrix L;
+      FloatMatrix B("44; 81; 117; 123");
+      FloatMatrix X;
+
+      bool flag = true;
+
+      flag &= CHECK( CholeskyDecomposition(A,L) );
+      CholeskySolve(L,B,X);
+
+      for (int i = 0; i < 4; ++i)
+         flag &= CHECK( fabs(X(i,0) - (i+1)) < 1e-4 );
+      flag &= CHECK( L(0,1) == 0.0f && fabs(L(3,3) - 3.0f) < 1e-5 );
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestFixedCholesky
+   //
+   //    A system of order 11, padded to order 16 with identity rows, must give
+   //    the same factor and solution as the general routine.
+   //--------------------------------------------------------------------------
+   bool TestFixedCholesky()
+   {
+      const int M  = 11;
+      const int N  = 16;
+      const int LD = FixedStride<N>();
+
+      double A[M*M], F[N*(N + FIXED_BLOCK)], b[M], x[N];
+      for (int i = 0; i < M; ++i) {
+         for (int j = 0; j < M; ++j)
+            A[i*M + j] = (i == j) ? 16.0 : 14.0*exp( -0.3*fabs(double(i-j)) );
+         b[i] = 1.0 + 0.5*i;
+      }
+
+      for (int i = 0; i < N; ++i) {
+         for (int j = 0; j <= i; ++j)
+            F[i*LD + j] = (i < M) ? A[i*M + j] : double(i == j);
+         x[i] = (i < M) ? b[i] : 0.0;
+      }
+
+      bool flag = true;
+
+      flag &= CHECK( CholeskyDecomposition(M, A, M) );
+      flag &= CHECK( FixedCholesky<N>(F) );
+      FixedSolve<N>(F, x);
+      CholeskySolve(M, A, M, b);
+
+      for (int i = 0; i < M; ++i) {
+         for (int j = 0; j <= i; ++j)
+            flag &= CHECK( fabs(F[i*LD + j] - A[i*M + j]) < TOLERANCE );
+         flag &= CHECK( fabs(x[i] - b[i]) < TOLERANCE );
+      }
+      for (int i = M; i < N; ++i)
+         flag &= CHECK( x[i] == 0.0 );
+
+      double G[8*(8 + FIXED_BLOCK)] = {};
+      G[0] = -1.0;
+      flag &= CHECK( !FixedCholesky<8>(G) );
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestBatchedCholesky
+   //
+   //    Each lane of a batch must give the same factor and solution as the
+   //    general routine on its own system, including a lane padded with
+   //    identity rows, and a failed lane must not disturb the others.
+   //--------------------------------------------------------------------------
+   bool TestBatchedCholesky()
+   {
+      const int n = 9;
+      const int W = BATCH_LANES;
+      const int order[] = {9, 6, 9, 9};
+
+      double A[W][n*n], b[W][n], L[W*n*n], x[W*n];
+      for (int l = 0; l < W; ++l) {
+         for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < n; ++j) {
+               if (i < order[l] && j < order[l])
+                  A[l][i*n + j] = (i == j) ? 10.0 + l : 8.0*exp( -(0.2 + 0.1*l)*fabs(double(i-j)) );
+               else
+                  A[l][i*n + j] = double(i == j);
+               L[(i*n + j)*W + l] = A[l][i*n + j];
+            }
+            b[l][i] = (i < order[l]) ? 1.0 + 0.25*i*l : 0.0;
+            x[i*W + l] = b[l][i];
+         }
+      }
+      L[(4*n + 4)*W + 2] = -1.0;               // lane 2 is not positive definite
+
+      bool ok[W];
+      BatchedCholesky(n, L, ok);
+      BatchedSolve(n, L, x);
+
+      bool flag = true;
+
+      for (int l = 0; l < W; ++l) {
+         if (l == 2) {
+            flag &= CHECK( !ok[l] );
+            continue;
+         }
+
+         flag &= CHECK( ok[l] && CholeskyDecomposition(n, A[l], n) );
+         CholeskySolve(n, A[l], n, b[l]);
+
+         for (int i = 0; i < n; ++i) {
+            for (int j = 0; j <= i; ++j)
+               flag &= CHECK( fabs(L[(i*n + j)*W + l] - A[l][i*n + j]) < TOLERANCE );
+            flag &= CHECK( fabs(x[i*W + l] - b[l][i]) < TOLERANCE );
+         }
+      }
+      return flag;
+   }
+
    //--------------------------------------------------------------------------
    // TestCholeskyInverse
    //--------------------------------------------------------------------------
@@ -126,6 +250,9 @@ std::pair<int,int> test_LinearSystems()
 
    TALLY( TestCholeskyDecomposition() );
    TALLY( TestCholeskySolve() );
+   TALLY( TestCholeskyFloat() );
+   TALLY( TestFixedCholesky() );
+   TALLY( TestBatchedCholesky() );
    TALLY( TestCholeskyInverse() );
    TALLY( TestRSPDInv() );
    TALLY( TestLeastSquaresSolve() );
@@ -11,10 +11,18 @@
 //=============================================================================
 #include <iostream>
 
+#include "test_arena.h"
+#include "test_checkpoint.h"
 #include "test_engine.h"
+#include "test_hmatrix.h"
 #include "test_linear_systems.h"
 #include "test_matrix.h"
+#include "test_matrix_free.h"
+#include "test_nystrom.h"
+#include "test_server.h"
+#include "test_sparse.h"
 #include "test_special_functions.h"
+#include "test_vecchia.h"
 
 //-----------------------------------------------------------------------------
 //
@@ -26,10 +34,22 @@ int main()
 
    std::pair<int,int> counts;
 
+   counts = test_Arena();
+   nsucc += counts.first;
+   nfail += counts.second;
+
+   counts = test_Checkpoint();
+   nsucc += counts.first;
+   nfail += counts.second;
+
    counts = test_Engine();
    nsucc += counts.first;
    nfail += counts.second;
 
+   counts = test_HMatrix();
+   nsucc += counts.first;
+   nfail += counts.second;
+
    counts = test_LinearSystems();
    nsucc += counts.first;
    nfail += counts.second;
@@ -38,10 +58,30 @@ int main()
    nsucc += counts.first;
    nfail += counts.second;
 
+   counts = test_MatrixFree();
+   nsucc += counts.first;
+   nfail += counts.second;
+
+   counts = test_Nystrom();
+   nsucc += counts.first;
+   nfail += counts.second;
+
+   counts = test_Server();
+   nsucc += counts.first;
+   nfail += counts.second;
+
+   counts = test_Sparse();
+   nsucc += counts.first;
+   nfail += counts.second;
+
    counts = test_SpecialFunctions();
    nsucc += counts.first;
    nfail += counts.second;
 
+   counts = test_Vecchia();
+   nsucc += counts.first;
+   nfail += counts.second;
+
    if (nfail > 0)
       std::cerr << "WEBINAN TESTS: nsucc = " << nsucc << '\t' << "nfail = " << nfail << std::endl;
    else
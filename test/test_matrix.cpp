@@ -23,6 +23,7 @@
 #include "test_matrix.h"
 #include "unit_test.h"
 #include "..\src\matrix.h"
+#include "..\src\profile.h"
 
 //-----------------------------------------------------------------------------
 // Hide all of the testing details inside an unnamed namespace. This allows me
@@ -139,6 +140,109 @@ namespace{
       return CHECK( isClose(A, B, TOLERANCE) );
    }
 
+   //--------------------------------------------------------------------------
+   // TestMatrixMoveConstructor
+   //--------------------------------------------------------------------------
+   bool TestMatrixMoveConstructor()
+   {
+      Matrix A("1,2,3;4,5,6");
+      const double* base = A.Base();
+      Matrix B( std::move(A) );
+
+      bool flag = true;
+
+      flag &= CHECK( isClose(B, Matrix("1,2,3;4,5,6"), TOLERANCE) );
+      flag &= CHECK( B.Base() == base );
+      flag &= CHECK( A.nRows() == 0 && A.nCols() == 0 );
+      flag &= CHECK( A.Base() == nullptr );
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestMatrixMoveAssignment
+   //--------------------------------------------------------------------------
+   bool TestMatrixMoveAssignment()
+   {
+      Matrix A("1,2,3;4,5,6");
+      Matrix B("0,1;1,0");
+      const double* base = A.Base();
+      B = std::move(A);
+
+      bool flag = true;
+
+      flag &= CHECK( isClose(B, Matrix("1,2,3;4,5,6"), TOLERANCE) );
+      flag &= CHECK( B.Base() == base );
+      flag &= CHECK( B.Capacity() == 6 );
+      flag &= CHECK( A.nRows() == 0 && A.nCols() == 0 );
+      flag &= CHECK( A.Capacity() == 0 );
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestMatrixUninitializedConstructor
+   //--------------------------------------------------------------------------
+   bool TestMatrixUninitializedConstructor()
+   {
+      Matrix A(2,3, Matrix::UNINITIALIZED);
+      Matrix B(0,3, Matrix::UNINITIALIZED);
+
+      bool flag = true;
+
+      flag &= CHECK( A.nRows() == 2 && A.nCols() == 3 );
+      flag &= CHECK( A.Capacity() == 6 );
+      flag &= CHECK( B.nRows() == 0 && B.nCols() == 0 );
+      flag &= CHECK( B.Base() == nullptr );
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestMatrixResizeReusesStorage
+   //--------------------------------------------------------------------------
+   bool TestMatrixResizeReusesStorage()
+   {
+      Matrix A("1,2,3;4,5,6");
+      Matrix Z("0,0;0,0");
+      const double* base = A.Base();
+      const long long count = MatrixAllocationCount();
+
+      bool flag = true;
+
+      A.Resize(2,2);
+      flag &= CHECK( isClose(A, Z, TOLERANCE) );
+      flag &= CHECK( A.Base() == base && A.Capacity() == 6 );
+
+      A.Resize(3,2, Matrix::UNINITIALIZED);
+      flag &= CHECK( A.nRows() == 3 && A.nCols() == 2 );
+      flag &= CHECK( A.Base() == base );
+
+      A.Resize(0,0);
+      A.Resize(1,6);
+      flag &= CHECK( A.Base() == base );
+      flag &= CHECK( MatrixAllocationCount() == count );
+
+      A.Resize(3,3);
+      flag &= CHECK( A.Capacity() == 9 );
+      flag &= CHECK( MatrixAllocationCount() == count+1 );
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestMatrixAssignmentReusesStorage
+   //--------------------------------------------------------------------------
+   bool TestMatrixAssignmentReusesStorage()
+   {
+      Matrix A("1,2;3,4");
+      Matrix B("0,0,0;0,0,0");
+      const double* base = B.Base();
+      B = A;
+
+      bool flag = true;
+
+      flag &= CHECK( isClose(A, B, TOLERANCE) );
+      flag &= CHECK( B.Base() == base );
+      return flag;
+   }
+
    //--------------------------------------------------------------------------
    // TestMatrixScalarAssignment
    //--------------------------------------------------------------------------
@@ -686,6 +790,11 @@ std::pair<int,int> test_Matrix()
    TALLY( TestMatrixConstructorWithStringFill() );
    TALLY( TestMatrixDestructiveResize() );
    TALLY( TestMatrixAssignmentOperator() );
+   TALLY( TestMatrixMoveConstructor() );
+   TALLY( TestMatrixMoveAssignment() );
+   TALLY( TestMatrixUninitializedConstructor() );
+   TALLY( TestMatrixResizeReusesStorage() );
+   TALLY( TestMatrixAssignmentReusesStorage() );
    TALLY( TestMatrixScalarAssignment() );
    TALLY( TestMatrixAccess() );
    TALLY( TestMatrixRowAndColumnSize() );
@@ -0,0 +1,176 @@
+//=============================================================================
+// test_matrix_free.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "test_matrix_free.h"
+#include "unit_test.h"
+#include "..\src\linear_systems.h"
+#include "..\src\matrix.h"
+#include "..\src\matrix_free.h"
+
+//-----------------------------------------------------------------------------
+// Hide all of the testing details inside an unnamed namespace. This allows me
+// to create many small unit tests with polluting the global namespace.
+//-----------------------------------------------------------------------------
+namespace{
+   const double NUGGET = 2.0;
+   const double SILL   = 10.0;
+   const double RANGE  = 600.0;
+
+   //--------------------------------------------------------------------------
+   // The covariance between scattered points [i] and [j].
+   //--------------------------------------------------------------------------
+   double Covariance( const std::vector<double>& x, const std::vector<double>& y, int i, int j )
+   {
+      return ExponentialCovariance(x, y, i, j, NUGGET, SILL, RANGE/3.0);
+   }
+
+   //--------------------------------------------------------------------------
+   // The excluded set of the points within "radius" of point [k].
+   //--------------------------------------------------------------------------
+   std::vector<int> Near( const std::vector<double>& x, const std::vector<double>& y, int k, double radius )
+   {
+      std::vector<int> excluded;
+      for (int j = 0; j < static_cast<int>(x.size()); ++j)
+         if (j == k || hypot(x[j]-x[k], y[j]-y[k]) < radius) excluded.push_back(j);
+      return excluded;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestOperatorSolve
+   //
+   //    The solutions, for a column of C and for ones, must match those of
+   //    the dense factorization of the active submatrix, and be zero in the
+   //    excluded set.
+   //--------------------------------------------------------------------------
+   bool TestOperatorSolve()
+   {
+      const int n = 300, k = 123;
+      std::vector<double> x, y;
+      ScatteredPoints(n, x, y, false);
+
+      CovarianceOperator C;
+      bool flag = true;
+      flag &= CHECK( C.Build(x, y, NUGGET, SILL, RANGE, 2) );
+      flag &= CHECK( C.nRows() == n );
+
+      const std::vector<int> excluded = Near(x, y, k, 40.0);
+      std::vector<char> out(n, 0);
+      for (int j : excluded) out[j] = 1;
+
+      std::vector<double> B(2*n), X(2*n, 0.0);
+      C.Column(k, B.data());
+      for (int j = 0; j < n; ++j) {
+         flag &= CHECK( fabs(B[j] - Covariance(x, y, j, k)) < 1e-12 );
+         B[n + j] = 1.0;
+      }
+
+      Exclusion set;
+      C.Exclude(excluded, set);
+      const Exclusion* sets[2] = { &set, &set };
+
+      OperatorWorkspace ws;
+      int iterations[2];
+      double residual[2];
+      C.Solve(2, sets, B.data(), X.data(), 1e-12, 1000, ws, iterations, residual);
+
+      // The dense solution on the active set.
+      std::vector<int> active;
+      for (int j = 0; j < n; ++j)
+         if (!out[j]) active.push_back(j);
+      const int m = active.size();
+
+      Matrix A(m, m), L, b(m, 1), w;
+      for (int a = 0; a < m; ++a)
+         for (int c = 0; c < m; ++c)
+            A(a,c) = Covariance(x, y, active[a], active[c]);
+      CholeskyDecomposition(A, L);
+
+      for (int r = 0; r < 2; ++r) {
+         for (int a = 0; a < m; ++a)
+            b(a,0) = (r == 0) ? Covariance(x, y, active[a], k) : 1.0;
+         CholeskySolve(L, b, w);
+
+         flag &= CHECK( iterations[r] > 0 && iterations[r] < m );
+         flag &= CHECK( residual[r] <= 1e-12 );
+         for (int a = 0; a < m; ++a)
+            flag &= CHECK( fabs(X[r*n + active[a]] - w(a,0)) < 1e-8*(1.0 + fabs(w(a,0))) );
+         for (int j : excluded)
+            flag &= CHECK( X[r*n + j] == 0.0 );
+      }
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestOperatorBatch
+   //
+   //    Systems with different excluded sets, solved together, must give
+   //    exactly what they give solved one at a time.
+   //--------------------------------------------------------------------------
+   bool TestOperatorBatch()
+   {
+      const int n = 250, nrhs = 4;
+      std::vector<double> x, y;
+      ScatteredPoints(n, x, y, false);
+
+      CovarianceOperator C;
+      C.Build(x, y, NUGGET, SILL, RANGE, 1);
+
+      std::vector<Exclusion> set(nrhs);
+      std::vector<const Exclusion*> sets(nrhs);
+      std::vector<double> B(nrhs*n), X(nrhs*n, 0.0);
+      for (int r = 0; r < nrhs; ++r) {
+         C.Exclude(Near(x, y, 60*r + 5, 25.0 + 10.0*r), set[r]);
+         sets[r] = &set[r];
+         C.Column(60*r + 5, &B[r*n]);
+      }
+
+      OperatorWorkspace ws;
+      std::vector<int> iterations(nrhs);
+      std::vector<double> residual(nrhs);
+      C.Solve(nrhs, sets.data(), B.data(), X.data(), 1e-10, 1000, ws, iterations.data(), residual.data());
+
+      bool flag = true;
+      for (int r = 0; r < nrhs; ++r) {
+         std::vector<double> x1(n, 0.0);
+         int iterations1;
+         double residual1;
+         C.Solve(1, &sets[r], &B[r*n], x1.data(), 1e-10, 1000, ws, &iterations1, &residual1);
+
+         flag &= CHECK( iterations1 == iterations[r] );
+         flag &= CHECK( residual1 == residual[r] );
+         for (int j = 0; j < n; ++j)
+            flag &= CHECK( x1[j] == X[r*n + j] );
+      }
+
+      return flag;
+   }
+}
+
+
+//-----------------------------------------------------------------------------
+// test_MatrixFree
+//-----------------------------------------------------------------------------
+std::pair<int,int> test_MatrixFree()
+{
+   int nsucc = 0;
+   int nfail = 0;
+
+   TALLY( TestOperatorSolve() );
+   TALLY( TestOperatorBatch() );
+
+   return std::make_pair( nsucc, nfail );
+}
@@ -0,0 +1,21 @@
+//=============================================================================
+// test_matrix_free.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef TEST_MATRIX_FREE_H
+#define TEST_MATRIX_FREE_H
+
+#include <utility>
+
+//-----------------------------------------------------------------------------
+std::pair<int,int> test_MatrixFree();
+
+//=============================================================================
+#endif  // TEST_MATRIX_FREE_H
@@ -0,0 +1,135 @@
+//=============================================================================
+// test_nystrom.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "test_nystrom.h"
+#include "unit_test.h"
+#include "..\src\nystrom.h"
+#include "..\src\spatial_index.h"
+#include "..\src\vecchia.h"
+
+//-----------------------------------------------------------------------------
+// Hide all of the testing details inside an unnamed namespace. This allows me
+// to create many small unit tests with polluting the global namespace.
+//-----------------------------------------------------------------------------
+namespace{
+   const double NUGGET = 2.0;
+   const double SILL   = 10.0;
+   const double RANGE  = 900.0;
+
+   //--------------------------------------------------------------------------
+   // The covariance between scattered points [i] and [j].
+   //--------------------------------------------------------------------------
+   double Covariance( const std::vector<double>& x, const std::vector<double>& y, int i, int j )
+   {
+      return ExponentialCovariance(x, y, i, j, NUGGET, SILL, RANGE/3.0);
+   }
+
+   // Entry (i,j) of U U' + D.
+   double Approximation( const Nystrom& V, int i, int j )
+   {
+      double sum = (i == j) ? V.Diagonal(i) : 0.0;
+      for (int a = 0; a < V.Rank(); ++a)
+         sum += V.Row(i)[a] * V.Row(j)[a];
+      return sum;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestNystromExact
+   //
+   //    With every point a landmark the approximation is exact: U U' + D must
+   //    be C, and D the nugget.
+   //--------------------------------------------------------------------------
+   bool TestNystromExact()
+   {
+      const int n = 120;
+      std::vector<double> x, y;
+      ScatteredPoints(n, x, y, true);
+      for (int i = 0; i < n; ++i)
+         x[i] += 0.01*i;            // no repeated locations
+
+      Nystrom V;
+      bool flag = true;
+      flag &= CHECK( V.Build(x, y, NUGGET, SILL, RANGE, n + 5, 2) );
+      flag &= CHECK( V.nRows() == n );
+      flag &= CHECK( V.Rank() == n );
+
+      for (int i = 0; i < n; ++i) {
+         flag &= CHECK( isClose(V.Diagonal(i), NUGGET, 1e-8) );
+         for (int j = 0; j < n; ++j)
+            flag &= CHECK( isClose(Approximation(V, i, j), Covariance(x, y, i, j), 1e-8) );
+      }
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestNystromLowRank
+   //
+   //    With fewer landmarks, they must be the leading points of the maxmin
+   //    order, the diagonal of C must still be reproduced exactly, and D must
+   //    be the nugget at the landmarks and at least the nugget elsewhere.
+   //    Repeated landmark locations without a nugget must be reported.
+   //--------------------------------------------------------------------------
+   bool TestNystromLowRank()
+   {
+      const int n = 400, r = 40;
+      std::vector<double> x, y;
+      ScatteredPoints(n, x, y, true);
+
+      Nystrom V;
+      bool flag = true;
+      flag &= CHECK( V.Build(x, y, NUGGET, SILL, RANGE, r, 2) );
+      flag &= CHECK( V.Rank() == r );
+
+      KdTree tree;
+      tree.Build(x, y);
+      const std::vector<int> order = MaxminOrder(x, y, tree);
+      flag &= CHECK( std::equal(V.Landmarks().begin(), V.Landmarks().end(), order.begin()) );
+
+      std::vector<char> landmark(n, 0);
+      for (int l : V.Landmarks())
+         landmark[l] = 1;
+
+      for (int i = 0; i < n; ++i) {
+         flag &= CHECK( isClose(Approximation(V, i, i), SILL, 1e-8) );
+         if (landmark[i])
+            flag &= CHECK( isClose(V.Diagonal(i), NUGGET, 1e-8) );
+         else
+            flag &= CHECK( V.Diagonal(i) >= NUGGET );
+      }
+
+      // Every point is a landmark, and some are repeated.
+      flag &= CHECK( !V.Build(x, y, NUGGET, SILL, RANGE, n, 2) );
+      flag &= CHECK( V.nRows() == 0 );
+
+      return flag;
+   }
+}
+
+
+//-----------------------------------------------------------------------------
+// test_Nystrom
+//-----------------------------------------------------------------------------
+std::pair<int,int> test_Nystrom()
+{
+   int nsucc = 0;
+   int nfail = 0;
+
+   TALLY( TestNystromExact() );
+   TALLY( TestNystromLowRank() );
+
+   return std::make_pair( nsucc, nfail );
+}
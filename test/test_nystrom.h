@@ -0,0 +1,21 @@
+//=============================================================================
+// test_nystrom.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef TEST_NYSTROM_H
+#define TEST_NYSTROM_H
+
+#include <utility>
+
+//-----------------------------------------------------------------------------
+std::pair<int,int> test_Nystrom();
+
+//=============================================================================
+#endif  // TEST_NYSTROM_H
@@ -0,0 +1,214 @@
+//=============================================================================
+// test_server.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "test_server.h"
+#include "unit_test.h"
+#include "..\src\engine.h"
+#include "..\src\locations.h"
+#include "..\src\server.h"
+
+//-----------------------------------------------------------------------------
+// Hide all of the testing details inside an unnamed namespace. This allows me
+// to create many small unit tests with polluting the global namespace.
+//-----------------------------------------------------------------------------
+namespace{
+   const double NUGGET = 2.0;
+   const double SILL   = 16.0;
+   const double RANGE  = 1000.0;
+   const double RADIUS = 150.0;
+   const double TOLERANCE = 1e-12;
+
+   std::vector<DataRecord> Observations()
+   {
+      std::vector<DataRecord> obs;
+      for (int i = 0; i < 9; ++i)
+         for (int j = 0; j < 9; ++j) {
+            DataRecord rec = { "W" + std::to_string(9*i + j), 90.0*i + 11.0*j, 100.0*j + 7.0*i, 100.0 + i - j + 0.1*((i*j)%5) };
+            obs.push_back(rec);
+         }
+      return obs;
+   }
+
+   // The number following the first "key": in a response, after "from".
+   double Field( const std::string& response, const std::string& key, std::size_t from = 0 )
+   {
+      const std::string pattern = "\"" + key + "\":";
+      const std::size_t at = response.find(pattern, from);
+      if (at == std::string::npos) return NAN;
+      return strtod( response.c_str() + at + pattern.size(), nullptr );
+   }
+
+   bool Failed( const std::string& response )
+   {
+      return response.find("\"error\":") != std::string::npos;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestServerScore
+   //
+   //    A score must echo the id and return the results of the local engine,
+   //    in the order requested, with the parameters of the request, or the
+   //    SERVER_NEIGHBORS nearest active data by default.
+   //--------------------------------------------------------------------------
+   bool TestServerScore()
+   {
+      const std::vector<DataRecord> obs = Observations();
+
+      Assembly assembly(NUGGET, SILL, RANGE);
+      for (const auto& rec : obs)
+         assembly.Append(rec);
+      Locations L;
+      assembly.Finalize(L);
+
+      EngineOptions options;
+      options.nthreads = 1;
+      Server server( NUGGET, SILL, RANGE, RADIUS, obs, options );
+
+      bool flag = true;
+      flag &= CHECK( server.Size() == static_cast<int>(obs.size()) );
+
+      for (int neighbors : { 0, 20 }) {
+         std::vector<Boomerang> local(obs.size());
+         options.neighbors = neighbors;
+         options.targets = { 17, 40 };
+         Engine( SILL, RADIUS, obs, L, [&](int k, const Boomerang& r) { local[k] = r; }, options );
+
+         const std::string response = server.Respond(
+            "{\"id\":\"a7\", \"op\":\"score\", \"ids\":[\"W40\", \"W17\"], \"neighbors\":" + std::to_string(neighbors) + "}" );
+         flag &= CHECK( !Failed(response) );
+         flag &= CHECK( response.compare(0, 11, "{\"id\":\"a7\",") == 0 );
+
+         const std::size_t second = response.find("\"W17\"");
+         flag &= CHECK( second != std::string::npos );
+         flag &= CHECK( Field(response, "count") == local[40].cnt );
+         flag &= CHECK( isClose(Field(response, "zhat"), local[40].zhat, TOLERANCE) );
+         flag &= CHECK( isClose(Field(response, "kstd"), local[40].kstd, TOLERANCE) );
+         flag &= CHECK( isClose(Field(response, "pvalue"), local[40].pvalue, TOLERANCE) );
+         flag &= CHECK( Field(response, "count", second) == local[17].cnt );
+         flag &= CHECK( isClose(Field(response, "zhat", second), local[17].zhat, TOLERANCE) );
+         flag &= CHECK( Field(response, "ms") >= 0.0 );
+      }
+
+      // Another radius, for this request alone, with the default neighbors.
+      std::vector<Boomerang> wide(obs.size());
+      options.neighbors = SERVER_NEIGHBORS;
+      options.targets = { 40 };
+      Engine( SILL, 250.0, obs, L, [&](int k, const Boomerang& r) { wide[k] = r; }, options );
+
+      const std::string response = server.Respond( "{\"id\":8, \"op\":\"score\", \"ids\":[\"W40\"], \"radius\":250}" );
+      flag &= CHECK( response.compare(0, 7, "{\"id\":8") == 0 );
+      flag &= CHECK( Field(response, "count") == wide[40].cnt );
+      flag &= CHECK( isClose(Field(response, "zhat"), wide[40].zhat, TOLERANCE) );
+
+      // Another model, on the points and index of the dataset.
+      Locations other( L );
+      other.SetModel( NUGGET, 20.0, 600.0 );
+      std::vector<Boomerang> modeled(obs.size());
+      options.neighbors = 20;
+      Engine( 20.0, RADIUS, obs, other, [&](int k, const Boomerang& r) { modeled[k] = r; }, options );
+
+      const std::string changed = server.Respond( "{\"id\":9, \"op\":\"score\", \"ids\":[\"W40\"], \"sill\":20, \"range\":600, \"neighbors\":20}" );
+      flag &= CHECK( &other.Index() == &L.Index() );
+      flag &= CHECK( isClose(Field(changed, "zhat"), modeled[40].zhat, TOLERANCE) );
+      flag &= CHECK( isClose(Field(changed, "kstd"), modeled[40].kstd, TOLERANCE) );
+
+      // The original keeps its model.
+      flag &= CHECK( isClose(L.Covariance(0, 1), (SILL - NUGGET)*exp(-3.0*L.Distance(0, 1)/RANGE), 1e-9) );
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestServerHypothetical
+   //
+   //    A hypothetical observation at the location, and with the value, of an
+   //    observation must be scored as that observation is. The info must
+   //    report the parameters.
+   //--------------------------------------------------------------------------
+   bool TestServerHypothetical()
+   {
+      const std::vector<DataRecord> obs = Observations();
+      EngineOptions options;
+      options.neighbors = 30;
+      Server server( NUGGET, SILL, RANGE, RADIUS, obs, options );
+
+      bool flag = true;
+      for (int k : { 0, 40, 77 }) {
+         const std::string score = server.Respond( "{\"id\":1, \"op\":\"score\", \"ids\":[\"" + obs[k].id + "\"]}" );
+
+         char request[256];
+         snprintf( request, sizeof(request), "{\"id\":2, \"op\":\"hypothetical\", \"x\":%.17g, \"y\":%.17g, \"z\":%.17g}", obs[k].x, obs[k].y, obs[k].z );
+         const std::string hypothetical = server.Respond( request );
+
+         flag &= CHECK( !Failed(hypothetical) );
+         flag &= CHECK( Field(hypothetical, "count") == Field(score, "count") );
+         flag &= CHECK( isClose(Field(hypothetical, "zhat"), Field(score, "zhat"), TOLERANCE) );
+         flag &= CHECK( isClose(Field(hypothetical, "kstd"), Field(score, "kstd"), TOLERANCE) );
+         flag &= CHECK( isClose(Field(hypothetical, "pvalue"), Field(score, "pvalue"), TOLERANCE) );
+      }
+
+      const std::string info = server.Respond( "{\"op\":\"info\", \"sill\":20}" );
+      flag &= CHECK( info.compare(0, 10, "{\"id\":null") == 0 );
+      flag &= CHECK( Field(info, "observations") == obs.size() );
+      flag &= CHECK( Field(info, "sill") == 20.0 );
+      flag &= CHECK( Field(info, "neighbors") == 30.0 );
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestServerErrors
+   //
+   //    A request that cannot be answered must be answered with an error,
+   //    and the id if it could be read.
+   //--------------------------------------------------------------------------
+   bool TestServerErrors()
+   {
+      Server server( NUGGET, SILL, RANGE, RADIUS, Observations(), EngineOptions() );
+
+      bool flag = true;
+      flag &= CHECK( Failed(server.Respond("{\"id\":1, \"op\":\"score\", \"ids\":[\"W17\"")) );
+      flag &= CHECK( Failed(server.Respond("[1, 2]")) );
+      flag &= CHECK( Failed(server.Respond("{\"id\":2, \"op\":\"predict\"}")) );
+      flag &= CHECK( Failed(server.Respond("{\"id\":3, \"op\":\"score\", \"ids\":[\"W17\", \"X1\"]}")) );
+      flag &= CHECK( Failed(server.Respond("{\"id\":4, \"op\":\"score\", \"ids\":[]}")) );
+      flag &= CHECK( Failed(server.Respond("{\"id\":5, \"op\":\"hypothetical\", \"x\":1, \"y\":2}")) );
+      flag &= CHECK( Failed(server.Respond("{\"id\":6, \"op\":\"info\", \"nugget\":-1}")) );
+      flag &= CHECK( Failed(server.Respond("{\"id\":7, \"op\":\"info\", \"neighbors\":2.5}")) );
+
+      const std::string response = server.Respond( "{\"id\":\"q\\\"9\", \"op\":\"score\", \"ids\":[\"X1\"]}" );
+      flag &= CHECK( response == "{\"id\":\"q\\\"9\",\"error\":\"ID X1 is not an observation\"}" );
+
+      return flag;
+   }
+}
+
+
+//-----------------------------------------------------------------------------
+// test_Server
+//-----------------------------------------------------------------------------
+std::pair<int,int> test_Server()
+{
+   int nsucc = 0;
+   int nfail = 0;
+
+   TALLY( TestServerScore() );
+   TALLY( TestServerHypothetical() );
+   TALLY( TestServerErrors() );
+
+   return std::make_pair( nsucc, nfail );
+}
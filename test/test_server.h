@@ -0,0 +1,21 @@
+//=============================================================================
+// test_server.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef TEST_SERVER_H
+#define TEST_SERVER_H
+
+#include <utility>
+
+//-----------------------------------------------------------------------------
+std::pair<int,int> test_Server();
+
+//=============================================================================
+#endif  // TEST_SERVER_H
@@ -0,0 +1,173 @@
+//=============================================================================
+// test_sparse.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "test_sparse.h"
+#include "unit_test.h"
+#include "..\src\linear_systems.h"
+#include "..\src\matrix.h"
+#include "..\src\sparse_cholesky.h"
+#include "..\src\sparse_matrix.h"
+
+//-----------------------------------------------------------------------------
+// Hide all of the testing details inside an unnamed namespace. This allows me
+// to create many small unit tests with polluting the global namespace.
+//-----------------------------------------------------------------------------
+namespace{
+   const double TOLERANCE = 1e-9;
+
+   //--------------------------------------------------------------------------
+   // The sparse matrix with entries for the pairs of points closer than
+   // "cutoff": an exponential covariance, with a nugget, times the Wendland
+   // taper.
+   //--------------------------------------------------------------------------
+   SparseMatrix Tapered( const std::vector<double>& x, const std::vector<double>& y, double cutoff, Matrix& dense )
+   {
+      const int n = x.size();
+      std::vector<int> start(1, 0), columns;
+      std::vector<double> values;
+
+      dense.Resize(n, n);
+      for (int i = 0; i < n; ++i) {
+         for (int j = 0; j < n; ++j) {
+            const double h = hypot( x[i]-x[j], y[i]-y[j] );
+            if (h < cutoff) {
+               const double t = h / cutoff;
+               const double c = ExponentialCovariance(x, y, i, j, 2.0, 10.0, 100.0) * ((i == j) ? 1.0 : pow(1.0 - t, 4)*(4.0*t + 1.0));
+               columns.push_back(j);
+               values.push_back(c);
+               dense(i,j) = c;
+            }
+         }
+         start.push_back( columns.size() );
+      }
+      return SparseMatrix( start, columns, values );
+   }
+
+   //--------------------------------------------------------------------------
+   // TestSparseMatrix
+   //--------------------------------------------------------------------------
+   bool TestSparseMatrix()
+   {
+      SparseMatrix A( {0, 2, 3, 5}, {0, 2, 1, 0, 2}, {4.0, 1.0, 3.0, 1.0, 5.0} );
+
+      bool flag = true;
+
+      flag &= CHECK( A.nRows() == 3 && A.NonZeros() == 5 );
+      flag &= CHECK( A(0,0) == 4.0 && A(0,2) == 1.0 && A(2,0) == 1.0 );
+      flag &= CHECK( A(0,1) == 0.0 && A(1,2) == 0.0 );
+      flag &= CHECK( A.RowStart()[2] == 3 && A.Columns()[3] == 0 && A.Values()[4] == 5.0 );
+
+      SparseMatrix E;
+      flag &= CHECK( E.nRows() == 0 && E.NonZeros() == 0 );
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestNestedDissection
+   //
+   //    The order must be a permutation of the points.
+   //--------------------------------------------------------------------------
+   bool TestNestedDissection()
+   {
+      std::vector<double> x, y;
+      ScatteredPoints(500, x, y, false);
+
+      std::vector<int> order = NestedDissection(x, y, 60.0);
+      std::sort( order.begin(), order.end() );
+
+      bool flag = true;
+
+      flag &= CHECK( order.size() == 500 );
+      for (int i = 0; i < static_cast<int>(order.size()); ++i)
+         flag &= CHECK( order[i] == i );
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestSparseCholesky
+   //
+   //    The solutions must match those of the dense factorization, for the
+   //    natural and the nested dissection orders, and the factor must have
+   //    fewer entries than the dense one.
+   //--------------------------------------------------------------------------
+   bool TestSparseCholesky()
+   {
+      const int n = 400;
+      std::vector<double> x, y;
+      ScatteredPoints(n, x, y, false);
+
+      Matrix dense;
+      SparseMatrix A = Tapered(x, y, 60.0, dense);
+
+      Matrix L, B0(n, 1), B1(n, 1, 1.0), X0, X1;
+      for (int i = 0; i < n; ++i)
+         B0(i,0) = sin(0.1*i);
+      CholeskyDecomposition(dense, L);
+      CholeskySolve(L, B0, X0);
+      CholeskySolve(L, B1, X1);
+
+      std::vector<int> natural(n);
+      for (int i = 0; i < n; ++i)
+         natural[i] = i;
+
+      bool flag = true;
+
+      for (int pass = 0; pass < 2; ++pass) {
+         SparseCholesky factor;
+         flag &= CHECK( factor.Factor(A, pass ? NestedDissection(x, y, 60.0) : natural) );
+         flag &= CHECK( factor.nRows() == n );
+         flag &= CHECK( factor.NonZeros() < static_cast<std::size_t>(n)*(n+1)/2 );
+         flag &= CHECK( factor.Supernodes() < n );
+
+         std::vector<double> b(2*n), work(2*n);
+         for (int i = 0; i < n; ++i) {
+            b[i]     = B0(i,0);
+            b[n + i] = B1(i,0);
+         }
+         factor.Solve(2, b.data(), work.data());
+
+         for (int i = 0; i < n; ++i) {
+            flag &= CHECK( fabs(b[i] - X0(i,0)) < TOLERANCE );
+            flag &= CHECK( fabs(b[n + i] - X1(i,0)) < TOLERANCE );
+         }
+      }
+
+      // A matrix that is not positive definite.
+      SparseMatrix C( {0, 2, 4}, {0, 1, 0, 1}, {1.0, 2.0, 2.0, 1.0} );
+      SparseCholesky factor;
+      flag &= CHECK( !factor.Factor(C, std::vector<int>{0, 1}) );
+
+      return flag;
+   }
+}
+
+
+//-----------------------------------------------------------------------------
+// test_Sparse
+//-----------------------------------------------------------------------------
+std::pair<int,int> test_Sparse()
+{
+   int nsucc = 0;
+   int nfail = 0;
+
+   TALLY( TestSparseMatrix() );
+   TALLY( TestNestedDissection() );
+   TALLY( TestSparseCholesky() );
+
+   return std::make_pair( nsucc, nfail );
+}
@@ -0,0 +1,21 @@
+//=============================================================================
+// test_sparse.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef TEST_SPARSE_H
+#define TEST_SPARSE_H
+
+#include <utility>
+
+//-----------------------------------------------------------------------------
+std::pair<int,int> test_Sparse();
+
+//=============================================================================
+#endif  // TEST_SPARSE_H
@@ -14,6 +14,7 @@
 
 #include "test_special_functions.h"
 #include "unit_test.h"
+#include "..\src\fast_exp-inl.h"
 #include "..\src\special_functions.h"
 
 //-----------------------------------------------------------------------------
@@ -270,6 +271,57 @@ namespace{
 
       return flag;
    }
+
+   //--------------------------------------------------------------------------
+   // TestGaussianCDFBatched
+   //--------------------------------------------------------------------------
+   bool TestGaussianCDFBatched()
+   {
+      const double x[] = {-37, -20, -10, -6, -1.5, -0.3, 0, 0.3, 1.5, 6};
+      const int N = sizeof(x)/sizeof(double);
+
+      // The lower tail keeps its relative accuracy. These test values were
+      // computed using erfc(-x/sqrt(2))/2.
+      const double tail[] = { 5.725571222525e-300, 2.753624118606e-89, 7.619853024161e-24 };
+
+      double p[N];
+      GaussianCDF(N, x, p);
+
+      bool flag = true;
+
+      for (int i = 0; i < N; ++i)
+         flag &= (p[i] == GaussianCDF(x[i]));
+
+      for (int i = 0; i < 3; ++i)
+         flag &= isClose(p[i], tail[i], 1e-12*tail[i]);
+
+      double q[N];
+      GaussianCDFInv(N-4, p+2, q);
+      for (int i = 0; i < N-4; ++i)
+         flag &= isClose(q[i], x[i+2], 1e-12) && (q[i] == GaussianCDFInv(p[i+2]));
+
+      const double nan = NAN;
+      GaussianCDF(1, &nan, p);
+      flag &= std::isnan(p[0]);
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestFastExp
+   //--------------------------------------------------------------------------
+   bool TestFastExp()
+   {
+      bool flag = true;
+
+      for (double x = -700.0; x <= 700.0; x += 0.37)
+         flag &= isClose(FastExp(x), exp(x), 1e-15*exp(x));
+
+      flag &= (FastExp(0.0) == 1.0);
+      flag &= (FastExp(-1000.0) >= 0.0 && FastExp(-1000.0) < 1e-300);
+
+      return flag;
+   }
 }
 
 //-----------------------------------------------------------------------------
@@ -288,6 +340,8 @@ std::pair<int,int> test_SpecialFunctions()
    TALLY( TestIncompleteGammaInv() );
    TALLY( TestGaussianCDF() );
    TALLY( TestGaussianCDFInv() );
+   TALLY( TestGaussianCDFBatched() );
+   TALLY( TestFastExp() );
 
    return std::make_pair( nsucc, nfail );
 }
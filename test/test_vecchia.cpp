@@ -0,0 +1,232 @@
+//=============================================================================
+// test_vecchia.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "test_vecchia.h"
+#include "unit_test.h"
+#include "..\src\linear_systems.h"
+#include "..\src\matrix.h"
+#include "..\src\spatial_index.h"
+#include "..\src\vecchia.h"
+
+//-----------------------------------------------------------------------------
+// Hide all of the testing details inside an unnamed namespace. This allows me
+// to create many small unit tests with polluting the global namespace.
+//-----------------------------------------------------------------------------
+namespace{
+   const double NUGGET = 2.0;
+   const double SILL   = 10.0;
+   const double SCALE  = 300.0;
+
+   //--------------------------------------------------------------------------
+   // The covariance between scattered points [i] and [j].
+   //--------------------------------------------------------------------------
+   double Covariance( const std::vector<double>& x, const std::vector<double>& y, int i, int j )
+   {
+      return ExponentialCovariance(x, y, i, j, NUGGET, SILL, SCALE);
+   }
+
+   //--------------------------------------------------------------------------
+   // TestKdTree
+   //
+   //    The radius and nearest-neighbor searches must find exactly what a
+   //    direct search finds, including the filter and the tie-breaking.
+   //--------------------------------------------------------------------------
+   bool TestKdTree()
+   {
+      const int n = 700;
+      std::vector<double> x, y;
+      ScatteredPoints(n, x, y, true);
+
+      KdTree tree;
+      tree.Build(x, y);
+
+      bool flag = true;
+      flag &= CHECK( tree.Size() == n );
+
+      for (int k = 0; k < n; k += 29) {
+         std::vector<int> found, expected;
+         tree.Within(x[k], y[k], 45.0, found);
+         for (int j = 0; j < n; ++j)
+            if (hypot(x[k]-x[j], y[k]-y[j]) < 45.0) expected.push_back(j);
+
+         std::sort( found.begin(), found.end() );
+         flag &= CHECK( found == expected );
+
+         // The 12 nearest odd-numbered points.
+         std::vector<std::pair<double,int>> ranked;
+         for (int j = 1; j < n; j += 2) {
+            const double dx = x[j] - x[k], dy = y[j] - y[k];
+            ranked.push_back( std::make_pair(dx*dx + dy*dy, j) );
+         }
+         std::sort( ranked.begin(), ranked.end() );
+
+         tree.Nearest(x[k], y[k], 12, [](int j) { return j % 2 == 1; }, found);
+         flag &= CHECK( found.size() == 12 );
+         for (int a = 0; a < static_cast<int>(found.size()); ++a)
+            flag &= CHECK( found[a] == ranked[a].second );
+      }
+
+      std::vector<int> found;
+      tree.Nearest(x[0], y[0], 5, [](int j) { return j < 3; }, found);
+      flag &= CHECK( found.size() == 3 );
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestMaxminOrder
+   //
+   //    The order must be a permutation in which each point is at least as
+   //    far from its predecessors as every point after it.
+   //--------------------------------------------------------------------------
+   bool TestMaxminOrder()
+   {
+      const int n = 300;
+      std::vector<double> x, y;
+      ScatteredPoints(n, x, y, true);
+
+      KdTree tree;
+      tree.Build(x, y);
+      const std::vector<int> order = MaxminOrder(x, y, tree);
+
+      bool flag = true;
+
+      std::vector<int> sorted( order );
+      std::sort( sorted.begin(), sorted.end() );
+      for (int i = 0; i < n; ++i)
+         flag &= CHECK( sorted[i] == i );
+
+      // distance[j] is the distance from point [j] to the ordered points.
+      std::vector<double> distance(n, HUGE_VAL);
+      for (int r = 1; r < n; ++r) {
+         const int p = order[r-1];
+         for (int j = 0; j < n; ++j)
+            distance[j] = std::min( distance[j], hypot(x[j]-x[p], y[j]-y[p]) );
+
+         for (int s = r+1; s < n; ++s)
+            flag &= CHECK( distance[order[r]] >= distance[order[s]] );
+      }
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestVecchiaExact
+   //
+   //    With every predecessor in the conditioning sets the approximation is
+   //    exact: Q, its blocks, and its products must be those of the inverse
+   //    of C.
+   //--------------------------------------------------------------------------
+   bool TestVecchiaExact()
+   {
+      const int n = 120;
+      std::vector<double> x, y;
+      ScatteredPoints(n, x, y, true);
+      for (int i = 0; i < n; ++i)
+         x[i] += 0.01*i;            // no repeated locations
+
+      Matrix A(n, n), L, Ainv;
+      for (int i = 0; i < n; ++i)
+         for (int j = 0; j < n; ++j)
+            A(i,j) = Covariance(x, y, i, j);
+      CholeskyDecomposition(A, L);
+      CholeskyInverse(L, Ainv);
+
+      Vecchia V;
+      bool flag = true;
+      flag &= CHECK( V.Build(x, y, [&](int i, int j) { return Covariance(x, y, i, j); }, n-1, 2) );
+      flag &= CHECK( V.nRows() == n );
+      flag &= CHECK( static_cast<int>(V.Order().size()) == n );
+
+      for (int i = 0; i < n; ++i)
+         for (int j = 0; j < n; ++j)
+            flag &= CHECK( fabs(V.Precision(i,j) - Ainv(i,j)) < 1e-9 );
+
+      const int index[] = { 7, 111, 3, 50, 51, 119, 0 };
+      const int m = sizeof(index) / sizeof(index[0]);
+      std::vector<double> G(m*m);
+      VecchiaWorkspace ws;
+      for (int pass = 0; pass < 2; ++pass) {           // the workspace is reused
+         const int mp = m - pass;
+         V.PrecisionBlock(mp, index + pass, G.data(), ws);
+         for (int a = 0; a < mp; ++a)
+            for (int c = 0; c < mp; ++c)
+               flag &= CHECK( fabs(G[a*mp + c] - Ainv(index[pass+a], index[pass+c])) < 1e-9 );
+      }
+
+      std::vector<double> v(n), Qv(n);
+      for (int i = 0; i < n; ++i)
+         v[i] = sin(0.1*i);
+      V.Multiply(v.data(), Qv.data());
+      for (int i = 0; i < n; ++i) {
+         double Av = 0.0;
+         for (int j = 0; j < n; ++j)
+            Av += Ainv(i,j) * v[j];
+         flag &= CHECK( fabs(Qv[i] - Av) < 1e-9 );
+      }
+
+      return flag;
+   }
+
+   //--------------------------------------------------------------------------
+   // TestVecchiaSparse
+   //
+   //    With a small conditioning set, U must have at most m+1 entries per
+   //    row, Q must be symmetric, and a singular covariance (repeated
+   //    locations without a nugget) must be reported.
+   //--------------------------------------------------------------------------
+   bool TestVecchiaSparse()
+   {
+      const int n = 400, m = 10;
+      std::vector<double> x, y;
+      ScatteredPoints(n, x, y, true);
+
+      Vecchia V;
+      bool flag = true;
+      flag &= CHECK( V.Build(x, y, [&](int i, int j) { return Covariance(x, y, i, j); }, m, 2) );
+
+      const int* start = V.Factor().RowStart();
+      for (int i = 0; i < n; ++i)
+         flag &= CHECK( start[i+1] - start[i] <= m+1 );
+
+      for (int i = 0; i < n; i += 7)
+         for (int j = 0; j < n; j += 11)
+            flag &= CHECK( V.Precision(i,j) == V.Precision(j,i) );
+
+      auto singular = [&](int i, int j) { return 8.0*exp( -hypot(x[i]-x[j], y[i]-y[j]) / 300.0 ); };
+      flag &= CHECK( !V.Build(x, y, singular, m, 2) );
+      flag &= CHECK( V.nRows() == 0 );
+
+      return flag;
+   }
+}
+
+
+//-----------------------------------------------------------------------------
+// test_Vecchia
+//-----------------------------------------------------------------------------
+std::pair<int,int> test_Vecchia()
+{
+   int nsucc = 0;
+   int nfail = 0;
+
+   TALLY( TestKdTree() );
+   TALLY( TestMaxminOrder() );
+   TALLY( TestVecchiaExact() );
+   TALLY( TestVecchiaSparse() );
+
+   return std::make_pair( nsucc, nfail );
+}
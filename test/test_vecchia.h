@@ -0,0 +1,21 @@
+//=============================================================================
+// test_vecchia.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil, Environmental, and Geo- Engineering
+//    University of Minnesota
+//
+// version:
+//    26 June 2017
+//=============================================================================
+#ifndef TEST_VECCHIA_H
+#define TEST_VECCHIA_H
+
+#include <utility>
+
+//-----------------------------------------------------------------------------
+std::pair<int,int> test_Vecchia();
+
+//=============================================================================
+#endif  // TEST_VECCHIA_H
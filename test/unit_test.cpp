@@ -9,7 +9,50 @@
 // version:
 //    26 June 2017
 //=============================================================================
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <new>
+
+#include "unit_test.h"
+
+//-----------------------------------------------------------------------------
+// Replace the global allocation functions, so that the tests can count the
+// heap allocations made by the code under test.
+//-----------------------------------------------------------------------------
+namespace{
+   std::atomic<long long> g_allocations(0);
+}
+
+void* operator new( std::size_t size )
+{
+   ++g_allocations;
+   void* p = std::malloc( size ? size : 1 );
+   if (!p) throw std::bad_alloc();
+   return p;
+}
+
+void* operator new[]( std::size_t size )
+{
+   return operator new( size );
+}
+
+void operator delete( void* p ) noexcept
+{
+   std::free( p );
+}
+
+void operator delete[]( void* p ) noexcept
+{
+   std::free( p );
+}
+
+//-----------------------------------------------------------------------------
+long long AllocationCount()
+{
+   return g_allocations.load();
+}
 
 //-----------------------------------------------------------------------------
 bool isClose( double x, double y, double tol )
@@ -25,3 +68,33 @@ bool Check( bool test, int line, const char* file )
 
    return test;
 }
+
+//-----------------------------------------------------------------------------
+void ScatteredPoints( int n, std::vector<double>& x, std::vector<double>& y, bool repeats )
+{
+   x.resize(n);
+   y.resize(n);
+   for (int i = 0; i < n; ++i) {
+      x[i] = fmod( 37.0*i + 0.31*i*i, 500.0 );
+      y[i] = fmod( 53.0*i + 0.17*i*i, 400.0 );
+   }
+   if (repeats) {
+      for (int i = 0; i + 50 < n; i += 50) {
+         x[i+50] = x[i];
+         y[i+50] = y[i];
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+double ExponentialCovariance(
+   const std::vector<double>& x,
+   const std::vector<double>& y,
+   int i,
+   int j,
+   double nugget,
+   double sill,
+   double scale )
+{
+   return (i == j) ? sill : (sill - nugget)*exp( -hypot(x[i]-x[j], y[i]-y[j]) / scale );
+}
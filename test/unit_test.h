@@ -12,10 +12,36 @@
 #ifndef UNIT_TEST_H
 #define UNIT_TEST_H
 
+#include <vector>
 
 //=============================================================================
 bool isClose( double x, double y, double tol );
 bool Check( bool test, int line, const char* file );
+long long AllocationCount();     // heap allocations so far, on all threads
+
+//-----------------------------------------------------------------------------
+// Test fixtures shared by the approximate engines.
+//
+//    ScatteredPoints fills x and y with n reproducible, irregularly scattered
+//    points in [0,500) x [0,400); with "repeats", every 50th point is moved
+//    onto the one 50 before it, so that some locations are repeated.
+//
+//    ExponentialCovariance is the covariance between points [i] and [j] of
+//    the exponential model: the sill for i == j, and otherwise
+//    (sill - nugget) exp(-h/scale) at separation distance h; the scale is a
+//    third of the practical range.
+//-----------------------------------------------------------------------------
+void ScatteredPoints( int n, std::vector<double>& x, std::vector<double>& y, bool repeats );
+
+double ExponentialCovariance(
+   const std::vector<double>& x,
+   const std::vector<double>& y,
+   int i,
+   int j,
+   double nugget,
+   double sill,
+   double scale
+);
 
 #define CHECK(X) Check( (X), __LINE__, __FILE__ )
 #define TALLY(X) ( (X) ? ++nsucc : ++nfail );